@@ -0,0 +1,64 @@
+#include "bench.h"
+#include <stdio.h>
+#include <algorithm>
+
+BenchRunner::BenchRunner(BenchClock clock, uint32_t ticksPerUs, const char* target) :
+    clock(clock),
+    ticksPerUs(ticksPerUs),
+    target(target)
+{
+}
+
+uint32_t BenchRunner::timeBatch(BenchOp op, void* context, uint32_t batch) {
+    uint32_t start = clock();
+    for (uint32_t i = 0; i < batch; i++) {
+        op(context);
+    }
+    return clock() - start;
+}
+
+void BenchRunner::run(const char* name, BenchOp op, void* context, uint32_t bytesPerOp,
+                      BenchResult& out, uint32_t maxBatch) {
+    // Grow the batch until it is long enough to time accurately
+    const uint32_t targetTicks = BENCH_TARGET_BATCH_US * ticksPerUs;
+    uint32_t batch = 1;
+    while (batch < maxBatch && timeBatch(op, context, batch) < targetTicks) {
+        batch *= 2;
+    }
+    if (batch > maxBatch) batch = maxBatch;
+
+    for (int i = 0; i < BENCH_WARMUP_BATCHES; i++) {
+        timeBatch(op, context, batch);
+    }
+
+    const float nsPerTick = 1000.0f / ticksPerUs;
+    double total = 0;
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        samples[i] = timeBatch(op, context, batch) * nsPerTick / batch;
+        total += samples[i];
+    }
+    std::sort(samples, samples + BENCH_SAMPLES);
+
+    out.name = name;
+    out.samples = BENCH_SAMPLES;
+    out.batch = batch;
+    out.bytesPerOp = bytesPerOp;
+    out.minNs = samples[0];
+    out.p50Ns = samples[BENCH_SAMPLES / 2];
+    out.p90Ns = samples[BENCH_SAMPLES * 90 / 100];
+    out.p99Ns = samples[BENCH_SAMPLES * 99 / 100];
+    out.maxNs = samples[BENCH_SAMPLES - 1];
+    out.meanNs = (float)(total / BENCH_SAMPLES);
+}
+
+void benchFormatHeader(char* line, size_t size) {
+    snprintf(line, size, "BENCH,target,name,samples,batch,bytes,min_ns,p50_ns,p90_ns,p99_ns,max_ns,mean_ns,mb_s");
+}
+
+void benchFormatResult(const BenchRunner& runner, const BenchResult& r, char* line, size_t size) {
+    // Throughput from the median: bytes per ns * 1000 = MB/s
+    float mbps = r.bytesPerOp && r.p50Ns > 0 ? r.bytesPerOp * 1000.0f / r.p50Ns : 0.0f;
+    snprintf(line, size, "BENCH,%s,%s,%lu,%lu,%lu,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.2f",
+             runner.getTarget(), r.name, (unsigned long)r.samples, (unsigned long)r.batch,
+             (unsigned long)r.bytesPerOp, r.minNs, r.p50Ns, r.p90Ns, r.p99Ns, r.maxNs, r.meanNs, mbps);
+}
@@ -0,0 +1,69 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ==============================================
+// MICROBENCHMARK HARNESS
+// ==============================================
+// Times one operation in batches: the batch size is doubled until a batch
+// takes BENCH_TARGET_BATCH_US (so clock reads and call overhead vanish),
+// BENCH_WARMUP_BATCHES are run untimed, then BENCH_SAMPLES batches are timed
+// and reported as per-operation percentiles. Preemption and cache misses show
+// up in the tail (p99/max) instead of skewing the median.
+//
+// Results print as one CSV line each, prefixed "BENCH," so they can be
+// grepped out of a serial log and diffed between builds.
+
+#define BENCH_SAMPLES           200     // Timed batches per benchmark
+#define BENCH_WARMUP_BATCHES    10
+#define BENCH_TARGET_BATCH_US   200     // Batch duration the batch size is grown to
+#define BENCH_MAX_BATCH         65536
+#define BENCH_LINE_SIZE         192     // Enough for one formatted result
+
+// Free-running tick counter (CPU cycles on the board, nanoseconds on the host).
+// Only differences are used, so wrapping is fine.
+typedef uint32_t (*BenchClock)();
+
+// One operation; context is whatever the benchmark set up
+typedef void (*BenchOp)(void* context);
+
+struct BenchResult {
+    const char* name;
+    uint32_t samples;
+    uint32_t batch;             // Operations per timed batch
+    uint32_t bytesPerOp;        // 0 when throughput does not apply
+    float minNs;
+    float p50Ns;
+    float p90Ns;
+    float p99Ns;
+    float maxNs;
+    float meanNs;
+};
+
+class BenchRunner {
+public:
+    BenchRunner(BenchClock clock, uint32_t ticksPerUs, const char* target);
+
+    // Time op. maxBatch caps the batch for operations with side effects that
+    // must not run unbounded (e.g. storage writes).
+    void run(const char* name, BenchOp op, void* context, uint32_t bytesPerOp,
+             BenchResult& out, uint32_t maxBatch = BENCH_MAX_BATCH);
+
+    const char* getTarget() const { return target; }
+
+private:
+    BenchClock clock;
+    uint32_t ticksPerUs;
+    const char* target;
+    float samples[BENCH_SAMPLES];
+
+    uint32_t timeBatch(BenchOp op, void* context, uint32_t batch);
+};
+
+// CSV column names / one result, without a trailing newline
+void benchFormatHeader(char* line, size_t size);
+void benchFormatResult(const BenchRunner& runner, const BenchResult& result, char* line, size_t size);
+
+#endif // BENCH_H
@@ -0,0 +1,413 @@
+#include "bench_suite.h"
+#include <string.h>
+#include <new>
+#include "crc16.h"
+#include "ubx_parser.h"
+#include "packet_builder.h"
+#include "delta_codec.h"
+#include "log_format.h"
+#include "log_writer.h"
+#include "file_transfer_protocol.h"
+#include "fusion_engine.h"
+#include "telemetry_ring.h"
+#include "latency_histogram.h"
+#include "telemetry_batch.h"
+#include "report_policy.h"
+#include "rate_control.h"
+#include "command_parser.h"
+#include "command_frame.h"
+
+#define BENCH_TRACK_LENGTH      64      // Distinct packets cycled through by the codec benchmarks
+#define BENCH_BLOCK_SIZE        4096    // SD_LOG_BLOCK_SIZE
+#define BENCH_RING_CAPACITY     1024    // TELEMETRY_RING_CAPACITY
+#define BENCH_FT_MTU            247     // Typical negotiated ATT MTU
+#define BENCH_FT_WINDOW         16      // FT_WINDOW_FRAMES
+
+// PacketLink that accepts everything, so only the sender and the file read are timed
+class NullLink : public PacketLink {
+public:
+    bool isReady() override { return true; }
+    size_t maxPayload() override { return BENCH_FT_MTU - FT_ATT_OVERHEAD; }
+    bool send(const uint8_t*, size_t) override { return true; }
+};
+
+// Everything the benchmarks operate on. Heap allocated: too big for a task stack.
+struct BenchState {
+    uint8_t crcBuffer[BENCH_BLOCK_SIZE];
+    uint32_t crcLength;
+    uint16_t (*crcImpl)(uint16_t, const uint8_t*, size_t);
+    volatile uint16_t crcResult;
+
+    uint8_t navPvtFrame[UBX_NAV_PVT_LEN + 8];
+    UbxParser parser;
+    UbxNavPvt pvt;
+    GPSData gps;
+    IMUData imu;
+    PacketPower power;
+    GPSPacket packet;
+
+    GPSPacket track[BENCH_TRACK_LENGTH];
+    uint32_t trackIndex;
+    DeltaEncoder encoder;
+    uint8_t record[DELTA_MAX_RECORD_SIZE];
+    uint8_t encoded[BENCH_TRACK_LENGTH * DELTA_MAX_RECORD_SIZE];
+    size_t encodedLength;
+    size_t decodeOffset;
+    DeltaDecoder decoder;
+
+    TelemetryRing<GPSPacket> ring;
+    int ringConsumer;
+
+    uint8_t block[BENCH_BLOCK_SIZE];
+    LogBlockBuilder builder;
+    uint32_t blockSequence;
+
+    FusionEngine fusion;
+    FusionGnssFix fix;
+    int64_t fusionUs;
+
+    LatencyHistogram histogram;
+    uint32_t histogramValue;
+
+    TelemetryBatcher batcher;
+    uint32_t batchSequence;
+
+    ReportPolicy policy;
+    uint32_t policyMs;
+    volatile bool policySent;
+
+    RateDecimator decimator;
+    int64_t decimatorUs;
+    GPSPacket decimated;
+
+    ParsedCommand command;
+    uint8_t commandFrame[CMD_FRAME_MAX_SIZE];
+    size_t commandFrameLength;
+
+    StorageFile* storage;
+    LogWriter writer;
+    FtSender sender;
+    NullLink link;
+    uint8_t frame[sizeof(FtDataHeader) + FT_MAX_PAYLOAD];
+    bool storageFailed;
+};
+
+static void benchNoop(void* context) {
+    (void)context;
+}
+
+static void benchCrc(void* context) {
+    BenchState* s = (BenchState*)context;
+    s->crcResult = s->crcImpl(CRC16_INIT, s->crcBuffer, s->crcLength);
+}
+
+static void benchUbxParse(void* context) {
+    BenchState* s = (BenchState*)context;
+    s->parser.feed(s->navPvtFrame, sizeof(s->navPvtFrame));
+}
+
+static void benchNavPvtToGps(void* context) {
+    BenchState* s = (BenchState*)context;
+    gpsDataFromNavPvt(s->pvt, s->gps);
+}
+
+static void benchBuildPacket(void* context) {
+    BenchState* s = (BenchState*)context;
+    buildPacket(s->gps, &s->imu, s->power, s->packet);
+}
+
+static void benchDeltaEncode(void* context) {
+    BenchState* s = (BenchState*)context;
+    s->encoder.encode(s->track[s->trackIndex++ % BENCH_TRACK_LENGTH], s->record);
+}
+
+static void benchDeltaDecode(void* context) {
+    BenchState* s = (BenchState*)context;
+    size_t consumed = 0;
+    if (s->decodeOffset >= s->encodedLength) s->decodeOffset = 0;     // Stream opens with a keyframe
+    s->decoder.decode(s->encoded + s->decodeOffset, s->encodedLength - s->decodeOffset, s->packet, &consumed);
+    s->decodeOffset += consumed;
+}
+
+static void benchRingPush(void* context) {
+    BenchState* s = (BenchState*)context;
+    s->ring.push(s->packet);
+}
+
+static void benchRingPushRead(void* context) {
+    BenchState* s = (BenchState*)context;
+    s->ring.push(s->packet);
+    s->ring.read(s->ringConsumer, s->packet);
+}
+
+// Spread over every bucket range an epoch interval or sink latency lands in
+static void benchHistogramRecord(void* context) {
+    BenchState* s = (BenchState*)context;
+    s->histogramValue = s->histogramValue * 1664525UL + 1013904223UL;
+    s->histogram.record(s->histogramValue >> 14);
+}
+
+// sinkBLE() in batch mode; every fifth call completes a frame on the null link
+static void benchBatchAdd(void* context) {
+    BenchState* s = (BenchState*)context;
+    s->batcher.add(s->link, s->packet, s->batchSequence, s->batchSequence, s->batchSequence);
+    s->batchSequence++;
+}
+
+static void benchPolicyOffer(void* context) {
+    BenchState* s = (BenchState*)context;
+    s->policySent = s->policy.offer(s->track[s->trackIndex++ % BENCH_TRACK_LENGTH], s->policyMs);
+    s->policyMs += 40;
+}
+
+static void benchRateAverage(void* context) {
+    BenchState* s = (BenchState*)context;
+    s->decimator.push(s->track[s->trackIndex++ % BENCH_TRACK_LENGTH], s->decimatorUs, s->decimated);
+    s->decimatorUs += 40000;
+}
+
+// RATE:BLE:5:AVG as a config characteristic write, text and binary
+#define BENCH_COMMAND_TEXT      "RATE:BLE:5:AVG"
+
+static void benchCommandText(void* context) {
+    BenchState* s = (BenchState*)context;
+    parseCommand(COMMAND_CHANNEL_CONFIG, BENCH_COMMAND_TEXT, sizeof(BENCH_COMMAND_TEXT) - 1, s->command);
+}
+
+static void benchCommandFrame(void* context) {
+    BenchState* s = (BenchState*)context;
+    parseCommandFrame(s->commandFrame, s->commandFrameLength, s->command);
+}
+
+// Same keyframe-per-block policy as sinkSD(); sealing is part of the amortised cost
+static void benchLogBlockAdd(void* context) {
+    BenchState* s = (BenchState*)context;
+    if (s->builder.isActive() && s->builder.space() < DELTA_MAX_RECORD_SIZE) {
+        s->builder.seal(s->blockSequence++, 0);
+    }
+    if (!s->builder.isActive()) {
+        s->builder.begin(s->block, BENCH_BLOCK_SIZE, LOG_ENCODING_DELTA);
+        s->encoder.forceKeyframe();
+    }
+    const GPSPacket& packet = s->track[s->trackIndex++ % BENCH_TRACK_LENGTH];
+    size_t length = s->encoder.encode(packet, s->record);
+    s->builder.add(s->record, length, packet.timestamp);
+}
+
+static void benchFusionPredict(void* context) {
+    BenchState* s = (BenchState*)context;
+    s->fusionUs += 5000;
+    s->fusion.predict(s->fusionUs, 0.2f, 0.01f);
+}
+
+static void benchFusionCorrect(void* context) {
+    BenchState* s = (BenchState*)context;
+    s->fix.timestampUs = s->fusionUs;
+    s->fusion.correct(s->fix);
+}
+
+static void benchLogWrite(void* context) {
+    BenchState* s = (BenchState*)context;
+    if (!s->writer.writeBlock(s->block, BENCH_BLOCK_SIZE, 1)) s->storageFailed = true;
+}
+
+// One notification of a file download, acknowledged at once so the window never fills
+static void benchFtFrame(void* context) {
+    BenchState* s = (BenchState*)context;
+    if (s->sender.getSentOffset() >= s->sender.getFileSize()) {
+        s->sender.begin(s->sender.getFileSize(), s->sender.getPayloadSize(), BENCH_FT_WINDOW, 0);
+    }
+    if (ftSendFrames(s->sender, *s->storage, s->link, 1, s->frame) < 0) s->storageFailed = true;
+    FtAckFrame ack = { FT_FRAME_ACK, 0, 0, s->sender.getSentOffset() };
+    s->sender.onAck(ack, 0);
+}
+
+// 25 Hz drive: enough movement that every delta field changes
+static void buildTrack(BenchState* s) {
+    for (uint32_t i = 0; i < BENCH_TRACK_LENGTH; i++) {
+        GPSPacket& p = s->track[i];
+        memset(&p, 0, sizeof(p));
+        p.timestamp = 1755604800UL + i / 25;
+        p.latitude = 522297000 + (int32_t)(i * 37);
+        p.longitude = 210122000 + (int32_t)(i * 53);
+        p.altitude = 110000 + (int32_t)(i % 7) * 10;
+        p.speed = 12000 + (uint16_t)(i * 13);
+        p.heading = 4500000 + i * 800;
+        p.fixType = 3;
+        p.satellites = 14;
+        p.battery_mv = 3950;
+        p.battery_pct = 87;
+        p.accel_x = (int16_t)(i % 5);
+        p.accel_z = 1000;
+        p.crc = crc16((const uint8_t*)&p, sizeof(GPSPacket) - 2);
+    }
+}
+
+static void buildNavPvtFrame(BenchState* s) {
+    UbxNavPvt& pvt = s->pvt;
+    memset(&pvt, 0, sizeof(pvt));
+    pvt.iTOW = 43200000;
+    pvt.year = 2025; pvt.month = 8; pvt.day = 19; pvt.hour = 12;
+    pvt.valid = 0x07;
+    pvt.fixType = 3;
+    pvt.flags = 0x01;
+    pvt.numSV = 14;
+    pvt.lat = 522297000;
+    pvt.lon = 210122000;
+    pvt.height = 110000;
+    pvt.hAcc = 1500;
+    pvt.gSpeed = 12000;
+    pvt.headMot = 4500000;
+    pvt.sAcc = 200;
+    pvt.headAcc = 50000;
+
+    uint8_t* f = s->navPvtFrame;
+    f[0] = UBX_SYNC_CHAR_1; f[1] = UBX_SYNC_CHAR_2;
+    f[2] = UBX_CLASS_NAV; f[3] = UBX_ID_NAV_PVT;
+    f[4] = UBX_NAV_PVT_LEN; f[5] = 0;
+    memcpy(f + 6, &pvt, UBX_NAV_PVT_LEN);
+    uint8_t ckA = 0, ckB = 0;
+    for (int i = 2; i < 6 + UBX_NAV_PVT_LEN; i++) { ckA += f[i]; ckB += ckA; }
+    f[6 + UBX_NAV_PVT_LEN] = ckA;
+    f[7 + UBX_NAV_PVT_LEN] = ckB;
+}
+
+uint32_t benchRunSuite(BenchRunner& runner, StorageFile* storage, const char* filter, BenchReport report) {
+    BenchState* s = new (std::nothrow) BenchState();
+    if (!s) return 0;
+
+    for (uint32_t i = 0; i < sizeof(s->crcBuffer); i++) {
+        s->crcBuffer[i] = (uint8_t)(i * 37 + 11);
+    }
+    buildTrack(s);
+    buildNavPvtFrame(s);
+    gpsDataFromNavPvt(s->pvt, s->gps);
+    s->imu.accelX = 0.12f;
+    s->imu.accelZ = 1.0f;
+    s->power.batteryMv = 3950;
+    s->power.batteryPct = 87;
+    s->power.pmuStatus = 0x04;
+    buildPacket(s->gps, &s->imu, s->power, s->packet);
+
+    s->encoder.forceKeyframe();
+    for (uint32_t i = 0; i < BENCH_TRACK_LENGTH; i++) {
+        s->encodedLength += s->encoder.encode(s->track[i], s->encoded + s->encodedLength);
+    }
+
+    s->ring.begin(BENCH_RING_CAPACITY);
+    s->ringConsumer = s->ring.addConsumer();
+
+    s->fix.latitude = s->pvt.lat;
+    s->fix.longitude = s->pvt.lon;
+    s->fix.speed = 12.0f;
+    s->fix.heading = 45.0f;
+    s->fix.horizontalAccuracy = 1.5f;
+    s->fix.speedAccuracy = 0.2f;
+    s->fix.headingAccuracy = 0.5f;
+    s->fix.timestampUs = 0;
+    s->fusion.correct(s->fix);     // First fix initializes the filter
+    s->batcher.setMaxLatency(UINT32_MAX);
+    ReportPolicyConfig policyConfig;
+    policyConfig.enabled = true;
+    s->policy.configure(policyConfig);
+    s->decimator.configure(10, RATE_FILTER_AVERAGE, 25);     // 40 ms steps below
+    CommandFrameBuilder builder;
+    builder.begin(1, CMD_OP_RATE);
+    builder.addText("BLE");
+    builder.addUint(5);
+    builder.addText("AVG");
+    s->commandFrameLength = builder.finish();
+    memcpy(s->commandFrame, builder.data(), s->commandFrameLength);
+    s->storage = storage;
+
+    struct Case {
+        const char* name;
+        BenchOp op;
+        uint32_t bytes;
+        uint16_t (*crcImpl)(uint16_t, const uint8_t*, size_t);
+        uint32_t crcLength;
+    };
+    const uint32_t packetCrc = sizeof(GPSPacket) - 2;
+    const Case cases[] = {
+        { "noop",               benchNoop,          0, nullptr, 0 },
+        { "crc16_bitwise_pkt",  benchCrc,           packetCrc, crc16Bitwise, packetCrc },
+        { "crc16_table_pkt",    benchCrc,           packetCrc, crc16Table, packetCrc },
+        { "crc16_slice4_pkt",   benchCrc,           packetCrc, crc16Slice4, packetCrc },
+#ifdef ARDUINO
+        { "crc16_rom_pkt",      benchCrc,           packetCrc, crc16Rom, packetCrc },
+#endif
+        { "crc16_bitwise_4k",   benchCrc,           BENCH_BLOCK_SIZE, crc16Bitwise, BENCH_BLOCK_SIZE },
+        { "crc16_table_4k",     benchCrc,           BENCH_BLOCK_SIZE, crc16Table, BENCH_BLOCK_SIZE },
+        { "crc16_slice4_4k",    benchCrc,           BENCH_BLOCK_SIZE, crc16Slice4, BENCH_BLOCK_SIZE },
+#ifdef ARDUINO
+        { "crc16_rom_4k",       benchCrc,           BENCH_BLOCK_SIZE, crc16Rom, BENCH_BLOCK_SIZE },
+#endif
+        { "ubx_parse_navpvt",   benchUbxParse,      sizeof(s->navPvtFrame), nullptr, 0 },
+        { "navpvt_to_gps",      benchNavPvtToGps,   0, nullptr, 0 },
+        { "build_packet",       benchBuildPacket,   sizeof(GPSPacket), nullptr, 0 },
+        { "delta_encode",       benchDeltaEncode,   sizeof(GPSPacket), nullptr, 0 },
+        { "delta_decode",       benchDeltaDecode,   sizeof(GPSPacket), nullptr, 0 },
+        { "ring_push",          benchRingPush,      sizeof(GPSPacket), nullptr, 0 },
+        { "ring_push_read",     benchRingPushRead,  sizeof(GPSPacket), nullptr, 0 },
+        { "log_block_add",      benchLogBlockAdd,   sizeof(GPSPacket), nullptr, 0 },
+        { "hist_record",        benchHistogramRecord, 0, nullptr, 0 },
+        { "ble_batch_add",      benchBatchAdd,      sizeof(GPSPacket), nullptr, 0 },
+        { "report_offer",       benchPolicyOffer,   sizeof(GPSPacket), nullptr, 0 },
+        { "rate_average",       benchRateAverage,   sizeof(GPSPacket), nullptr, 0 },
+        { "cmd_parse_text",     benchCommandText,   sizeof(BENCH_COMMAND_TEXT) - 1, nullptr, 0 },
+        { "cmd_parse_frame",    benchCommandFrame,  (uint32_t)s->commandFrameLength, nullptr, 0 },
+        { "fusion_predict",     benchFusionPredict, 0, nullptr, 0 },
+        { "fusion_correct",     benchFusionCorrect, 0, nullptr, 0 },
+    };
+
+    uint32_t count = 0;
+    BenchResult result;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        const Case& c = cases[i];
+        if (filter && filter[0] && !strstr(c.name, filter)) continue;
+        s->crcImpl = c.crcImpl;
+        s->crcLength = c.crcLength;
+        runner.run(c.name, c.op, s, c.bytes, result);
+        report(runner, result);
+        count++;
+    }
+
+    // Storage: whole log blocks through LogWriter, one per timed batch (a full run
+    // writes about 1 MB), then the same file read back as download frames
+    bool wantWrite = !filter || !filter[0] || strstr("log_write_4k", filter);
+    bool wantFrames = !filter || !filter[0] || strstr("ft_send_frame", filter);
+    if (storage && (wantWrite || wantFrames)) {
+        LogFileHeader header;
+        logInitFileHeader(header, BENCH_BLOCK_SIZE, 0, LOG_ENCODING_DELTA, 0);
+        if (s->writer.open(storage, BENCH_STORAGE_PATH, header)) {
+            if (s->builder.isActive()) s->builder.seal(0, 0);
+            s->builder.begin(s->block, BENCH_BLOCK_SIZE, LOG_ENCODING_DELTA);
+            s->builder.add(s->encoded, s->encodedLength, s->track[0].timestamp);
+            s->builder.seal(0, 0);
+            if (wantWrite) {
+                runner.run("log_write_4k", benchLogWrite, s, BENCH_BLOCK_SIZE, result, 1);
+                if (!s->storageFailed) {
+                    report(runner, result);
+                    count++;
+                }
+            } else {
+                for (int i = 0; i < BENCH_STORAGE_BLOCKS; i++) benchLogWrite(s);
+            }
+            s->writer.finish();
+        }
+
+        if (wantFrames && !s->storageFailed && storage->open(BENCH_STORAGE_PATH, STORAGE_READ)) {
+            uint16_t payload = (uint16_t)ftPayloadSize(BENCH_FT_MTU);
+            s->sender.begin(storage->size(), payload, BENCH_FT_WINDOW, 0);
+            runner.run("ft_send_frame", benchFtFrame, s, payload, result);
+            if (!s->storageFailed) {
+                report(runner, result);
+                count++;
+            }
+            storage->close();
+        }
+    }
+
+    delete s;
+    return count;
+}
@@ -0,0 +1,28 @@
+#ifndef BENCH_SUITE_H
+#define BENCH_SUITE_H
+
+#include <stdint.h>
+#include "bench.h"
+#include "platform_io.h"
+
+// ==============================================
+// DATA-PATH BENCHMARKS
+// ==============================================
+// The per-sample primitives of the telemetry path, timed exactly as the
+// firmware calls them: CRC variants, UBX parse, NAV-PVT -> packet, delta
+// codec, ring, histogram recording, BLE batching, log block building, fusion,
+// and - when storage is given - log block writes and file-transfer frames
+// read back from that storage.
+// Run with `gpslogger_host bench` on the host or BENCH over serial/BLE on
+// the board.
+
+#define BENCH_STORAGE_PATH      "/BENCH.bin"    // Scratch file for the storage benchmarks
+#define BENCH_STORAGE_BLOCKS    16              // Blocks written for ft_send_frame when log_write_4k is filtered out
+
+typedef void (*BenchReport)(const BenchRunner& runner, const BenchResult& result);
+
+// Run every benchmark whose name contains `filter` (null or empty runs all).
+// storage may be null, which skips the storage benchmarks. Returns the number run.
+uint32_t benchRunSuite(BenchRunner& runner, StorageFile* storage, const char* filter, BenchReport report);
+
+#endif // BENCH_SUITE_H
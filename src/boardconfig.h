@@ -4,7 +4,9 @@
 // ==============================================
 // PERIPHERAL ENABLE/DISABLE OPTIONS
 // ==============================================
-// Set to false to disable peripherals that aren't connected
+// Set to false to disable peripherals that aren't connected. These and the
+// other knobs listed in DeviceConfigId are build defaults: the values in NVS
+// (CFG:<key>=<value>) win at boot.
 #define ENABLE_GPS          false    // Set to false if no GPS module connected
 #define ENABLE_IMU          false    // Set to false if no IMU connected  
 #define ENABLE_SD_CARD      true    // Set to false if no SD card
@@ -18,13 +20,161 @@
 #define WIFI_CONNECT_TIMEOUT_MS 20000   // 20 seconds to connect WiFi
 #define SD_INIT_RETRIES         3       // Number of SD init attempts
 
+// GNSS navigation rate
+#define GNSS_NAV_RATE_HZ        25      // NAV-PVT epochs per second
+#define GNSS_RX_BUFFER_SIZE     2048    // UART2 RX ring (NAV-PVT frame is 100 bytes)
+#define GNSS_RX_CHUNK           256     // Bytes pulled from the UART per read in the ingest task
+
+// FreeRTOS task pipeline (ESP32-S3: radio stacks live on core 0, Arduino on core 1)
+#define INGEST_TASK_CORE        1
+#define INGEST_TASK_PRIORITY    5       // Highest of ours - must never miss an epoch
+#define INGEST_TASK_STACK       4096
+#define INGEST_PERIOD_MS        5       // GNSS poll + IMU sample cadence
+#define SINK_TASK_CORE          0
+#define SINK_TASK_PRIORITY      3
+#define SINK_TASK_STACK         8192
+#define UI_TASK_CORE            1
+#define UI_TASK_PRIORITY        2
+#define UI_TASK_STACK           8192
+#define UI_PERIOD_MS            10      // lv_timer_handler() cadence
+#define TELEMETRY_RING_CAPACITY 1024    // Samples on the central bus (power of two, PSRAM)
+#define PIPELINE_MAX_SINKS      6
+
+// Per-consumer output rates (rate_control.h), 0 = every bus sample. Averaged
+// down from the bus rate; RATE:<SD|BLE|UDP|UI>:<hz>[:AVG|LAST] at runtime.
+#define SD_RATE_HZ              25
+#define BLE_RATE_HZ             10
+#define UDP_RATE_HZ             5
+#define UI_RATE_HZ              15
+
+// UDP telemetry sink: own task and bus cursor, batched frames (telemetry_batch.h)
+#define UDP_TASK_CORE           0
+#define UDP_TASK_PRIORITY       2       // Below the shared sinks - lwIP stalls must not hold them up
+#define UDP_TASK_STACK          4096
+#define UDP_TASK_IDLE_MS        20      // Deadline check cadence while no samples arrive
+#define UDP_MAX_BACKLOG         250     // Unsent samples kept before the oldest are dropped (10 s at 25 Hz)
+#define UDP_MAX_DATAGRAM        1472    // Unfragmented UDP over a 1500-byte MTU
+#define UDP_BATCH_DEFAULT_BYTES 512     // UDP_BATCH:<bytes>[:<ms>] changes both at runtime
+#define UDP_BATCH_DEFAULT_MS    100
+#define UDP_BATCH_MAX_LATENCY_MS 1000
+#define UDP_REPORT_POLICY       false   // Dead-band filter at boot (report_policy.h), REPORT:UDP:... at runtime
+
+// Log / UBX capture replay (replay_source.h), started with REPLAY:<file>[:speed]
+#define REPLAY_INGEST_BURST     32      // Samples per ingest period while replaying (6400/s ceiling)
+#define REPLAY_RING_CAPACITY    256     // Records read ahead by the sink task (power of two)
+
+// Latency histograms (latency_histogram.h), reported with HIST, exported with HIST:EXPORT
+#define HISTOGRAM_WINDOW_MS     60000   // Window length; the previous window stays queryable
+#define EPOCH_BUDGET_US         40000   // Hard per-epoch budget: HIST reports samples above it
+#define HISTOGRAM_EXPORT_PATH   "/HIST.bin"
+
+// IMU FIFO sampling (imu_sampler.h)
+#define IMU_INT_PIN             GPIO_SPARE_1    // MPU INT line (-1 = no interrupt wired, drain the FIFO on a timer)
+#define IMU_SAMPLE_RATE_HZ      200     // Output data rate, 4-1000 Hz (1 kHz / (1 + SMPLRT_DIV))
+#define IMU_FIFO_BATCH          8       // Samples per task wake-up
+#define IMU_RING_CAPACITY       256     // IMU samples buffered for consumers (power of two)
+#define IMU_TASK_CORE           1
+#define IMU_TASK_PRIORITY       4       // Just below ingest
+#define IMU_TASK_STACK          3072
+
+// GNSS/IMU fusion (fusion_engine.h), runs on the ingest task
+#define ENABLE_FUSION           true
+#define FUSION_OUTPUT_HZ        100     // Fused states published per second
+#define FUSION_RING_CAPACITY    128     // Fused states buffered for the UI and sinks (power of two)
+#define FUSION_YAW_SIGN         -1.0f   // MPU Z gyro is counter-clockwise positive, heading is clockwise
+
+// Batched SD logger (blocks live in PSRAM, written by a background task)
+#define SD_LOG_BLOCK_SIZE       4096    // Bytes per log block/write, multiple of the 512-byte sector (4-16 KB)
+#define SD_LOG_BLOCK_COUNT      4       // Block pool size - one filling, the rest queued/writing
+#define SD_LOG_MAX_BLOCK_AGE_MS 5000    // Seal a partial block after this (blocks are padded to full size)
+#define SD_LOG_FLUSH_INTERVAL_MS 5000   // FAT sync at most this far apart...
+#define SD_LOG_FLUSH_BYTES      65536   // ...or after this many bytes, whichever comes first
+#define SD_LOG_DELTA_ENCODING   true    // Delta/varint records (delta_codec.h) instead of raw packets
+#define SD_WRITER_TASK_CORE     0
+#define SD_WRITER_TASK_PRIORITY 1       // Below the sinks - SD latency must not stall fan-out
+#define SD_WRITER_TASK_STACK    4096
+
+// BLE link parameters requested on every connection
+#define BLE_PREFERRED_MTU       517     // ATT MTU offered to the client (max for BLE 4.2+)
+#define BLE_PREFERRED_TX_OCTETS 251     // Data length extension (27 without DLE)
+#define BLE_CONN_INTERVAL_MIN   6       // 7.5 ms (1.25 ms units)
+#define BLE_CONN_INTERVAL_MAX   12      // 15 ms
+#define BLE_CONN_LATENCY        0
+#define BLE_SUPERVISION_TIMEOUT 400     // 4 s (10 ms units)
+#define BLE_TEXT_CHUNK_DELAY_MS 20      // Gap between queued chunks of a multi-notification reply
+#define BLE_BATCH_DEFAULT_MS    0       // Telemetry batching deadline at boot (telemetry_batch.h), 0 = off
+#define BLE_BATCH_MAX_LATENCY_MS 1000   // Largest deadline BATCH:<ms> accepts
+#define BLE_REPORT_POLICY       false   // Dead-band filter at boot (report_policy.h), REPORT:BLE:... at runtime
+
+// BLE binary file transfer (file_transfer_protocol.h)
+#define FT_WINDOW_FRAMES        16      // Unacknowledged notifications in flight
+#define FT_FRAMES_PER_POLL      8       // Notifications per housekeeping pass
+#define FT_ACK_TIMEOUT_MS       1000    // Resend from the last ack after this long without progress
+#define FT_MAX_STALLED_TIMEOUTS 10      // Abort the transfer after this many timeouts in a row
+#define FT_ACK_QUEUE_LENGTH     16      // Acks buffered between the BLE callback and the sink task
+#define CMD_ACK_QUEUE_LENGTH    8       // Binary command responses queued by the BLE callbacks
+
+// Serial console: config commands (START_LOG, REPLAY:..., BENCH, ...) typed one per line
+#define SERIAL_COMMAND_MAX      80      // Longest accepted line
+
 // Debug options
 #define DEBUG_PERIPHERAL_INIT   true    // Print detailed init info
 #define DEBUG_MISSING_HARDWARE  true    // Warn about missing hardware
+#define DEBUG_MODE              true    // Periodic stats on the console
+#define DEBUG_LINE_SIZE         256     // One debugPrintf() line, longer ones are cut
 
 // WiFi Configuration
 #define WIFI_SSID "Puchatkova"
 #define WIFI_PASSWORD "Internet2@"
+#define UDP_TARGET_HOST         "172.16.2.158"
+#define UDP_TARGET_PORT         9000
+
+// ==============================================
+// RUNTIME CONFIGURATION (config_registry.h)
+// ==============================================
+// Loaded from NVS once at boot, read with CFG / CFG:<key>, changed with
+// CFG:<key>=<value>, all back to the build defaults with CFG:RESET. Changes
+// are persisted and applied by the sink task; boot entries take effect after
+// a restart. BATCH:, UDP_BATCH:, RATE: and REPORT: stay session-only overrides.
+#define CONFIG_NVS_NAMESPACE    "config"
+
+enum DeviceConfigScope {     // Bit 0 is CONFIG_SCOPE_BOOT
+    CONFIG_SCOPE_DEBUG      = 0x0002,
+    CONFIG_SCOPE_UDP        = 0x0004,   // Target address
+    CONFIG_SCOPE_BATCHING   = 0x0008,
+    CONFIG_SCOPE_RATES      = 0x0010,
+    CONFIG_SCOPE_REPORT     = 0x0020
+};
+
+enum DeviceConfigId {
+    CFG_ENABLE_GPS = 0,     // Boot
+    CFG_ENABLE_IMU,
+    CFG_ENABLE_SD,
+    CFG_ENABLE_WIFI,
+    CFG_ENABLE_BLE,
+    CFG_ENABLE_TOUCH,
+    CFG_NAV_RATE_HZ,
+    CFG_GPS_TIMEOUT_MS,
+    CFG_WIFI_TIMEOUT_MS,
+    CFG_UDP_BACKLOG,
+    CFG_DEBUG,              // Live
+    CFG_UDP_HOST,
+    CFG_UDP_PORT,
+    CFG_UDP_BATCH_BYTES,
+    CFG_UDP_BATCH_MS,
+    CFG_BLE_BATCH_MS,
+    CFG_RATE_SD,
+    CFG_RATE_BLE,
+    CFG_RATE_UDP,
+    CFG_RATE_UI,
+    CFG_BLE_REPORT,
+    CFG_UDP_REPORT,
+    CFG_HISTOGRAM_MS,
+    CFG_COUNT
+};
+
+class ConfigRegistry;
+extern ConfigRegistry deviceConfig;     // globals.cpp
 
 // External variable declarations (not definitions)
 extern bool debugMode;
@@ -92,18 +242,43 @@ const float IMPACT_THRESHOLD = 2.5;
 #define MPU6xxx_TEMP_OUT_H 0x41
 #define MPU6xxx_ACCEL_CONFIG 0x1C
 #define MPU6xxx_GYRO_CONFIG 0x1B
+#define MPU6xxx_SMPLRT_DIV 0x19
+#define MPU6xxx_CONFIG 0x1A
+#define MPU6xxx_FIFO_EN 0x23
+#define MPU6xxx_INT_PIN_CFG 0x37
+#define MPU6xxx_INT_ENABLE 0x38
+#define MPU6xxx_INT_STATUS 0x3A
+#define MPU6xxx_USER_CTRL 0x6A
+#define MPU6xxx_FIFO_COUNTH 0x72
+#define MPU6xxx_FIFO_R_W 0x74
+#define MPU6xxx_BURST_LENGTH 14         // ACCEL_XOUT_H..GYRO_ZOUT_L: accel XYZ, temp, gyro XYZ
+#define MPU6xxx_ACCEL_LSB_PER_G 16384.0f    // +-2 g range
+#define MPU6xxx_GYRO_LSB_PER_DPS 131.0f     // +-250 deg/s range
 
 // Performance monitoring - External declarations
 extern unsigned long lastPacketTime;
 extern unsigned long lastDebugTime;
 extern unsigned long lastWiFiCheck;
-extern unsigned long lastPerfReset;
+extern unsigned long lastHistogramRotate;
 
 // File transfer deferred operations - External declarations
 extern volatile bool pendingListFiles;
 extern volatile bool pendingStartTransfer;
 extern volatile bool pendingDeleteFile;
 extern volatile bool pendingCancelTransfer;
+extern volatile bool pendingStatusRequest;
+extern volatile bool pendingToggleLogging;
+extern volatile bool pendingIMUCalibration;
+extern volatile bool pendingStartReplay;
+extern volatile bool pendingStopReplay;
+extern volatile bool pendingBenchmark;
+extern volatile bool pendingProbeReport;
+extern volatile bool pendingProbeReset;
+extern volatile bool pendingHistogramReport;
+extern volatile bool pendingHistogramExport;
+extern volatile bool pendingPolicyReport;
+extern volatile bool pendingRateReport;
+extern volatile bool pendingConfigReport;
 
 // Power Management - JC3248W535EN doesn't have dedicated PMU
 #define ADC_BAT             7    // Available ADC pin for battery monitoring
@@ -116,4 +291,9 @@ extern volatile bool pendingCancelTransfer;
 #define GPIO_SPARE_5        19
 #define GPIO_SPARE_6        20
 
+// analogRead(ADC_BAT) would take the pin off the data-ready interrupt
+#if IMU_INT_PIN == ADC_BAT
+#error "IMU_INT_PIN must not share a GPIO with ADC_BAT"
+#endif
+
 #endif // BOARDCONFIG_H
\ No newline at end of file
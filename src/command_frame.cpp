@@ -0,0 +1,200 @@
+#include "command_frame.h"
+#include <stdio.h>
+#include <string.h>
+#include "crc16.h"
+
+enum CommandArgument : uint8_t {
+    CMD_ARG_NONE,
+    CMD_ARG_OPTIONAL,
+    CMD_ARG_REQUIRED
+};
+
+enum CommandReply : uint8_t {
+    CMD_REPLY_NONE,
+    CMD_REPLY_ALWAYS,
+    CMD_REPLY_QUERY             // Only without an argument (a report, not a setting)
+};
+
+struct OpcodeSyntax {
+    CommandId id;
+    CommandArgument argument;
+    CommandReply reply;
+};
+
+// Indexed by CommandOpcode; the argument rules match the text keywords
+static const OpcodeSyntax opcodeTable[CMD_OP_COUNT] = {
+    { CMD_NONE,             CMD_ARG_NONE,     CMD_REPLY_NONE },
+    { CMD_START_LOG,        CMD_ARG_NONE,     CMD_REPLY_NONE },
+    { CMD_STOP_LOG,         CMD_ARG_NONE,     CMD_REPLY_NONE },
+    { CMD_LIST_FILES,       CMD_ARG_NONE,     CMD_REPLY_ALWAYS },     // FILES:
+    { CMD_DOWNLOAD,         CMD_ARG_REQUIRED, CMD_REPLY_ALWAYS },     // START: or ERROR:
+    { CMD_DELETE,           CMD_ARG_REQUIRED, CMD_REPLY_ALWAYS },     // DELETED: or ERROR:
+    { CMD_CANCEL_TRANSFER,  CMD_ARG_NONE,     CMD_REPLY_NONE },
+    { CMD_TRANSFER_STATUS,  CMD_ARG_NONE,     CMD_REPLY_ALWAYS },     // STATUS:
+    { CMD_CALIBRATE_IMU,    CMD_ARG_NONE,     CMD_REPLY_NONE },
+    { CMD_REPLAY,           CMD_ARG_REQUIRED, CMD_REPLY_NONE },
+    { CMD_STOP_REPLAY,      CMD_ARG_NONE,     CMD_REPLY_NONE },
+    { CMD_BENCHMARK,        CMD_ARG_OPTIONAL, CMD_REPLY_NONE },       // Console only
+    { CMD_PROBES,           CMD_ARG_OPTIONAL, CMD_REPLY_ALWAYS },     // PROBES:
+    { CMD_BLE_BATCH,        CMD_ARG_REQUIRED, CMD_REPLY_NONE },
+    { CMD_UDP_BATCH,        CMD_ARG_REQUIRED, CMD_REPLY_NONE },
+    { CMD_REPORT_POLICY,    CMD_ARG_OPTIONAL, CMD_REPLY_QUERY },      // REPORT:
+    { CMD_RATE,             CMD_ARG_OPTIONAL, CMD_REPLY_QUERY },      // RATE:
+    { CMD_HISTOGRAMS,       CMD_ARG_OPTIONAL, CMD_REPLY_ALWAYS },     // HIST:
+    { CMD_SHOW_SCREEN,      CMD_ARG_REQUIRED, CMD_REPLY_NONE },
+    { CMD_CONFIG,           CMD_ARG_OPTIONAL, CMD_REPLY_ALWAYS },     // CFG:
+};
+
+uint8_t commandOpcode(CommandId id) {
+    for (uint8_t op = 1; op < CMD_OP_COUNT; op++) {
+        if (opcodeTable[op].id == id) return op;
+    }
+    return 0;
+}
+
+bool commandHasReply(const ParsedCommand& cmd) {
+    uint8_t op = commandOpcode(cmd.id);
+    if (op == 0) return false;
+    CommandReply reply = opcodeTable[op].reply;
+    return reply == CMD_REPLY_ALWAYS || (reply == CMD_REPLY_QUERY && cmd.argument[0] == '\0');
+}
+
+static uint16_t readCrc(const uint8_t* data) {
+    return (uint16_t)(data[0] | (data[1] << 8));
+}
+
+static void writeCrc(uint8_t* data, uint16_t crc) {
+    data[0] = (uint8_t)crc;
+    data[1] = (uint8_t)(crc >> 8);
+}
+
+CommandStatus parseCommandFrame(const uint8_t* data, size_t length, ParsedCommand& out) {
+    out.id = CMD_NONE;
+    out.argument[0] = '\0';
+    out.requestId = 0;
+
+    if (length < sizeof(CommandFrameHeader) || data[0] != CMD_FRAME_REQUEST) return CMD_STATUS_BAD_FRAME;
+    CommandFrameHeader header;
+    memcpy(&header, data, sizeof(header));
+    out.requestId = header.requestId;
+    if (header.requestId == 0 || header.length > CMD_FRAME_MAX_FIELDS_SIZE ||
+        length != sizeof(header) + header.length + 2) {
+        return CMD_STATUS_BAD_FRAME;
+    }
+    size_t crcOffset = sizeof(header) + header.length;
+    if (crc16(data, crcOffset) != readCrc(data + crcOffset)) return CMD_STATUS_BAD_CRC;
+    if (header.opcode == 0 || header.opcode >= CMD_OP_COUNT) return CMD_STATUS_UNKNOWN_OPCODE;
+    const OpcodeSyntax& syntax = opcodeTable[header.opcode];
+
+    // Fields -> "a:b:c", written straight into the fixed argument buffer
+    size_t argumentLength = 0;
+    const uint8_t* field = data + sizeof(header);
+    const uint8_t* end = data + crcOffset;
+    while (field < end) {
+        if (end - field < 2 || field[1] > end - field - 2) return CMD_STATUS_BAD_ARGUMENT;
+        uint8_t type = field[0];
+        uint8_t size = field[1];
+        const uint8_t* value = field + 2;
+        field = value + size;
+
+        char number[11];
+        const char* text;
+        size_t textLength;
+        if (type == CMD_TLV_TEXT) {
+            if (size == 0 || memchr(value, '\0', size)) return CMD_STATUS_BAD_ARGUMENT;
+            text = (const char*)value;
+            textLength = size;
+        } else if (type == CMD_TLV_UINT && (size == 1 || size == 2 || size == 4)) {
+            uint32_t n = 0;
+            for (int i = size - 1; i >= 0; i--) n = (n << 8) | value[i];
+            textLength = (size_t)snprintf(number, sizeof(number), "%lu", (unsigned long)n);
+            text = number;
+        } else {
+            return CMD_STATUS_BAD_ARGUMENT;
+        }
+
+        size_t separator = argumentLength > 0 ? 1 : 0;
+        if (argumentLength + separator + textLength > COMMAND_MAX_ARGUMENT) return CMD_STATUS_BAD_ARGUMENT;
+        if (separator) out.argument[argumentLength++] = ':';
+        memcpy(out.argument + argumentLength, text, textLength);
+        argumentLength += textLength;
+    }
+    out.argument[argumentLength] = '\0';
+
+    if ((syntax.argument == CMD_ARG_NONE && argumentLength > 0) ||
+        (syntax.argument == CMD_ARG_REQUIRED && argumentLength == 0)) {
+        out.argument[0] = '\0';
+        return CMD_STATUS_BAD_ARGUMENT;
+    }
+    out.id = syntax.id;
+    return CMD_STATUS_OK;
+}
+
+size_t encodeCommandResponse(uint8_t requestId, uint8_t opcode, CommandStatus status, uint8_t flags,
+                             const uint8_t* payload, size_t length, uint8_t* out) {
+    if (length > CMD_RESPONSE_MAX_PAYLOAD) length = CMD_RESPONSE_MAX_PAYLOAD;
+    CommandResponseHeader header = { CMD_FRAME_RESPONSE, requestId, opcode, status, flags, (uint8_t)length };
+    memcpy(out, &header, sizeof(header));
+    if (length > 0) memcpy(out + sizeof(header), payload, length);
+    size_t crcOffset = sizeof(header) + length;
+    writeCrc(out + crcOffset, crc16(out, crcOffset));
+    return crcOffset + 2;
+}
+
+bool parseCommandResponse(const uint8_t* data, size_t length, CommandResponseHeader& header,
+                          const uint8_t*& payload) {
+    if (length < sizeof(header) + 2 || data[0] != CMD_FRAME_RESPONSE) return false;
+    memcpy(&header, data, sizeof(header));
+    size_t crcOffset = sizeof(header) + header.length;
+    if (length != crcOffset + 2 || crc16(data, crcOffset) != readCrc(data + crcOffset)) return false;
+    payload = data + sizeof(header);
+    return true;
+}
+
+void CommandFrameBuilder::begin(uint8_t requestId, uint8_t opcode) {
+    CommandFrameHeader header = { CMD_FRAME_REQUEST, requestId, opcode, 0 };
+    memcpy(frame, &header, sizeof(header));
+    length = sizeof(header);
+    overflow = false;
+}
+
+bool CommandFrameBuilder::addField(uint8_t type, const uint8_t* value, size_t size) {
+    if (size > 255 || length + 2 + size > sizeof(CommandFrameHeader) + CMD_FRAME_MAX_FIELDS_SIZE) {
+        overflow = true;
+        return false;
+    }
+    frame[length++] = type;
+    frame[length++] = (uint8_t)size;
+    memcpy(frame + length, value, size);
+    length += size;
+    return true;
+}
+
+bool CommandFrameBuilder::addText(const char* text) {
+    return addField(CMD_TLV_TEXT, (const uint8_t*)text, strlen(text));
+}
+
+bool CommandFrameBuilder::addUint(uint32_t value) {
+    uint8_t bytes[4] = { (uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24) };
+    return addField(CMD_TLV_UINT, bytes, value > 0xFFFF ? 4 : value > 0xFF ? 2 : 1);
+}
+
+size_t CommandFrameBuilder::finish() {
+    if (overflow) return 0;
+    frame[3] = (uint8_t)(length - sizeof(CommandFrameHeader));
+    writeCrc(frame + length, crc16(frame, length));
+    return length + 2;
+}
+
+const char* commandStatusName(CommandStatus status) {
+    switch (status) {
+        case CMD_STATUS_OK:             return "OK";
+        case CMD_STATUS_ACCEPTED:       return "ACCEPTED";
+        case CMD_STATUS_BAD_FRAME:      return "BAD_FRAME";
+        case CMD_STATUS_BAD_CRC:        return "BAD_CRC";
+        case CMD_STATUS_UNKNOWN_OPCODE: return "UNKNOWN_OPCODE";
+        case CMD_STATUS_BAD_ARGUMENT:   return "BAD_ARGUMENT";
+        case CMD_STATUS_FAILED:         return "FAILED";
+        default:                        return "?";
+    }
+}
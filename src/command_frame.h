@@ -0,0 +1,134 @@
+#ifndef COMMAND_FRAME_H
+#define COMMAND_FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "command_parser.h"
+
+// ==============================================
+// BINARY COMMAND FRAMES (BLE config / file transfer characteristics)
+// ==============================================
+// Alternative to the text commands, accepted on the same characteristics.
+// Like the file-transfer frames, a binary frame starts with a byte >= 0x80,
+// which no text command does:
+//
+//   client -> device   CommandFrameHeader + TLV fields + CRC16 (crc16.h)
+//   device -> client   CommandResponseHeader + payload + CRC16, notified on
+//                      the file transfer characteristic
+//
+// Opcodes are looked up in a fixed table and decode to the same ParsedCommand
+// as the text form, so both reach the same dispatchCommand(). The TLV fields
+// become the text argument joined with ':' (CMD_TLV_UINT as decimal), e.g.
+// RATE with "BLE", 5, "AVG" is RATE:BLE:5:AVG.
+//
+// Every request is answered by one response carrying its request id:
+// CMD_STATUS_OK, an error status, or CMD_STATUS_ACCEPTED for commands whose
+// reply is produced later by the sink task. That reply follows with the same
+// request id, split over frames flagged CMD_RESPONSE_FLAG_MORE when it does
+// not fit one notification. Payloads are the text replies (CFG:..., RATE:...).
+// Parsing never allocates.
+
+#define CMD_FRAME_REQUEST           0xC1
+#define CMD_FRAME_RESPONSE          0xC2
+
+#define CMD_TLV_TEXT                0x01    // Verbatim, no NUL
+#define CMD_TLV_UINT                0x02    // 1, 2 or 4 bytes, little-endian
+
+#define CMD_FRAME_MAX_FIELDS_SIZE   96      // TLV bytes in one request
+#define CMD_FRAME_MAX_SIZE          (sizeof(CommandFrameHeader) + CMD_FRAME_MAX_FIELDS_SIZE + 2)
+#define CMD_RESPONSE_MAX_PAYLOAD    236     // MTU 247 minus ATT, header and CRC
+#define CMD_RESPONSE_MAX_SIZE       (sizeof(CommandResponseHeader) + CMD_RESPONSE_MAX_PAYLOAD + 2)
+
+#define CMD_RESPONSE_FLAG_MORE      0x01    // Reply continues in the next frame
+
+struct __attribute__((packed)) CommandFrameHeader {
+    uint8_t type;               // CMD_FRAME_REQUEST
+    uint8_t requestId;          // 1-255, chosen by the client (0 = text command)
+    uint8_t opcode;             // CommandOpcode
+    uint8_t length;             // TLV bytes that follow (then the CRC)
+};
+
+struct __attribute__((packed)) CommandResponseHeader {
+    uint8_t type;               // CMD_FRAME_RESPONSE
+    uint8_t requestId;
+    uint8_t opcode;
+    uint8_t status;             // CommandStatus
+    uint8_t flags;
+    uint8_t length;             // Payload bytes that follow (then the CRC)
+};
+
+// Wire opcodes: fixed, independent of the CommandId order
+enum CommandOpcode : uint8_t {
+    CMD_OP_START_LOG = 0x01,
+    CMD_OP_STOP_LOG,
+    CMD_OP_LIST_FILES,
+    CMD_OP_DOWNLOAD,
+    CMD_OP_DELETE,
+    CMD_OP_CANCEL_TRANSFER,
+    CMD_OP_TRANSFER_STATUS,
+    CMD_OP_CALIBRATE_IMU,
+    CMD_OP_REPLAY,
+    CMD_OP_STOP_REPLAY,
+    CMD_OP_BENCHMARK,
+    CMD_OP_PROBES,
+    CMD_OP_BLE_BATCH,
+    CMD_OP_UDP_BATCH,
+    CMD_OP_REPORT_POLICY,
+    CMD_OP_RATE,
+    CMD_OP_HISTOGRAMS,
+    CMD_OP_SHOW_SCREEN,
+    CMD_OP_CONFIG,
+    CMD_OP_COUNT
+};
+
+enum CommandStatus : uint8_t {
+    CMD_STATUS_OK = 0,
+    CMD_STATUS_ACCEPTED,        // Reply follows with the same request id
+    CMD_STATUS_BAD_FRAME,       // Truncated, oversized or request id 0
+    CMD_STATUS_BAD_CRC,
+    CMD_STATUS_UNKNOWN_OPCODE,
+    CMD_STATUS_BAD_ARGUMENT,    // Missing, unexpected, malformed or too long
+    CMD_STATUS_FAILED           // Reply payload says why (e.g. CFG:ERROR:...)
+};
+
+// Decodes one request. On CMD_STATUS_OK `out` holds the command and its
+// request id; otherwise out.requestId is still set when the header was
+// readable, so the error can be answered.
+CommandStatus parseCommandFrame(const uint8_t* data, size_t length, ParsedCommand& out);
+
+// Opcode of a command id, 0 when it has none
+uint8_t commandOpcode(CommandId id);
+// True when the command answers later (the response to the request is
+// ACCEPTED); REPORT and RATE only reply when asked without an argument
+bool commandHasReply(const ParsedCommand& cmd);
+
+// One response frame into out (>= CMD_RESPONSE_MAX_SIZE bytes); payloads
+// beyond CMD_RESPONSE_MAX_PAYLOAD are cut. Returns the frame length.
+size_t encodeCommandResponse(uint8_t requestId, uint8_t opcode, CommandStatus status, uint8_t flags,
+                             const uint8_t* payload, size_t length, uint8_t* out);
+
+// Validates a response frame; payload points into data
+bool parseCommandResponse(const uint8_t* data, size_t length, CommandResponseHeader& header,
+                          const uint8_t*& payload);
+
+// Client side: builds a request in a fixed buffer
+class CommandFrameBuilder {
+public:
+    void begin(uint8_t requestId, uint8_t opcode);
+    bool addText(const char* text);
+    bool addUint(uint32_t value);
+    // Appends the CRC; returns the frame length, 0 when a field did not fit
+    size_t finish();
+    const uint8_t* data() const { return frame; }
+
+private:
+    uint8_t frame[CMD_FRAME_MAX_SIZE];
+    size_t length;
+    bool overflow;
+
+    bool addField(uint8_t type, const uint8_t* value, size_t size);
+};
+
+const char* commandStatusName(CommandStatus status);
+
+#endif // COMMAND_FRAME_H
@@ -0,0 +1,70 @@
+#include "command_parser.h"
+#include <string.h>
+
+struct CommandSyntax {
+    CommandChannel channel;
+    const char* keyword;        // Commands with an argument end in ':'
+    CommandId id;
+};
+
+static const CommandSyntax commandTable[] = {
+    { COMMAND_CHANNEL_CONFIG, "START_LOG",       CMD_START_LOG },
+    { COMMAND_CHANNEL_CONFIG, "STOP_LOG",        CMD_STOP_LOG },
+    { COMMAND_CHANNEL_CONFIG, "LIST_FILES",      CMD_LIST_FILES },
+    { COMMAND_CHANNEL_CONFIG, "DOWNLOAD:",       CMD_DOWNLOAD },
+    { COMMAND_CHANNEL_CONFIG, "DELETE:",         CMD_DELETE },
+    { COMMAND_CHANNEL_CONFIG, "CANCEL_TRANSFER", CMD_CANCEL_TRANSFER },
+    { COMMAND_CHANNEL_CONFIG, "CALIBRATE_IMU",   CMD_CALIBRATE_IMU },
+    { COMMAND_CHANNEL_CONFIG, "REPLAY:",         CMD_REPLAY },
+    { COMMAND_CHANNEL_CONFIG, "STOP_REPLAY",     CMD_STOP_REPLAY },
+    { COMMAND_CHANNEL_CONFIG, "BENCH",           CMD_BENCHMARK },
+    { COMMAND_CHANNEL_CONFIG, "BENCH:",          CMD_BENCHMARK },
+    { COMMAND_CHANNEL_CONFIG, "PROBES",          CMD_PROBES },
+    { COMMAND_CHANNEL_CONFIG, "PROBES:",         CMD_PROBES },
+    { COMMAND_CHANNEL_CONFIG, "BATCH:",          CMD_BLE_BATCH },
+    { COMMAND_CHANNEL_CONFIG, "UDP_BATCH:",      CMD_UDP_BATCH },
+    { COMMAND_CHANNEL_CONFIG, "REPORT",          CMD_REPORT_POLICY },
+    { COMMAND_CHANNEL_CONFIG, "REPORT:",         CMD_REPORT_POLICY },
+    { COMMAND_CHANNEL_CONFIG, "RATE",            CMD_RATE },
+    { COMMAND_CHANNEL_CONFIG, "RATE:",           CMD_RATE },
+    { COMMAND_CHANNEL_CONFIG, "CFG",             CMD_CONFIG },
+    { COMMAND_CHANNEL_CONFIG, "CFG:",            CMD_CONFIG },
+    { COMMAND_CHANNEL_CONFIG, "HIST",            CMD_HISTOGRAMS },
+    { COMMAND_CHANNEL_CONFIG, "HIST:",           CMD_HISTOGRAMS },
+    { COMMAND_CHANNEL_CONFIG, "SCREEN:",         CMD_SHOW_SCREEN },
+    { COMMAND_CHANNEL_FILE,   "LIST",            CMD_LIST_FILES },
+    { COMMAND_CHANNEL_FILE,   "GET:",            CMD_DOWNLOAD },
+    { COMMAND_CHANNEL_FILE,   "DEL:",            CMD_DELETE },
+    { COMMAND_CHANNEL_FILE,   "STOP",            CMD_CANCEL_TRANSFER },
+    { COMMAND_CHANNEL_FILE,   "CANCEL",          CMD_CANCEL_TRANSFER },
+    { COMMAND_CHANNEL_FILE,   "STATUS",          CMD_TRANSFER_STATUS },
+};
+
+bool parseCommand(CommandChannel channel, const char* text, size_t length, ParsedCommand& out) {
+    out.id = CMD_NONE;
+    out.argument[0] = '\0';
+    out.requestId = 0;
+
+    for (size_t i = 0; i < sizeof(commandTable) / sizeof(commandTable[0]); i++) {
+        const CommandSyntax& syntax = commandTable[i];
+        if (syntax.channel != channel) continue;
+
+        size_t keywordLength = strlen(syntax.keyword);
+        bool hasArgument = syntax.keyword[keywordLength - 1] == ':';
+        if (length < keywordLength || memcmp(text, syntax.keyword, keywordLength) != 0) continue;
+
+        if (!hasArgument) {
+            if (length != keywordLength) continue;     // "STOP" must not match "STOP_LOG"
+            out.id = syntax.id;
+            return true;
+        }
+
+        size_t argumentLength = length - keywordLength;
+        if (argumentLength == 0 || argumentLength > COMMAND_MAX_ARGUMENT) return false;
+        memcpy(out.argument, text + keywordLength, argumentLength);
+        out.argument[argumentLength] = '\0';
+        out.id = syntax.id;
+        return true;
+    }
+    return false;
+}
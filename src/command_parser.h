@@ -0,0 +1,56 @@
+#ifndef COMMAND_PARSER_H
+#define COMMAND_PARSER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ==============================================
+// TEXT COMMAND PARSER
+// ==============================================
+// Turns a write on the config or file-transfer characteristic (or a line on
+// the serial console, which uses the config commands) into a command id plus
+// an optional argument, without touching any global state. Binary requests
+// (command_frame.h) decode to the same ParsedCommand.
+// gpscode.cpp dispatches the result; the host build drives it directly.
+
+#define COMMAND_MAX_ARGUMENT    63      // Longest file name argument
+
+enum CommandChannel : uint8_t {
+    COMMAND_CHANNEL_CONFIG,             // Config characteristic
+    COMMAND_CHANNEL_FILE                // File transfer characteristic (text commands)
+};
+
+enum CommandId : uint8_t {
+    CMD_NONE = 0,
+    CMD_START_LOG,
+    CMD_STOP_LOG,
+    CMD_LIST_FILES,
+    CMD_DOWNLOAD,                       // argument: file name
+    CMD_DELETE,                         // argument: file name
+    CMD_CANCEL_TRANSFER,
+    CMD_TRANSFER_STATUS,
+    CMD_CALIBRATE_IMU,
+    CMD_REPLAY,                         // argument: file name, optionally ":speed" (0 = as fast as possible)
+    CMD_STOP_REPLAY,
+    CMD_BENCHMARK,                      // argument (optional): benchmark name filter
+    CMD_PROBES,                         // argument (optional): RESET clears the counters after the report
+    CMD_BLE_BATCH,                      // argument: max batching latency in ms, 0 = one notification per sample
+    CMD_UDP_BATCH,                      // argument: max datagram bytes, optionally ":ms" deadline (0 = one sample each)
+    CMD_REPORT_POLICY,                  // argument (optional): "<BLE|UDP>:<OFF|ON|key=value,...>" (report_policy.h)
+    CMD_RATE,                           // argument (optional): "<SD|BLE|UDP|UI>:<hz>[:AVG|LAST]" (rate_control.h)
+    CMD_CONFIG,                         // argument (optional): "RESET", "<key>" or "<key>=<value>" (config_registry.h)
+    CMD_HISTOGRAMS,                     // argument (optional): EXPORT writes the binary export to SD
+    CMD_SHOW_SCREEN,                    // argument: ScreenType number
+    CMD_COUNT
+};
+
+struct ParsedCommand {
+    CommandId id;
+    char argument[COMMAND_MAX_ARGUMENT + 1];
+    uint8_t requestId;                  // Binary frames (command_frame.h), 0 = text command
+};
+
+// Returns false for unknown commands, missing or oversized arguments.
+bool parseCommand(CommandChannel channel, const char* text, size_t length, ParsedCommand& out);
+
+#endif // COMMAND_PARSER_H
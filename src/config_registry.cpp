@@ -0,0 +1,241 @@
+#include "config_registry.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+ConfigRegistry::ConfigRegistry(const ConfigEntry* table, int entryCount) :
+    entries(table),
+    count(entryCount < CONFIG_MAX_ENTRIES ? entryCount : CONFIG_MAX_ENTRIES),
+    dirty(0),
+    erase(0),
+    listenerCount(0)
+{
+    memset(texts, 0, sizeof(texts));
+    memset(stagedTexts, 0, sizeof(stagedTexts));
+    memset(textBegun, 0, sizeof(textBegun));
+    memset(textDone, 0, sizeof(textDone));
+    int slot = 0;
+    for (int id = 0; id < count; id++) {
+        if (entries[id].type == CONFIG_TYPE_TEXT) {
+            values[id] = slot < CONFIG_MAX_TEXTS ? slot++ : CONFIG_MAX_TEXTS - 1;
+            strncpy(texts[values[id]], entries[id].defaultText ? entries[id].defaultText : "", CONFIG_TEXT_MAX);
+        } else {
+            values[id] = entries[id].defaultValue;
+        }
+        staged[id] = values[id];
+    }
+    memcpy(stagedTexts, texts, sizeof(texts));
+}
+
+const char* configResultName(ConfigResult result) {
+    switch (result) {
+        case CONFIG_OK:             return "OK";
+        case CONFIG_UNKNOWN_KEY:    return "UNKNOWN_KEY";
+        case CONFIG_BAD_VALUE:      return "BAD_VALUE";
+        case CONFIG_OUT_OF_RANGE:   return "OUT_OF_RANGE";
+        default:                    return "?";
+    }
+}
+
+static bool fits(const ConfigEntry& entry, uint32_t value) {
+    if (entry.type == CONFIG_TYPE_BOOL) return value <= 1;
+    return value >= entry.minValue && value <= entry.maxValue;
+}
+
+static size_t textLimit(const ConfigEntry& entry) {
+    return entry.maxValue > 0 && entry.maxValue < CONFIG_TEXT_MAX ? entry.maxValue : CONFIG_TEXT_MAX;
+}
+
+void ConfigRegistry::load(ConfigStore& store) {
+    for (int id = 0; id < count; id++) {
+        const ConfigEntry& entry = entries[id];
+        if (entry.type == CONFIG_TYPE_TEXT) {
+            uint8_t text[CONFIG_TEXT_MAX + 1];
+            size_t length = store.read(entry.key, text, sizeof(text));
+            if (length == 0) continue;
+            if (length > textLimit(entry) || memchr(text, '\0', length)) {
+                stats.rejected++;
+                continue;
+            }
+            memcpy(texts[values[id]], text, length);
+            texts[values[id]][length] = '\0';
+            memcpy(stagedTexts[values[id]], texts[values[id]], sizeof(texts[0]));
+        } else {
+            uint32_t value;
+            size_t length = store.read(entry.key, (uint8_t*)&value, sizeof(value));
+            if (length == 0) continue;
+            if (length != sizeof(value) || !fits(entry, value)) {
+                stats.rejected++;
+                continue;
+            }
+            values[id] = staged[id] = value;
+        }
+        stats.loaded++;
+    }
+}
+
+int ConfigRegistry::find(const char* key) const {
+    for (int id = 0; id < count; id++) {
+        if (strcmp(entries[id].key, key) == 0) return id;
+    }
+    return -1;
+}
+
+const char* ConfigRegistry::getText(int id) const {
+    return entries[id].type == CONFIG_TYPE_TEXT ? texts[values[id]] : "";
+}
+
+// Any task: bracket the copy so service() can tell it was not torn
+void ConfigRegistry::stageText(uint32_t slot, const char* text) {
+    __atomic_fetch_add(&textBegun[slot], 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    strncpy(stagedTexts[slot], text, CONFIG_TEXT_MAX);
+    stagedTexts[slot][CONFIG_TEXT_MAX] = '\0';
+    __atomic_fetch_add(&textDone[slot], 1, __ATOMIC_RELEASE);
+}
+
+// False when a stageText() was in progress before or during the copy
+bool ConfigRegistry::copyStagedText(uint32_t slot, char* out) const {
+    uint32_t current = __atomic_load_n(&textDone[slot], __ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&textBegun[slot], __ATOMIC_RELAXED) != current) return false;
+    memcpy(out, stagedTexts[slot], CONFIG_TEXT_MAX + 1);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    out[CONFIG_TEXT_MAX] = '\0';
+    return __atomic_load_n(&textBegun[slot], __ATOMIC_RELAXED) == current;
+}
+
+ConfigResult ConfigRegistry::set(int id, const char* text) {
+    if (id < 0 || id >= count) return CONFIG_UNKNOWN_KEY;
+    const ConfigEntry& entry = entries[id];
+    uint32_t value = 0;
+
+    switch (entry.type) {
+        case CONFIG_TYPE_BOOL:
+            if (strcmp(text, "1") == 0 || strcmp(text, "true") == 0 || strcmp(text, "ON") == 0) {
+                value = 1;
+            } else if (strcmp(text, "0") != 0 && strcmp(text, "false") != 0 && strcmp(text, "OFF") != 0) {
+                return CONFIG_BAD_VALUE;
+            }
+            break;
+        case CONFIG_TYPE_UINT: {
+            char* end;
+            unsigned long parsed = strtoul(text, &end, 10);
+            if (end == text || *end != '\0' || text[0] == '-') return CONFIG_BAD_VALUE;
+            if (parsed > UINT32_MAX || !fits(entry, (uint32_t)parsed)) return CONFIG_OUT_OF_RANGE;
+            value = (uint32_t)parsed;
+            break;
+        }
+        case CONFIG_TYPE_TEXT: {
+            size_t length = strlen(text);
+            if (length > textLimit(entry)) return CONFIG_BAD_VALUE;
+            stageText(values[id], text);
+            break;
+        }
+    }
+
+    if (entry.type != CONFIG_TYPE_TEXT) staged[id] = value;
+    __atomic_fetch_and(&erase, ~(1UL << id), __ATOMIC_SEQ_CST);
+    __atomic_fetch_or(&dirty, 1UL << id, __ATOMIC_SEQ_CST);
+    return CONFIG_OK;
+}
+
+void ConfigRegistry::resetAll() {
+    for (int id = 0; id < count; id++) {
+        const ConfigEntry& entry = entries[id];
+        if (entry.type == CONFIG_TYPE_TEXT) {
+            stageText(values[id], entry.defaultText ? entry.defaultText : "");
+        } else {
+            staged[id] = entry.defaultValue;
+        }
+    }
+    uint32_t all = count >= 32 ? UINT32_MAX : (1UL << count) - 1;
+    __atomic_fetch_or(&erase, all, __ATOMIC_SEQ_CST);
+    __atomic_fetch_or(&dirty, all, __ATOMIC_SEQ_CST);
+}
+
+bool ConfigRegistry::subscribe(uint16_t scopes, ConfigListener listener) {
+    if (!listener || listenerCount >= CONFIG_MAX_LISTENERS) return false;
+    listeners[listenerCount].scopes = scopes;
+    listeners[listenerCount].listener = listener;
+    listenerCount++;
+    return true;
+}
+
+int ConfigRegistry::service(ConfigStore& store) {
+    uint32_t pending = __atomic_exchange_n(&dirty, 0, __ATOMIC_SEQ_CST);
+    if (!pending) return 0;
+    uint32_t erasing = __atomic_exchange_n(&erase, 0, __ATOMIC_SEQ_CST) & pending;
+
+    int changed = 0;
+    for (int id = 0; id < count; id++) {
+        if (!(pending & (1UL << id))) continue;
+        const ConfigEntry& entry = entries[id];
+        bool isText = entry.type == CONFIG_TYPE_TEXT;
+        char text[CONFIG_TEXT_MAX + 1];
+        if (isText && !copyStagedText(values[id], text)) {
+            // Being set right now: leave it staged for the next pass
+            if (erasing & (1UL << id)) __atomic_fetch_or(&erase, 1UL << id, __ATOMIC_SEQ_CST);
+            __atomic_fetch_or(&dirty, 1UL << id, __ATOMIC_SEQ_CST);
+            continue;
+        }
+
+        bool ok;
+        if (erasing & (1UL << id)) {
+            ok = store.erase(entry.key);
+        } else if (isText) {
+            ok = store.write(entry.key, (const uint8_t*)text, strlen(text));
+        } else {
+            ok = store.write(entry.key, (const uint8_t*)&staged[id], sizeof(staged[id]));
+        }
+        stats.writes++;
+        if (!ok) stats.writeFailures++;
+
+        if (entry.scopes & CONFIG_SCOPE_BOOT) continue;
+        if (isText) {
+            if (strcmp(texts[values[id]], text) == 0) continue;
+            memcpy(texts[values[id]], text, sizeof(texts[0]));
+        } else {
+            if (values[id] == staged[id]) continue;
+            values[id] = staged[id];
+        }
+        notify(id);
+        changed++;
+    }
+    return changed;
+}
+
+void ConfigRegistry::notify(int id) {
+    for (int i = 0; i < listenerCount; i++) {
+        if (listeners[i].scopes & entries[id].scopes) {
+            listeners[i].listener(id);
+            stats.notifications++;
+        }
+    }
+}
+
+void ConfigRegistry::notifyAll() {
+    for (int id = 0; id < count; id++) {
+        notify(id);
+    }
+}
+
+size_t ConfigRegistry::format(int id, char* out, size_t size) const {
+    if (size == 0) return 0;
+    if (id < 0 || id >= count) {
+        out[0] = '\0';
+        return 0;
+    }
+    const ConfigEntry& entry = entries[id];
+    int n;
+    if (entry.type == CONFIG_TYPE_TEXT) {
+        char text[CONFIG_TEXT_MAX + 1];
+        bool next = copyStagedText(values[id], text) && strcmp(texts[values[id]], text) != 0;
+        n = snprintf(out, size, next ? "%s=%s->%s" : "%s=%s", entry.key, texts[values[id]], text);
+    } else {
+        bool next = values[id] != staged[id];
+        n = snprintf(out, size, next ? "%s=%lu->%lu" : "%s=%lu", entry.key, (unsigned long)values[id],
+                     (unsigned long)staged[id]);
+    }
+    if (n < 0) return 0;
+    return (size_t)n < size ? (size_t)n : size - 1;
+}
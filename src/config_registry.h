@@ -0,0 +1,126 @@
+#ifndef CONFIG_REGISTRY_H
+#define CONFIG_REGISTRY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "platform_io.h"
+
+// ==============================================
+// TYPED CONFIGURATION REGISTRY
+// ==============================================
+// A fixed table of settings (ConfigEntry), each with a type, a range, a
+// build default and the subsystems that care about it. load() applies the
+// defaults and then whatever the ConfigStore (NVS on the board) holds;
+// values that no longer fit the table are ignored, so a firmware update with
+// tighter ranges never boots with a bad value.
+//
+// set() may be called from any task: it only stages the value. service(),
+// always from the same task, persists staged values, makes them live and
+// calls the listeners subscribed to the entry's scopes. Staged text is handed
+// over with StagedReportPolicy's begun/done generations: service() copies a
+// slot only when no set() was writing it, and retries on its next pass
+// otherwise, so a half-written value never reaches the store. CONFIG_SCOPE_BOOT
+// entries are persisted but stay at their boot value until the next restart.
+
+#define CONFIG_MAX_ENTRIES      32      // Dirty flags are one 32-bit mask
+#define CONFIG_MAX_TEXTS        4       // Text entries (each CONFIG_TEXT_MAX long)
+#define CONFIG_TEXT_MAX         31
+#define CONFIG_KEY_MAX          15      // NVS key limit
+#define CONFIG_MAX_LISTENERS    8
+#define CONFIG_LINE_SIZE        64      // One format() line
+
+enum ConfigType : uint8_t {
+    CONFIG_TYPE_BOOL,
+    CONFIG_TYPE_UINT,
+    CONFIG_TYPE_TEXT
+};
+
+// Who is told about a change (bit mask, application-defined above BOOT)
+enum ConfigScope : uint16_t {
+    CONFIG_SCOPE_BOOT = 0x0001          // Read once at boot; changes apply after a restart
+};
+
+struct ConfigEntry {
+    const char* key;            // NVS key and command name, <= CONFIG_KEY_MAX
+    ConfigType type;
+    uint32_t minValue;          // UINT only
+    uint32_t maxValue;          // UINT only; TEXT: longest value
+    uint32_t defaultValue;      // BOOL/UINT
+    const char* defaultText;    // TEXT
+    uint16_t scopes;
+};
+
+enum ConfigResult : uint8_t {
+    CONFIG_OK = 0,
+    CONFIG_UNKNOWN_KEY,
+    CONFIG_BAD_VALUE,           // Not a number/bool, or too long
+    CONFIG_OUT_OF_RANGE
+};
+
+struct ConfigStats {
+    uint32_t loaded = 0;        // Entries taken from the store at boot
+    uint32_t rejected = 0;      // Stored values that did not fit the table
+    uint32_t writes = 0;
+    uint32_t writeFailures = 0;
+    uint32_t notifications = 0;
+};
+
+typedef void (*ConfigListener)(int id);
+
+class ConfigRegistry {
+public:
+    ConfigRegistry(const ConfigEntry* entries, int count);
+
+    // Defaults, then the stored values. Call once, before any get().
+    void load(ConfigStore& store);
+
+    int find(const char* key) const;
+    int getCount() const { return count; }
+    const ConfigEntry& getEntry(int id) const { return entries[id]; }
+
+    // Live values (any task)
+    uint32_t get(int id) const { return values[id]; }
+    bool getBool(int id) const { return values[id] != 0; }
+    const char* getText(int id) const;
+
+    // Stage a value from its text form ("1"/"0"/"true"/"false", decimal, or
+    // text); applied by the next service()
+    ConfigResult set(int id, const char* text);
+    // Stage every entry back to its default (stored keys are erased)
+    void resetAll();
+
+    bool subscribe(uint16_t scopes, ConfigListener listener);
+
+    // Persist and apply staged values, then notify. Returns entries changed.
+    int service(ConfigStore& store);
+    // Call every listener once for every entry, e.g. after load()
+    void notifyAll();
+
+    // "key=value", with "->next" when a boot entry changes at the next restart
+    size_t format(int id, char* out, size_t size) const;
+
+    const ConfigStats& getStats() const { return stats; }
+
+private:
+    const ConfigEntry* entries;
+    int count;
+    uint32_t values[CONFIG_MAX_ENTRIES];        // Live; TEXT entries hold their text slot
+    uint32_t staged[CONFIG_MAX_ENTRIES];        // Last value set (= stored value once serviced)
+    char texts[CONFIG_MAX_TEXTS][CONFIG_TEXT_MAX + 1];
+    char stagedTexts[CONFIG_MAX_TEXTS][CONFIG_TEXT_MAX + 1];
+    uint32_t textBegun[CONFIG_MAX_TEXTS];       // Staged text writes started
+    uint32_t textDone[CONFIG_MAX_TEXTS];        // Staged text writes finished
+    volatile uint32_t dirty;                    // Staged but not serviced
+    volatile uint32_t erase;                    // Staged back to the default: drop the stored key
+    struct { uint16_t scopes; ConfigListener listener; } listeners[CONFIG_MAX_LISTENERS];
+    int listenerCount;
+    ConfigStats stats;
+
+    void notify(int id);
+    void stageText(uint32_t slot, const char* text);
+    bool copyStagedText(uint32_t slot, char* out) const;
+};
+
+const char* configResultName(ConfigResult result);
+
+#endif // CONFIG_REGISTRY_H
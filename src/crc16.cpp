@@ -0,0 +1,134 @@
+#include "crc16.h"
+
+#ifdef ARDUINO
+#include <esp_rom_crc.h>
+#endif
+
+#define CRC16_POLY 0x1021
+
+// crcTables[0] is the classic byte table; [1..3] extend it for slice-by-4
+static uint16_t crcTables[4][256];
+static volatile bool crcTablesReady = false;
+
+// Building the tables twice from two tasks is harmless: both write identical values
+static void buildTables() {
+    for (int i = 0; i < 256; i++) {
+        uint16_t crc = (uint16_t)(i << 8);
+        for (int j = 0; j < 8; j++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ CRC16_POLY) : (uint16_t)(crc << 1);
+        }
+        crcTables[0][i] = crc;
+    }
+    for (int i = 0; i < 256; i++) {
+        for (int t = 1; t < 4; t++) {
+            uint16_t prev = crcTables[t - 1][i];
+            crcTables[t][i] = (uint16_t)((prev << 8) ^ crcTables[0][prev >> 8]);
+        }
+    }
+    crcTablesReady = true;
+}
+
+uint16_t crc16Bitwise(uint16_t crc, const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t j = 0; j < 8; j++) {
+            if (crc & 0x8000)
+                crc = (crc << 1) ^ CRC16_POLY;
+            else
+                crc <<= 1;
+        }
+    }
+    return crc;
+}
+
+uint16_t crc16Table(uint16_t crc, const uint8_t* data, size_t length) {
+    if (!crcTablesReady) buildTables();
+    const uint16_t* table = crcTables[0];
+    while (length--) {
+        crc = (uint16_t)((crc << 8) ^ table[(crc >> 8) ^ *data++]);
+    }
+    return crc;
+}
+
+// Four input bytes per step: the 16-bit CRC is folded into the first two bytes,
+// then each byte is looked up in the table that accounts for its distance to the end.
+uint16_t crc16Slice4(uint16_t crc, const uint8_t* data, size_t length) {
+    if (!crcTablesReady) buildTables();
+    while (length >= 4) {
+        uint8_t b0 = data[0] ^ (uint8_t)(crc >> 8);
+        uint8_t b1 = data[1] ^ (uint8_t)crc;
+        crc = crcTables[3][b0] ^ crcTables[2][b1] ^ crcTables[1][data[2]] ^ crcTables[0][data[3]];
+        data += 4;
+        length -= 4;
+    }
+    return crc16Table(crc, data, length);
+}
+
+#ifdef ARDUINO
+// The ROM routine inverts the CRC on entry and exit; undo that to stay in XMODEM form
+uint16_t crc16Rom(uint16_t crc, const uint8_t* data, size_t length) {
+    return (uint16_t)~esp_rom_crc16_be((uint16_t)~crc, data, (uint32_t)length);
+}
+#endif
+
+typedef uint16_t (*Crc16Function)(uint16_t crc, const uint8_t* data, size_t length);
+
+#if CRC16_IMPL == CRC16_IMPL_ROM && defined(ARDUINO)
+static Crc16Function crcSelected = crc16Rom;
+static const char* crcSelectedName = "rom";
+#elif CRC16_IMPL == CRC16_IMPL_ROM || CRC16_IMPL == CRC16_IMPL_SLICE4
+static Crc16Function crcSelected = crc16Slice4;
+static const char* crcSelectedName = "slice4";
+#elif CRC16_IMPL == CRC16_IMPL_TABLE
+static Crc16Function crcSelected = crc16Table;
+static const char* crcSelectedName = "table";
+#else
+static Crc16Function crcSelected = crc16Bitwise;
+static const char* crcSelectedName = "bitwise";
+#endif
+
+uint16_t crc16Update(uint16_t crc, const uint8_t* data, size_t length) {
+    return crcSelected(crc, data, length);
+}
+
+const char* crc16ImplName() {
+    return crcSelectedName;
+}
+
+// Odd lengths and split buffers exercise the slice tail and incremental paths
+static bool agreesWithBitwise(Crc16Function fn) {
+    uint8_t pattern[67];
+    for (size_t i = 0; i < sizeof(pattern); i++) {
+        pattern[i] = (uint8_t)(i * 37 + 11);
+    }
+
+    for (size_t len = 0; len <= sizeof(pattern); len++) {
+        uint16_t expected = crc16Bitwise(CRC16_INIT, pattern, len);
+        size_t split = len / 3;
+        if (fn(CRC16_INIT, pattern, len) != expected) return false;
+        if (fn(fn(CRC16_INIT, pattern, split), pattern + split, len - split) != expected) return false;
+    }
+    return true;
+}
+
+bool crc16SelfTest() {
+    // Standard check value for CRC-16/XMODEM
+    static const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    if (crc16Bitwise(CRC16_INIT, check, sizeof(check)) != 0x31C3) return false;
+
+    bool all = agreesWithBitwise(crc16Table) && agreesWithBitwise(crc16Slice4);
+#ifdef ARDUINO
+    all &= agreesWithBitwise(crc16Rom);
+#endif
+    if (agreesWithBitwise(crcSelected)) return all;
+
+    // The selected routine is wrong: fall back to the fastest one that is right
+    if (agreesWithBitwise(crc16Slice4)) {
+        crcSelected = crc16Slice4;
+        crcSelectedName = "slice4";
+    } else {
+        crcSelected = crc16Bitwise;
+        crcSelectedName = "bitwise";
+    }
+    return false;
+}
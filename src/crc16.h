@@ -0,0 +1,53 @@
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ==============================================
+// CRC16 (CCITT polynomial 0x1021, init 0x0000, no reflection - a.k.a. XMODEM)
+// ==============================================
+// Every variant produces the same value as the original bit-at-a-time loop.
+// All functions take the running CRC, so a CRC over discontiguous buffers is
+//   crc = crc16Update(crc16Update(CRC16_INIT, a, aLen), b, bLen);
+
+#define CRC16_INIT          0x0000
+
+// Implementation selected for crc16()/crc16Update()
+#define CRC16_IMPL_BITWISE  0
+#define CRC16_IMPL_TABLE    1
+#define CRC16_IMPL_SLICE4   2
+#define CRC16_IMPL_ROM      3
+
+#ifndef CRC16_IMPL
+#ifdef ARDUINO
+#define CRC16_IMPL          CRC16_IMPL_ROM      // ESP32-S3 ROM routine, no flash/cache footprint
+#else
+#define CRC16_IMPL          CRC16_IMPL_SLICE4
+#endif
+#endif
+
+// Individual implementations (all exposed for the benchmark and self-test)
+uint16_t crc16Bitwise(uint16_t crc, const uint8_t* data, size_t length);
+uint16_t crc16Table(uint16_t crc, const uint8_t* data, size_t length);
+uint16_t crc16Slice4(uint16_t crc, const uint8_t* data, size_t length);
+#ifdef ARDUINO
+uint16_t crc16Rom(uint16_t crc, const uint8_t* data, size_t length);
+#endif
+
+// Selected implementation (CRC16_IMPL, or the fallback crc16SelfTest() switched to)
+uint16_t crc16Update(uint16_t crc, const uint8_t* data, size_t length);
+const char* crc16ImplName();
+
+// One-shot CRC of a single buffer
+inline uint16_t crc16(const uint8_t* data, size_t length) {
+    return crc16Update(CRC16_INIT, data, length);
+}
+
+// Cross-check every implementation against the bitwise reference. Returns true when all agree.
+// When the selected one disagrees, crc16Update() switches to crc16Slice4 (or, should
+// that fail too, the bitwise reference), so packet CRCs stay correct either way.
+// Call it once at startup, before any task computes CRCs.
+bool crc16SelfTest();
+
+#endif // CRC16_H
@@ -4,6 +4,28 @@
 #include <Arduino.h>
 #include <FS.h>
 #include <SD.h>
+#include "gps_packet.h"
+#include "sensor_data.h"
+#include "file_transfer_protocol.h"
+#include "sd_storage.h"
+
+// Parameters negotiated for the current BLE connection, plus notify throughput
+struct BleLinkState {
+    bool connected = false;
+    uint16_t connId = 0;
+    uint8_t peerAddress[6] = {0};
+    uint16_t mtu = 23;                  // ATT MTU (notification payload is mtu - 3)
+    bool mtuNegotiated = false;
+    uint16_t txOctets = 27;             // LL data length (DLE), bytes per air packet
+    uint16_t connInterval = 0;          // 1.25 ms units
+    uint16_t latency = 0;               // Connection events the peripheral may skip
+    uint16_t supervisionTimeout = 0;    // 10 ms units
+    uint32_t notifications = 0;
+    uint32_t notifyBytes = 0;
+    uint32_t notifyErrors = 0;
+    uint32_t oversizeDrops = 0;         // Payloads that did not fit the MTU
+    uint32_t throughputBps = 0;         // Notify payload bytes/s over the last second
+};
 
 // System state data
 struct SystemData {
@@ -17,47 +39,7 @@ struct SystemData {
     const unsigned long DISPLAY_TIMEOUT = 60000;
     int currentScreen = 0;
     const int MAX_SCREENS = 4;
-    uint16_t currentMTU = 23;
-};
-
-// GPS data structure
-struct GPSData {
-    uint32_t timestamp = 0;
-    float latitude = 0.0;
-    float longitude = 0.0;
-    int32_t altitude = 0; // meters
-    float speed = 0.0; // km/h
-    float heading = 0.0; // degrees
-    uint8_t fixType = 0;
-    uint8_t satellites = 0;
-    uint16_t year = 0;
-    uint8_t month = 0;
-    uint8_t day = 0;
-    uint8_t hour = 0;
-    uint8_t minute = 0;
-    uint8_t second = 0;
-};
-
-// IMU data structure
-struct IMUData {
-    float accelX = 0.0, accelY = 0.0, accelZ = 0.0;
-    float gyroX = 0.0, gyroY = 0.0, gyroZ = 0.0;
-    float temperature = 0.0;
-    float magnitude = 0.0;
-    bool motionDetected = false;
-    unsigned long lastMotionTime = 0;
-    
-    // Calibration data
-    float accelOffsetX = 0.0;
-    float accelOffsetY = 0.0;
-    float accelOffsetZ = 0.0;
-    float gyroOffsetX = 0.0;
-    float gyroOffsetY = 0.0;
-    float gyroOffsetZ = 0.0;
-    bool isCalibrated = false;
-    unsigned long calibrationStartTime = 0;
-    int calibrationSamples = 0;
-    bool calibrationInProgress = false;
+    BleLinkState bleLink;
 };
 
 // Enhanced battery monitoring with basic ADC monitoring for JC3248W535EN
@@ -78,48 +60,104 @@ struct BatteryData {
 struct PerformanceStats {
     unsigned long totalPackets = 0;
     unsigned long droppedPackets = 0;
-    unsigned long minDelta = 9999;
-    unsigned long maxDelta = 0;
-    unsigned long avgDelta = 0;
-    unsigned long lastResetTime = 0;
+};
+
+// MPU6xxx register read timing (microseconds)
+struct ImuReadStats {
+    uint32_t reads = 0;
+    uint32_t errors = 0;            // Short or NACKed burst reads
+    uint32_t lastReadUs = 0;
+    uint32_t maxReadUs = 0;
+    uint64_t totalReadUs = 0;
+};
+
+// MPU FIFO sampler statistics (see imu_sampler.h)
+struct ImuSamplerStats {
+    uint32_t samples = 0;
+    uint32_t batches = 0;           // FIFO drains
+    uint32_t interrupts = 0;        // Data-ready edges
+    uint32_t fifoOverflows = 0;     // FIFO filled up before it was drained - samples lost
+    uint32_t resyncs = 0;           // FIFO count not a whole number of records
+    uint32_t readErrors = 0;
+    uint32_t maxBatch = 0;          // Most records drained at once
+    uint32_t lastDrainUs = 0;
+    uint32_t maxDrainUs = 0;
+};
+
+// Fusion engine update cost (microseconds)
+struct FusionTimingStats {
+    uint32_t lastPredictUs = 0;
+    uint32_t maxPredictUs = 0;
+    uint32_t lastCorrectUs = 0;
+    uint32_t maxCorrectUs = 0;
+    uint32_t published = 0;         // States pushed onto the fusion bus
+};
+
+// Per-task timing statistics for the FreeRTOS pipeline (all times in microseconds)
+struct TaskTimingStats {
+    uint32_t iterations = 0;
+    uint32_t lastExecUs = 0;
+    uint32_t maxExecUs = 0;
+    uint64_t totalExecUs = 0;
+    uint32_t overruns = 0;          // Iterations that exceeded the task period
+    uint32_t queueDrops = 0;        // Samples lost downstream (ring overruns seen by this task's consumers)
+    uint32_t queueHighWater = 0;    // Deepest backlog seen on the task's input
+    uint32_t stackHighWater = 0;    // Minimum free stack (words) reported by FreeRTOS
+};
+
+// Per-sink callback cost on the sink task. How long samples waited on the bus
+// (ingest timestamp -> callback start) is kept in the pipeline's histograms.
+struct SinkTimingStats {
+    uint32_t samples = 0;
+    uint32_t maxExecUs = 0;         // Callback duration for one sample
+    uint64_t totalExecUs = 0;
+};
+
+// Background SD logger statistics
+struct SdLoggerStats {
+    uint32_t bytesWritten = 0;
+    uint32_t blocksWritten = 0;
+    uint32_t recordsDropped = 0;    // Block pool exhausted or write failed
+    uint32_t writeErrors = 0;
+    uint32_t flushes = 0;           // FAT syncs (file.flush())
+    uint32_t lastWriteUs = 0;
+    uint32_t maxWriteUs = 0;
+    uint64_t totalWriteUs = 0;
+    uint32_t bytesPerSecond = 0;
+    uint32_t queueHighWater = 0;    // Most blocks waiting for the writer at once
+};
+
+// GNSS epoch tracking for the ingest task
+struct EpochStats {
+    uint32_t epochs = 0;
+    uint32_t missedEpochs = 0;      // Gaps longer than 1.5x the nominal nav period
+    uint32_t maxGapUs = 0;
+    int64_t lastEpochUs = 0;
 };
 
 // Enhanced File transfer state
 struct FileTransferState {
     bool active = false;
     bool listingFiles = false;
-    File transferFile;
+    SdStorageFile transferFile;
     String filename = "";
     size_t fileSize = 0;
-    size_t bytesSent = 0;
+    size_t bytesSent = 0;                   // Bytes acknowledged by the client
     unsigned long lastChunkTime = 0;
-    uint16_t currentMTU = 23;
-    bool mtuNegotiated = false;
     float progressPercent = 0.0f;
     unsigned long transferStartTime = 0;
-    unsigned long estimatedTimeRemaining = 0;
+    unsigned long estimatedTimeRemaining = 0;   // ms
+    FtSender sender;                        // Window/ack state (file_transfer_protocol.h)
+    uint16_t payloadSize = 0;               // Data bytes per notification for this transfer
+    uint32_t throughputBps = 0;             // Acknowledged bytes per second since start
+    uint8_t stalledTimeouts = 0;            // Consecutive ack timeouts without progress
 };
 
-// GPS Packet Structure (42 bytes) for transmission
-struct __attribute__((packed)) GPSPacket {
-    uint32_t timestamp;      // Unix epoch (4 bytes)
-    int32_t latitude;        // deg * 1e7 (4 bytes)
-    int32_t longitude;       // deg * 1e7 (4 bytes)
-    int32_t altitude;        // mm (4 bytes)
-    uint16_t speed;          // mm/s (2 bytes)
-    uint32_t heading;        // deg * 1e5 (4 bytes)
-    uint8_t fixType;         // 0-5 (1 byte)
-    uint8_t satellites;      // count (1 byte)
-    uint16_t battery_mv;     // mV (2 bytes)
-    uint8_t battery_pct;     // % (1 byte)
-    
-    int16_t accel_x;         // mg (2 bytes)
-    int16_t accel_y;         // mg (2 bytes) 
-    int16_t accel_z;         // mg (2 bytes)
-    int16_t gyro_x;          // deg/s * 100 (2 bytes)
-    int16_t gyro_y;          // deg/s * 100 (2 bytes)
-    uint8_t pmu_status;      // PMU status flags (1 byte)
-    uint16_t crc;            // CRC16 (2 bytes)
+// Timestamped sample published on the telemetry ring (see telemetry_ring.h)
+struct TelemetrySample {
+    int64_t timestampUs = 0;    // esp_timer_get_time() at ingest
+    uint32_t sequence = 0;      // Monotonic per ingested sample
+    GPSPacket packet;
 };
 
 // Screen types for the UI
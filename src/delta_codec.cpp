@@ -0,0 +1,134 @@
+#include "delta_codec.h"
+#include "crc16.h"
+#include <string.h>
+
+// Field values are carried as uint32 so deltas wrap consistently for signed and unsigned fields
+static void packetToFields(const GPSPacket& p, uint32_t* f) {
+    f[DELTA_FIELD_TIMESTAMP] = p.timestamp;
+    f[DELTA_FIELD_LATITUDE] = (uint32_t)p.latitude;
+    f[DELTA_FIELD_LONGITUDE] = (uint32_t)p.longitude;
+    f[DELTA_FIELD_ALTITUDE] = (uint32_t)p.altitude;
+    f[DELTA_FIELD_SPEED] = p.speed;
+    f[DELTA_FIELD_HEADING] = p.heading;
+    f[DELTA_FIELD_FIX_TYPE] = p.fixType;
+    f[DELTA_FIELD_SATELLITES] = p.satellites;
+    f[DELTA_FIELD_BATTERY_MV] = p.battery_mv;
+    f[DELTA_FIELD_BATTERY_PCT] = p.battery_pct;
+    f[DELTA_FIELD_ACCEL_X] = (uint32_t)(int32_t)p.accel_x;
+    f[DELTA_FIELD_ACCEL_Y] = (uint32_t)(int32_t)p.accel_y;
+    f[DELTA_FIELD_ACCEL_Z] = (uint32_t)(int32_t)p.accel_z;
+    f[DELTA_FIELD_GYRO_X] = (uint32_t)(int32_t)p.gyro_x;
+    f[DELTA_FIELD_GYRO_Y] = (uint32_t)(int32_t)p.gyro_y;
+    f[DELTA_FIELD_PMU_STATUS] = p.pmu_status;
+}
+
+static void fieldsToPacket(const uint32_t* f, GPSPacket& p) {
+    p.timestamp = f[DELTA_FIELD_TIMESTAMP];
+    p.latitude = (int32_t)f[DELTA_FIELD_LATITUDE];
+    p.longitude = (int32_t)f[DELTA_FIELD_LONGITUDE];
+    p.altitude = (int32_t)f[DELTA_FIELD_ALTITUDE];
+    p.speed = (uint16_t)f[DELTA_FIELD_SPEED];
+    p.heading = f[DELTA_FIELD_HEADING];
+    p.fixType = (uint8_t)f[DELTA_FIELD_FIX_TYPE];
+    p.satellites = (uint8_t)f[DELTA_FIELD_SATELLITES];
+    p.battery_mv = (uint16_t)f[DELTA_FIELD_BATTERY_MV];
+    p.battery_pct = (uint8_t)f[DELTA_FIELD_BATTERY_PCT];
+    p.accel_x = (int16_t)f[DELTA_FIELD_ACCEL_X];
+    p.accel_y = (int16_t)f[DELTA_FIELD_ACCEL_Y];
+    p.accel_z = (int16_t)f[DELTA_FIELD_ACCEL_Z];
+    p.gyro_x = (int16_t)f[DELTA_FIELD_GYRO_X];
+    p.gyro_y = (int16_t)f[DELTA_FIELD_GYRO_Y];
+    p.pmu_status = (uint8_t)f[DELTA_FIELD_PMU_STATUS];
+    p.crc = crc16((const uint8_t*)&p, sizeof(GPSPacket) - 2);
+}
+
+size_t varintEncode(uint32_t value, uint8_t* out) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+size_t varintDecode(const uint8_t* data, size_t length, uint32_t* value) {
+    uint32_t result = 0;
+    for (size_t i = 0; i < length && i < DELTA_FIELD_MAX_BYTES; i++) {
+        result |= (uint32_t)(data[i] & 0x7F) << (7 * i);
+        if (!(data[i] & 0x80)) {
+            *value = result;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+DeltaEncoder::DeltaEncoder() : needKeyframe(true), sinceKeyframe(0) {
+    memset(previous, 0, sizeof(previous));
+}
+
+size_t DeltaEncoder::encode(const GPSPacket& packet, uint8_t* out) {
+    uint32_t fields[DELTA_FIELD_COUNT];
+    packetToFields(packet, fields);
+
+    bool keyframe = needKeyframe || sinceKeyframe >= DELTA_KEYFRAME_INTERVAL;
+    uint32_t mask = 0;
+    for (int i = 0; i < DELTA_FIELD_COUNT; i++) {
+        if (keyframe || fields[i] != previous[i]) mask |= 1UL << i;
+    }
+
+    size_t n = varintEncode((mask << 1) | (keyframe ? 1 : 0), out);
+    for (int i = 0; i < DELTA_FIELD_COUNT; i++) {
+        if (!(mask & (1UL << i))) continue;
+        int32_t value = keyframe ? (int32_t)fields[i] : (int32_t)(fields[i] - previous[i]);
+        n += varintEncode(zigzagEncode(value), out + n);
+    }
+
+    memcpy(previous, fields, sizeof(previous));
+    if (keyframe) {
+        needKeyframe = false;
+        sinceKeyframe = 0;
+        stats.keyframes++;
+    }
+    sinceKeyframe++;
+
+    stats.records++;
+    stats.rawBytes += sizeof(GPSPacket);
+    stats.encodedBytes += n;
+    return n;
+}
+
+DeltaDecoder::DeltaDecoder() : synced(false) {
+    memset(previous, 0, sizeof(previous));
+}
+
+DeltaDecoder::Result DeltaDecoder::decode(const uint8_t* data, size_t length, GPSPacket& packet, size_t* consumed) {
+    uint32_t header;
+    size_t n = varintDecode(data, length, &header);
+    if (n == 0 || (header >> (DELTA_FIELD_COUNT + 1)) != 0) return DECODE_ERROR;
+
+    bool keyframe = header & 1;
+    uint32_t mask = header >> 1;
+    if (keyframe && mask != (1UL << DELTA_FIELD_COUNT) - 1) return DECODE_ERROR;
+
+    uint32_t fields[DELTA_FIELD_COUNT];
+    memcpy(fields, previous, sizeof(fields));
+    for (int i = 0; i < DELTA_FIELD_COUNT; i++) {
+        if (!(mask & (1UL << i))) continue;
+        uint32_t raw;
+        size_t used = varintDecode(data + n, length - n, &raw);
+        if (used == 0) return DECODE_ERROR;
+        n += used;
+        int32_t value = zigzagDecode(raw);
+        fields[i] = keyframe ? (uint32_t)value : fields[i] + (uint32_t)value;
+    }
+
+    *consumed = n;
+    if (!keyframe && !synced) return DECODE_SKIPPED;
+
+    memcpy(previous, fields, sizeof(previous));
+    synced = true;
+    fieldsToPacket(fields, packet);
+    return DECODE_OK;
+}
@@ -0,0 +1,95 @@
+#ifndef DELTA_CODEC_H
+#define DELTA_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "gps_packet.h"
+
+// ==============================================
+// DELTA / VARINT TELEMETRY RECORD CODEC
+// ==============================================
+// Record = varint(header) followed by one zigzag varint per field set in the mask.
+//   header bit 0      : 1 = keyframe (absolute values), 0 = delta against the previous record
+//   header bits 1..16 : mask of the GPSPacket fields present (DELTA_FIELD_*)
+// Keyframes carry every field, deltas only the fields that changed, so a parked
+// device logs ~3 bytes per sample. The packet CRC is not stored; the decoder
+// recomputes it. A decoder can resynchronise at any keyframe; the SD sink
+// forces one at the start of every log block so blocks decode independently.
+
+enum DeltaField {
+    DELTA_FIELD_TIMESTAMP = 0,
+    DELTA_FIELD_LATITUDE,
+    DELTA_FIELD_LONGITUDE,
+    DELTA_FIELD_ALTITUDE,
+    DELTA_FIELD_SPEED,
+    DELTA_FIELD_HEADING,
+    DELTA_FIELD_FIX_TYPE,
+    DELTA_FIELD_SATELLITES,
+    DELTA_FIELD_BATTERY_MV,
+    DELTA_FIELD_BATTERY_PCT,
+    DELTA_FIELD_ACCEL_X,
+    DELTA_FIELD_ACCEL_Y,
+    DELTA_FIELD_ACCEL_Z,
+    DELTA_FIELD_GYRO_X,
+    DELTA_FIELD_GYRO_Y,
+    DELTA_FIELD_PMU_STATUS,
+    DELTA_FIELD_COUNT
+};
+
+#define DELTA_HEADER_MAX_BYTES  3       // 17-bit header
+#define DELTA_FIELD_MAX_BYTES   5       // 32-bit zigzag varint
+#define DELTA_MAX_RECORD_SIZE   (DELTA_HEADER_MAX_BYTES + DELTA_FIELD_COUNT * DELTA_FIELD_MAX_BYTES)
+#define DELTA_KEYFRAME_INTERVAL 250     // Records between forced keyframes (10 s at 25 Hz)
+
+// Varint helpers (LEB128, little-endian groups of 7 bits)
+size_t varintEncode(uint32_t value, uint8_t* out);
+size_t varintDecode(const uint8_t* data, size_t length, uint32_t* value);
+inline uint32_t zigzagEncode(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+inline int32_t zigzagDecode(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+struct DeltaCodecStats {
+    uint32_t records = 0;
+    uint32_t keyframes = 0;
+    uint32_t rawBytes = 0;          // sizeof(GPSPacket) per record
+    uint32_t encodedBytes = 0;
+};
+
+class DeltaEncoder {
+public:
+    DeltaEncoder();
+
+    // Next record will be a keyframe (call at every independently decodable boundary)
+    void forceKeyframe() { needKeyframe = true; }
+
+    // Encode one packet into out (at least DELTA_MAX_RECORD_SIZE bytes). Returns bytes written.
+    size_t encode(const GPSPacket& packet, uint8_t* out);
+
+    const DeltaCodecStats& getStats() const { return stats; }
+
+private:
+    uint32_t previous[DELTA_FIELD_COUNT];
+    bool needKeyframe;
+    uint32_t sinceKeyframe;
+    DeltaCodecStats stats;
+};
+
+class DeltaDecoder {
+public:
+    enum Result {
+        DECODE_OK,          // packet filled
+        DECODE_SKIPPED,     // well-formed delta before the first keyframe - skipped
+        DECODE_ERROR        // truncated or malformed record
+    };
+
+    DeltaDecoder();
+    void reset() { synced = false; }
+
+    // Decode one record. consumed is set for OK and SKIPPED.
+    Result decode(const uint8_t* data, size_t length, GPSPacket& packet, size_t* consumed);
+
+private:
+    uint32_t previous[DELTA_FIELD_COUNT];
+    bool synced;
+};
+
+#endif // DELTA_CODEC_H
@@ -0,0 +1,221 @@
+#include "file_transfer_protocol.h"
+#include "crc16.h"
+#include <string.h>
+
+size_t ftPayloadSize(uint16_t mtu) {
+    size_t overhead = FT_ATT_OVERHEAD + sizeof(FtDataHeader);
+    if (mtu <= overhead) return 1;
+    size_t size = mtu - overhead;
+    return size > FT_MAX_PAYLOAD ? FT_MAX_PAYLOAD : size;
+}
+
+bool ftParseAck(const uint8_t* data, size_t length, FtAckFrame& ack) {
+    if (length != sizeof(FtAckFrame) || data[0] != FT_FRAME_ACK) return false;
+    memcpy(&ack, data, sizeof(ack));
+    return true;
+}
+
+// ==============================================
+// SENDER
+// ==============================================
+
+FtSender::FtSender() {
+    begin(0, 1, 1, 0);
+}
+
+void FtSender::begin(uint32_t size, uint16_t payload, uint16_t frames, uint32_t nowMs) {
+    fileSize = size;
+    payloadSize = payload > 0 ? payload : 1;
+    window = frames > 0 ? frames : 1;
+    sentOffset = 0;
+    ackedOffset = 0;
+    crcOffset = 0;
+    crc = CRC16_INIT;
+    lastProgressMs = nowMs;
+    framesSent = 0;
+    retransmits = 0;
+    timeouts = 0;
+}
+
+bool FtSender::canSend() const {
+    return sentOffset < fileSize &&
+           sentOffset - ackedOffset < (uint32_t)window * payloadSize;
+}
+
+size_t FtSender::nextFrame(FtDataHeader& header) const {
+    uint32_t remaining = fileSize - sentOffset;
+    size_t length = remaining < payloadSize ? remaining : payloadSize;
+
+    header.type = FT_FRAME_DATA;
+    header.flags = (sentOffset + length >= fileSize) ? FT_DATA_FLAG_LAST : 0;
+    header.sequence = (uint16_t)(sentOffset / payloadSize);
+    header.offset = sentOffset;
+    return length;
+}
+
+void FtSender::onSent(const FtDataHeader& header, const uint8_t* payload, size_t length) {
+    // Frames always start on a payload boundary, so a frame is either entirely
+    // below crcOffset (a retransmit) or starts exactly at it
+    if (header.offset == crcOffset) {
+        crc = crc16Update(crc, payload, length);
+        crcOffset += length;
+    } else {
+        retransmits++;
+    }
+    sentOffset = header.offset + length;
+    framesSent++;
+}
+
+void FtSender::onAck(const FtAckFrame& ack, uint32_t nowMs) {
+    if (ack.window > 0) window = ack.window;
+
+    uint32_t offset = ack.offset > crcOffset ? crcOffset : ack.offset;
+    if (offset > ackedOffset) {
+        ackedOffset = offset;
+        lastProgressMs = nowMs;
+        if (sentOffset < ackedOffset) sentOffset = ackedOffset;
+    }
+
+    if (ack.flags & FT_ACK_FLAG_RESEND) {
+        rewind();
+        lastProgressMs = nowMs;
+    }
+}
+
+bool FtSender::checkTimeout(uint32_t nowMs, uint32_t timeoutMs) {
+    if (sentOffset == ackedOffset) {
+        lastProgressMs = nowMs;     // Nothing in flight, nothing to wait for
+        return false;
+    }
+    if (nowMs - lastProgressMs < timeoutMs) return false;
+
+    rewind();
+    timeouts++;
+    lastProgressMs = nowMs;
+    return true;
+}
+
+void FtSender::buildEnd(FtEndFrame& frame) const {
+    frame.type = FT_FRAME_END;
+    frame.flags = 0;
+    frame.payloadSize = payloadSize;
+    frame.fileSize = fileSize;
+    frame.crc = crc;
+}
+
+void FtSender::rewind() {
+    sentOffset = ackedOffset;
+}
+
+int ftSendFrames(FtSender& sender, StorageFile& file, PacketLink& link, int maxFrames, uint8_t* frame) {
+    uint8_t* payload = frame + sizeof(FtDataHeader);
+    int sent = 0;
+
+    while (sent < maxFrames && sender.canSend()) {
+        FtDataHeader header;
+        size_t length = sender.nextFrame(header);
+
+        if (file.position() != header.offset) {
+            file.seek(header.offset);   // Rewound after a gap or timeout
+        }
+        if (file.read(payload, length) != length) return -1;
+
+        // A frame the link refuses counts as lost; the window recovers it
+        memcpy(frame, &header, sizeof(header));
+        link.send(frame, sizeof(FtDataHeader) + length);
+        sender.onSent(header, payload, length);
+        sent++;
+    }
+    return sent;
+}
+
+// ==============================================
+// REFERENCE RECEIVER
+// ==============================================
+
+FtReceiver::FtReceiver() {
+    begin(0, 1, 0);
+}
+
+void FtReceiver::begin(uint32_t size, uint16_t every, uint16_t frames) {
+    fileSize = size;
+    expected = 0;
+    crc = CRC16_INIT;
+    ackEvery = every > 0 ? every : 1;
+    window = frames;
+    sinceAck = 0;
+    ackPending = false;
+    resendPending = false;
+    resendRequested = false;
+    gaps = 0;
+    duplicates = 0;
+}
+
+FtReceiver::Result FtReceiver::onFrame(const uint8_t* data, size_t length,
+                                       const uint8_t** payload, size_t* payloadLength, uint32_t* offset) {
+    if (length == 0) return FT_RX_INVALID;
+
+    if (data[0] == FT_FRAME_END) {
+        if (length != sizeof(FtEndFrame)) return FT_RX_INVALID;
+        FtEndFrame end;
+        memcpy(&end, data, sizeof(end));
+        if (expected < end.fileSize) {
+            // Tail frames were lost - ask for them again
+            ackPending = true;
+            resendPending = true;
+            return FT_RX_CRC_ERROR;
+        }
+        bool sizeOk = end.fileSize == expected && (fileSize == 0 || fileSize == end.fileSize);
+        return (sizeOk && end.crc == crc) ? FT_RX_COMPLETE : FT_RX_CRC_ERROR;
+    }
+
+    if (data[0] != FT_FRAME_DATA || length < sizeof(FtDataHeader)) return FT_RX_INVALID;
+
+    FtDataHeader header;
+    memcpy(&header, data, sizeof(header));
+    size_t dataLength = length - sizeof(FtDataHeader);
+
+    if (header.offset > expected) {
+        gaps++;
+        if (!resendRequested) {
+            resendRequested = true;
+            ackPending = true;
+            resendPending = true;
+        }
+        return FT_RX_GAP;
+    }
+
+    if (header.offset < expected) {
+        // Our ack was probably lost and the sender rewound - repeat it
+        duplicates++;
+        ackPending = true;
+        return FT_RX_DUPLICATE;
+    }
+
+    crc = crc16Update(crc, data + sizeof(FtDataHeader), dataLength);
+    expected += dataLength;
+    resendRequested = false;
+
+    if (++sinceAck >= ackEvery || (header.flags & FT_DATA_FLAG_LAST)) {
+        ackPending = true;
+    }
+
+    *payload = data + sizeof(FtDataHeader);
+    *payloadLength = dataLength;
+    *offset = header.offset;
+    return FT_RX_DATA;
+}
+
+bool FtReceiver::takeAck(FtAckFrame& ack) {
+    if (!ackPending) return false;
+
+    ack.type = FT_FRAME_ACK;
+    ack.flags = resendPending ? FT_ACK_FLAG_RESEND : 0;
+    ack.window = window;
+    ack.offset = expected;
+
+    ackPending = false;
+    resendPending = false;
+    sinceAck = 0;
+    return true;
+}
@@ -0,0 +1,159 @@
+#ifndef FILE_TRANSFER_PROTOCOL_H
+#define FILE_TRANSFER_PROTOCOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "platform_io.h"
+
+// ==============================================
+// BINARY WINDOWED FILE TRANSFER (BLE fileTransferChar)
+// ==============================================
+// Text commands (LIST, GET:<name>, DEL:<name>, STOP, STATUS) and text replies
+// (START:, FILES:, ERROR:...) stay ASCII. File contents are sent as binary
+// notifications whose first byte is >= 0x80, so a client can tell them apart:
+//
+//   device -> client   FtDataHeader + raw payload (payload sized from the MTU)
+//                      FtEndFrame once every byte has been acknowledged
+//   client -> device   FtAckFrame: cumulative offset received in order
+//
+// The sender keeps at most `window` frames beyond the last acknowledged offset
+// in flight (go-back-N). A client acks every few frames, immediately with
+// FT_ACK_FLAG_RESEND when it sees a gap, and the sender rewinds on its own
+// when acks stop arriving. Sequence numbers are offset / payloadSize, so a
+// retransmitted frame keeps its number.
+// No Arduino dependencies - FtReceiver doubles as the reference client.
+
+#define FT_FRAME_DATA           0xD1
+#define FT_FRAME_END            0xE1
+#define FT_FRAME_ACK            0xA1
+
+#define FT_DATA_FLAG_LAST       0x01    // Frame ends at the end of the file
+#define FT_ACK_FLAG_RESEND      0x01    // Gap detected - rewind to the acked offset now
+
+#define FT_ATT_OVERHEAD         3       // ATT notification opcode + handle
+#define FT_MAX_PAYLOAD          500     // Largest payload per frame (MTU 517 minus headers, rounded)
+
+struct __attribute__((packed)) FtDataHeader {
+    uint8_t type;               // FT_FRAME_DATA
+    uint8_t flags;
+    uint16_t sequence;
+    uint32_t offset;            // File offset of the first payload byte
+};
+
+struct __attribute__((packed)) FtEndFrame {
+    uint8_t type;               // FT_FRAME_END
+    uint8_t flags;
+    uint16_t payloadSize;       // Payload bytes per full data frame
+    uint32_t fileSize;
+    uint16_t crc;               // CRC16 (crc16.h) of the whole file
+};
+
+struct __attribute__((packed)) FtAckFrame {
+    uint8_t type;               // FT_FRAME_ACK
+    uint8_t flags;
+    uint16_t window;            // Frames the client can buffer, 0 = unchanged
+    uint32_t offset;            // Every byte below this was received in order
+};
+
+// Payload bytes per data frame for a negotiated ATT MTU
+size_t ftPayloadSize(uint16_t mtu);
+
+bool ftParseAck(const uint8_t* data, size_t length, FtAckFrame& ack);
+
+// Sender window bookkeeping. The caller owns the file and the radio.
+class FtSender {
+public:
+    FtSender();
+
+    void begin(uint32_t fileSize, uint16_t payloadSize, uint16_t window, uint32_t nowMs);
+
+    // Room in the window for another frame?
+    bool canSend() const;
+
+    // Fill the header for the next frame. Returns the payload length to read at
+    // header.offset; the caller sends it and then calls onSent().
+    size_t nextFrame(FtDataHeader& header) const;
+    void onSent(const FtDataHeader& header, const uint8_t* payload, size_t length);
+
+    void onAck(const FtAckFrame& ack, uint32_t nowMs);
+
+    // Rewind to the acked offset when nothing was acknowledged for timeoutMs.
+    // Returns true when it rewound.
+    bool checkTimeout(uint32_t nowMs, uint32_t timeoutMs);
+
+    bool done() const { return ackedOffset >= fileSize; }
+    void buildEnd(FtEndFrame& frame) const;
+
+    uint32_t getFileSize() const { return fileSize; }
+    uint32_t getSentOffset() const { return sentOffset; }
+    uint32_t getAckedOffset() const { return ackedOffset; }
+    uint16_t getPayloadSize() const { return payloadSize; }
+    uint16_t getWindow() const { return window; }
+    uint32_t getFramesSent() const { return framesSent; }
+    uint32_t getRetransmits() const { return retransmits; }
+    uint32_t getTimeouts() const { return timeouts; }
+
+private:
+    uint32_t fileSize;
+    uint16_t payloadSize;
+    uint16_t window;
+    uint32_t sentOffset;        // Next byte to send
+    uint32_t ackedOffset;
+    uint32_t crcOffset;         // File CRC covers [0, crcOffset)
+    uint16_t crc;
+    uint32_t lastProgressMs;
+    uint32_t framesSent;
+    uint32_t retransmits;       // Frames sent again after a rewind
+    uint32_t timeouts;
+
+    void rewind();
+};
+
+// Fill the window: read up to maxFrames frames from `file` and send them over `link`.
+// `frame` must hold sizeof(FtDataHeader) + the payload size. Returns the number of
+// frames sent, or -1 when the file could not be read.
+int ftSendFrames(FtSender& sender, StorageFile& file, PacketLink& link, int maxFrames, uint8_t* frame);
+
+// Reference client: reassembles the stream and decides when to ack.
+class FtReceiver {
+public:
+    enum Result {
+        FT_RX_DATA,             // In-order payload at `offset` - store it
+        FT_RX_DUPLICATE,        // Already received, ignored
+        FT_RX_GAP,              // Frame beyond the expected offset, ignored
+        FT_RX_COMPLETE,         // End frame received and the file CRC matches
+        FT_RX_CRC_ERROR,        // End frame received but size or CRC differ
+        FT_RX_INVALID           // Not a transfer frame
+    };
+
+    FtReceiver();
+
+    // fileSize from the START reply (0 = take it from the end frame)
+    void begin(uint32_t fileSize, uint16_t ackEvery, uint16_t window);
+
+    // Process one notification. For FT_RX_DATA, *payload/*length/*offset point into `data`.
+    Result onFrame(const uint8_t* data, size_t length,
+                   const uint8_t** payload, size_t* payloadLength, uint32_t* offset);
+
+    // Ack to write back after the last onFrame(), if any
+    bool takeAck(FtAckFrame& ack);
+
+    uint32_t getReceived() const { return expected; }
+    uint32_t getGaps() const { return gaps; }
+    uint32_t getDuplicates() const { return duplicates; }
+
+private:
+    uint32_t fileSize;
+    uint32_t expected;
+    uint16_t crc;
+    uint16_t ackEvery;
+    uint16_t window;
+    uint16_t sinceAck;
+    bool ackPending;
+    bool resendPending;
+    bool resendRequested;       // One RESEND per gap until in-order data resumes
+    uint32_t gaps;
+    uint32_t duplicates;
+};
+
+#endif // FILE_TRANSFER_PROTOCOL_H
@@ -0,0 +1,225 @@
+#include "fusion_engine.h"
+#include <math.h>
+#include <string.h>
+
+#define FUSION_PI               3.14159265f
+#define FUSION_DEG_TO_RAD       (FUSION_PI / 180.0f)
+#define METERS_PER_LAT_UNIT     0.0111319491f   // 1e-7 deg of latitude on the WGS84 mean radius
+#define FUSION_REANCHOR_M       20000.0f        // Move the tangent plane origin beyond this
+#define FUSION_MIN_POS_STD      0.5f
+#define FUSION_MIN_SPEED_STD    0.1f
+#define FUSION_MIN_HEADING_STD  (1.0f * FUSION_DEG_TO_RAD)
+
+static float wrapAngle(float a) {
+    while (a >= 2.0f * FUSION_PI) a -= 2.0f * FUSION_PI;
+    while (a < 0.0f) a += 2.0f * FUSION_PI;
+    return a;
+}
+
+static float wrapInnovation(float a) {
+    while (a > FUSION_PI) a -= 2.0f * FUSION_PI;
+    while (a < -FUSION_PI) a += 2.0f * FUSION_PI;
+    return a;
+}
+
+static int32_t wrapLongitude(int64_t lon) {
+    while (lon > 1800000000LL) lon -= 3600000000LL;
+    while (lon < -1800000000LL) lon += 3600000000LL;
+    return (int32_t)lon;
+}
+
+static float maxf(float a, float b) { return a > b ? a : b; }
+
+FusionEngine::FusionEngine() {
+    reset();
+}
+
+void FusionEngine::reset() {
+    memset(x, 0, sizeof(x));
+    memset(P, 0, sizeof(P));
+    initialized = false;
+    lastPredictUs = 0;
+    lastFixUs = 0;
+    originLat = 0;
+    originLon = 0;
+    metersPerLonUnit = METERS_PER_LAT_UNIT;
+    consecutiveRejects = 0;
+}
+
+void FusionEngine::toLocal(int32_t lat, int32_t lon, float* east, float* north) const {
+    *north = (float)((int64_t)lat - originLat) * METERS_PER_LAT_UNIT;
+    *east = (float)wrapLongitude((int64_t)lon - originLon) * metersPerLonUnit;
+}
+
+void FusionEngine::initialize(const FusionGnssFix& fix) {
+    memset(x, 0, sizeof(x));
+    memset(P, 0, sizeof(P));
+
+    originLat = fix.latitude;
+    originLon = fix.longitude;
+    metersPerLonUnit = METERS_PER_LAT_UNIT * cosf(fix.latitude * 1e-7f * FUSION_DEG_TO_RAD);
+
+    float posStd = maxf(fix.horizontalAccuracy, FUSION_MIN_POS_STD);
+    float speedStd = maxf(fix.speedAccuracy, FUSION_MIN_SPEED_STD);
+    bool moving = fix.speed >= FUSION_MIN_HEADING_SPEED;
+
+    x[FUSION_SPEED] = fix.speed;
+    x[FUSION_HEADING] = wrapAngle(fix.heading * FUSION_DEG_TO_RAD);
+    P[FUSION_EAST][FUSION_EAST] = posStd * posStd;
+    P[FUSION_NORTH][FUSION_NORTH] = posStd * posStd;
+    P[FUSION_SPEED][FUSION_SPEED] = speedStd * speedStd;
+    P[FUSION_HEADING][FUSION_HEADING] = moving ?
+        maxf(fix.headingAccuracy * FUSION_DEG_TO_RAD, FUSION_MIN_HEADING_STD) *
+        maxf(fix.headingAccuracy * FUSION_DEG_TO_RAD, FUSION_MIN_HEADING_STD) :
+        FUSION_PI * FUSION_PI;
+    P[FUSION_GYRO_BIAS][FUSION_GYRO_BIAS] = 0.01f * 0.01f;
+
+    initialized = true;
+    lastPredictUs = fix.timestampUs;
+    lastFixUs = fix.timestampUs;
+    consecutiveRejects = 0;
+}
+
+void FusionEngine::predict(int64_t timestampUs, float forwardAccel, float yawRate) {
+    if (!initialized) {
+        lastPredictUs = timestampUs;
+        return;
+    }
+
+    float dt = (float)(timestampUs - lastPredictUs) * 1e-6f;
+    lastPredictUs = timestampUs;
+    if (dt <= 0.0f) return;
+    if (dt > FUSION_MAX_PREDICT_DT) dt = FUSION_MAX_PREDICT_DT;
+
+    float v = x[FUSION_SPEED];
+    float s = sinf(x[FUSION_HEADING]);
+    float c = cosf(x[FUSION_HEADING]);
+
+    x[FUSION_EAST] += v * s * dt;
+    x[FUSION_NORTH] += v * c * dt;
+    x[FUSION_SPEED] += forwardAccel * dt;
+    x[FUSION_HEADING] = wrapAngle(x[FUSION_HEADING] + (yawRate - x[FUSION_GYRO_BIAS]) * dt);
+
+    // Jacobian - identity plus these terms
+    float F[FUSION_STATE_COUNT][FUSION_STATE_COUNT];
+    memset(F, 0, sizeof(F));
+    for (int i = 0; i < FUSION_STATE_COUNT; i++) F[i][i] = 1.0f;
+    F[FUSION_EAST][FUSION_SPEED] = s * dt;
+    F[FUSION_EAST][FUSION_HEADING] = v * c * dt;
+    F[FUSION_NORTH][FUSION_SPEED] = c * dt;
+    F[FUSION_NORTH][FUSION_HEADING] = -v * s * dt;
+    F[FUSION_HEADING][FUSION_GYRO_BIAS] = -dt;
+
+    // P = F P F^T + Q
+    float FP[FUSION_STATE_COUNT][FUSION_STATE_COUNT];
+    for (int i = 0; i < FUSION_STATE_COUNT; i++) {
+        for (int j = 0; j < FUSION_STATE_COUNT; j++) {
+            float sum = 0.0f;
+            for (int k = 0; k < FUSION_STATE_COUNT; k++) sum += F[i][k] * P[k][j];
+            FP[i][j] = sum;
+        }
+    }
+    for (int i = 0; i < FUSION_STATE_COUNT; i++) {
+        for (int j = 0; j < FUSION_STATE_COUNT; j++) {
+            float sum = 0.0f;
+            for (int k = 0; k < FUSION_STATE_COUNT; k++) sum += FP[i][k] * F[j][k];
+            P[i][j] = sum;
+        }
+    }
+    P[FUSION_SPEED][FUSION_SPEED] += FUSION_ACCEL_NOISE * FUSION_ACCEL_NOISE * dt;
+    P[FUSION_HEADING][FUSION_HEADING] += FUSION_GYRO_NOISE * FUSION_GYRO_NOISE * dt;
+    P[FUSION_GYRO_BIAS][FUSION_GYRO_BIAS] += FUSION_BIAS_WALK * FUSION_BIAS_WALK * dt;
+
+    stats.predictions++;
+}
+
+// Scalar measurement of state `index`. Returns false if gated out (state untouched).
+bool FusionEngine::update(int index, float innovation, float variance, bool gate) {
+    float S = P[index][index] + variance;
+    if (gate && innovation * innovation > FUSION_GATE_SIGMA * FUSION_GATE_SIGMA * S) return false;
+
+    float K[FUSION_STATE_COUNT];
+    float row[FUSION_STATE_COUNT];
+    for (int j = 0; j < FUSION_STATE_COUNT; j++) {
+        K[j] = P[j][index] / S;
+        row[j] = P[index][j];
+    }
+    for (int j = 0; j < FUSION_STATE_COUNT; j++) {
+        x[j] += K[j] * innovation;
+        for (int k = 0; k < FUSION_STATE_COUNT; k++) {
+            P[j][k] -= K[j] * row[k];
+        }
+    }
+    x[FUSION_HEADING] = wrapAngle(x[FUSION_HEADING]);
+    return true;
+}
+
+bool FusionEngine::correct(const FusionGnssFix& fix) {
+    if (!initialized) {
+        initialize(fix);
+        return true;
+    }
+
+    float east, north;
+    toLocal(fix.latitude, fix.longitude, &east, &north);
+    float posStd = maxf(fix.horizontalAccuracy, FUSION_MIN_POS_STD);
+    float posVar = posStd * posStd;
+
+    // Gate on position before touching the state
+    float innE = east - x[FUSION_EAST];
+    float innN = north - x[FUSION_NORTH];
+    float limit = FUSION_GATE_SIGMA * FUSION_GATE_SIGMA;
+    if (innE * innE > limit * (P[FUSION_EAST][FUSION_EAST] + posVar) ||
+        innN * innN > limit * (P[FUSION_NORTH][FUSION_NORTH] + posVar)) {
+        stats.rejectedFixes++;
+        if (++consecutiveRejects >= FUSION_MAX_REJECTS) {
+            stats.resets++;
+            initialize(fix);
+        }
+        return false;
+    }
+    consecutiveRejects = 0;
+
+    update(FUSION_EAST, innE, posVar, false);
+    update(FUSION_NORTH, north - x[FUSION_NORTH], posVar, false);
+
+    float speedStd = maxf(fix.speedAccuracy, FUSION_MIN_SPEED_STD);
+    update(FUSION_SPEED, fix.speed - x[FUSION_SPEED], speedStd * speedStd, false);
+
+    if (fix.speed >= FUSION_MIN_HEADING_SPEED) {
+        float headingStd = maxf(fix.headingAccuracy * FUSION_DEG_TO_RAD, FUSION_MIN_HEADING_STD);
+        float innovation = wrapInnovation(fix.heading * FUSION_DEG_TO_RAD - x[FUSION_HEADING]);
+        update(FUSION_HEADING, innovation, headingStd * headingStd, true);
+    }
+
+    // Keep the tangent plane small so float positions stay precise
+    if (fabsf(x[FUSION_EAST]) > FUSION_REANCHOR_M || fabsf(x[FUSION_NORTH]) > FUSION_REANCHOR_M) {
+        originLat += (int32_t)lrintf(x[FUSION_NORTH] / METERS_PER_LAT_UNIT);
+        originLon = wrapLongitude((int64_t)originLon + lrintf(x[FUSION_EAST] / metersPerLonUnit));
+        metersPerLonUnit = METERS_PER_LAT_UNIT * cosf(originLat * 1e-7f * FUSION_DEG_TO_RAD);
+        x[FUSION_EAST] = 0.0f;
+        x[FUSION_NORTH] = 0.0f;
+    }
+
+    lastFixUs = fix.timestampUs;
+    stats.corrections++;
+    return true;
+}
+
+void FusionEngine::getState(FusionState& out) const {
+    out.valid = initialized;
+    if (!initialized) return;
+
+    float speed = x[FUSION_SPEED];
+    float heading = x[FUSION_HEADING];
+
+    out.timestampUs = lastPredictUs;
+    out.latitude = originLat + (int32_t)lrintf(x[FUSION_NORTH] / METERS_PER_LAT_UNIT);
+    out.longitude = wrapLongitude((int64_t)originLon + lrintf(x[FUSION_EAST] / metersPerLonUnit));
+    out.speed = speed > 0.0f ? speed : 0.0f;
+    out.heading = heading / FUSION_DEG_TO_RAD;
+    out.velocityNorth = speed * cosf(heading);
+    out.velocityEast = speed * sinf(heading);
+    out.positionStd = sqrtf(P[FUSION_EAST][FUSION_EAST] + P[FUSION_NORTH][FUSION_NORTH]);
+    out.sinceFixMs = lastPredictUs > lastFixUs ? (uint32_t)((lastPredictUs - lastFixUs) / 1000) : 0;
+}
@@ -0,0 +1,103 @@
+#ifndef FUSION_ENGINE_H
+#define FUSION_ENGINE_H
+
+#include <stdint.h>
+
+// ==============================================
+// GNSS/IMU FUSION (5-state EKF)
+// ==============================================
+// State: east/north position in a local tangent plane around the first fix
+// (m), forward speed (m/s), heading (rad, clockwise from north) and gyro yaw
+// bias (rad/s). Every IMU sample propagates the state with the forward
+// acceleration and yaw rate; every GNSS fix corrects it with sequential
+// scalar updates (position, speed, and heading when moving fast enough for
+// headMot to mean something), so no matrix inversion is needed.
+// Position fixes whose innovation exceeds FUSION_GATE_SIGMA are rejected;
+// after FUSION_MAX_REJECTS in a row the filter re-initialises on the fix.
+// Single precision throughout (the ESP32-S3 FPU has no double support).
+
+#define FUSION_STATE_COUNT      5
+#define FUSION_ACCEL_NOISE      0.5f        // m/s^2, forward acceleration noise
+#define FUSION_GYRO_NOISE       0.02f       // rad/s, yaw-rate noise
+#define FUSION_BIAS_WALK        0.0005f     // rad/s per sqrt(s), gyro bias random walk
+#define FUSION_MIN_HEADING_SPEED 1.0f       // m/s, below this GNSS heading is ignored
+#define FUSION_GATE_SIGMA       5.0f
+#define FUSION_MAX_REJECTS      5
+#define FUSION_MAX_PREDICT_DT   0.1f        // s, longer IMU gaps are clamped
+
+enum FusionStateIndex {
+    FUSION_EAST = 0,
+    FUSION_NORTH,
+    FUSION_SPEED,
+    FUSION_HEADING,
+    FUSION_GYRO_BIAS
+};
+
+// GNSS measurement in NAV-PVT units
+struct FusionGnssFix {
+    int64_t timestampUs;
+    int32_t latitude;           // deg * 1e7
+    int32_t longitude;          // deg * 1e7
+    float speed;                // m/s
+    float heading;              // deg, heading of motion
+    float horizontalAccuracy;   // m (hAcc)
+    float speedAccuracy;        // m/s (sAcc)
+    float headingAccuracy;      // deg (headAcc)
+};
+
+// Fused output
+struct FusionState {
+    int64_t timestampUs = 0;
+    int32_t latitude = 0;       // deg * 1e7
+    int32_t longitude = 0;      // deg * 1e7
+    float speed = 0.0f;         // m/s
+    float heading = 0.0f;       // deg, 0-360 clockwise from north
+    float velocityNorth = 0.0f; // m/s
+    float velocityEast = 0.0f;  // m/s
+    float positionStd = 0.0f;   // m, 1-sigma horizontal
+    uint32_t sinceFixMs = 0;    // Time dead-reckoned since the last accepted fix
+    bool valid = false;
+};
+
+struct FusionStats {
+    uint32_t predictions = 0;
+    uint32_t corrections = 0;
+    uint32_t rejectedFixes = 0;
+    uint32_t resets = 0;
+};
+
+class FusionEngine {
+public:
+    FusionEngine();
+
+    void reset();
+    bool isInitialized() const { return initialized; }
+
+    // Propagate to timestampUs. forwardAccel in m/s^2 along the direction of travel,
+    // yawRate in rad/s with the heading convention (clockwise positive).
+    void predict(int64_t timestampUs, float forwardAccel, float yawRate);
+
+    // Correct with a GNSS fix. Returns false when the fix was gated out.
+    bool correct(const FusionGnssFix& fix);
+
+    void getState(FusionState& out) const;
+    const FusionStats& getStats() const { return stats; }
+
+private:
+    float x[FUSION_STATE_COUNT];
+    float P[FUSION_STATE_COUNT][FUSION_STATE_COUNT];
+    bool initialized;
+    int64_t lastPredictUs;
+    int64_t lastFixUs;
+    int32_t originLat;          // deg * 1e7
+    int32_t originLon;
+    float metersPerLonUnit;     // Tangent plane scale at the origin latitude
+    uint8_t consecutiveRejects;
+    FusionStats stats;
+
+    void initialize(const FusionGnssFix& fix);
+    void toLocal(int32_t lat, int32_t lon, float* east, float* north) const;
+    bool update(int index, float innovation, float variance, bool gate);
+};
+
+#endif // FUSION_ENGINE_H
@@ -1,8 +1,11 @@
 // globals.cpp - Define all global variables here (once only)
 #include "boardconfig.h"
+#include "config_registry.h"
+#include "telemetry_batch.h"
+#include "rate_control.h"
 
 // Debug and WiFi settings
-bool debugMode = true;
+bool debugMode = DEBUG_MODE;
 bool wifiUDPEnabled = false;
 
 // BLE Configuration
@@ -20,10 +23,65 @@ char currentLogFilename[64] = "";
 unsigned long lastPacketTime = 0;
 unsigned long lastDebugTime = 0;
 unsigned long lastWiFiCheck = 0;
-unsigned long lastPerfReset = 0;
+unsigned long lastHistogramRotate = 0;
 
 // File transfer deferred operations
 volatile bool pendingListFiles = false;
 volatile bool pendingStartTransfer = false;
 volatile bool pendingDeleteFile = false;
-volatile bool pendingCancelTransfer = false;
\ No newline at end of file
+volatile bool pendingCancelTransfer = false;
+volatile bool pendingStatusRequest = false;
+volatile bool pendingToggleLogging = false;
+
+// Replay control (handled on the ingest task)
+volatile bool pendingStartReplay = false;
+volatile bool pendingStopReplay = false;
+
+// Microbenchmarks (run by the sink task)
+volatile bool pendingBenchmark = false;
+
+// Stage probe report (sink task)
+volatile bool pendingProbeReport = false;
+volatile bool pendingProbeReset = false;
+
+// Latency histogram report / export (sink task)
+volatile bool pendingHistogramReport = false;
+volatile bool pendingHistogramExport = false;
+
+// Report policy stats (sink task)
+volatile bool pendingPolicyReport = false;
+
+// Consumer rate report (sink task)
+volatile bool pendingRateReport = false;
+
+// CFG replies (sink task, after the change was applied)
+volatile bool pendingConfigReport = false;
+
+// Runtime configuration: key, type, min, max, build default, scopes (DeviceConfigId order)
+static const ConfigEntry deviceConfigEntries[CFG_COUNT] = {
+    { "gps",          CONFIG_TYPE_BOOL, 0, 1, ENABLE_GPS, nullptr, CONFIG_SCOPE_BOOT },
+    { "imu",          CONFIG_TYPE_BOOL, 0, 1, ENABLE_IMU, nullptr, CONFIG_SCOPE_BOOT },
+    { "sd",           CONFIG_TYPE_BOOL, 0, 1, ENABLE_SD_CARD, nullptr, CONFIG_SCOPE_BOOT },
+    { "wifi",         CONFIG_TYPE_BOOL, 0, 1, ENABLE_WIFI, nullptr, CONFIG_SCOPE_BOOT },
+    { "ble",          CONFIG_TYPE_BOOL, 0, 1, ENABLE_BLE, nullptr, CONFIG_SCOPE_BOOT },
+    { "touch",        CONFIG_TYPE_BOOL, 0, 1, ENABLE_TOUCH, nullptr, CONFIG_SCOPE_BOOT },
+    { "nav_hz",       CONFIG_TYPE_UINT, 1, 25, GNSS_NAV_RATE_HZ, nullptr, CONFIG_SCOPE_BOOT },
+    { "gps_timeout",  CONFIG_TYPE_UINT, 1000, 60000, GPS_INIT_TIMEOUT_MS, nullptr, CONFIG_SCOPE_BOOT },
+    { "wifi_timeout", CONFIG_TYPE_UINT, 1000, 60000, WIFI_CONNECT_TIMEOUT_MS, nullptr, CONFIG_SCOPE_BOOT },
+    { "udp_backlog",  CONFIG_TYPE_UINT, 1, TELEMETRY_RING_CAPACITY, UDP_MAX_BACKLOG, nullptr, CONFIG_SCOPE_BOOT },
+    { "debug",        CONFIG_TYPE_BOOL, 0, 1, DEBUG_MODE, nullptr, CONFIG_SCOPE_DEBUG },
+    { "udp_host",     CONFIG_TYPE_TEXT, 0, 15, 0, UDP_TARGET_HOST, CONFIG_SCOPE_UDP },
+    { "udp_port",     CONFIG_TYPE_UINT, 1, 65535, UDP_TARGET_PORT, nullptr, CONFIG_SCOPE_UDP },
+    { "udp_bytes",    CONFIG_TYPE_UINT, sizeof(TelemetryBatchHeader) + sizeof(GPSPacket), UDP_MAX_DATAGRAM,
+                      UDP_BATCH_DEFAULT_BYTES, nullptr, CONFIG_SCOPE_BATCHING },
+    { "udp_ms",       CONFIG_TYPE_UINT, 0, UDP_BATCH_MAX_LATENCY_MS, UDP_BATCH_DEFAULT_MS, nullptr, CONFIG_SCOPE_BATCHING },
+    { "ble_ms",       CONFIG_TYPE_UINT, 0, BLE_BATCH_MAX_LATENCY_MS, BLE_BATCH_DEFAULT_MS, nullptr, CONFIG_SCOPE_BATCHING },
+    { "rate_sd",      CONFIG_TYPE_UINT, 0, RATE_MAX_HZ, SD_RATE_HZ, nullptr, CONFIG_SCOPE_RATES },
+    { "rate_ble",     CONFIG_TYPE_UINT, 0, RATE_MAX_HZ, BLE_RATE_HZ, nullptr, CONFIG_SCOPE_RATES },
+    { "rate_udp",     CONFIG_TYPE_UINT, 0, RATE_MAX_HZ, UDP_RATE_HZ, nullptr, CONFIG_SCOPE_RATES },
+    { "rate_ui",      CONFIG_TYPE_UINT, 0, RATE_MAX_HZ, UI_RATE_HZ, nullptr, CONFIG_SCOPE_RATES },
+    { "ble_report",   CONFIG_TYPE_BOOL, 0, 1, BLE_REPORT_POLICY, nullptr, CONFIG_SCOPE_REPORT },
+    { "udp_report",   CONFIG_TYPE_BOOL, 0, 1, UDP_REPORT_POLICY, nullptr, CONFIG_SCOPE_REPORT },
+    { "hist_ms",      CONFIG_TYPE_UINT, 1000, 3600000, HISTOGRAM_WINDOW_MS, nullptr, 0 },    // Read on use
+};
+ConfigRegistry deviceConfig(deviceConfigEntries, CFG_COUNT);
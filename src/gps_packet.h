@@ -0,0 +1,31 @@
+#ifndef GPS_PACKET_H
+#define GPS_PACKET_H
+
+#include <stdint.h>
+
+// Wire/log record shared by every sink. Kept free of Arduino headers so the
+// codecs that handle it also build on the host.
+
+// GPS Packet Structure (42 bytes) for transmission
+struct __attribute__((packed)) GPSPacket {
+    uint32_t timestamp;      // Unix epoch (4 bytes)
+    int32_t latitude;        // deg * 1e7 (4 bytes)
+    int32_t longitude;       // deg * 1e7 (4 bytes)
+    int32_t altitude;        // mm (4 bytes)
+    uint16_t speed;          // mm/s (2 bytes)
+    uint32_t heading;        // deg * 1e5 (4 bytes)
+    uint8_t fixType;         // 0-5 (1 byte)
+    uint8_t satellites;      // count (1 byte)
+    uint16_t battery_mv;     // mV (2 bytes)
+    uint8_t battery_pct;     // % (1 byte)
+    
+    int16_t accel_x;         // mg (2 bytes)
+    int16_t accel_y;         // mg (2 bytes) 
+    int16_t accel_z;         // mg (2 bytes)
+    int16_t gyro_x;          // deg/s * 100 (2 bytes)
+    int16_t gyro_y;          // deg/s * 100 (2 bytes)
+    uint8_t pmu_status;      // PMU status flags (1 byte)
+    uint16_t crc;            // CRC16 (2 bytes)
+};
+
+#endif // GPS_PACKET_H
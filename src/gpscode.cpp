@@ -7,15 +7,39 @@
 #include <BLEServer.h>
 #include <BLEUtils.h>
 #include <BLE2902.h>
+#include <esp_gap_ble_api.h>
 #include <FS.h>
 #include <SD.h>
 #include <SPI.h>
 #include <Preferences.h>
 #include <lvgl.h>
 #include <Arduino_GFX_Library.h>
+#include <esp_timer.h>
 #include <vector>
+#include <deque>
 
 #include "ui_manager.h"
+#include "task_pipeline.h"
+#include "ubx_parser.h"
+#include "crc16.h"
+#include "sd_logger.h"
+#include "delta_codec.h"
+#include "file_transfer_protocol.h"
+#include "imu_sampler.h"
+#include "imu_calibration.h"
+#include "fusion_engine.h"
+#include "packet_builder.h"
+#include "command_parser.h"
+#include "command_frame.h"
+#include "replay_source.h"
+#include "bench_suite.h"
+#include "stage_probe.h"
+#include "latency_histogram.h"
+#include "telemetry_batch.h"
+#include "report_policy.h"
+#include "rate_control.h"
+#include "config_registry.h"
+#include "telemetry_ring.h"
 #include "data_structures.h"
 #include "boardconfig.h"
 
@@ -23,8 +47,64 @@
 SFE_UBLOX_GNSS myGNSS;
 Preferences preferences;
 HardwareSerial GNSS_Serial(2);  // Use UART2 for GPS
+
+// ByteStream over a hardware UART (platform_io.h)
+class SerialByteStream : public ByteStream {
+public:
+    explicit SerialByteStream(HardwareSerial& serial) : serial(serial) {}
+    size_t available() override { int n = serial.available(); return n > 0 ? (size_t)n : 0; }
+    size_t read(uint8_t* buffer, size_t length) override { return serial.read(buffer, length); }
+    size_t write(const uint8_t* data, size_t length) override { return serial.write(data, length); }
+private:
+    HardwareSerial& serial;
+};
+
+SerialByteStream gnssStream(GNSS_Serial);
+UbxParser ubxParser;            // Streaming NAV-PVT decoder fed straight from GNSS_Serial
+ImuSampler imuSampler;          // MPU FIFO drained by its own task once started
+int imuConsumerId = -1;         // Ingest task's cursor on the IMU ring
+ImuCalibrator imuCalibrator;    // Fed from applyIMUReading() on the ingest task
+volatile bool pendingIMUCalibration = false;       // Start requested from UI / BLE, picked up by ingest
+volatile bool pendingSaveIMUCalibration = false;   // NVS write deferred to the sink task
+FusionEngine fusion;            // Predicted per IMU sample, corrected per NAV-PVT (ingest task)
+TelemetryRing<FusionState> fusionBus;   // Fused state stream for the UI and sinks
+int uiFusionConsumerId = -1;    // UI task: newest fused state only
+int udpFusionConsumerId = -1;   // UDP task: every fused state, as TB_FRAME_FUSION datagrams
+FusionTimingStats fusionTiming;
+bool fusionActive = false;      // ENABLE_FUSION and fusionBus allocated (set in setup)
+ReplaySource replay(esp_timer_get_time);    // File reader (sink task, which owns the SD card)
+SdStorageFile replayFile;
+uint8_t* replayBuffer = nullptr;            // One log block, PSRAM, allocated on first replay
+char replayPath[COMMAND_MAX_ARGUMENT + 1] = "";
+uint16_t replaySpeed = 1;
+TelemetryRing<ReplayRecord> replayRing;     // Decoded records, sink task -> ingest task
+volatile int replayConsumerId = -1;         // Ingest task's cursor, set once the ring exists
+volatile uint16_t replayQueuedSpeed = 1;    // Speed of the replay being queued
+volatile uint32_t replayStops = 0;          // Stops and restarts; end markers carry the count
+bool replayMarkerPending = false;           // End marker still to be queued (sink task)
+ReplayPacer replayPacer(esp_timer_get_time);    // Releases queued records on time (ingest task)
+ReplayRecord replayNext;                    // Taken off the ring, not yet due (ingest task)
+bool replayHolding = false;
+bool replayIngesting = false;               // Stands in for the GNSS receiver (ingest task)
+uint32_t replayStopsSeen = 0;               // From the last end marker; behind replayStops = flushing
+volatile bool pendingReplayReport = false;  // Summary printed by the sink task once a replay ends
+char benchFilter[COMMAND_MAX_ARGUMENT + 1] = "";
+TelemetryBatcher bleBatcher;                // Batched telemetry notifications (sink task)
+volatile uint16_t bleBatchLatencyMs = BLE_BATCH_DEFAULT_MS;    // 0 = one notification per sample
+TelemetryBatcher udpBatcher;                // UDP datagrams (UDP sink task)
+volatile uint16_t udpBatchBytes = UDP_BATCH_DEFAULT_BYTES;
+volatile uint16_t udpBatchLatencyMs = UDP_BATCH_DEFAULT_MS;     // 0 = one sample per datagram
+ReportPolicy blePolicy;                     // Dead-band filters in front of the radio links (owning sink task)
+ReportPolicy udpPolicy;
+StagedReportPolicy blePolicyConfig;         // Staged by REPORT:<sink>:..., picked up by the sink
+StagedReportPolicy udpPolicyConfig;
+char configQuery[COMMAND_MAX_ARGUMENT + 1] = "";    // CFG:<key>[=<value>] being answered
+volatile ConfigResult configResult = CONFIG_OK;
+int bleSinkIndex = -1;                      // Pipeline sink slots, -1 when run from the fallback loop
+int udpSinkIndex = -1;
 WiFiUDP udp;
 UIManager uiManager;
+TaskPipeline pipeline;
 
 // Separate I2C for IMU (different from touch I2C)
 TwoWire IMU_Wire = TwoWire(1);
@@ -32,14 +112,23 @@ TwoWire IMU_Wire = TwoWire(1);
 // WiFi Configuration
 const char* ssid = WIFI_SSID;
 const char* password = WIFI_PASSWORD;
-const IPAddress remoteIP(172, 16, 2, 158);
-const uint16_t remotePort = 9000;
+// CFG:udp_host / CFG:udp_port: published as one copy by applyUdpConfig() on the
+// sink task, copied out by UdpLink::send() on the UDP task
+struct UdpTarget {
+    IPAddress ip;
+    uint16_t port;
+};
+UdpTarget udpTarget = { IPAddress(), UDP_TARGET_PORT };
+portMUX_TYPE udpTargetMux = portMUX_INITIALIZER_UNLOCKED;
 
 // BLE objects
 BLECharacteristic* telemetryChar = nullptr;
 BLECharacteristic* configChar = nullptr;
 BLECharacteristic* fileTransferChar = nullptr;
 BLE2902* telemetryDescriptor = nullptr;
+QueueHandle_t fileTransferAcks = nullptr;  // FtAckFrame from the BLE callback to the sink task
+QueueHandle_t commandAcks = nullptr;       // CommandResponseHeader answering binary requests, sent by the sink task
+volatile uint8_t commandReplyIds[CMD_COUNT];    // Request id a command's next reply answers, 0 = text
 
 // Global data structures
 SystemData systemData;
@@ -47,11 +136,15 @@ GPSData gpsData;
 IMUData imuData;
 BatteryData batteryData;
 PerformanceStats perfStats;
+ImuReadStats imuReadStats;
+uint8_t imuChipType = 0;        // WHO_AM_I, read once in initIMU()
 FileTransferState fileTransfer;
 
 // SD Card and Logging
-File logFile;
-String pendingFilename = "";
+SdLogger sdLogger;
+DeltaEncoder logEncoder;
+char pendingFilename[COMMAND_MAX_ARGUMENT + 1] = "";    // DOWNLOAD/DELETE argument
+unsigned long lastPacketDelta = 0;
 
 // Forward declarations
 class EnhancedConfigCallbacks;
@@ -69,10 +162,13 @@ void debugPrintln(const String& message) {
 
 void debugPrintf(const char* format, ...) {
     if(debugMode && DEBUG_PERIPHERAL_INIT) {
+        // Serial.printf is variadic itself and cannot take a va_list
+        char line[DEBUG_LINE_SIZE];
         va_list args;
         va_start(args, format);
-        Serial.printf(format, args);
+        vsnprintf(line, sizeof(line), format, args);
         va_end(args);
+        Serial.print(line);
     }
 }
 
@@ -108,80 +204,175 @@ int16_t readRegister16(uint8_t reg) {
     return value;
 }
 
-// CRC16 calculation
-uint16_t crc16(const uint8_t* data, size_t length) {
-    uint16_t crc = 0x0000;
-    for (size_t i = 0; i < length; i++) {
-        crc ^= (uint16_t)data[i] << 8;
-        for (uint8_t j = 0; j < 8; j++) {
-            if (crc & 0x8000)
-                crc = (crc << 1) ^ 0x1021;
-            else
-                crc <<= 1;
-        }
-    }
-    return crc;
+// Read `length` consecutive registers in a single I2C transaction (auto-increment)
+bool readRegisters(uint8_t reg, uint8_t* buffer, size_t length) {
+    IMU_Wire.beginTransmission(MPU6xxx_ADDRESS);
+    IMU_Wire.write(reg);
+    if (IMU_Wire.endTransmission(false) != 0) return false;
+    if (IMU_Wire.requestFrom((uint8_t)MPU6xxx_ADDRESS, (uint8_t)length, (uint8_t)1) != length) return false;
+    return IMU_Wire.readBytes(buffer, length) == length;
 }
 
-bool calibrateAccelerometer() {
-    debugPrintln("🔧 Calibrating accelerometer...");
-    
-    const int CALIBRATION_SAMPLES = 100;
-    const int CALIBRATION_DELAY = 20;
-    
-    float accelSumX = 0, accelSumY = 0, accelSumZ = 0;
-    float gyroSumX = 0, gyroSumY = 0, gyroSumZ = 0;
-    
-    for (int i = 0; i < CALIBRATION_SAMPLES; i++) {
-        int16_t accelX = readRegister16(MPU6xxx_ACCEL_XOUT_H);
-        int16_t accelY = readRegister16(MPU6xxx_ACCEL_XOUT_H + 2);
-        int16_t accelZ = readRegister16(MPU6xxx_ACCEL_XOUT_H + 4);
-        
-        int16_t gyroX = readRegister16(MPU6xxx_GYRO_XOUT_H);
-        int16_t gyroY = readRegister16(MPU6xxx_GYRO_XOUT_H + 2);
-        int16_t gyroZ = readRegister16(MPU6xxx_GYRO_XOUT_H + 4);
-        
-        float accelX_g = accelX / 16384.0;
-        float accelY_g = accelY / 16384.0;
-        float accelZ_g = accelZ / 16384.0;
-        
-        float gyroX_dps = gyroX / 131.0;
-        float gyroY_dps = gyroY / 131.0;
-        float gyroZ_dps = gyroZ / 131.0;
-        
-        accelSumX += accelX_g;
-        accelSumY += accelY_g;
-        accelSumZ += accelZ_g;
-        
-        gyroSumX += gyroX_dps;
-        gyroSumY += gyroY_dps;
-        gyroSumZ += gyroZ_dps;
-        
-        delay(CALIBRATION_DELAY);
+bool readMPUBurst(MpuReading& out) {
+    PROBE_SCOPE(PROBE_IMU_READ);
+    uint8_t raw[MPU6xxx_BURST_LENGTH];
+    
+    int64_t start = esp_timer_get_time();
+    bool ok = readRegisters(MPU6xxx_ACCEL_XOUT_H, raw, sizeof(raw));
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+    
+    imuReadStats.reads++;
+    imuReadStats.lastReadUs = elapsed;
+    imuReadStats.totalReadUs += elapsed;
+    if (elapsed > imuReadStats.maxReadUs) imuReadStats.maxReadUs = elapsed;
+    if (!ok) {
+        imuReadStats.errors++;
+        return false;
     }
     
-    imuData.accelOffsetX = accelSumX / CALIBRATION_SAMPLES;
-    imuData.accelOffsetY = accelSumY / CALIBRATION_SAMPLES;
-    imuData.accelOffsetZ = (accelSumZ / CALIBRATION_SAMPLES) - 1.0;
+    decodeMPUBurst(raw, out);
+    return true;
+}
+
+// Time the old seven-transaction read against the burst read (boot diagnostics)
+void compareIMUReadTiming() {
+    const int ITERATIONS = 50;
+    MpuReading reading;
+    
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < ITERATIONS; i++) {
+        readRegister16(MPU6xxx_ACCEL_XOUT_H);
+        readRegister16(MPU6xxx_ACCEL_XOUT_H + 2);
+        readRegister16(MPU6xxx_ACCEL_XOUT_H + 4);
+        readRegister16(MPU6xxx_GYRO_XOUT_H);
+        readRegister16(MPU6xxx_GYRO_XOUT_H + 2);
+        readRegister16(MPU6xxx_GYRO_XOUT_H + 4);
+        readRegister16(MPU6xxx_TEMP_OUT_H);
+    }
+    float perRegisterUs = (float)(esp_timer_get_time() - start) / ITERATIONS;
     
-    imuData.gyroOffsetX = gyroSumX / CALIBRATION_SAMPLES;
-    imuData.gyroOffsetY = gyroSumY / CALIBRATION_SAMPLES;
-    imuData.gyroOffsetZ = gyroSumZ / CALIBRATION_SAMPLES;
+    start = esp_timer_get_time();
+    for (int i = 0; i < ITERATIONS; i++) {
+        uint8_t raw[MPU6xxx_BURST_LENGTH];
+        readRegisters(MPU6xxx_ACCEL_XOUT_H, raw, sizeof(raw));
+        decodeMPUBurst(raw, reading);
+    }
+    float burstUs = (float)(esp_timer_get_time() - start) / ITERATIONS;
     
+    debugPrintf("⏱️ IMU read: 7 x 16-bit %.0fus, 14-byte burst %.0fus (%.1fx)\n",
+                perRegisterUs, burstUs, burstUs > 0 ? perRegisterUs / burstUs : 0.0f);
+}
+
+// IMU offsets persist in NVS so a calibrated device is ready at boot
+bool loadIMUCalibration() {
+    float offsets[6];
+    preferences.begin("imu_cal", true);
+    bool ok = preferences.getBytes("offsets", offsets, sizeof(offsets)) == sizeof(offsets);
+    preferences.end();
+    if (!ok) return false;
+    
+    imuData.accelOffsetX = offsets[0];
+    imuData.accelOffsetY = offsets[1];
+    imuData.accelOffsetZ = offsets[2];
+    imuData.gyroOffsetX = offsets[3];
+    imuData.gyroOffsetY = offsets[4];
+    imuData.gyroOffsetZ = offsets[5];
     imuData.isCalibrated = true;
     
-    debugPrintln("✅ IMU calibration complete!");
-    debugPrintf("📊 Accel offsets: X=%.4f, Y=%.4f, Z=%.4f\n", 
-                  imuData.accelOffsetX, imuData.accelOffsetY, imuData.accelOffsetZ);
-    
+    debugPrintf("📊 IMU offsets from NVS: accel %.4f %.4f %.4f gyro %.3f %.3f %.3f\n",
+                offsets[0], offsets[1], offsets[2], offsets[3], offsets[4], offsets[5]);
     return true;
 }
 
+void saveIMUCalibration() {
+    float offsets[6] = {
+        imuData.accelOffsetX, imuData.accelOffsetY, imuData.accelOffsetZ,
+        imuData.gyroOffsetX, imuData.gyroOffsetY, imuData.gyroOffsetZ
+    };
+    preferences.begin("imu_cal", false);
+    bool ok = preferences.putBytes("offsets", offsets, sizeof(offsets)) == sizeof(offsets);
+    preferences.end();
+    debugPrintln(ok ? "💾 IMU calibration saved" : "❌ IMU calibration save failed");
+}
+
+// Runtime configuration (config_registry.h) lives in its own NVS namespace.
+// Used from setup() and the sink task, like the IMU calibration.
+class NvsConfigStore : public ConfigStore {
+public:
+    size_t read(const char* key, uint8_t* buffer, size_t size) override {
+        if (!preferences.begin(CONFIG_NVS_NAMESPACE, true)) return 0;     // Nothing saved yet
+        size_t length = preferences.isKey(key) ? preferences.getBytes(key, buffer, size) : 0;
+        preferences.end();
+        return length;
+    }
+    bool write(const char* key, const uint8_t* data, size_t length) override {
+        if (!preferences.begin(CONFIG_NVS_NAMESPACE, false)) return false;
+        bool ok = preferences.putBytes(key, data, length) == length;
+        preferences.end();
+        return ok;
+    }
+    bool erase(const char* key) override {
+        if (!preferences.begin(CONFIG_NVS_NAMESPACE, false)) return false;
+        bool ok = !preferences.isKey(key) || preferences.remove(key);
+        preferences.end();
+        return ok;
+    }
+};
+
+NvsConfigStore nvsConfigStore;
+
+// Called from UI / BLE context - calibration itself runs in the sampling path
+void requestIMUCalibration() {
+    pendingIMUCalibration = true;
+}
+
+void startIMUCalibration() {
+    imuCalibrator.start(millis());
+    imuData.calibrationInProgress = true;
+    imuData.calibrationSamples = 0;
+    imuData.calibrationStartTime = millis();
+    debugPrintln("🔧 IMU calibration started - keep the device still");
+    uiManager.requestUpdate();
+}
+
+// Feed one uncalibrated reading to a running calibration
+void updateIMUCalibration(const MpuReading& reading) {
+    const float accel[3] = { reading.accelX, reading.accelY, reading.accelZ };
+    const float gyro[3] = { reading.gyroX, reading.gyroY, reading.gyroZ };
+    
+    bool finished = imuCalibrator.addSample(accel, gyro, millis());
+    imuData.calibrationSamples = imuCalibrator.getSamples();
+    if (!finished) return;
+    
+    imuData.calibrationInProgress = false;
+    if (imuCalibrator.getState() == IMU_CAL_DONE) {
+        const ImuCalibrationResult& result = imuCalibrator.getResult();
+        imuData.accelOffsetX = result.accelOffset[0];
+        imuData.accelOffsetY = result.accelOffset[1];
+        imuData.accelOffsetZ = result.accelOffset[2];
+        imuData.gyroOffsetX = result.gyroOffset[0];
+        imuData.gyroOffsetY = result.gyroOffset[1];
+        imuData.gyroOffsetZ = result.gyroOffset[2];
+        imuData.isCalibrated = true;
+        pendingSaveIMUCalibration = true;
+        
+        debugPrintf("✅ IMU calibration complete in %lums (σ accel %.4fg gyro %.3f°/s, %lu restarts)\n",
+                    millis() - imuData.calibrationStartTime, result.accelStd, result.gyroStd,
+                    imuCalibrator.getRestarts());
+        debugPrintf("📊 Accel offsets: X=%.4f, Y=%.4f, Z=%.4f\n", 
+                    imuData.accelOffsetX, imuData.accelOffsetY, imuData.accelOffsetZ);
+    } else {
+        debugPrintf("⚠️ IMU calibration failed: device kept moving (%lu restarts)\n",
+                    imuCalibrator.getRestarts());
+    }
+    uiManager.requestUpdate();
+}
+
 bool configureGNSS() {
     debugPrintln("🛰️ Configuring GNSS...");
     
     myGNSS.setUART1Output(COM_TYPE_UBX);
-    myGNSS.setNavigationFrequency(25);
+    myGNSS.setNavigationFrequency(deviceConfig.get(CFG_NAV_RATE_HZ));
     myGNSS.setAutoPVT(true);
     myGNSS.setDynamicModel(DYN_MODEL_AUTOMOTIVE);
     
@@ -192,54 +383,43 @@ bool configureGNSS() {
     return true;
 }
 
-void readMPU6050() {
-    if (!systemData.mpuAvailable) return;
-    
-    int16_t accelX = readRegister16(MPU6xxx_ACCEL_XOUT_H);
-    int16_t accelY = readRegister16(MPU6xxx_ACCEL_XOUT_H + 2);
-    int16_t accelZ = readRegister16(MPU6xxx_ACCEL_XOUT_H + 4);
-    
-    int16_t gyroX = readRegister16(MPU6xxx_GYRO_XOUT_H);
-    int16_t gyroY = readRegister16(MPU6xxx_GYRO_XOUT_H + 2);
-    int16_t gyroZ = readRegister16(MPU6xxx_GYRO_XOUT_H + 4);
-    
-    int16_t temp = readRegister16(MPU6xxx_TEMP_OUT_H);
-    
-    float rawAccelX = accelX / 16384.0;
-    float rawAccelY = accelY / 16384.0;
-    float rawAccelZ = accelZ / 16384.0;
-    
-    float rawGyroX = gyroX / 131.0;
-    float rawGyroY = gyroY / 131.0;
-    float rawGyroZ = gyroZ / 131.0;
+// Drain the UART2 RX buffer through the UBX parser. Returns true when a new NAV-PVT arrived.
+// After configureGNSS() the SparkFun library is no longer polled; the module pushes NAV-PVT
+// on its own (auto PVT) and we decode it here in a single pass.
+bool pollGNSS() {
+    PROBE_SCOPE(PROBE_GNSS_PARSE);
+    uint8_t buffer[GNSS_RX_CHUNK];
+    return ubxParser.poll(gnssStream, buffer, sizeof(buffer)) > 0;
+}
+
+// Apply calibration and update temperature/motion state from one IMU reading
+void applyIMUReading(const MpuReading& reading) {
+    if (imuCalibrator.isCollecting()) {
+        updateIMUCalibration(reading);
+    }
     
     if (imuData.isCalibrated) {
-        imuData.accelX = rawAccelX - imuData.accelOffsetX;
-        imuData.accelY = rawAccelY - imuData.accelOffsetY;
-        imuData.accelZ = rawAccelZ - imuData.accelOffsetZ;
+        imuData.accelX = reading.accelX - imuData.accelOffsetX;
+        imuData.accelY = reading.accelY - imuData.accelOffsetY;
+        imuData.accelZ = reading.accelZ - imuData.accelOffsetZ;
         
-        imuData.gyroX = rawGyroX - imuData.gyroOffsetX;
-        imuData.gyroY = rawGyroY - imuData.gyroOffsetY;
-        imuData.gyroZ = rawGyroZ - imuData.gyroOffsetZ;
+        imuData.gyroX = reading.gyroX - imuData.gyroOffsetX;
+        imuData.gyroY = reading.gyroY - imuData.gyroOffsetY;
+        imuData.gyroZ = reading.gyroZ - imuData.gyroOffsetZ;
     } else {
-        imuData.accelX = rawAccelX;
-        imuData.accelY = rawAccelY;
-        imuData.accelZ = rawAccelZ;
+        imuData.accelX = reading.accelX;
+        imuData.accelY = reading.accelY;
+        imuData.accelZ = reading.accelZ;
         
-        imuData.gyroX = rawGyroX;
-        imuData.gyroY = rawGyroY;
-        imuData.gyroZ = rawGyroZ;
-    }
-    
-    static uint8_t chipType = 0;
-    if (chipType == 0) {
-        chipType = readRegister(MPU6xxx_WHO_AM_I);
+        imuData.gyroX = reading.gyroX;
+        imuData.gyroY = reading.gyroY;
+        imuData.gyroZ = reading.gyroZ;
     }
     
-    if (chipType == 0x68) {
-        imuData.temperature = (temp / 340.0) + 36.53;
+    if (imuChipType == 0x68) {
+        imuData.temperature = (reading.rawTemp / 340.0) + 36.53;
     } else {
-        imuData.temperature = (temp / 333.87) + 21.0;
+        imuData.temperature = (reading.rawTemp / 333.87) + 21.0;
     }
     
     imuData.magnitude = sqrt(imuData.accelX * imuData.accelX + 
@@ -267,6 +447,69 @@ void readMPU6050() {
     }
 }
 
+// Propagate the fusion filter with the calibrated reading in imuData and
+// publish the fused state at FUSION_OUTPUT_HZ
+void predictFusion(int64_t timestampUs) {
+    if (!fusionActive || imuCalibrator.isCollecting()) return;
+    
+    int64_t start = esp_timer_get_time();
+    fusion.predict(timestampUs, imuData.accelX * 9.80665f,
+                   FUSION_YAW_SIGN * imuData.gyroZ * (PI / 180.0f));
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+    fusionTiming.lastPredictUs = elapsed;
+    if (elapsed > fusionTiming.maxPredictUs) fusionTiming.maxPredictUs = elapsed;
+    
+    static int64_t lastPublishUs = 0;
+    if (fusion.isInitialized() && timestampUs - lastPublishUs >= 1000000 / FUSION_OUTPUT_HZ) {
+        lastPublishUs = timestampUs;
+        FusionState state;
+        fusion.getState(state);
+        fusionBus.push(state);
+        fusionTiming.published++;
+    }
+}
+
+// Correct the fusion filter with the NAV-PVT that was just decoded
+void correctFusion(const UbxNavPvt& pvt, int64_t timestampUs) {
+    if (!fusionActive || !(pvt.flags & 0x01) || pvt.fixType < 2) return;   // gnssFixOK, 2D or better
+    
+    FusionGnssFix fix;
+    fix.timestampUs = timestampUs;
+    fix.latitude = pvt.lat;
+    fix.longitude = pvt.lon;
+    fix.speed = pvt.gSpeed * 0.001f;
+    fix.heading = pvt.headMot * 1e-5f;
+    fix.horizontalAccuracy = pvt.hAcc * 0.001f;
+    fix.speedAccuracy = pvt.sAcc * 0.001f;
+    fix.headingAccuracy = pvt.headAcc * 1e-5f;
+    
+    int64_t start = esp_timer_get_time();
+    fusion.correct(fix);
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+    fusionTiming.lastCorrectUs = elapsed;
+    if (elapsed > fusionTiming.maxCorrectUs) fusionTiming.maxCorrectUs = elapsed;
+}
+
+// Polled fallback when the FIFO sampler is not running
+void readMPU6050() {
+    if (!systemData.mpuAvailable) return;
+    
+    MpuReading reading;
+    if (readMPUBurst(reading)) {
+        applyIMUReading(reading);
+        predictFusion(esp_timer_get_time());
+    }
+}
+
+// Consume every IMU sample the sampler task published since the last call
+void consumeIMUSamples() {
+    ImuSample sample;
+    while (imuSampler.getBus().read(imuConsumerId, sample)) {
+        applyIMUReading(sample.reading);
+        predictFusion(sample.timestampUs);
+    }
+}
+
 // Basic battery monitoring using ADC (JC3248W535EN doesn't have PMU)
 void updateBatteryData() {
     static unsigned long lastBatteryUpdate = 0;
@@ -295,7 +538,7 @@ void updateBatteryData() {
 
 // Robust peripheral initialization functions
 bool initGPS() {
-    if (!ENABLE_GPS) {
+    if (!deviceConfig.getBool(CFG_ENABLE_GPS)) {
         debugPrintln("🛰️ GPS disabled in configuration");
         return false;
     }
@@ -303,11 +546,12 @@ bool initGPS() {
     debugPrintln("🛰️ Initializing GPS...");
     unsigned long startTime = millis();
     
-    // Try high speed first
+    // Try high speed first (RX buffer sized for several epochs of NAV-PVT)
+    GNSS_Serial.setRxBufferSize(GNSS_RX_BUFFER_SIZE);
     GNSS_Serial.begin(921600, SERIAL_8N1, GNSS_RX, GNSS_TX);
     delay(100);
     
-    while (millis() - startTime < GPS_INIT_TIMEOUT_MS) {
+    while (millis() - startTime < deviceConfig.get(CFG_GPS_TIMEOUT_MS)) {
         if (myGNSS.begin(GNSS_Serial)) {
             debugPrintln("✅ GPS detected at 921600 baud");
             configureGNSS();
@@ -319,11 +563,12 @@ bool initGPS() {
     // Try standard speed
     GNSS_Serial.end();
     delay(100);
+    GNSS_Serial.setRxBufferSize(GNSS_RX_BUFFER_SIZE);
     GNSS_Serial.begin(115200, SERIAL_8N1, GNSS_RX, GNSS_TX);
     delay(100);
     
     startTime = millis();
-    while (millis() - startTime < GPS_INIT_TIMEOUT_MS / 2) {
+    while (millis() - startTime < deviceConfig.get(CFG_GPS_TIMEOUT_MS) / 2) {
         if (myGNSS.begin(GNSS_Serial)) {
             debugPrintln("✅ GPS detected at 115200 baud");
             configureGNSS();
@@ -337,7 +582,7 @@ bool initGPS() {
 }
 
 bool initIMU() {
-    if (!ENABLE_IMU) {
+    if (!deviceConfig.getBool(CFG_ENABLE_IMU)) {
         debugPrintln("📄 IMU disabled in configuration");
         return false;
     }
@@ -356,6 +601,7 @@ bool initIMU() {
         
         if (whoami == 0x68 || whoami == 0x70 || whoami == 0x71 || whoami == 0x73) {
             debugPrintln("✅ IMU detected");
+            imuChipType = whoami;
             
             writeRegister(MPU6xxx_PWR_MGMT_1, 0x00);
             delay(100);
@@ -366,7 +612,9 @@ bool initIMU() {
             int16_t testRead = readRegister16(MPU6xxx_ACCEL_XOUT_H);
             if (testRead != -1 && testRead != 0) {
                 debugPrintln("✅ IMU communication verified");
-                calibrateAccelerometer();
+                if (DEBUG_PERIPHERAL_INIT) {
+                    compareIMUReadTiming();
+                }
                 return true;
             }
         }
@@ -378,7 +626,7 @@ bool initIMU() {
 }
 
 bool initSDCardRobust() {
-    if (!ENABLE_SD_CARD) {
+    if (!deviceConfig.getBool(CFG_ENABLE_SD)) {
         debugPrintln("📱 SD Card disabled in configuration");
         return false;
     }
@@ -421,7 +669,7 @@ bool initSDCardRobust() {
 }
 
 bool initWiFiRobust() {
-    if (!ENABLE_WIFI) {
+    if (!deviceConfig.getBool(CFG_ENABLE_WIFI)) {
         debugPrintln("📡 WiFi disabled in configuration");
         wifiUDPEnabled = false;
         return false;
@@ -432,7 +680,7 @@ bool initWiFiRobust() {
     WiFi.begin(ssid, password);
     
     unsigned long startTime = millis();
-    while (WiFi.status() != WL_CONNECTED && millis() - startTime < WIFI_CONNECT_TIMEOUT_MS) {
+    while (WiFi.status() != WL_CONNECTED && millis() - startTime < deviceConfig.get(CFG_WIFI_TIMEOUT_MS)) {
         delay(1000);
         debugPrint(".");
     }
@@ -451,16 +699,16 @@ bool initWiFiRobust() {
 
 // Mock data generation for missing peripherals
 void generateMockGPSData() {
-    static float mockLat = 52.2297;  // Warsaw coordinates
-    static float mockLon = 21.0122;
+    static const int32_t mockLat = 522297000;  // Warsaw coordinates (deg * 1e7)
+    static const int32_t mockLon = 210122000;
     static unsigned long lastMockUpdate = 0;
     
     if (millis() - lastMockUpdate > 1000) {  // Update every second
-        gpsData.latitude = mockLat + (random(-100, 100) / 100000.0);
-        gpsData.longitude = mockLon + (random(-100, 100) / 100000.0);
-        gpsData.altitude = 100 + random(-10, 10);
-        gpsData.speed = random(0, 60);
-        gpsData.heading = random(0, 360);
+        gpsData.latitude = mockLat + random(-100, 100) * 100;
+        gpsData.longitude = mockLon + random(-100, 100) * 100;
+        gpsData.altitude = (100 + random(-10, 10)) * 1000;
+        gpsData.speed = random(0, 16667);               // 0-60 km/h
+        gpsData.heading = random(0, 360) * 100000;
         gpsData.fixType = 3;  // 3D fix
         gpsData.satellites = random(8, 12);
         gpsData.timestamp = millis() / 1000;
@@ -504,30 +752,26 @@ bool createLogFile() {
         gpsData.year, gpsData.month, gpsData.day,
         gpsData.hour, gpsData.minute, gpsData.second);
     
-    logFile = SD.open(currentLogFilename, FILE_WRITE);
-    if (!logFile) {
+    // Queued only: serviceHousekeeping() reports the writer's result
+    bool queued = SD_LOG_DELTA_ENCODING
+        ? sdLogger.open(currentLogFilename, gpsData.timestamp, 0, LOG_ENCODING_DELTA)
+        : sdLogger.open(currentLogFilename, gpsData.timestamp, sizeof(GPSPacket), LOG_ENCODING_RAW);
+    if (!queued) {
         debugPrintln("❌ Failed to create log file");
         return false;
     }
-    
-    debugPrintf("📄 Created: %s\n", currentLogFilename);
-    
-    const char* header = "GPS_LOG_V1.0\n";
-    logFile.write((uint8_t*)header, strlen(header));
-    logFile.flush();
-    
     return true;
 }
 
 void toggleLogging() {
     if (systemData.loggingActive) {
         systemData.loggingActive = false;
-        if (logFile) {
-            logFile.close();
+        if (sdLogger.isOpen()) {
+            sdLogger.close();
             debugPrintln("⚪ Logging stopped");
         }
     } else {
-        if (systemData.sdCardAvailable && (gpsData.fixType >= 2 || !ENABLE_GPS)) {
+        if (systemData.sdCardAvailable && (gpsData.fixType >= 2 || !deviceConfig.getBool(CFG_ENABLE_GPS))) {
             systemData.loggingActive = true;
             if (createLogFile()) {
                 debugPrintln("🔴 Logging started");
@@ -541,22 +785,180 @@ void toggleLogging() {
     uiManager.requestUpdate();
 }
 
-// File transfer functions (same as original)
+// Called from UI / BLE context - the actual toggle runs on the sink task, which owns the SD card
+void requestToggleLogging() {
+    pendingToggleLogging = true;
+}
+
+// Largest notification payload the current connection accepts
+size_t bleNotifyPayload() {
+    return systemData.bleLink.mtu - 3;
+}
+
+// Every BLE notification goes through here so link throughput is measured in one place
+bool bleNotify(BLECharacteristic* characteristic, const uint8_t* data, size_t length) {
+    BleLinkState& link = systemData.bleLink;
+    if (length > bleNotifyPayload()) {
+        link.oversizeDrops++;
+        return false;
+    }
+    
+    PROBE_SCOPE(PROBE_BLE_NOTIFY);
+    characteristic->setValue((uint8_t*)data, length);
+    characteristic->notify();
+    link.notifications++;
+    link.notifyBytes += length;
+    return true;
+}
+
+void updateBleLinkThroughput() {
+    static unsigned long lastTime = 0;
+    static uint32_t lastBytes = 0;
+    
+    unsigned long now = millis();
+    if (now - lastTime < 1000) return;
+    
+    BleLinkState& link = systemData.bleLink;
+    link.throughputBps = (uint64_t)(link.notifyBytes - lastBytes) * 1000 / (now - lastTime);
+    lastBytes = link.notifyBytes;
+    lastTime = now;
+}
+
+// PacketLink adapters (platform_io.h) used by the sinks and the file transfer
+class BleNotifyLink : public PacketLink {
+public:
+    explicit BleNotifyLink(BLECharacteristic** characteristic) : characteristic(characteristic) {}
+    bool isReady() override { return *characteristic && systemData.bleLink.connected; }
+    size_t maxPayload() override { return bleNotifyPayload(); }
+    bool send(const uint8_t* data, size_t length) override { return bleNotify(*characteristic, data, length); }
+private:
+    BLECharacteristic** characteristic;     // Created in initBLERobust()
+};
+
+class UdpLink : public PacketLink {
+public:
+    bool isReady() override { return deviceConfig.getBool(CFG_ENABLE_WIFI) && wifiUDPEnabled && WiFi.status() == WL_CONNECTED; }
+    size_t maxPayload() override { return UDP_MAX_DATAGRAM; }
+    bool send(const uint8_t* data, size_t length) override {
+        PROBE_SCOPE(PROBE_UDP_SEND);
+        portENTER_CRITICAL(&udpTargetMux);
+        UdpTarget target = udpTarget;
+        portEXIT_CRITICAL(&udpTargetMux);
+        if (length > maxPayload() || !udp.beginPacket(target.ip, target.port)) return false;
+        udp.write(data, length);
+        return udp.endPacket() == 1;
+    }
+};
+
+BleNotifyLink bleTelemetryLink(&telemetryChar);
+BleNotifyLink bleFileLink(&fileTransferChar);
+UdpLink udpLink;
+
+// Replies are queued one notification per entry and paced from the
+// housekeeping pass, like processFileTransfer() paces frames, so a long LIST
+// or CFG reply never sleeps the sink task. Sink task only.
+struct ReplyChunk {
+    std::vector<uint8_t> data;
+    bool continuation;          // Not the first chunk of its reply: waits BLE_TEXT_CHUNK_DELAY_MS
+};
+std::deque<ReplyChunk> replyQueue;
+unsigned long lastReplyChunkTime = 0;
+
+void queueReplyChunk(const uint8_t* data, size_t length, bool continuation) {
+    replyQueue.push_back(ReplyChunk());
+    replyQueue.back().data.assign(data, data + length);
+    replyQueue.back().continuation = continuation;
+}
+
+void sendQueuedReplies() {
+    if (!fileTransferChar || !systemData.bleLink.connected) {
+        replyQueue.clear();
+        return;
+    }
+    while (!replyQueue.empty()) {
+        const ReplyChunk& chunk = replyQueue.front();
+        unsigned long now = millis();
+        if (chunk.continuation && now - lastReplyChunkTime < BLE_TEXT_CHUNK_DELAY_MS) return;
+        bleNotify(fileTransferChar, chunk.data.data(), chunk.data.size());
+        lastReplyChunkTime = now;
+        replyQueue.pop_front();
+    }
+}
+
+// File transfer functions
 void sendFileResponse(String response) {
     if (!fileTransferChar) return;
     
-    int maxChunkSize = 400;
-    for (int i = 0; i < response.length(); i += maxChunkSize) {
-        String chunk = response.substring(i, min(i + maxChunkSize, (int)response.length()));
-        fileTransferChar->setValue(chunk.c_str());
-        fileTransferChar->notify();
-        delay(50);
+    size_t chunkSize = bleNotifyPayload();
+    for (size_t i = 0; i < response.length(); i += chunkSize) {
+        size_t length = min(chunkSize, response.length() - i);
+        queueReplyChunk((const uint8_t*)response.c_str() + i, length, i > 0);
+    }
+    sendQueuedReplies();
+}
+
+// One binary reply (command_frame.h), split over notifications when needed
+void sendCommandResponse(uint8_t requestId, uint8_t opcode, CommandStatus status,
+                         const uint8_t* payload, size_t length) {
+    const size_t overhead = sizeof(CommandResponseHeader) + 2;
+    if (!fileTransferChar || bleNotifyPayload() <= overhead) return;
+    
+    uint8_t frame[CMD_RESPONSE_MAX_SIZE];
+    size_t chunkSize = min(bleNotifyPayload() - overhead, (size_t)CMD_RESPONSE_MAX_PAYLOAD);
+    size_t offset = 0;
+    do {
+        size_t chunk = min(chunkSize, length - offset);
+        uint8_t flags = offset + chunk < length ? CMD_RESPONSE_FLAG_MORE : 0;
+        size_t frameLength = encodeCommandResponse(requestId, opcode, status, flags, payload + offset, chunk, frame);
+        queueReplyChunk(frame, frameLength, offset > 0);
+        offset += chunk;
+    } while (offset < length);
+    sendQueuedReplies();
+}
+
+// A reply to a binary request carries its request id; text commands get the text as before
+void sendCommandReply(CommandId id, const String& reply, CommandStatus status = CMD_STATUS_OK) {
+    uint8_t requestId = commandReplyIds[id];
+    if (requestId == 0) {
+        sendFileResponse(reply);
+        return;
+    }
+    commandReplyIds[id] = 0;
+    sendCommandResponse(requestId, commandOpcode(id), status, (const uint8_t*)reply.c_str(), reply.length());
+}
+
+// Immediate answers to binary requests, queued by the BLE callbacks
+void sendCommandAcks() {
+    CommandResponseHeader ack;
+    while (commandAcks && xQueueReceive(commandAcks, &ack, 0) == pdTRUE) {
+        sendCommandResponse(ack.requestId, ack.opcode, (CommandStatus)ack.status, nullptr, 0);
+    }
+}
+
+void sendFileStatus() {
+    String status = "STATUS:";
+    if (fileTransfer.active) {
+        // ACTIVE:<name>:<percent>:<acked bytes>:<bytes/s>:<eta s>
+        status += "ACTIVE:" + fileTransfer.filename + ":" + 
+                 String((int)fileTransfer.progressPercent) + ":" +
+                 String(fileTransfer.bytesSent) + ":" +
+                 String(fileTransfer.throughputBps) + ":" +
+                 String(fileTransfer.estimatedTimeRemaining / 1000);
+    } else {
+        status += "IDLE";
     }
+    
+    // :LINK:<mtu>:<tx octets>:<interval us>:<latency>:<timeout ms>:<notify bytes/s>
+    const BleLinkState& link = systemData.bleLink;
+    status += ":LINK:" + String(link.mtu) + ":" + String(link.txOctets) + ":" +
+              String((uint32_t)link.connInterval * 1250) + ":" + String(link.latency) + ":" +
+              String((uint32_t)link.supervisionTimeout * 10) + ":" + String(link.throughputBps);
+    sendCommandReply(CMD_TRANSFER_STATUS, status);
 }
 
 void listSDFiles() {
     if (!systemData.sdCardAvailable) {
-        sendFileResponse("ERROR:NO_SD_CARD");
+        sendCommandReply(CMD_LIST_FILES, "ERROR:NO_SD_CARD", CMD_STATUS_FAILED);
         return;
     }
     
@@ -564,7 +966,7 @@ void listSDFiles() {
     String fileList = "FILES:";
     File root = SD.open("/");
     if (!root) {
-        sendFileResponse("ERROR:CANT_OPEN_ROOT");
+        sendCommandReply(CMD_LIST_FILES, "ERROR:CANT_OPEN_ROOT", CMD_STATUS_FAILED);
         return;
     }
     
@@ -585,29 +987,24 @@ void listSDFiles() {
     root.close();
     
     fileList += "COUNT:" + String(fileCount);
-    sendFileResponse(fileList);
+    sendCommandReply(CMD_LIST_FILES, fileList);
     uiManager.requestUpdate();
 }
 
 void startFileTransfer(String filename) {
     if (!systemData.sdCardAvailable) {
-        sendFileResponse("ERROR:NO_SD_CARD");
+        sendCommandReply(CMD_DOWNLOAD, "ERROR:NO_SD_CARD", CMD_STATUS_FAILED);
         return;
     }
     
     String fullPath = "/" + filename;
     if (!SD.exists(fullPath.c_str())) {
-        sendFileResponse("ERROR:FILE_NOT_FOUND:" + filename);
+        sendCommandReply(CMD_DOWNLOAD, "ERROR:FILE_NOT_FOUND:" + filename, CMD_STATUS_FAILED);
         return;
     }
     
-    if (fileTransfer.active && fileTransfer.transferFile) {
-        fileTransfer.transferFile.close();
-    }
-    
-    fileTransfer.transferFile = SD.open(fullPath.c_str(), FILE_READ);
-    if (!fileTransfer.transferFile) {
-        sendFileResponse("ERROR:CANT_OPEN_FILE:" + filename);
+    if (!fileTransfer.transferFile.open(fullPath.c_str(), STORAGE_READ)) {
+        sendCommandReply(CMD_DOWNLOAD, "ERROR:CANT_OPEN_FILE:" + filename, CMD_STATUS_FAILED);
         return;
     }
     
@@ -618,85 +1015,118 @@ void startFileTransfer(String filename) {
     fileTransfer.lastChunkTime = millis();
     fileTransfer.progressPercent = 0.0f;
     fileTransfer.transferStartTime = millis();
-    
-    String response = "START:" + filename + ":" + String(fileTransfer.fileSize);
-    sendFileResponse(response);
-    
-    debugPrintf("📤 Starting transfer: %s (%d bytes)\n", filename.c_str(), fileTransfer.fileSize);
+    fileTransfer.estimatedTimeRemaining = 0;
+    fileTransfer.throughputBps = 0;
+    fileTransfer.stalledTimeouts = 0;
+    fileTransfer.payloadSize = ftPayloadSize(systemData.bleLink.mtu);
+    fileTransfer.sender.begin(fileTransfer.fileSize, fileTransfer.payloadSize, FT_WINDOW_FRAMES, millis());
+    if (fileTransferAcks) xQueueReset(fileTransferAcks);  // Stale acks from a previous transfer
+    
+    // START:<name>:<size>:<payload bytes per frame>:<window frames>
+    String response = "START:" + filename + ":" + String(fileTransfer.fileSize) + ":" +
+                      String(fileTransfer.payloadSize) + ":" + String(FT_WINDOW_FRAMES);
+    sendCommandReply(CMD_DOWNLOAD, response);
+    
+    debugPrintf("📤 Starting transfer: %s (%d bytes, %d-byte frames)\n",
+                filename.c_str(), fileTransfer.fileSize, fileTransfer.payloadSize);
+    uiManager.requestUpdate();
+}
+
+void finishFileTransfer() {
+    fileTransfer.transferFile.close();
+    fileTransfer.active = false;
+    fileTransfer.progressPercent = 0.0f;
+    fileTransfer.estimatedTimeRemaining = 0;
     uiManager.requestUpdate();
 }
 
+// Binary windowed transfer (file_transfer_protocol.h): drain acks, resend on
+// timeout, then fill the window with MTU-sized raw notifications.
 void processFileTransfer() {
-    if (!fileTransfer.active || !fileTransfer.transferFile) return;
+    if (!fileTransfer.active || !fileTransfer.transferFile.isOpen() || !fileTransferChar) return;
     
+    FtSender& sender = fileTransfer.sender;
     unsigned long now = millis();
-    if (now - fileTransfer.lastChunkTime < 100) return;
-    
-    const int chunkSize = 400;
-    uint8_t buffer[chunkSize];
-    
-    int bytesRead = fileTransfer.transferFile.read(buffer, chunkSize);
-    if (bytesRead > 0) {
-        String chunk = "CHUNK:";
-        for (int i = 0; i < bytesRead; i++) {
-            if (buffer[i] < 16) chunk += "0";
-            chunk += String(buffer[i], HEX);
-            if (chunk.length() > 800) break;
+    uint32_t ackedBefore = sender.getAckedOffset();
+    
+    FtAckFrame ack;
+    while (fileTransferAcks && xQueueReceive(fileTransferAcks, &ack, 0) == pdTRUE) {
+        sender.onAck(ack, now);
+    }
+    if (sender.getAckedOffset() > ackedBefore) {
+        fileTransfer.stalledTimeouts = 0;
+    }
+    
+    if (sender.checkTimeout(now, FT_ACK_TIMEOUT_MS)) {
+        if (++fileTransfer.stalledTimeouts >= FT_MAX_STALLED_TIMEOUTS) {
+            sendFileResponse("ERROR:TRANSFER_TIMEOUT:" + fileTransfer.filename);
+            debugPrintf("❌ Transfer timed out: %s at %u bytes\n",
+                        fileTransfer.filename.c_str(), sender.getAckedOffset());
+            finishFileTransfer();
+            return;
         }
-        
-        chunk += ":SEQ:" + String(fileTransfer.bytesSent / chunkSize);
-        
-        sendFileResponse(chunk);
-        fileTransfer.bytesSent += bytesRead;
+        debugPrintf("⏱️ No ack for %d ms, resending from %u\n", FT_ACK_TIMEOUT_MS, sender.getAckedOffset());
+    }
+    
+    static uint8_t frame[sizeof(FtDataHeader) + FT_MAX_PAYLOAD];
+    int sent = ftSendFrames(sender, fileTransfer.transferFile, bleFileLink, FT_FRAMES_PER_POLL, frame);
+    if (sent < 0) {
+        sendFileResponse("ERROR:READ_FAILED:" + fileTransfer.filename);
+        finishFileTransfer();
+        return;
+    }
+    if (sent > 0) {
         fileTransfer.lastChunkTime = now;
-        
-        fileTransfer.progressPercent = (float)fileTransfer.bytesSent / fileTransfer.fileSize * 100.0f;
-        
-        unsigned long elapsed = now - fileTransfer.transferStartTime;
-        if (elapsed > 2000 && fileTransfer.bytesSent > 0) {
-            float bytesPerMs = (float)fileTransfer.bytesSent / elapsed;
-            unsigned long remainingBytes = fileTransfer.fileSize - fileTransfer.bytesSent;
-            if (bytesPerMs > 0) {
-                fileTransfer.estimatedTimeRemaining = remainingBytes / bytesPerMs;
-            }
-        }
-        
-        if (fileTransfer.bytesSent % 2048 == 0) {
-            uiManager.requestUpdate();
-        }
-    } else {
-        fileTransfer.transferFile.close();
-        fileTransfer.active = false;
-        
-        unsigned long totalTime = now - fileTransfer.transferStartTime;
-        
-        sendFileResponse("COMPLETE:" + String(fileTransfer.bytesSent) + ":TIME:" + String(totalTime));
-        debugPrintf("✅ Transfer complete: %s (%d bytes in %.2fs)\n", 
-                     fileTransfer.filename.c_str(), fileTransfer.bytesSent, totalTime / 1000.0f);
-        
-        fileTransfer.progressPercent = 0.0f;
-        fileTransfer.estimatedTimeRemaining = 0;
+    }
+    
+    // Progress, throughput and ETA count acknowledged bytes only
+    fileTransfer.bytesSent = sender.getAckedOffset();
+    float progress = fileTransfer.fileSize > 0 ?
+        (float)fileTransfer.bytesSent / fileTransfer.fileSize * 100.0f : 100.0f;
+    if ((int)progress != (int)fileTransfer.progressPercent) {
         uiManager.requestUpdate();
     }
+    fileTransfer.progressPercent = progress;
+    
+    unsigned long elapsed = now - fileTransfer.transferStartTime;
+    if (elapsed > 0) {
+        fileTransfer.throughputBps = (uint64_t)fileTransfer.bytesSent * 1000 / elapsed;
+    }
+    if (fileTransfer.throughputBps > 0) {
+        fileTransfer.estimatedTimeRemaining =
+            (uint64_t)(fileTransfer.fileSize - fileTransfer.bytesSent) * 1000 / fileTransfer.throughputBps;
+    }
+    
+    if (sender.done()) {
+        FtEndFrame endFrame;
+        sender.buildEnd(endFrame);
+        bleFileLink.send((const uint8_t*)&endFrame, sizeof(endFrame));
+        
+        sendFileResponse("COMPLETE:" + String(fileTransfer.bytesSent) + ":TIME:" + String(elapsed));
+        debugPrintf("✅ Transfer complete: %s (%d bytes in %.2fs, %u B/s, %u frames, %u resent)\n",
+                    fileTransfer.filename.c_str(), fileTransfer.bytesSent, elapsed / 1000.0f,
+                    fileTransfer.throughputBps, sender.getFramesSent(), sender.getRetransmits());
+        finishFileTransfer();
+    }
 }
 
 void deleteFile(String filename) {
     if (!systemData.sdCardAvailable) {
-        sendFileResponse("ERROR:NO_SD_CARD");
+        sendCommandReply(CMD_DELETE, "ERROR:NO_SD_CARD", CMD_STATUS_FAILED);
         return;
     }
     
     String fullPath = "/" + filename;
     if (!SD.exists(fullPath.c_str())) {
-        sendFileResponse("ERROR:FILE_NOT_FOUND:" + filename);
+        sendCommandReply(CMD_DELETE, "ERROR:FILE_NOT_FOUND:" + filename, CMD_STATUS_FAILED);
         return;
     }
     
     if (SD.remove(fullPath.c_str())) {
-        sendFileResponse("DELETED:" + filename);
+        sendCommandReply(CMD_DELETE, "DELETED:" + filename);
         debugPrintf("🗑️ Deleted: %s\n", filename.c_str());
     } else {
-        sendFileResponse("ERROR:DELETE_FAILED:" + filename);
+        sendCommandReply(CMD_DELETE, "ERROR:DELETE_FAILED:" + filename, CMD_STATUS_FAILED);
     }
     
     uiManager.requestUpdate();
@@ -704,15 +1134,8 @@ void deleteFile(String filename) {
 
 void cancelFileTransfer() {
     if (fileTransfer.active) {
-        if (fileTransfer.transferFile) {
-            fileTransfer.transferFile.close();
-        }
-        fileTransfer.active = false;
         sendFileResponse("CANCELLED:" + fileTransfer.filename);
-        
-        fileTransfer.progressPercent = 0.0f;
-        fileTransfer.estimatedTimeRemaining = 0;
-        uiManager.requestUpdate();
+        finishFileTransfer();
     }
 }
 
@@ -723,92 +1146,299 @@ void processDeferredFileOperations() {
     } else if (pendingStartTransfer) {
         pendingStartTransfer = false;
         startFileTransfer(pendingFilename);
-        pendingFilename = "";
+        pendingFilename[0] = '\0';
     } else if (pendingDeleteFile) {
         pendingDeleteFile = false;
         deleteFile(pendingFilename);
-        pendingFilename = "";
+        pendingFilename[0] = '\0';
     } else if (pendingCancelTransfer) {
         pendingCancelTransfer = false;
         cancelFileTransfer();
     }
+    
+    if (pendingStatusRequest) {
+        pendingStatusRequest = false;
+        sendFileStatus();
+    }
 }
 
 // BLE Callbacks
-class EnhancedConfigCallbacks : public BLECharacteristicCallbacks {
-    void onWrite(BLECharacteristic* pCharacteristic) {
-        std::string stdValue = pCharacteristic->getValue();
-        String value = String(stdValue.c_str());
-        
-        if (value.length() == 0) return;
-        
-        debugPrintf("📝 Config command: %s\n", value.c_str());
-        
-        if (value == "START_LOG") {
-            if (systemData.sdCardAvailable && (gpsData.fixType >= 2 || !ENABLE_GPS)) {
+// Counts notifications the stack refused (congestion, no client)
+class NotifyStatusCallbacks : public BLECharacteristicCallbacks {
+    void onStatus(BLECharacteristic* pCharacteristic, Status s, uint32_t code) {
+        if (s == Status::ERROR_GATT || s == Status::ERROR_NO_CLIENT) {
+            systemData.bleLink.notifyErrors++;
+        }
+    }
+};
+
+// Runs on the BLE task (serial commands: the sink task): anything touching the SD card is deferred to the sink task
+void dispatchCommand(const ParsedCommand& cmd) {
+    switch (cmd.id) {
+        case CMD_START_LOG:
+            if (systemData.sdCardAvailable && (gpsData.fixType >= 2 || !deviceConfig.getBool(CFG_ENABLE_GPS))) {
                 systemData.loggingActive = true;
                 uiManager.requestUpdate();
             }
-        } else if (value == "STOP_LOG") {
-            systemData.loggingActive = false;
-            if (logFile) logFile.close();
+            break;
+        case CMD_STOP_LOG:
+            systemData.loggingActive = false;  // File is closed by the sink task
             uiManager.requestUpdate();
-        } else if (value == "LIST_FILES") {
+            break;
+        case CMD_LIST_FILES:
             pendingListFiles = true;
-        } else if (value.startsWith("DOWNLOAD:")) {
-            pendingFilename = value.substring(9);
+            break;
+        case CMD_DOWNLOAD:
+            strncpy(pendingFilename, cmd.argument, sizeof(pendingFilename) - 1);
             pendingStartTransfer = true;
-        } else if (value.startsWith("DELETE:")) {
-            pendingFilename = value.substring(7);
+            break;
+        case CMD_DELETE:
+            strncpy(pendingFilename, cmd.argument, sizeof(pendingFilename) - 1);
             pendingDeleteFile = true;
-        } else if (value == "CANCEL_TRANSFER") {
+            break;
+        case CMD_CANCEL_TRANSFER:
             pendingCancelTransfer = true;
+            break;
+        case CMD_TRANSFER_STATUS:
+            pendingStatusRequest = true;    // Reply may span several notifications
+            break;
+        case CMD_CALIBRATE_IMU:
+            requestIMUCalibration();
+            break;
+        case CMD_REPLAY: {
+            // REPLAY:<file>[:speed] - FAT names cannot contain ':'
+            strncpy(replayPath, cmd.argument, sizeof(replayPath) - 1);
+            char* speed = strchr(replayPath, ':');
+            replaySpeed = speed ? (uint16_t)atoi(speed + 1) : 1;
+            if (speed) *speed = '\0';
+            pendingStartReplay = true;
+            break;
+        }
+        case CMD_STOP_REPLAY:
+            pendingStopReplay = true;
+            break;
+        case CMD_BENCHMARK:
+            strncpy(benchFilter, cmd.argument, sizeof(benchFilter) - 1);
+            pendingBenchmark = true;
+            break;
+        case CMD_PROBES:
+            pendingProbeReset = strcmp(cmd.argument, "RESET") == 0;
+            pendingProbeReport = true;     // Reply may span several notifications
+            break;
+        case CMD_BLE_BATCH: {
+            int latencyMs = atoi(cmd.argument);
+            bleBatchLatencyMs = (uint16_t)constrain(latencyMs, 0, BLE_BATCH_MAX_LATENCY_MS);
+            debugPrintf("📶 BLE telemetry: %s (%ums)\n", bleBatchLatencyMs ? "batched" : "per sample",
+                        bleBatchLatencyMs);
+            break;
+        }
+        case CMD_UDP_BATCH: {
+            // UDP_BATCH:<bytes>[:<ms>]
+            int bytes = atoi(cmd.argument);
+            const char* latency = strchr(cmd.argument, ':');
+            udpBatchBytes = (uint16_t)constrain(bytes, (int)(sizeof(TelemetryBatchHeader) + sizeof(GPSPacket)),
+                                                UDP_MAX_DATAGRAM);
+            if (latency) {
+                udpBatchLatencyMs = (uint16_t)constrain(atoi(latency + 1), 0, UDP_BATCH_MAX_LATENCY_MS);
+            }
+            debugPrintf("📡 UDP batching: up to %u bytes / %ums\n", udpBatchBytes, udpBatchLatencyMs);
+            break;
+        }
+        case CMD_REPORT_POLICY: {
+            // REPORT[:<BLE|UDP>:<OFF|ON|key=value,...>]
+            const char* settings = strchr(cmd.argument, ':');
+            if (!settings) {
+                pendingPolicyReport = true;
+                break;
+            }
+            size_t sinkLength = settings - cmd.argument;
+            bool ble = sinkLength == 3 && strncmp(cmd.argument, "BLE", 3) == 0;
+            bool udp = sinkLength == 3 && strncmp(cmd.argument, "UDP", 3) == 0;
+            StagedReportPolicy& staged = ble ? blePolicyConfig : udpPolicyConfig;
+            ReportPolicyConfig parsed = staged.staged();
+            if ((!ble && !udp) || !reportPolicyParse(settings + 1, parsed)) {
+                debugPrintf("⚠️ REPORT: bad sink or setting in '%s'\n", cmd.argument);
+                break;
+            }
+            staged.publish(parsed);
+            debugPrintf("🎚️ %s report policy: %s (heartbeat %lums)\n", ble ? "BLE" : "UDP",
+                        parsed.enabled ? "dead-band" : "every sample", (unsigned long)parsed.heartbeatMs);
+            break;
+        }
+        case CMD_RATE: {
+            // RATE[:<SD|BLE|UDP|UI>:<hz>[:AVG|LAST]]
+            const char* hz = strchr(cmd.argument, ':');
+            if (!hz) {
+                pendingRateReport = true;
+                break;
+            }
+            char consumer[8];
+            size_t nameLength = hz - cmd.argument;
+            if (nameLength >= sizeof(consumer)) nameLength = sizeof(consumer) - 1;
+            for (size_t i = 0; i < nameLength; i++) consumer[i] = tolower(cmd.argument[i]);
+            consumer[nameLength] = '\0';
+            RateFilter filter = RATE_FILTER_AVERAGE;
+            const char* filterName = strchr(hz + 1, ':');
+            int rateHz = atoi(hz + 1);
+            if ((filterName && !rateFilterParse(filterName + 1, filter)) ||
+                !pipeline.setRate(consumer, (uint16_t)constrain(rateHz, 0, RATE_MAX_HZ), filter)) {
+                debugPrintf("⚠️ RATE: bad consumer or filter in '%s'\n", cmd.argument);
+                break;
+            }
+            debugPrintf("⏬ %s rate: %dHz %s (0 = every sample)\n", consumer, rateHz, rateFilterName(filter));
+            break;
+        }
+        case CMD_CONFIG: {
+            // CFG[:RESET|:<key>[=<value>]] - applied and answered by the sink task
+            strncpy(configQuery, cmd.argument, sizeof(configQuery) - 1);
+            char* value = strchr(configQuery, '=');
+            if (value) *value++ = '\0';
+            ConfigResult result = CONFIG_OK;
+            if (strcmp(configQuery, "RESET") == 0) {
+                deviceConfig.resetAll();
+            } else if (configQuery[0]) {
+                int id = deviceConfig.find(configQuery);
+                result = id < 0 ? CONFIG_UNKNOWN_KEY : value ? deviceConfig.set(id, value) : CONFIG_OK;
+            }
+            configResult = result;
+            pendingConfigReport = true;
+            break;
+        }
+        case CMD_HISTOGRAMS:
+            if (strcmp(cmd.argument, "EXPORT") == 0) {
+                pendingHistogramExport = true;
+            } else {
+                pendingHistogramReport = true;
+            }
+            break;
+        case CMD_SHOW_SCREEN: {
+            int screen = atoi(cmd.argument);
+            if (screen >= SCREEN_SPEEDOMETER && screen <= SCREEN_PERFORMANCE) {
+                uiManager.showScreen((ScreenType)screen);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Text command or binary request from a characteristic write. Runs in the
+// BLE stack's callback: parses in place, allocates nothing, and leaves every
+// reply to the sink task.
+void handleCommandWrite(CommandChannel channel, const uint8_t* data, size_t length) {
+    ParsedCommand cmd;
+    if (data[0] != CMD_FRAME_REQUEST) {
+        debugPrintf("📝 Command: %.*s\n", (int)length, (const char*)data);
+        if (parseCommand(channel, (const char*)data, length, cmd)) {
+            dispatchCommand(cmd);
         }
+        return;
+    }
+    
+    CommandStatus status = parseCommandFrame(data, length, cmd);
+    if (status == CMD_STATUS_OK && commandHasReply(cmd)) {
+        commandReplyIds[cmd.id] = cmd.requestId;    // Before the dispatch: the reply may be quick
+        status = CMD_STATUS_ACCEPTED;
+    }
+    debugPrintf("📝 Command frame #%u: %s %s\n", cmd.requestId, commandStatusName(status), cmd.argument);
+    if (cmd.requestId != 0 && commandAcks) {
+        CommandResponseHeader ack = { CMD_FRAME_RESPONSE, cmd.requestId, length > 2 ? data[2] : (uint8_t)0,
+                                      status, 0, 0 };
+        xQueueSend(commandAcks, &ack, 0);
+    }
+    if (cmd.id != CMD_NONE) {
+        dispatchCommand(cmd);
+    }
+}
+
+class EnhancedConfigCallbacks : public BLECharacteristicCallbacks {
+    void onWrite(BLECharacteristic* pCharacteristic) {
+        size_t length = pCharacteristic->getLength();
+        if (length == 0) return;
+        handleCommandWrite(COMMAND_CHANNEL_CONFIG, pCharacteristic->getData(), length);
     }
 };
 
-class EnhancedFileTransferCallbacks : public BLECharacteristicCallbacks {
+class EnhancedFileTransferCallbacks : public NotifyStatusCallbacks {
     void onWrite(BLECharacteristic* pCharacteristic) {
-        std::string stdValue = pCharacteristic->getValue();
-        String value = String(stdValue.c_str());
+        size_t length = pCharacteristic->getLength();
+        if (length == 0) return;
+        const uint8_t* data = pCharacteristic->getData();
+        
+        // Binary acks go straight to the sink task, which owns the transfer
+        FtAckFrame ack;
+        if (ftParseAck(data, length, ack)) {
+            if (fileTransferAcks) xQueueSend(fileTransferAcks, &ack, 0);
+            return;
+        }
         
-        if (value == "LIST") {
-            pendingListFiles = true;
-        } else if (value.startsWith("GET:")) {
-            pendingFilename = value.substring(4);
-            pendingStartTransfer = true;
-        } else if (value.startsWith("DEL:")) {
-            pendingFilename = value.substring(4);
-            pendingDeleteFile = true;
-        } else if (value == "STOP" || value == "CANCEL") {
-            pendingCancelTransfer = true;
-        } else if (value == "STATUS") {
-            String status = "STATUS:";
-            if (fileTransfer.active) {
-                status += "ACTIVE:" + fileTransfer.filename + ":" + 
-                         String((int)fileTransfer.progressPercent);
-            } else {
-                status += "IDLE";
+        handleCommandWrite(COMMAND_CHANNEL_FILE, data, length);
+    }
+};
+
+// Connection parameter and data length updates arrive as GAP events
+void bleGapHandler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t* param) {
+    BleLinkState& link = systemData.bleLink;
+    
+    switch (event) {
+        case ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT:
+            if (param->update_conn_params.status == ESP_BT_STATUS_SUCCESS) {
+                link.connInterval = param->update_conn_params.conn_int;
+                link.latency = param->update_conn_params.latency;
+                link.supervisionTimeout = param->update_conn_params.timeout;
+                debugPrintf("📶 BLE conn interval: %.2fms latency:%d timeout:%dms\n",
+                            link.connInterval * 1.25f, link.latency, link.supervisionTimeout * 10);
             }
-            
-            if (fileTransferChar) {
-                fileTransferChar->setValue(status.c_str());
-                fileTransferChar->notify();
+            break;
+        case ESP_GAP_BLE_SET_PKT_LENGTH_COMPLETE_EVT:
+            if (param->pkt_data_lenth_cmpl.status == ESP_BT_STATUS_SUCCESS) {
+                link.txOctets = param->pkt_data_lenth_cmpl.params.tx_len;
+                debugPrintf("📶 BLE data length: tx %d rx %d\n",
+                            param->pkt_data_lenth_cmpl.params.tx_len,
+                            param->pkt_data_lenth_cmpl.params.rx_len);
             }
-        }
+            break;
+        default:
+            break;
     }
-};
+}
 
 class EnhancedServerCallbacks : public BLEServerCallbacks {
-    void onConnect(BLEServer* pServer) {
+    void onConnect(BLEServer* pServer, esp_ble_gatts_cb_param_t* param) {
         debugPrintln("📱 BLE Client connected");
-        fileTransfer.mtuNegotiated = false;
-        fileTransfer.currentMTU = 23;
+        
+        BleLinkState& link = systemData.bleLink;
+        link.connected = true;
+        link.connId = param->connect.conn_id;
+        memcpy(link.peerAddress, param->connect.remote_bda, sizeof(link.peerAddress));
+        link.mtu = 23;
+        link.mtuNegotiated = false;
+        link.txOctets = 27;
+        link.connInterval = param->connect.conn_params.interval;
+        link.latency = param->connect.conn_params.latency;
+        link.supervisionTimeout = param->connect.conn_params.timeout;
+        
+        // The MTU exchange is started by the client (we answer with BLE_PREFERRED_MTU);
+        // interval and data length we can request ourselves
+        pServer->updateConnParams(param->connect.remote_bda, BLE_CONN_INTERVAL_MIN, BLE_CONN_INTERVAL_MAX,
+                                  BLE_CONN_LATENCY, BLE_SUPERVISION_TIMEOUT);
+        esp_ble_gap_set_pkt_data_len(param->connect.remote_bda, BLE_PREFERRED_TX_OCTETS);
+        uiManager.requestUpdate();
+    }
+    
+    void onMtuChanged(BLEServer* pServer, esp_ble_gatts_cb_param_t* param) {
+        systemData.bleLink.mtu = param->mtu.mtu;
+        systemData.bleLink.mtuNegotiated = true;
+        debugPrintf("📶 BLE MTU: %d\n", param->mtu.mtu);
         uiManager.requestUpdate();
     }
     
     void onDisconnect(BLEServer* pServer) {
         debugPrintln("📱 BLE Client disconnected");
+        systemData.bleLink.connected = false;
+        systemData.bleLink.mtu = 23;
+        systemData.bleLink.mtuNegotiated = false;
         
         if (fileTransfer.active) {
             pendingCancelTransfer = true;
@@ -820,7 +1450,7 @@ class EnhancedServerCallbacks : public BLEServerCallbacks {
 };
 
 bool initBLERobust() {
-    if (!ENABLE_BLE) {
+    if (!deviceConfig.getBool(CFG_ENABLE_BLE)) {
         debugPrintln("🔵 BLE disabled in configuration");
         return false;
     }
@@ -828,6 +1458,8 @@ bool initBLERobust() {
     try {
         debugPrintln("🔵 Initializing BLE...");
         BLEDevice::init("JC3248_GPS_Logger");
+        BLEDevice::setMTU(BLE_PREFERRED_MTU);
+        BLEDevice::setCustomGapHandler(bleGapHandler);
         
         BLEServer* pServer = BLEDevice::createServer();
         pServer->setCallbacks(new EnhancedServerCallbacks());
@@ -837,6 +1469,7 @@ bool initBLERobust() {
         telemetryChar = pService->createCharacteristic(telemetryCharUUID, BLECharacteristic::PROPERTY_NOTIFY);
         telemetryDescriptor = new BLE2902();
         telemetryChar->addDescriptor(telemetryDescriptor);
+        telemetryChar->setCallbacks(new NotifyStatusCallbacks());
         
         configChar = pService->createCharacteristic(configCharUUID, BLECharacteristic::PROPERTY_WRITE);
         configChar->setCallbacks(new EnhancedConfigCallbacks());
@@ -848,6 +1481,8 @@ bool initBLERobust() {
             BLECharacteristic::PROPERTY_NOTIFY
         );
         fileTransferChar->setCallbacks(new EnhancedFileTransferCallbacks());
+        fileTransferAcks = xQueueCreate(FT_ACK_QUEUE_LENGTH, sizeof(FtAckFrame));
+        commandAcks = xQueueCreate(CMD_ACK_QUEUE_LENGTH, sizeof(CommandResponseHeader));
         
         pService->start();
         
@@ -864,89 +1499,685 @@ bool initBLERobust() {
     }
 }
 
-void setup() {
-    Serial.begin(115200);
-    delay(3000);
-    Serial.println("🚀 JC3248W535EN GPS Logger v6.1 Starting...");
-    Serial.println("🔧 Robust peripheral detection enabled");
-    
-    // Initialize the UI Manager first (always works)
-    uiManager.init(&systemData, &gpsData, &imuData, &batteryData, &perfStats);
-    uiManager.setFileTransferData(&fileTransfer);
-    uiManager.setLoggingCallback(toggleLogging);
-    Serial.println("✅ UI Manager initialized");
-    
-    // Initialize peripherals with robust detection
-    systemData.mpuAvailable = initIMU();
-    systemData.sdCardAvailable = initSDCardRobust();
-    bool gpsAvailable = initGPS();
-    bool wifiAvailable = initWiFiRobust();
-    bool bleAvailable = initBLERobust();
-    
-    // System status summary
-    Serial.println("\n📊 System Status Summary:");
-    Serial.printf("   🖥️  Display: ✅ Ready\n");
-    Serial.printf("   🖱️  Touch:   %s\n", ENABLE_TOUCH ? "✅ Ready" : "❌ Disabled");
-    Serial.printf("   🛰️  GPS:     %s\n", gpsAvailable ? "✅ Connected" : "❌ Not found");
-    Serial.printf("   📄  IMU:     %s\n", systemData.mpuAvailable ? "✅ Connected" : "❌ Not found");
-    Serial.printf("   📱  SD Card: %s\n", systemData.sdCardAvailable ? "✅ Ready" : "❌ Not found");
-    Serial.printf("   📡  WiFi:    %s\n", wifiAvailable ? "✅ Connected" : "❌ Disabled/Failed");
-    Serial.printf("   🔵  BLE:     %s\n", bleAvailable ? "✅ Ready" : "❌ Failed");
-    
-    // Set system capabilities
-    systemData.touchAvailable = ENABLE_TOUCH;
-    systemData.displayOn = true;
-    systemData.lastDisplayActivity = millis();
+// ==============================================
+// REPLAY (sink task reads, ingest task paces)
+// ==============================================
+// A replay takes the GNSS receiver's place in ingestSample(), so the whole
+// path downstream of it - packet build, bus, sinks, fusion for UBX captures -
+// runs exactly as it does live. The SD card belongs to the sink task, so it
+// reads the file into replayRing, never more than the ingest task has room
+// for, and ends each replay with a REPLAY_FORMAT_NONE record. Ingest only
+// paces what it takes off the ring. On a stop or restart it drops what is
+// still queued, up to the end marker carrying that stop's count.
+
+void stopReplay() {
+    if (replay.isActive()) replay.close();
+    replayStops++;
+    replayMarkerPending = true;
+}
+
+void startReplay() {
+    stopReplay();
+    if (!systemData.sdCardAvailable) {
+        debugPrintln("❌ Replay: no SD card");
+        return;
+    }
+    if (!replayBuffer) {
+        replayBuffer = (uint8_t*)ps_malloc(LOG_MAX_BLOCK_SIZE);
+        if (!replayBuffer || !replayRing.begin(REPLAY_RING_CAPACITY)) {
+            debugPrintln("❌ Replay: buffer allocation failed");
+            free(replayBuffer);
+            replayBuffer = nullptr;
+            return;
+        }
+        replayConsumerId = replayRing.addConsumer();
+    }
     
-    perfStats.lastResetTime = millis();
+    char path[COMMAND_MAX_ARGUMENT + 2];
+    snprintf(path, sizeof(path), "/%s", replayPath);
+    if (!replay.open(&replayFile, path, replaySpeed, replayBuffer, LOG_MAX_BLOCK_SIZE)) {
+        debugPrintf("❌ Replay: %s is not a v2 log or UBX capture\n", path);
+        return;
+    }
+    replayQueuedSpeed = replaySpeed;
+    
+    pipeline.resetSinkStats();
+    pipeline.rotateHistograms();     // The replay report covers exactly this window
+    lastHistogramRotate = millis();
+    const char* format = replay.getFormat() == REPLAY_FORMAT_LOG ? "log" : "UBX";
+    if (replaySpeed > 0) {
+        debugPrintf("🔁 Replay: %s (%s) at %ux\n", path, format, replaySpeed);
+    } else {
+        debugPrintf("🔁 Replay: %s (%s) as fast as possible\n", path, format);
+    }
+}
+
+// Keep the ring topped up. One slot stays free so the reader is never lapped.
+void queueReplayRecords() {
+    if (replayConsumerId < 0) return;
+    ReplayRecord record;
+    while ((replayMarkerPending || replay.isActive()) &&
+           replayRing.available(replayConsumerId) < REPLAY_RING_CAPACITY - 1) {
+        if (replayMarkerPending) {
+            replayMarkerPending = false;
+            memset(&record, 0, sizeof(record));
+            record.format = REPLAY_FORMAT_NONE;
+            record.mediaUs = replayStops;
+        } else if (!replay.read(record)) {
+            replayMarkerPending = true;      // read() closed the file
+            continue;
+        }
+        replayRing.push(record);
+    }
+}
+
+// Ingest task from here on
+void finishReplay() {
+    replayIngesting = false;
+    pipeline.setIngestBurst(1);
+    pendingReplayReport = true;
+}
+
+// Take the next due replay sample into gpsData. Returns true when one was released.
+bool pollReplay() {
+    while (replayHolding || replayRing.read(replayConsumerId, replayNext)) {
+        replayHolding = false;
+        if (replayNext.format == REPLAY_FORMAT_NONE) {
+            replayStopsSeen = (uint32_t)replayNext.mediaUs;
+            if (replayIngesting) finishReplay();
+            continue;
+        }
+        if (replayStopsSeen != replayStops) {
+            if (replayIngesting) finishReplay();    // Stopped: drop the rest of this replay
+            continue;
+        }
+        if (!replayIngesting) {
+            replayIngesting = true;
+            replayPacer.start(replayQueuedSpeed);
+            pipeline.setIngestBurst(REPLAY_INGEST_BURST);
+        }
+        if (!replayPacer.release(replayNext)) {
+            replayHolding = true;
+            return false;
+        }
+        
+        if (replayNext.format == REPLAY_FORMAT_UBX) {
+            int64_t epochUs = esp_timer_get_time();
+            pipeline.markEpoch(epochUs);
+            correctFusion(replayNext.pvt, epochUs);
+            gpsDataFromNavPvt(replayNext.pvt, gpsData);
+        } else {
+            gpsDataFromPacket(replayNext.packet, gpsData);  // Battery and IMU fields come from the live device
+        }
+        return true;
+    }
+    return false;
+}
+
+void printReplayReport() {
+    const ReplayStats& paced = replayPacer.getStats();
+    const ReplayStats& rs = replay.getStats();
+    uint32_t elapsedMs = (uint32_t)((paced.lastUs - paced.startUs) / 1000);
+    uint32_t avgRead = paced.samples ? (uint32_t)(rs.totalReadUs / paced.samples) : 0;
+    Serial.printf("🔁 Replay done: %lu samples in %lums = %lu samples/s, lag max:%luus\n",
+                  (unsigned long)paced.samples, (unsigned long)elapsedMs,
+                  (unsigned long)replayPacer.samplesPerSecond(), (unsigned long)paced.maxLagUs);
+    Serial.printf("🔁 Replay read: %lu blocks %lluB avg:%luus max:%luus decodeErr:%lu torn:%lu\n",
+                  (unsigned long)rs.blocks, (unsigned long long)rs.bytesRead,
+                  (unsigned long)avgRead, (unsigned long)rs.maxReadUs, (unsigned long)rs.decodeErrors,
+                  (unsigned long)rs.tornBlocks);
+    if (pipeline.isRunning()) {
+        pipeline.printStats();
+    }
+}
+
+// ==============================================
+// BENCHMARKS (sink task)
+// ==============================================
+static uint32_t benchCycles() {
+    return ESP.getCycleCount();     // Sink task is pinned, so the core's counter is stable
+}
+
+static void printBenchResult(const BenchRunner& runner, const BenchResult& result) {
+    char line[BENCH_LINE_SIZE];
+    benchFormatResult(runner, result, line, sizeof(line));
+    Serial.println(line);
+}
+
+// listSDFiles() reply building with the directory walk taken out
+static void benchListingString(void* context) {
+    String fileList = "FILES:";
+    for (int i = 0; i < 32; i++) {
+        String filename = "gps_20250819_" + String(120000 + i) + ".bin";
+        fileList += filename + ":" + String(409600 + i * 4096) + ";";
+    }
+    fileList += "COUNT:" + String(32);
+    *(size_t*)context = fileList.length();
+}
+
+// Stalls the sinks for a few seconds; the telemetry bus absorbs it
+void runBenchmarks() {
+    Serial.printf("⏱️ Benchmarks%s%s (cpu %luMHz, sinks paused)\n", benchFilter[0] ? ": " : "",
+                  benchFilter, (unsigned long)ESP.getCpuFreqMHz());
+    BenchRunner runner(benchCycles, ESP.getCpuFreqMHz(), "esp32s3");
+    char line[BENCH_LINE_SIZE];
+    benchFormatHeader(line, sizeof(line));
+    Serial.println(line);
+    
+    SdStorageFile benchFile;
+    uint32_t count = benchRunSuite(runner, systemData.sdCardAvailable ? &benchFile : nullptr,
+                                   benchFilter, printBenchResult);
+    if (!benchFilter[0] || strstr("list_files_string", benchFilter)) {
+        size_t length = 0;
+        BenchResult result;
+        runner.run("list_files_string", benchListingString, &length, 0, result);
+        result.bytesPerOp = length;
+        printBenchResult(runner, result);
+        count++;
+    }
+    if (systemData.sdCardAvailable) SD.remove(BENCH_STORAGE_PATH);
+    Serial.printf("⏱️ %lu benchmarks done\n", (unsigned long)count);
+}
+
+// Stage probe table on the console, and as one PROBES: line to a connected BLE client
+void reportProbes() {
+    char report[PROBE_REPORT_SIZE];
+    probeFormat(report, sizeof(report), false);
+    Serial.printf("⏱️ Stage probes (%lu cycles/us):\n%s", (unsigned long)probeCyclesPerUs(), report);
+    
+    if (systemData.bleLink.connected) {
+        probeFormat(report, sizeof(report), true);
+        sendCommandReply(CMD_PROBES, report);
+    }
+    if (pendingProbeReset) {
+        pendingProbeReset = false;
+        probeReset();
+    }
+}
+
+// Latency histograms: last finished window and lifetime on the console, the
+// window as one HIST: line to a connected BLE client
+void reportHistograms() {
+    if (!pipeline.getHistogram(0)) return;
+    char line[LATENCY_LINE_SIZE];
+    Serial.printf("📈 Latency histograms (window %lus, budget %luus):\n",
+                  (unsigned long)(deviceConfig.get(CFG_HISTOGRAM_MS) / 1000), (unsigned long)EPOCH_BUDGET_US);
+    String reply = "HIST:";
+    for (int i = 0; i < pipeline.getHistogramCount(); i++) {
+        const WindowedHistogram* h = pipeline.getHistogram(i);
+        const char* name = pipeline.getHistogramName(i);
+        const LatencyHistogram* views[2] = { &h->getWindow(), &h->getLifetime() };
+        for (int v = 0; v < 2; v++) {
+            latencyFormat(*views[v], line, sizeof(line), false);
+            Serial.printf("  %-14s %-4s %s over:%lu\n", v == 0 ? name : "", v == 0 ? "win" : "all",
+                          line, (unsigned long)views[v]->countAbove(EPOCH_BUDGET_US));
+        }
+        latencyFormat(h->getWindow(), line, sizeof(line), true);
+        reply += String(name) + "=" + line + ";";
+    }
+    if (systemData.bleLink.connected) {
+        sendCommandReply(CMD_HISTOGRAMS, reply);
+    }
+}
+
+// Lifetime histograms in the compact binary form, for download with GET:
+void exportHistograms() {
+    if (!pipeline.getHistogram(0)) return;
+    if (!systemData.sdCardAvailable) {
+        sendCommandReply(CMD_HISTOGRAMS, "ERROR:NO_SD_CARD", CMD_STATUS_FAILED);
+        return;
+    }
+    uint8_t* buffer = (uint8_t*)ps_malloc(LATENCY_EXPORT_MAX_SIZE);
+    SdStorageFile file;
+    if (!buffer || !file.open(HISTOGRAM_EXPORT_PATH, STORAGE_WRITE)) {
+        free(buffer);
+        debugPrintln("❌ Histogram export failed");
+        sendCommandReply(CMD_HISTOGRAMS, "ERROR:HIST_EXPORT", CMD_STATUS_FAILED);
+        return;
+    }
+    uint32_t total = 0;
+    for (int i = 0; i < pipeline.getHistogramCount(); i++) {
+        size_t length = pipeline.getHistogram(i)->getLifetime().exportTo(pipeline.getHistogramName(i),
+                                                                           buffer, LATENCY_EXPORT_MAX_SIZE);
+        total += file.write(buffer, length);
+    }
+    file.close();
+    free(buffer);
+    debugPrintf("📈 Histograms exported: %s (%lu bytes)\n", HISTOGRAM_EXPORT_PATH, (unsigned long)total);
+    sendCommandReply(CMD_HISTOGRAMS, "HIST:EXPORTED:" + String(HISTOGRAM_EXPORT_PATH + 1) + ":" + String(total));
+}
+
+// Configured rate and in/out counts per bus consumer (counters are read across tasks)
+void reportRates() {
+    static const char* consumers[] = { "sd", "ble", "udp", "ui" };
+    String reply = "RATE:";
+    for (size_t i = 0; i < sizeof(consumers) / sizeof(consumers[0]); i++) {
+        const PipelineRate* rate = pipeline.getRate(consumers[i]);
+        if (!rate) continue;
+        const RateDecimator& d = rate->decimator;
+        const RateControlStats& s = d.getStats();
+        Serial.printf("⏬ %-4s %3uHz %-4s in:%lu out:%lu window max:%lu resync:%lu late:%lu\n",
+                      consumers[i], d.getRate(), rateFilterName(d.getFilter()), (unsigned long)s.in,
+                      (unsigned long)s.out, (unsigned long)s.maxWindow, (unsigned long)s.resyncs,
+                      (unsigned long)s.late);
+        reply += String(consumers[i]) + "=" + String(d.getRate()) + "/" + rateFilterName(d.getFilter()) +
+                 "/" + String(s.in) + "/" + String(s.out) + ";";
+    }
+    if (systemData.bleLink.connected) {
+        sendCommandReply(CMD_RATE, reply);
+    }
+}
+
+// Reduction ratio and held-back error per radio sink (UDP counters are read across tasks)
+void reportPolicies() {
+    char line[REPORT_STATS_LINE_SIZE];
+    String reply = "REPORT:";
+    const char* names[2] = { "BLE", "UDP" };
+    const ReportPolicy* policies[2] = { &blePolicy, &udpPolicy };
+    for (int i = 0; i < 2; i++) {
+        reportPolicyFormat(*policies[i], line, sizeof(line), false);
+        Serial.printf("🎚️ %s report policy: %s\n", names[i], line);
+        reportPolicyFormat(*policies[i], line, sizeof(line), true);
+        reply += String(names[i]) + "=" + line + "|";
+    }
+    if (systemData.bleLink.connected) {
+        sendCommandReply(CMD_REPORT_POLICY, reply);
+    }
+}
+
+// One CFG entry, or all of them (values are final: service() ran first)
+void reportConfig() {
+    if (configResult != CONFIG_OK) {
+        debugPrintf("⚠️ CFG:%s: %s\n", configQuery, configResultName(configResult));
+        if (systemData.bleLink.connected) {
+            sendCommandReply(CMD_CONFIG, "CFG:ERROR:" + String(configQuery) + ":" + configResultName(configResult),
+                             CMD_STATUS_FAILED);
+        }
+        return;
+    }
+    int only = deviceConfig.find(configQuery);
+    char line[CONFIG_LINE_SIZE];
+    String reply = "CFG:";
+    for (int id = 0; id < deviceConfig.getCount(); id++) {
+        if (only >= 0 && id != only) continue;
+        deviceConfig.format(id, line, sizeof(line));
+        Serial.printf("⚙️ %s\n", line);
+        reply += String(line) + ";";
+    }
+    if (only < 0) {
+        const ConfigStats& s = deviceConfig.getStats();
+        Serial.printf("⚙️ NVS loaded:%lu rejected:%lu writes:%lu failed:%lu (-> applies after restart)\n",
+                      (unsigned long)s.loaded, (unsigned long)s.rejected, (unsigned long)s.writes,
+                      (unsigned long)s.writeFailures);
+    }
+    if (systemData.bleLink.connected) {
+        sendCommandReply(CMD_CONFIG, reply);
+    }
+}
+
+// Config commands typed on the serial console, one per line
+void pollSerialCommands() {
+    static char line[SERIAL_COMMAND_MAX + 1];
+    static size_t length = 0;
+    
+    while (Serial.available() > 0) {
+        char c = (char)Serial.read();
+        if (c == '\r') continue;
+        if (c != '\n') {
+            if (length < SERIAL_COMMAND_MAX) line[length++] = c;
+            continue;
+        }
+        if (length > 0) {
+            ParsedCommand cmd;
+            if (parseCommand(COMMAND_CHANNEL_CONFIG, line, length, cmd)) {
+                dispatchCommand(cmd);
+            } else {
+                line[length] = '\0';
+                Serial.printf("❓ Unknown command: %s\n", line);
+            }
+        }
+        length = 0;
+    }
+}
+
+// ==============================================
+// PIPELINE STAGES
+// ==============================================
+// Ingest stage: IMU + GNSS (or mock) -> packet. Runs on the pinned ingest task.
+bool ingestSample(GPSPacket& packet) {
+    // Read IMU data or generate mock data
+    if (pendingIMUCalibration) {
+        pendingIMUCalibration = false;
+        if (systemData.mpuAvailable) startIMUCalibration();
+    }
     
-    Serial.println("\n🎯 JC3248W535EN GPS Logger Ready!");
-    if (!gpsAvailable) {
-        Serial.println("📍 No GPS detected - will use mock data for UI testing");
+    if (imuSampler.isRunning()) {
+        consumeIMUSamples();
+    } else if (systemData.mpuAvailable && deviceConfig.getBool(CFG_ENABLE_IMU)) {
+        readMPU6050();
+    } else {
+        generateMockIMUData();  // Provide mock data for UI testing
     }
-    if (!systemData.mpuAvailable) {
-        Serial.println("🎯 No IMU detected - will use mock data for UI testing");
+    
+    // Process GPS data or generate mock data
+    bool hasGPSData = false;
+    if (replayConsumerId >= 0 && (replayIngesting || replayRing.available(replayConsumerId) > 0)) {
+        hasGPSData = pollReplay();
+    } else if (deviceConfig.getBool(CFG_ENABLE_GPS) && pollGNSS()) {
+        hasGPSData = true;
+        int64_t epochUs = esp_timer_get_time();
+        pipeline.markEpoch(epochUs);
+        const UbxNavPvt& pvt = ubxParser.navPvt();
+        correctFusion(pvt, epochUs);
+        
+        gpsDataFromNavPvt(pvt, gpsData);
+    } else if (!deviceConfig.getBool(CFG_ENABLE_GPS)) {
+        generateMockGPSData();  // Provide mock data for UI testing
+        hasGPSData = true;
     }
-    Serial.println("🖱️ Touch interface active");
+    
+    if (!hasGPSData) return false;
+    
+    unsigned long now = millis();
+    unsigned long delta = now - lastPacketTime;
+    if (lastPacketTime == 0) delta = 0;  // Prevent invalid delta on first run
+    
+    // Update performance stats with bounds checking
+    if (perfStats.totalPackets < ULONG_MAX) {
+        perfStats.totalPackets++;
+    }
+    
+    lastPacketTime = now;
+    lastPacketDelta = delta;
+    
+    // Safe battery data with bounds checking
+    PacketPower power = { 0, 0, 0 };
+    if (batteryData.voltage >= 0 && batteryData.voltage <= 10) {
+        power.batteryMv = (uint16_t)(batteryData.voltage * 1000.0f);
+    }
+    if (batteryData.percentage <= 100) {
+        power.batteryPct = batteryData.percentage;
+    }
+    power.pmuStatus = (batteryData.isCharging ? 0x01 : 0x00) |
+                      (batteryData.usbConnected ? 0x02 : 0x00) |
+                      (batteryData.isConnected ? 0x04 : 0x00);
+    
+    bool hasIMU = systemData.mpuAvailable || !deviceConfig.getBool(CFG_ENABLE_IMU);
+    {
+        PROBE_SCOPE(PROBE_PACKET_BUILD);
+        buildPacket(gpsData, hasIMU ? &imuData : nullptr, power, packet);
+    }
+    return true;
 }
 
-void loop() {
-    static unsigned long lastPacketTime = 0;
-    static unsigned long lastDebugTime = 0;
-    static unsigned long lastWiFiCheck = 0;
-    static unsigned long lastPerfReset = 0;
+// Registry listeners (setup(), then the sink task after each CFG change)
+static void applyDebugConfig(int id) {
+    debugMode = deviceConfig.getBool(CFG_DEBUG);
+}
+
+static void applyUdpConfig(int id) {
+    portENTER_CRITICAL(&udpTargetMux);
+    UdpTarget target = udpTarget;
+    portEXIT_CRITICAL(&udpTargetMux);
+    
+    // A bad address keeps the current one rather than half-parsing over it
+    IPAddress parsed;
+    if (parsed.fromString(deviceConfig.getText(CFG_UDP_HOST))) {
+        target.ip = parsed;
+    } else {
+        Serial.printf("⚠️ CFG: udp_host '%s' is not an IPv4 address\n", deviceConfig.getText(CFG_UDP_HOST));
+    }
+    target.port = (uint16_t)deviceConfig.get(CFG_UDP_PORT);
     
-    // Handle LVGL tasks - this is CRITICAL for UI responsiveness
-    lv_timer_handler();
-    uiManager.update();
+    portENTER_CRITICAL(&udpTargetMux);
+    udpTarget = target;
+    portEXIT_CRITICAL(&udpTargetMux);
+}
+
+static void applyBatchConfig(int id) {
+    udpBatchBytes = (uint16_t)deviceConfig.get(CFG_UDP_BATCH_BYTES);
+    udpBatchLatencyMs = (uint16_t)deviceConfig.get(CFG_UDP_BATCH_MS);
+    bleBatchLatencyMs = (uint16_t)deviceConfig.get(CFG_BLE_BATCH_MS);
+}
+
+static void applyRateConfig(int id) {
+    static const char* consumers[] = { "sd", "ble", "udp", "ui" };      // CFG_RATE_SD order
+    if (id < CFG_RATE_SD || id > CFG_RATE_UI) return;
+    const char* consumer = consumers[id - CFG_RATE_SD];
+    const PipelineRate* rate = pipeline.getRate(consumer);
+    RateFilter filter = rate ? (RateFilter)rate->stagedFilter : RATE_FILTER_AVERAGE;    // RATE:...:LAST sticks
+    pipeline.setRate(consumer, (uint16_t)deviceConfig.get(id), filter);
+}
+
+static void applyReportConfig(int id) {
+    if (id != CFG_BLE_REPORT && id != CFG_UDP_REPORT) return;
+    StagedReportPolicy& staged = id == CFG_BLE_REPORT ? blePolicyConfig : udpPolicyConfig;
+    ReportPolicyConfig config = staged.staged();
+    config.enabled = deviceConfig.getBool(id);
+    staged.publish(config);
+}
+
+// A rate-controlled sink sees every n-th bus sequence
+static bool sinkDecimated(int index) {
+    return index >= 0 && pipeline.getSinkRate(index) != 0;
+}
+
+// Staged REPORT:<sink>:... settings take effect on the task that owns the policy, between samples
+static void applyReportPolicy(ReportPolicy& policy, StagedReportPolicy& staged) {
+    ReportPolicyConfig config;
+    if (staged.take(config)) policy.configure(config);
+}
+
+// Sink stage: each sink drains its own cursor on the telemetry bus (sink task, core 0).
+// UDP runs on its own task and bus cursor, so lwIP stalls only back up this
+// sink; the bus drops its oldest samples beyond UDP_MAX_BACKLOG.
+void sinkUDP(const TelemetrySample& sample) {
+    // Send via UDP (if WiFi enabled and connected)
+    if (!udpLink.isReady()) {
+        udpPolicy.restart();
+        return;
+    }
     
-    // CRITICAL: Process deferred file operations (called in main loop - safe stack)
+    applyReportPolicy(udpPolicy, udpPolicyConfig);
+    if (!udpPolicy.offer(sample.packet, (uint32_t)(sample.timestampUs / 1000))) return;
+    udpBatcher.setSparse(udpPolicy.isEnabled() || sinkDecimated(udpSinkIndex));
+    udpBatcher.setMaxFrame(udpBatchBytes);
+    udpBatcher.setMaxLatency(udpBatchLatencyMs * 1000UL);
+    udpBatcher.add(udpLink, sample.packet, sample.sequence, (uint32_t)sample.timestampUs,
+                   (uint32_t)esp_timer_get_time());
+}
+
+// Fused states published since the last wake-up, in one datagram
+void sendUDPFusion() {
+    if (udpFusionConsumerId < 0) return;
+    if (!udpLink.isReady()) {
+        fusionBus.trim(udpFusionConsumerId, 0);     // Nobody to send them to
+        return;
+    }
+    static FusionRecord records[TB_MAX_FUSION_RECORDS];
+    static uint8_t frame[TB_MAX_FRAME];
+    static uint16_t frameSequence = 0;
+    size_t limit = udpLink.maxPayload() < TB_MAX_FRAME ? udpLink.maxPayload() : TB_MAX_FRAME;
+    size_t maxRecords = (limit - sizeof(TelemetryBatchHeader)) / sizeof(FusionRecord);
+    
+    const TelemetryRing<FusionState>::ConsumerStats& cs = fusionBus.getConsumerStats(udpFusionConsumerId);
+    FusionState state;
+    uint32_t firstState = 0;
+    uint8_t count = 0;
+    while (count < maxRecords && fusionBus.read(udpFusionConsumerId, state)) {
+        if (count == 0) firstState = cs.reads + cs.overruns - 1;
+        fusionRecordFrom(state, records[count++]);
+    }
+    if (count == 0) return;
+    udpLink.send(frame, encodeFusionFrame(records, count, frameSequence++, firstState, frame));
+}
+
+// UDP task idle hook: fused states go out as they come, partial telemetry
+// datagrams on their deadline
+void pollUDPBatch() {
+    sendUDPFusion();
+    if (!udpBatcher.pending()) return;
+    if (!udpLink.isReady()) {
+        udpBatcher.discard();
+    } else {
+        udpBatcher.poll(udpLink, (uint32_t)esp_timer_get_time());
+    }
+}
+
+bool bleTelemetryReady() {
+    return deviceConfig.getBool(CFG_ENABLE_BLE) && telemetryDescriptor && telemetryDescriptor->getNotifications() && bleTelemetryLink.isReady();
+}
+
+void sinkBLE(const TelemetrySample& sample) {
+    // Send via BLE (if enabled and connected)
+    if (!bleTelemetryReady()) {
+        blePolicy.restart();        // A new client has nothing to hold
+        return;
+    }
+    
+    // Held-back and decimated samples leave sequence gaps, so batches go out as sparse frames
+    applyReportPolicy(blePolicy, blePolicyConfig);
+    if (!blePolicy.offer(sample.packet, (uint32_t)(sample.timestampUs / 1000))) return;
+    bleBatcher.setSparse(blePolicy.isEnabled() || sinkDecimated(bleSinkIndex));
+    
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    uint16_t batchMs = bleBatchLatencyMs;
+    if (batchMs == 0) {
+        bleBatcher.flush(bleTelemetryLink, now);    // Leftovers from batch mode go first
+        bleTelemetryLink.send((const uint8_t*)&sample.packet, sizeof(GPSPacket));
+        return;
+    }
+    bleBatcher.setMaxLatency(batchMs * 1000UL);
+    bleBatcher.add(bleTelemetryLink, sample.packet, sample.sequence, (uint32_t)sample.timestampUs, now);
+}
+
+// Partial batches go out on their deadline even when no new sample arrives
+void pollBLEBatch() {
+    if (!bleBatcher.pending()) return;
+    if (!bleTelemetryReady()) {
+        bleBatcher.discard();
+    } else if (bleBatchLatencyMs == 0) {
+        bleBatcher.flush(bleTelemetryLink, (uint32_t)esp_timer_get_time());
+    } else {
+        bleBatcher.poll(bleTelemetryLink, (uint32_t)esp_timer_get_time());
+    }
+}
+
+void sinkSD(const TelemetrySample& sample) {
+    // Log to SD (if enabled and available)
+    if (deviceConfig.getBool(CFG_ENABLE_SD) && systemData.loggingActive && systemData.sdCardAvailable) {
+        if (!sdLogger.isOpen()) {
+            createLogFile();
+        }
+        // Batched: the background writer owns the card, drops are counted by the logger
+        if (SD_LOG_DELTA_ENCODING) {
+            // Every block must open with a keyframe so it decodes on its own
+            if (sdLogger.blockSpace() < DELTA_MAX_RECORD_SIZE) {
+                sdLogger.seal();
+                logEncoder.forceKeyframe();
+            }
+            uint8_t record[DELTA_MAX_RECORD_SIZE];
+            size_t length = logEncoder.encode(sample.packet, record);
+            sdLogger.append(record, length, sample.packet.timestamp);
+        } else {
+            sdLogger.append(&sample.packet, sizeof(GPSPacket), sample.packet.timestamp);
+        }
+    }
+}
+
+// Housekeeping: everything slow or bursty that must stay off the ingest task.
+void serviceHousekeeping() {
+    // Answers to binary requests go out before any reply they announce
+    sendCommandAcks();
+    
+    // CRITICAL: Process deferred file operations (sink task owns the SD card)
     processDeferredFileOperations();
     
-    // Process file transfers (ongoing transfers)
-    processFileTransfer();
+    // CFG changes: persisted to NVS, then applied through the listeners
+    deviceConfig.service(nvsConfigStore);
+    if (pendingConfigReport) {
+        pendingConfigReport = false;
+        reportConfig();
+    }
     
-    // Update file transfer UI more frequently during transfer
-    if (fileTransfer.active) {
-        static unsigned long lastTransferUIUpdate = 0;
-        if (millis() - lastTransferUIUpdate > 500) {
+    if (pendingToggleLogging) {
+        pendingToggleLogging = false;
+        toggleLogging();
+    }
+    
+    if (pendingSaveIMUCalibration) {
+        pendingSaveIMUCalibration = false;
+        saveIMUCalibration();
+    }
+    
+    if (pendingStartReplay) {
+        pendingStartReplay = false;
+        startReplay();
+    }
+    if (pendingStopReplay) {
+        pendingStopReplay = false;
+        stopReplay();
+    }
+    queueReplayRecords();
+    if (pendingReplayReport) {
+        pendingReplayReport = false;
+        printReplayReport();
+    }
+    
+    pollSerialCommands();
+    if (pendingProbeReport) {
+        pendingProbeReport = false;
+        reportProbes();
+    }
+    if (pendingBenchmark) {
+        pendingBenchmark = false;
+        runBenchmarks();
+    }
+    if (pendingHistogramReport) {
+        pendingHistogramReport = false;
+        reportHistograms();
+    }
+    if (pendingHistogramExport) {
+        pendingHistogramExport = false;
+        exportHistograms();
+    }
+    if (pendingPolicyReport) {
+        pendingPolicyReport = false;
+        reportPolicies();
+    }
+    if (pendingRateReport) {
+        pendingRateReport = false;
+        reportRates();
+    }
+    
+    // Logging may be stopped from the BLE callback; close the file here, where SD is owned
+    if (!systemData.loggingActive && sdLogger.isOpen()) {
+        sdLogger.close();
+    }
+    sdLogger.poll();
+    bool logOpened;
+    if (sdLogger.takeOpenResult(logOpened)) {
+        if (logOpened) {
+            debugPrintf("📄 Created: %s\n", currentLogFilename);
+        } else if (systemData.loggingActive) {
+            systemData.loggingActive = false;
+            debugPrintln("❌ Failed to create log file");
             uiManager.requestUpdate();
-            lastTransferUIUpdate = millis();
         }
     }
     
+    // Rest of any multi-notification reply, then file transfers (ongoing transfers)
+    sendQueuedReplies();
+    processFileTransfer();
+    
+    pollBLEBatch();
+    updateBleLinkThroughput();
+    
     // Update battery data
     updateBatteryData();
     
-    // Read IMU data or generate mock data
-    if (systemData.mpuAvailable && ENABLE_IMU) {
-        readMPU6050();
-    } else {
-        generateMockIMUData();  // Provide mock data for UI testing
-    }
-    
     // WiFi check (if enabled)
-    if (ENABLE_WIFI && wifiUDPEnabled && millis() - lastWiFiCheck > 30000) {
+    if (deviceConfig.getBool(CFG_ENABLE_WIFI) && wifiUDPEnabled && millis() - lastWiFiCheck > 30000) {
         lastWiFiCheck = millis();
         if (WiFi.status() != WL_CONNECTED) {
             WiFi.disconnect();
@@ -956,285 +2187,297 @@ void loop() {
         }
     }
     
-    // Reset performance stats every 5 minutes
-    if (millis() - lastPerfReset > 300000) {
-        lastPerfReset = millis();
-        perfStats.minDelta = 9999;
-        perfStats.maxDelta = 0;
-        perfStats.droppedPackets = 0;
-        perfStats.totalPackets = 0;
+    // Start a new histogram window; a running replay keeps its window to the end
+    if (millis() - lastHistogramRotate > deviceConfig.get(CFG_HISTOGRAM_MS) && !replayIngesting) {
+        lastHistogramRotate = millis();
+        pipeline.rotateHistograms();
     }
     
-    // CRITICAL: Initialize GPS data with safe defaults if not already done
-    static bool gpsDataInitialized = false;
-    if (!gpsDataInitialized) {
-        // Initialize GPS data with safe default values
-        gpsData.timestamp = millis() / 1000;
-        gpsData.latitude = 0.0;
-        gpsData.longitude = 0.0;
-        gpsData.altitude = 0;
-        gpsData.speed = 0.0;
-        gpsData.heading = 0.0;
-        gpsData.fixType = 0;
-        gpsData.satellites = 0;
-        gpsData.year = 2025;
-        gpsData.month = 8;
-        gpsData.day = 19;
-        gpsData.hour = 12;
-        gpsData.minute = 0;
-        gpsData.second = 0;
-        gpsDataInitialized = true;
-        Serial.println("✅ GPS data initialized with safe defaults");
-    }
-    
-    // Process GPS data or generate mock data
-    bool hasGPSData = false;
-    if (ENABLE_GPS && myGNSS.getPVT()) {
-        hasGPSData = true;
-        unsigned long now = millis();
-        unsigned long delta = now - lastPacketTime;
-        
-        // SAFE: Update GPS data structure with bounds checking
-        uint32_t timestamp = myGNSS.getUnixEpoch();
-        if (timestamp > 0 && timestamp < 4000000000UL) {  // Reasonable timestamp range
-            gpsData.timestamp = timestamp;
+    // Debug output every 10 seconds with safe formatting
+    unsigned long now = millis();
+    if (now - lastDebugTime >= 10000) {
+        lastDebugTime = now;
+        
+        String dataSource = deviceConfig.getBool(CFG_ENABLE_GPS) ? "GPS" : "MOCK";
+        
+        // SAFE debug output with bounds checking
+        if (gpsData.year >= 2000 && gpsData.year <= 2100 &&
+            gpsData.month >= 1 && gpsData.month <= 12 &&
+            gpsData.day >= 1 && gpsData.day <= 31 &&
+            gpsData.hour <= 23 && gpsData.minute <= 59 && gpsData.second <= 59 &&
+            batteryData.voltage >= 0 && batteryData.voltage <= 10 &&
+            batteryData.percentage <= 100) {
+            
+            debugPrintf("📊 %s: %02d/%02d/%04d %02d:%02d:%02d | ",
+                dataSource.c_str(), gpsData.day, gpsData.month, gpsData.year,
+                gpsData.hour, gpsData.minute, gpsData.second);
+            
+            debugPrintf("Fix:%d Sats:%d Speed:%.1fkm/h Batt:%.1fV(%d%%)\n",
+                gpsData.fixType, gpsData.satellites, gpsData.speedKmh(), 
+                batteryData.voltage, batteryData.percentage);
         }
         
-        double lat = myGNSS.getLatitude() / 1e7;
-        if (lat >= -90.0 && lat <= 90.0) {
-            gpsData.latitude = lat;
+        unsigned long delta = lastPacketDelta;
+        if (delta < 10000) {  // Only print if delta is reasonable
+            debugPrintf("⚡ Perf: Δ=%lums Pkts:%lu Drop:%lu RAM:%d\n",
+                delta, perfStats.totalPackets, perfStats.droppedPackets, ESP.getFreeHeap());
         }
         
-        double lon = myGNSS.getLongitude() / 1e7;
-        if (lon >= -180.0 && lon <= 180.0) {
-            gpsData.longitude = lon;
+        if (systemData.sdCardAvailable) {
+            const SdLoggerStats& sd = sdLogger.getStats();
+            uint32_t avgWrite = sd.blocksWritten ? (uint32_t)(sd.totalWriteUs / sd.blocksWritten) : 0;
+            debugPrintf("💾 SD: %luB/s blocks:%lu write avg:%luus max:%luus qhw:%lu drop:%lu err:%lu\n",
+                sd.bytesPerSecond, sd.blocksWritten, avgWrite, sd.maxWriteUs,
+                sd.queueHighWater, sd.recordsDropped, sd.writeErrors);
+            
+            const DeltaCodecStats& codec = logEncoder.getStats();
+            if (SD_LOG_DELTA_ENCODING && codec.encodedBytes > 0) {
+                debugPrintf("🗜️ Log codec: %lu records %lu keyframes ratio %.2fx\n",
+                    codec.records, codec.keyframes, (float)codec.rawBytes / codec.encodedBytes);
+            }
         }
         
-        int32_t alt = myGNSS.getAltitude() / 1000;
-        if (alt >= -1000 && alt <= 10000) {
-            gpsData.altitude = alt;
+        if (imuSampler.isRunning()) {
+            const ImuSamplerStats& imu = imuSampler.getStats();
+            const ImuBus::ConsumerStats& bus = imuSampler.getBus().getConsumerStats(imuConsumerId);
+            debugPrintf("🧭 IMU FIFO: %uHz samples:%lu irq:%lu batches:%lu maxBatch:%lu drain:%lu/%luus ovf:%lu resync:%lu err:%lu lost:%lu\n",
+                imuSampler.getRateHz(), imu.samples, imu.interrupts, imu.batches, imu.maxBatch,
+                imu.lastDrainUs, imu.maxDrainUs, imu.fifoOverflows, imu.resyncs, imu.readErrors, bus.overruns);
+        } else if (systemData.mpuAvailable && imuReadStats.reads > 0) {
+            debugPrintf("🧭 IMU read: avg:%luus max:%luus reads:%lu err:%lu\n",
+                (uint32_t)(imuReadStats.totalReadUs / imuReadStats.reads), imuReadStats.maxReadUs,
+                imuReadStats.reads, imuReadStats.errors);
         }
         
-        float speed = myGNSS.getGroundSpeed() * 0.0036;
-        if (speed >= 0 && speed <= 500) {
-            gpsData.speed = speed;
+        if (fusionActive && fusion.isInitialized()) {
+            const FusionStats& fs = fusion.getStats();
+            FusionState state;
+            fusion.getState(state);
+            debugPrintf("🧮 Fusion: pred:%lu corr:%lu rej:%lu reset:%lu cost:%lu/%luus corr:%lu/%luus std:%.1fm dr:%lums\n",
+                fs.predictions, fs.corrections, fs.rejectedFixes, fs.resets,
+                fusionTiming.lastPredictUs, fusionTiming.maxPredictUs,
+                fusionTiming.lastCorrectUs, fusionTiming.maxCorrectUs,
+                state.positionStd, state.sinceFixMs);
         }
         
-        float heading = myGNSS.getHeading() / 100000.0;
-        if (heading >= 0 && heading <= 360) {
-            gpsData.heading = heading;
+        const BleLinkState& link = systemData.bleLink;
+        if (link.connected) {
+            debugPrintf("📶 BLE: mtu:%d dle:%d int:%.2fms lat:%d notify:%luB/s n:%lu err:%lu oversize:%lu\n",
+                link.mtu, link.txOctets, link.connInterval * 1.25f, link.latency,
+                link.throughputBps, link.notifications, link.notifyErrors, link.oversizeDrops);
         }
-        
-        uint8_t fixType = myGNSS.getFixType();
-        if (fixType <= 5) {
-            gpsData.fixType = fixType;
+        const TelemetryBatchStats& udpStats = udpBatcher.getStats();
+        if (udpStats.frames > 0 || udpStats.sendFailures > 0) {
+            debugPrintf("📡 UDP: datagrams:%lu samples/dgram:%.1f full:%lu deadline:%lu hold max:%luus fail:%lu lost:%lu\n",
+                udpStats.frames, udpStats.frames ? (float)udpStats.samples / udpStats.frames : 0.0f,
+                udpStats.fullFrames, udpStats.deadlineFrames, udpStats.maxHoldUs,
+                udpStats.sendFailures, udpStats.samplesLost);
         }
-        
-        uint8_t sats = myGNSS.getSIV();
-        if (sats <= 50) {
-            gpsData.satellites = sats;
+        char policyLine[REPORT_STATS_LINE_SIZE];
+        if (blePolicy.isEnabled()) {
+            reportPolicyFormat(blePolicy, policyLine, sizeof(policyLine), false);
+            debugPrintf("🎚️ BLE policy: %s\n", policyLine);
         }
-        
-        uint16_t year = myGNSS.getYear();
-        if (year >= 2000 && year <= 2100) {
-            gpsData.year = year;
+        if (udpPolicy.isEnabled()) {
+            reportPolicyFormat(udpPolicy, policyLine, sizeof(policyLine), false);
+            debugPrintf("🎚️ UDP policy: %s\n", policyLine);
         }
-        
-        uint8_t month = myGNSS.getMonth();
-        if (month >= 1 && month <= 12) {
-            gpsData.month = month;
+        const TelemetryBatchStats& batch = bleBatcher.getStats();
+        if (batch.frames > 0) {
+            debugPrintf("📶 BLE batch: frames:%lu samples/frame:%.1f full:%lu deadline:%lu hold avg:%luus max:%luus lost:%lu\n",
+                batch.frames, (float)batch.samples / batch.frames, batch.fullFrames, batch.deadlineFrames,
+                (uint32_t)(batch.totalHoldUs / batch.frames), batch.maxHoldUs, batch.samplesLost);
         }
         
-        uint8_t day = myGNSS.getDay();
-        if (day >= 1 && day <= 31) {
-            gpsData.day = day;
+        if (deviceConfig.getBool(CFG_ENABLE_GPS)) {
+            const UbxParserStats& ubx = ubxParser.getStats();
+            debugPrintf("🛰️ UBX: bytes:%lu frames:%lu pvt:%lu ckErr:%lu lenErr:%lu\n",
+                ubx.bytes, ubx.frames, ubx.navPvtFrames, ubx.checksumErrors, ubx.lengthErrors);
         }
         
-        uint8_t hour = myGNSS.getHour();
-        if (hour <= 23) {
-            gpsData.hour = hour;
-        }
+        // Peripheral status
+        debugPrintf("🔗 Active: Display:✅ GPS:%s IMU:%s SD:%s WiFi:%s BLE:%s\n",
+            deviceConfig.getBool(CFG_ENABLE_GPS) ? "✅" : "🔄",
+            systemData.mpuAvailable ? "✅" : "🔄", 
+            systemData.sdCardAvailable ? "✅" : "❌",
+            (deviceConfig.getBool(CFG_ENABLE_WIFI) && WiFi.status() == WL_CONNECTED) ? "✅" : "❌",
+            (deviceConfig.getBool(CFG_ENABLE_BLE) && telemetryDescriptor && telemetryDescriptor->getNotifications()) ? "✅" : "❌");
         
-        uint8_t minute = myGNSS.getMinute();
-        if (minute <= 59) {
-            gpsData.minute = minute;
+        if (pipeline.isRunning() && debugMode) {
+            pipeline.printStats();
         }
-        
-        uint8_t second = myGNSS.getSecond();
-        if (second <= 59) {
-            gpsData.second = second;
+        if (STAGE_PROBES_ENABLED && debugMode) {
+            char report[PROBE_REPORT_SIZE];
+            probeFormat(report, sizeof(report), false);
+            Serial.print(report);
         }
-        
-        lastPacketTime = now;
-    } else if (!ENABLE_GPS) {
-        generateMockGPSData();  // Provide mock data for UI testing
-        hasGPSData = true;
     }
+}
+
+// UI stage: sole owner of LVGL. latest is the newest bus sample since the last call, or null.
+void serviceUI(const TelemetrySample* latest) {
+    // Handle LVGL tasks - this is CRITICAL for UI responsiveness
+    {
+        PROBE_SCOPE(PROBE_LVGL);
+        lv_timer_handler();
+    }
+    uiManager.update();
     
-    // Create and transmit data packet (with real or mock data)
-    if (hasGPSData || !ENABLE_GPS) {
-        unsigned long now = millis();
-        unsigned long delta = now - lastPacketTime;
-        if (lastPacketTime == 0) delta = 0;  // Prevent invalid delta on first run
-        
-        // Update performance stats with bounds checking
-        if (perfStats.totalPackets < ULONG_MAX) {
-            perfStats.totalPackets++;
-        }
-        
-        if (lastPacketTime > 0 && delta < 10000) {  // Reasonable delta range
-            if (delta < perfStats.minDelta) perfStats.minDelta = delta;
-            if (delta > perfStats.maxDelta && delta < 10000) perfStats.maxDelta = delta;
-            if (perfStats.avgDelta == 0) {
-                perfStats.avgDelta = delta;
-            } else {
-                perfStats.avgDelta = (perfStats.avgDelta + delta) / 2;
-            }
-        }
-        lastPacketTime = now;
-        
-        // Create GPS packet for transmission with bounds checking
-        GPSPacket packet;
-        memset(&packet, 0, sizeof(packet));  // Initialize all fields to zero
-        
-        packet.timestamp = gpsData.timestamp;
-        
-        // Safe coordinate conversion with bounds checking
-        if (gpsData.latitude >= -90 && gpsData.latitude <= 90) {
-            packet.latitude = (int32_t)(gpsData.latitude * 1e7);
-        }
-        if (gpsData.longitude >= -180 && gpsData.longitude <= 180) {
-            packet.longitude = (int32_t)(gpsData.longitude * 1e7);
-        }
-        if (gpsData.altitude >= -1000 && gpsData.altitude <= 10000) {
-            packet.altitude = gpsData.altitude * 1000;  // m to mm
-        }
-        if (gpsData.speed >= 0 && gpsData.speed <= 500) {
-            packet.speed = (uint16_t)(gpsData.speed / 0.0036);  // km/h to mm/s
-        }
-        if (gpsData.heading >= 0 && gpsData.heading <= 360) {
-            packet.heading = (uint32_t)(gpsData.heading * 1e5);
-        }
-        
-        packet.fixType = gpsData.fixType;
-        packet.satellites = gpsData.satellites;
-        
-        // Safe battery data with bounds checking
-        if (batteryData.voltage >= 0 && batteryData.voltage <= 10) {
-            packet.battery_mv = (uint16_t)(batteryData.voltage * 1000.0f);
-        }
-        if (batteryData.percentage <= 100) {
-            packet.battery_pct = batteryData.percentage;
-        }
-        
-        // Safe IMU data with bounds checking
-        if (systemData.mpuAvailable || !ENABLE_IMU) {
-            if (imuData.accelX >= -50 && imuData.accelX <= 50) {
-                packet.accel_x = (int16_t)(imuData.accelX * 1000);
-            }
-            if (imuData.accelY >= -50 && imuData.accelY <= 50) {
-                packet.accel_y = (int16_t)(imuData.accelY * 1000);
-            }
-            if (imuData.accelZ >= -50 && imuData.accelZ <= 50) {
-                packet.accel_z = (int16_t)(imuData.accelZ * 1000);
-            }
-            if (imuData.gyroX >= -2000 && imuData.gyroX <= 2000) {
-                packet.gyro_x = (int16_t)(imuData.gyroX * 100);
-            }
-            if (imuData.gyroY >= -2000 && imuData.gyroY <= 2000) {
-                packet.gyro_y = (int16_t)(imuData.gyroY * 100);
-            }
-        }
-        
-        packet.pmu_status = (batteryData.isCharging ? 0x01 : 0x00) |
-                           (batteryData.usbConnected ? 0x02 : 0x00) |
-                           (batteryData.isConnected ? 0x04 : 0x00);
-       
-        packet.crc = crc16((uint8_t*)&packet, sizeof(GPSPacket) - 2);
-        
-        // Send via UDP (if WiFi enabled and connected)
-        if (ENABLE_WIFI && wifiUDPEnabled && WiFi.status() == WL_CONNECTED) {
-            udp.beginPacket(remoteIP, remotePort);
-            udp.write((uint8_t*)&packet, sizeof(GPSPacket));
-            udp.endPacket();
-        }
-        
-        // Send via BLE (if enabled and connected)
-        if (ENABLE_BLE && telemetryChar && telemetryDescriptor && telemetryDescriptor->getNotifications()) {
-            telemetryChar->setValue((uint8_t*)&packet, sizeof(GPSPacket));
-            telemetryChar->notify();
-        }
-        
-        // Log to SD (if enabled and available)
-        if (ENABLE_SD_CARD && systemData.loggingActive && systemData.sdCardAvailable) {
-            if (!logFile) {
-                createLogFile();
-            }
-            if (logFile) {
-                size_t written = logFile.write((uint8_t*)&packet, sizeof(GPSPacket));
-                if (written != sizeof(GPSPacket)) {
-                    if (perfStats.droppedPackets < ULONG_MAX) {
-                        perfStats.droppedPackets++;
-                    }
-                } else {
-                    logFile.flush();
-                }
-            }
-        }
-        
-        // Update UI if significant changes (with bounds checking)
-        static uint8_t lastFixType = 255;  // Initialize to invalid value
-        static uint8_t lastSats = 255;
-        static float lastSpeed = -1;
-        
-        if (gpsData.fixType != lastFixType || 
-            abs((int)gpsData.satellites - (int)lastSats) > 1 ||
-            (lastSpeed >= 0 && abs(gpsData.speed - lastSpeed) > 1.0f)) {
+    // Update file transfer UI more frequently during transfer
+    if (fileTransfer.active) {
+        static unsigned long lastTransferUIUpdate = 0;
+        if (millis() - lastTransferUIUpdate > 500) {
             uiManager.requestUpdate();
-            lastFixType = gpsData.fixType;
-            lastSats = gpsData.satellites;
-            lastSpeed = gpsData.speed;
+            lastTransferUIUpdate = millis();
         }
-        
-        // Debug output every 10 seconds with safe formatting
-        if (now - lastDebugTime >= 10000) {
-            lastDebugTime = now;
-            
-            String dataSource = ENABLE_GPS ? "GPS" : "MOCK";
-            
-            // SAFE debug output with bounds checking
-            if (gpsData.year >= 2000 && gpsData.year <= 2100 &&
-                gpsData.month >= 1 && gpsData.month <= 12 &&
-                gpsData.day >= 1 && gpsData.day <= 31 &&
-                gpsData.hour <= 23 && gpsData.minute <= 59 && gpsData.second <= 59 &&
-                gpsData.speed >= 0 && gpsData.speed <= 500 &&
-                batteryData.voltage >= 0 && batteryData.voltage <= 10 &&
-                batteryData.percentage <= 100) {
-                
-                debugPrintf("📊 %s: %02d/%02d/%04d %02d:%02d:%02d | ",
-                    dataSource.c_str(), gpsData.day, gpsData.month, gpsData.year,
-                    gpsData.hour, gpsData.minute, gpsData.second);
-                
-                debugPrintf("Fix:%d Sats:%d Speed:%.1fkm/h Batt:%.1fV(%d%%)\n",
-                    gpsData.fixType, gpsData.satellites, gpsData.speed, 
-                    batteryData.voltage, batteryData.percentage);
-            }
-            
-            if (delta < 10000) {  // Only print if delta is reasonable
-                debugPrintf("⚡ Perf: Δ=%lums Pkts:%lu Drop:%lu RAM:%d\n",
-                    delta, perfStats.totalPackets, perfStats.droppedPackets, ESP.getFreeHeap());
-            }
-            
-            // Peripheral status
-            debugPrintf("🔗 Active: Display:✅ GPS:%s IMU:%s SD:%s WiFi:%s BLE:%s\n",
-                ENABLE_GPS ? "✅" : "🔄",
-                systemData.mpuAvailable ? "✅" : "🔄", 
-                systemData.sdCardAvailable ? "✅" : "❌",
-                (ENABLE_WIFI && WiFi.status() == WL_CONNECTED) ? "✅" : "❌",
-                (ENABLE_BLE && telemetryDescriptor && telemetryDescriptor->getNotifications()) ? "✅" : "❌");
+    }
+    
+    FusionState fused;
+    if (uiFusionConsumerId >= 0 && fusionBus.readLatest(uiFusionConsumerId, fused)) {
+        uiManager.setFusionState(fused);
+    }
+    
+    // Fresh samples arrive at the UI rate (RATE:UI:<hz>), already averaged
+    if (latest) {
+        uiManager.requestUpdate();
+    }
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(3000);
+    Serial.println("🚀 JC3248W535EN GPS Logger v6.1 Starting...");
+    Serial.println("🔧 Robust peripheral detection enabled");
+    
+    // Initialize the UI Manager first (always works)
+    uiManager.init(&systemData, &gpsData, &imuData, &batteryData, &perfStats);
+    uiManager.setFileTransferData(&fileTransfer);
+    uiManager.setLoggingCallback(requestToggleLogging);
+    Serial.println("✅ UI Manager initialized");
+    
+    if (!crc16SelfTest()) {
+        Serial.printf("⚠️ CRC16 self-test failed - using the %s implementation\n", crc16ImplName());
+    }
+    
+    // Build defaults overridden by NVS; decides which peripherals are brought up
+    deviceConfig.load(nvsConfigStore);
+    const ConfigStats& configStats = deviceConfig.getStats();
+    Serial.printf("⚙️ Config: %lu stored values loaded, %lu rejected\n",
+                  (unsigned long)configStats.loaded, (unsigned long)configStats.rejected);
+    debugMode = deviceConfig.getBool(CFG_DEBUG);
+    
+    // Initialize peripherals with robust detection
+    systemData.mpuAvailable = initIMU();
+    if (systemData.mpuAvailable && imuSampler.begin(&IMU_Wire, imuChipType, IMU_SAMPLE_RATE_HZ, IMU_INT_PIN)) {
+        imuConsumerId = imuSampler.getBus().addConsumer();
+    }
+    if (systemData.mpuAvailable && !loadIMUCalibration()) {
+        requestIMUCalibration();    // Runs in the background once samples flow
+    }
+    if (ENABLE_FUSION) {
+        fusionActive = fusionBus.begin(FUSION_RING_CAPACITY);
+        if (fusionActive) {
+            uiFusionConsumerId = fusionBus.addConsumer();
+            udpFusionConsumerId = fusionBus.addConsumer();
+        } else {
+            Serial.println("❌ Fusion bus allocation failed - fusion disabled");
+        }
+    }
+    systemData.sdCardAvailable = initSDCardRobust();
+    if (systemData.sdCardAvailable) {
+        SdLogger::repairLogs();  // Logs cut off by a power loss get their index rebuilt
+        if (!sdLogger.begin(&perfStats)) {
+            systemData.sdCardAvailable = false;
         }
     }
+    bool gpsAvailable = initGPS();
+    bool wifiAvailable = initWiFiRobust();
+    bool bleAvailable = initBLERobust();
+    
+    // System status summary
+    Serial.println("\n📊 System Status Summary:");
+    Serial.printf("   🖥️  Display: ✅ Ready\n");
+    Serial.printf("   🖱️  Touch:   %s\n", deviceConfig.getBool(CFG_ENABLE_TOUCH) ? "✅ Ready" : "❌ Disabled");
+    Serial.printf("   🛰️  GPS:     %s\n", gpsAvailable ? "✅ Connected" : "❌ Not found");
+    Serial.printf("   📄  IMU:     %s\n", systemData.mpuAvailable ? "✅ Connected" : "❌ Not found");
+    Serial.printf("   📱  SD Card: %s\n", systemData.sdCardAvailable ? "✅ Ready" : "❌ Not found");
+    Serial.printf("   📡  WiFi:    %s\n", wifiAvailable ? "✅ Connected" : "❌ Disabled/Failed");
+    Serial.printf("   🔵  BLE:     %s\n", bleAvailable ? "✅ Ready" : "❌ Failed");
+    
+    // Set system capabilities
+    systemData.touchAvailable = deviceConfig.getBool(CFG_ENABLE_TOUCH);
+    systemData.displayOn = true;
+    systemData.lastDisplayActivity = millis();
+    
+    
+    // CRITICAL: Initialize GPS data with safe defaults before any task reads it
+    gpsData.timestamp = millis() / 1000;
+    gpsData.year = 2025;
+    gpsData.month = 8;
+    gpsData.day = 19;
+    gpsData.hour = 12;
+    Serial.println("✅ GPS data initialized with safe defaults");
+    
+    Serial.println("\n🎯 JC3248W535EN GPS Logger Ready!");
+    if (!gpsAvailable) {
+        Serial.println("📍 No GPS detected - will use mock data for UI testing");
+    }
+    if (!systemData.mpuAvailable) {
+        Serial.println("🎯 No IMU detected - will use mock data for UI testing");
+    }
+    Serial.println("🖱️ Touch interface active");
+    
+    // Hand the data path over to the pinned FreeRTOS tasks
+    pipeline.addSink("sd", sinkSD);
+    pipeline.addSink("ble", sinkBLE);
+    if (deviceConfig.getBool(CFG_ENABLE_WIFI)) {
+        SinkTaskConfig udpTask = { UDP_TASK_CORE, UDP_TASK_PRIORITY, UDP_TASK_STACK,
+                                   UDP_TASK_IDLE_MS, deviceConfig.get(CFG_UDP_BACKLOG), pollUDPBatch };
+        pipeline.addTaskSink("udp", sinkUDP, udpTask);
+    }
+    bleSinkIndex = pipeline.findSink("ble");
+    udpSinkIndex = pipeline.findSink("udp");
+    pipeline.setEpochRate((uint16_t)deviceConfig.get(CFG_NAV_RATE_HZ));
+    
+    // Live settings reach their owners now and after every CFG change
+    deviceConfig.subscribe(CONFIG_SCOPE_DEBUG, applyDebugConfig);
+    deviceConfig.subscribe(CONFIG_SCOPE_UDP, applyUdpConfig);
+    deviceConfig.subscribe(CONFIG_SCOPE_BATCHING, applyBatchConfig);
+    deviceConfig.subscribe(CONFIG_SCOPE_RATES, applyRateConfig);
+    deviceConfig.subscribe(CONFIG_SCOPE_REPORT, applyReportConfig);
+    deviceConfig.notifyAll();
+    
+    PipelineCallbacks callbacks;
+    callbacks.ingest = ingestSample;
+    callbacks.housekeeping = serviceHousekeeping;
+    callbacks.uiService = serviceUI;
+    if (!pipeline.begin(callbacks)) {
+        Serial.println("⚠️ Pipeline start failed - falling back to single-loop mode");
+    }
+}
+
+void loop() {
+    if (pipeline.isRunning()) {
+        // All work happens in the pipeline tasks; the Arduino loop task is not needed
+        vTaskDelete(NULL);
+        return;
+    }
+    
+    // Fallback: run every stage serially, as before
+    static uint32_t sequence = 0;
+    TelemetrySample sample;
+    serviceHousekeeping();
+    bool ingested = ingestSample(sample.packet);
+    if (ingested) {
+        sample.timestampUs = esp_timer_get_time();
+        sample.sequence = sequence++;
+        sinkSD(sample);
+        sinkBLE(sample);
+        sinkUDP(sample);
+    }
+    serviceUI(ingested ? &sample : nullptr);
+    pollUDPBatch();
     
     // Small delay to prevent overwhelming the system
     delay(5);
-}
\ No newline at end of file
+}
@@ -0,0 +1,215 @@
+#include "host_io.h"
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+HostStorageFile::HostStorageFile(const std::string& root) : root(root), file(nullptr) {}
+
+HostStorageFile::~HostStorageFile() {
+    close();
+}
+
+std::string HostStorageFile::hostPath(const char* path) const {
+    std::string full = root;
+    if (!full.empty() && full[full.size() - 1] != '/' && path[0] != '/') full += '/';
+    return full + path;
+}
+
+bool HostStorageFile::open(const char* path, StorageMode mode) {
+    close();
+    const char* stdioMode = mode == STORAGE_READ ? "rb" : mode == STORAGE_APPEND ? "ab" : "wb";
+    file = fopen(hostPath(path).c_str(), stdioMode);
+    return file != nullptr;
+}
+
+void HostStorageFile::close() {
+    if (file) fclose(file);
+    file = nullptr;
+}
+
+size_t HostStorageFile::read(uint8_t* buffer, size_t length) {
+    return file ? fread(buffer, 1, length, file) : 0;
+}
+
+size_t HostStorageFile::write(const uint8_t* data, size_t length) {
+    return file ? fwrite(data, 1, length, file) : 0;
+}
+
+bool HostStorageFile::seek(uint32_t position) {
+    return file && fseek(file, position, SEEK_SET) == 0;
+}
+
+uint32_t HostStorageFile::position() {
+    return file ? (uint32_t)ftell(file) : 0;
+}
+
+uint32_t HostStorageFile::size() {
+    if (!file) return 0;
+    long current = ftell(file);
+    fseek(file, 0, SEEK_END);
+    long end = ftell(file);
+    fseek(file, current, SEEK_SET);
+    return (uint32_t)end;
+}
+
+void HostStorageFile::flush() {
+    if (file) fflush(file);
+}
+
+LoopbackLink::LoopbackLink(size_t maxPayload, uint32_t lossPercent, uint32_t seed) :
+    payloadLimit(maxPayload), lossPercent(lossPercent), rng(seed ? seed : 1),
+    frames(0), bytes(0), lost(0), refused(0) {}
+
+bool LoopbackLink::send(const uint8_t* data, size_t length) {
+    if (length > payloadLimit) {
+        refused++;
+        return false;
+    }
+    frames++;
+    bytes += length;
+
+    // xorshift32 - reproducible loss pattern for a given seed
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    if (lossPercent > 0 && rng % 100 < lossPercent) {
+        lost++;
+        return true;    // Accepted by the radio, lost on the air
+    }
+    queue.push_back(std::vector<uint8_t>(data, data + length));
+    return true;
+}
+
+bool LoopbackLink::receive(std::vector<uint8_t>& out) {
+    if (queue.empty()) return false;
+    out.swap(queue.front());
+    queue.pop_front();
+    return true;
+}
+
+MemoryByteStream::MemoryByteStream() : readPos(0), releasedPos(0) {}
+
+void MemoryByteStream::load(const std::vector<uint8_t>& data) {
+    rx = data;
+    readPos = 0;
+    releasedPos = 0;
+}
+
+void MemoryByteStream::release(size_t count) {
+    releasedPos += count;
+    if (releasedPos > rx.size()) releasedPos = rx.size();
+}
+
+size_t MemoryByteStream::read(uint8_t* buffer, size_t length) {
+    size_t n = available() < length ? available() : length;
+    memcpy(buffer, rx.data() + readPos, n);
+    readPos += n;
+    return n;
+}
+
+size_t MemoryByteStream::write(const uint8_t* data, size_t length) {
+    tx.insert(tx.end(), data, data + length);
+    return length;
+}
+
+size_t MemoryConfigStore::read(const char* key, uint8_t* buffer, size_t size) {
+    std::map<std::string, std::vector<uint8_t> >::const_iterator it = values.find(key);
+    if (it == values.end() || it->second.size() > size) return 0;
+    memcpy(buffer, it->second.data(), it->second.size());
+    return it->second.size();
+}
+
+bool MemoryConfigStore::write(const char* key, const uint8_t* data, size_t length) {
+    values[key].assign(data, data + length);
+    return true;
+}
+
+bool MemoryConfigStore::erase(const char* key) {
+    values.erase(key);
+    return true;
+}
+
+static int openUdpSocket() {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd >= 0) fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+UdpSocketLink::UdpSocketLink() : fd(-1) {}
+
+UdpSocketLink::~UdpSocketLink() {
+    close();
+}
+
+bool UdpSocketLink::open(const char* address, uint16_t port) {
+    close();
+    sockaddr_in to;
+    memset(&to, 0, sizeof(to));
+    to.sin_family = AF_INET;
+    to.sin_port = htons(port);
+    if (inet_pton(AF_INET, address, &to.sin_addr) != 1) return false;
+
+    fd = openUdpSocket();
+    if (fd < 0) return false;
+    if (connect(fd, (const sockaddr*)&to, sizeof(to)) != 0) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void UdpSocketLink::close() {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+}
+
+bool UdpSocketLink::send(const uint8_t* data, size_t length) {
+    if (fd < 0 || length > maxPayload()) return false;
+    return ::send(fd, data, length, 0) == (ssize_t)length;
+}
+
+UdpReceiver::UdpReceiver() : fd(-1), port(0) {}
+
+UdpReceiver::~UdpReceiver() {
+    close();
+}
+
+bool UdpReceiver::open(uint16_t listenPort, int receiveBuffer) {
+    close();
+    fd = openUdpSocket();
+    if (fd < 0) return false;
+    if (receiveBuffer > 0) {
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+    }
+
+    sockaddr_in local;
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_port = htons(listenPort);
+    local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(local);
+    if (bind(fd, (const sockaddr*)&local, sizeof(local)) != 0 ||
+        getsockname(fd, (sockaddr*)&local, &length) != 0) {
+        close();
+        return false;
+    }
+    port = ntohs(local.sin_port);
+    return true;
+}
+
+void UdpReceiver::close() {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+}
+
+bool UdpReceiver::receive(std::vector<uint8_t>& out) {
+    if (fd < 0) return false;
+    out.resize(65536);
+    ssize_t length = recv(fd, out.data(), out.size(), 0);
+    if (length < 0) return false;
+    out.resize(length);
+    return true;
+}
@@ -0,0 +1,148 @@
+#ifndef HOST_IO_H
+#define HOST_IO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include "../platform_io.h"
+
+// ==============================================
+// HOST STAND-INS FOR THE PLATFORM I/O INTERFACES
+// ==============================================
+// Used by the PlatformIO `native` environment only (excluded from the
+// firmware build): files live under a host directory instead of the SD card,
+// BLE becomes an in-memory loopback queue, UDP a real socket on the host, and
+// the GNSS UART is a byte buffer released to the parser a chunk at a time.
+
+// StorageFile backed by stdio, with SD paths ("/LOG_0001.bin") mapped under root
+class HostStorageFile : public StorageFile {
+public:
+    explicit HostStorageFile(const std::string& root);
+    ~HostStorageFile();
+
+    bool open(const char* path, StorageMode mode) override;
+    bool isOpen() const override { return file != nullptr; }
+    void close() override;
+
+    size_t read(uint8_t* buffer, size_t length) override;
+    size_t write(const uint8_t* data, size_t length) override;
+    bool seek(uint32_t position) override;
+    uint32_t position() override;
+    uint32_t size() override;
+    void flush() override;
+
+    std::string hostPath(const char* path) const;
+
+private:
+    std::string root;
+    FILE* file;
+};
+
+// PacketLink that queues every accepted datagram for the other end to collect.
+// lossPercent drops frames pseudo-randomly (deterministic seed) after they were accepted.
+class LoopbackLink : public PacketLink {
+public:
+    LoopbackLink(size_t maxPayload, uint32_t lossPercent = 0, uint32_t seed = 1);
+
+    bool isReady() override { return true; }
+    size_t maxPayload() override { return payloadLimit; }
+    bool send(const uint8_t* data, size_t length) override;
+
+    // Other end of the link: next queued datagram, if any
+    bool receive(std::vector<uint8_t>& out);
+    size_t pending() const { return queue.size(); }
+
+    uint32_t getFrames() const { return frames; }
+    uint64_t getBytes() const { return bytes; }
+    uint32_t getLost() const { return lost; }
+    uint32_t getRefused() const { return refused; }
+
+private:
+    size_t payloadLimit;
+    uint32_t lossPercent;
+    uint32_t rng;
+    std::deque<std::vector<uint8_t> > queue;
+    uint32_t frames;
+    uint64_t bytes;
+    uint32_t lost;
+    uint32_t refused;
+};
+
+// ByteStream over a memory buffer. Bytes become readable only once released,
+// which models data arriving in the UART RX buffer over time.
+class MemoryByteStream : public ByteStream {
+public:
+    MemoryByteStream();
+
+    void load(const std::vector<uint8_t>& data);
+    void release(size_t count);             // Make the next `count` bytes readable
+    bool exhausted() const { return readPos >= rx.size(); }
+
+    size_t available() override { return releasedPos - readPos; }
+    size_t read(uint8_t* buffer, size_t length) override;
+    size_t write(const uint8_t* data, size_t length) override;
+
+    const std::vector<uint8_t>& written() const { return tx; }
+
+private:
+    std::vector<uint8_t> rx;
+    std::vector<uint8_t> tx;
+    size_t readPos;
+    size_t releasedPos;
+};
+
+// ConfigStore over a map, standing in for the NVS namespace. Survives a
+// ConfigRegistry being rebuilt, which is how the tests model a reboot.
+class MemoryConfigStore : public ConfigStore {
+public:
+    size_t read(const char* key, uint8_t* buffer, size_t size) override;
+    bool write(const char* key, const uint8_t* data, size_t length) override;
+    bool erase(const char* key) override;
+
+    bool contains(const char* key) const { return values.count(key) != 0; }
+    size_t size() const { return values.size(); }
+
+private:
+    std::map<std::string, std::vector<uint8_t> > values;
+};
+
+// PacketLink over a real non-blocking UDP socket (the UDP sink's WiFiUDP).
+// send() fails instead of blocking when the host stack pushes back.
+class UdpSocketLink : public PacketLink {
+public:
+    UdpSocketLink();
+    ~UdpSocketLink();
+
+    bool open(const char* address, uint16_t port);
+    void close();
+
+    bool isReady() override { return fd >= 0; }
+    size_t maxPayload() override { return 1472; }
+    bool send(const uint8_t* data, size_t length) override;
+
+private:
+    int fd;
+};
+
+// The listening end: a bound non-blocking socket standing in for the ground station
+class UdpReceiver {
+public:
+    UdpReceiver();
+    ~UdpReceiver();
+
+    // port 0 picks a free one; receiveBuffer 0 keeps the system default
+    bool open(uint16_t port, int receiveBuffer = 0);
+    void close();
+    uint16_t getPort() const { return port; }
+
+    bool receive(std::vector<uint8_t>& out);
+
+private:
+    int fd;
+    uint16_t port;
+};
+
+#endif // HOST_IO_H
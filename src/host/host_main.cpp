@@ -0,0 +1,1833 @@
+// Host build of the telemetry data path (PlatformIO `native` environment).
+//
+//   gpslogger_host [epochs] [output dir]
+//   gpslogger_host replay <file> [speed]
+//   gpslogger_host bench [filter] [output dir]
+//   gpslogger_host fuzz [iterations] [seed]
+//
+// Runs the firmware's own UBX parser, packet builder, delta codec, log writer,
+// file-transfer protocol, command parser, replay source, latency histograms,
+// the telemetry bus ring (including a reader racing the producer thread),
+// BLE/UDP telemetry batching, dead-band reporting, per-consumer rate
+// control, GNSS/IMU fusion and the NVS config registry against the stand-ins
+// in host_io.h (UDP over real loopback sockets), checks every stage end to end
+// and prints per-stage timings. Exits non-zero when any check fails, so it
+// doubles as a regression run.
+//
+// `replay` feeds a v2 log or raw UBX capture (e.g. one pulled off the SD card)
+// through the same ingest path at `speed` times real time, 0 = as fast as
+// possible, and reports samples/s and per-stage cost. `bench` runs the
+// data-path microbenchmarks (bench_suite.h) and prints their CSV lines.
+// `fuzz` throws random and mutated input at the text and binary command
+// parsers and checks they never accept anything malformed.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "host_io.h"
+#include "../ubx_parser.h"
+#include "../packet_builder.h"
+#include "../delta_codec.h"
+#include "../log_format.h"
+#include "../log_writer.h"
+#include "../file_transfer_protocol.h"
+#include "../command_parser.h"
+#include "../command_frame.h"
+#include "../replay_source.h"
+#include "../bench_suite.h"
+#include "../latency_histogram.h"
+#include "../telemetry_batch.h"
+#include "../report_policy.h"
+#include "../rate_control.h"
+#include "../config_registry.h"
+#include "../telemetry_ring.h"
+#include "../crc16.h"
+#include "../fusion_engine.h"
+
+#define HOST_NAV_RATE_HZ        25
+#define HOST_BLOCK_SIZE         4096
+#define HOST_BLE_MTU            247
+#define HOST_LOSS_PERCENT       5
+#define HOST_LOG_PATH           "/HOST_0001.bin"
+#define HOST_CAPTURE_PATH       "/HOST_0001.ubx"
+#define HOST_BATCH_LATENCY_US   100000  // BATCH:100
+#define HOST_RING_CAPACITY      1024    // TELEMETRY_RING_CAPACITY
+#define HOST_UDP_BACKLOG        250     // UDP_MAX_BACKLOG
+#define EPOCH_BUDGET_HOST_US    40000   // EPOCH_BUDGET_US
+#define HOST_REPLAY_SPEED       1000    // Paced replay check: 25 Hz recorded, 25 kHz replayed
+#define HOST_REPLAY_RING_CAPACITY 64    // REPLAY_RING_CAPACITY
+#define HOST_PARKED_SECONDS     120     // Stationary tail appended to the replayed drive
+#define HOST_INGEST_JITTER_US   3000    // +- on the 40 ms ingest timestamps in the rate stage
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsedUs(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+static int64_t hostClockUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now().time_since_epoch()).count();
+}
+
+static uint32_t hostClockNs() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("%s %s\n", ok ? "PASS" : "FAIL", what);
+    if (!ok) failures++;
+}
+
+// UBX frame around a payload, with the Fletcher checksum
+static void appendUbxFrame(std::vector<uint8_t>& out, uint8_t cls, uint8_t id,
+                           const uint8_t* payload, uint16_t length) {
+    uint8_t header[6] = { UBX_SYNC_CHAR_1, UBX_SYNC_CHAR_2, cls, id,
+                          (uint8_t)(length & 0xFF), (uint8_t)(length >> 8) };
+    uint8_t ckA = 0, ckB = 0;
+    for (int i = 2; i < 6; i++) { ckA += header[i]; ckB += ckA; }
+    for (uint16_t i = 0; i < length; i++) { ckA += payload[i]; ckB += ckA; }
+    out.insert(out.end(), header, header + 6);
+    out.insert(out.end(), payload, payload + length);
+    out.push_back(ckA);
+    out.push_back(ckB);
+}
+
+// Synthetic drive: 25 Hz NAV-PVT along a slow curve out of Warsaw
+static void synthesizeNavPvt(uint32_t epochs, std::vector<uint8_t>& stream) {
+    double lat = 52.2297, lon = 21.0122, heading = 45.0;
+    for (uint32_t i = 0; i < epochs; i++) {
+        double t = (double)i / HOST_NAV_RATE_HZ;
+        double speed = 12.0 + 3.0 * sin(t * 0.2);       // m/s
+        heading = fmod(heading + 2.0 / HOST_NAV_RATE_HZ + 360.0, 360.0);
+        lat += speed * cos(heading * M_PI / 180.0) / HOST_NAV_RATE_HZ / 111319.5;
+        lon += speed * sin(heading * M_PI / 180.0) / HOST_NAV_RATE_HZ / (111319.5 * cos(lat * M_PI / 180.0));
+
+        UbxNavPvt pvt;
+        memset(&pvt, 0, sizeof(pvt));
+        uint32_t second = 12 * 3600 + i / HOST_NAV_RATE_HZ;
+        pvt.iTOW = i * (1000 / HOST_NAV_RATE_HZ);
+        pvt.year = 2025; pvt.month = 8; pvt.day = 19;
+        pvt.hour = (second / 3600) % 24; pvt.min = (second / 60) % 60; pvt.sec = second % 60;
+        pvt.valid = 0x07;
+        pvt.fixType = 3;
+        pvt.flags = 0x01;
+        pvt.numSV = 14;
+        pvt.lat = (int32_t)llround(lat * 1e7);
+        pvt.lon = (int32_t)llround(lon * 1e7);
+        pvt.height = 110000 + (int32_t)(i % 50);
+        pvt.hAcc = 1500;
+        pvt.gSpeed = (int32_t)(speed * 1000);
+        pvt.headMot = (int32_t)(heading * 1e5);
+        pvt.sAcc = 200;
+        pvt.headAcc = 50000;
+        appendUbxFrame(stream, UBX_CLASS_NAV, UBX_ID_NAV_PVT, (const uint8_t*)&pvt, sizeof(pvt));
+
+        // Something the parser has to skip (NAV-STATUS sized)
+        if (i % 10 == 0) {
+            uint8_t status[16] = { 0 };
+            appendUbxFrame(stream, UBX_CLASS_NAV, 0x03, status, sizeof(status));
+        }
+    }
+}
+
+// Stage 1-3: UART -> UBX parser -> GPSData -> packet -> UDP/BLE/SD sinks
+static void runPipeline(uint32_t epochs, HostStorageFile& storage, std::vector<GPSPacket>& packets) {
+    std::vector<uint8_t> bytes;
+    synthesizeNavPvt(epochs, bytes);
+
+    // Keep the receiver output as a capture for the replay stage
+    check(storage.open(HOST_CAPTURE_PATH, STORAGE_WRITE) &&
+          storage.write(bytes.data(), bytes.size()) == bytes.size(), "UBX capture written");
+    storage.close();
+
+    MemoryByteStream uart;
+    uart.load(bytes);
+    UbxParser parser;
+    GPSData gps;
+    IMUData imu;
+    PacketPower power = { 3950, 87, 0x04 };
+    LoopbackLink udp(1472);
+    LoopbackLink ble(HOST_BLE_MTU - FT_ATT_OVERHEAD);
+    TelemetryBatcher udpBatcher;    // Size-bound only: the simulated epochs take no time
+    udpBatcher.setMaxFrame(512);
+    udpBatcher.setMaxLatency(100000);
+
+    LogFileHeader header;
+    logInitFileHeader(header, HOST_BLOCK_SIZE, 0, LOG_ENCODING_DELTA, 1755604800UL);
+    LogWriter writer;
+    check(writer.open(&storage, HOST_LOG_PATH, header), "log file created");
+
+    static uint8_t block[HOST_BLOCK_SIZE];
+    LogBlockBuilder builder;
+    DeltaEncoder encoder;
+    uint32_t sequence = 0, firstRecord = 0;
+
+    double parseUs = 0, buildUs = 0, logUs = 0;
+    uint8_t rx[256];
+    size_t frameBytes = sizeof(UbxNavPvt) + 8;
+
+    while (!uart.exhausted()) {
+        uart.release(frameBytes);   // One epoch's worth of UART bytes arrives
+
+        Clock::time_point t0 = Clock::now();
+        uint32_t fixes = parser.poll(uart, rx, sizeof(rx));
+        parseUs += elapsedUs(t0);
+        if (fixes == 0) continue;
+
+        t0 = Clock::now();
+        gpsDataFromNavPvt(parser.navPvt(), gps);
+        imu.accelX = 0.01f * (packets.size() % 7);
+        imu.accelZ = 1.0f;
+        GPSPacket packet;
+        buildPacket(gps, &imu, power, packet);
+        buildUs += elapsedUs(t0);
+        packets.push_back(packet);
+
+        udpBatcher.add(udp, packet, (uint32_t)packets.size() - 1, 0, 0);
+        ble.send((const uint8_t*)&packet, sizeof(packet));
+
+        // Same keyframe-per-block policy as sinkSD()
+        t0 = Clock::now();
+        uint8_t record[DELTA_MAX_RECORD_SIZE];
+        if (builder.isActive() && builder.space() < DELTA_MAX_RECORD_SIZE) {
+            uint16_t count = builder.seal(sequence++, firstRecord);
+            firstRecord += count;
+            writer.writeBlock(block, HOST_BLOCK_SIZE, count);
+        }
+        if (!builder.isActive()) {
+            builder.begin(block, HOST_BLOCK_SIZE, LOG_ENCODING_DELTA);
+            encoder.forceKeyframe();
+        }
+        size_t length = encoder.encode(packet, record);
+        builder.add(record, length, packet.timestamp);
+        logUs += elapsedUs(t0);
+    }
+    if (builder.isActive() && builder.records() > 0) {
+        uint16_t count = builder.seal(sequence++, firstRecord);
+        writer.writeBlock(block, HOST_BLOCK_SIZE, count);
+    }
+    uint32_t blocks = writer.getBlocks();
+    writer.finish();
+    udpBatcher.flush(udp, 0);
+
+    const UbxParserStats& ubx = parser.getStats();
+    const DeltaCodecStats& codec = encoder.getStats();
+    printf("pipeline: %u epochs, %u frames (%u NAV-PVT), ck errors %u\n",
+           epochs, ubx.frames, ubx.navPvtFrames, ubx.checksumErrors);
+    printf("  parse %.3f us/epoch, packet %.3f us, log %.3f us\n",
+           parseUs / packets.size(), buildUs / packets.size(), logUs / packets.size());
+    printf("  log: %u blocks, codec ratio %.2fx, udp %u datagrams, ble %u frames\n",
+           blocks, (double)codec.rawBytes / codec.encodedBytes, udp.getFrames(), ble.getFrames());
+
+    check(ubx.navPvtFrames == epochs && ubx.checksumErrors == 0, "every NAV-PVT parsed");
+    check(packets.size() == epochs, "one packet per epoch");
+    check(udpBatcher.getStats().samples == epochs && ble.getFrames() == epochs && ble.getRefused() == 0,
+          "sinks saw every packet");
+}
+
+// Stage 3b: a damaged receiver stream - bit flips, truncated frames, junk
+// between frames - fed byte by byte, then in reads split at random points.
+// Every intact frame has to come out, in order, and every bad one counted.
+enum UbxDamage { UBX_INTACT, UBX_FLIP_BODY, UBX_FLIP_LENGTH, UBX_TRUNCATED, UBX_JUNK_BEFORE, UBX_FLIP_SYNC };
+
+static void checkUbxCorruption() {
+    const uint32_t frames = 2000;
+    uint32_t rng = 2024;
+    std::vector<uint8_t> stream, frame;
+    std::vector<uint32_t> intact;
+    uint32_t bad = 0, damaged[UBX_FLIP_SYNC + 1] = { 0 };
+
+    for (uint32_t i = 0; i < frames; i++) {
+        UbxNavPvt pvt;
+        uint8_t* raw = (uint8_t*)&pvt;
+        for (size_t b = 0; b < sizeof(pvt); b++) raw[b] = (uint8_t)((rng = rng * 1103515245 + 12345) >> 16);
+        pvt.iTOW = i;
+        frame.clear();
+        appendUbxFrame(frame, UBX_CLASS_NAV, UBX_ID_NAV_PVT, raw, sizeof(pvt));
+
+        uint32_t r = (rng = rng * 1103515245 + 12345) >> 16;
+        UbxDamage damage = r % 100 < 60 ? UBX_INTACT : (UbxDamage)(1 + r % 5);
+        uint32_t at = ((rng = rng * 1103515245 + 12345) >> 16);
+        switch (damage) {
+            case UBX_FLIP_BODY:     frame[6 + at % (frame.size() - 6)] ^= 1 << (at >> 8) % 8; break;
+            case UBX_FLIP_LENGTH:   frame[4 + at % 2] ^= 1 << (at >> 8) % 8; break;
+            case UBX_TRUNCATED:     frame.resize(2 + at % (frame.size() - 3)); break;
+            case UBX_FLIP_SYNC:     frame[at % 2] ^= 1 << (at >> 8) % 8; break;
+            case UBX_JUNK_BEFORE:
+                for (uint32_t n = at % 40; n > 0; n--) {
+                    uint8_t junk = (uint8_t)((rng = rng * 1103515245 + 12345) >> 16);
+                    stream.push_back(junk == UBX_SYNC_CHAR_1 ? 0 : junk);
+                }
+                break;
+            default: break;
+        }
+        damaged[damage]++;
+        if (damage == UBX_INTACT || damage == UBX_JUNK_BEFORE) intact.push_back(i);
+        if (damage == UBX_FLIP_BODY || damage == UBX_FLIP_LENGTH || damage == UBX_TRUNCATED) bad++;
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+
+    // A rescan can complete several frames on one byte; navPvt() is the last of them
+    UbxParser parser;
+    size_t decoded = 0;
+    bool inOrder = true;
+    for (size_t i = 0; i < stream.size(); i++) {
+        uint32_t completed = parser.feed(&stream[i], 1);
+        if (completed == 0) continue;
+        decoded += completed;
+        inOrder &= decoded <= intact.size() && parser.navPvt().iTOW == intact[decoded - 1];
+    }
+    const UbxParserStats& s = parser.getStats();
+    printf("ubx damage: %u frames, %u intact, %u flipped body, %u flipped length, %u truncated, %u after junk, "
+           "%u flipped sync -> %u decoded, %u checksum + %u length errors, %u rescans\n",
+           frames, damaged[UBX_INTACT], damaged[UBX_FLIP_BODY], damaged[UBX_FLIP_LENGTH], damaged[UBX_TRUNCATED],
+           damaged[UBX_JUNK_BEFORE], damaged[UBX_FLIP_SYNC], (uint32_t)decoded, s.checksumErrors,
+           s.lengthErrors, s.rescans);
+    check(inOrder && decoded == intact.size(), "every intact UBX frame decodes after corrupted ones, in order");
+    check(s.checksumErrors + s.lengthErrors >= bad && s.rescans >= bad &&
+          s.checksumErrors >= damaged[UBX_FLIP_BODY], "every corrupted UBX frame is counted");
+
+    // Same stream as UART reads of random size through a small buffer
+    MemoryByteStream uart;
+    uart.load(stream);
+    UbxParser split;
+    uint8_t rx[64];
+    uint32_t completed = 0;
+    while (!uart.exhausted()) {
+        uart.release(1 + ((rng = rng * 1103515245 + 12345) >> 16) % 300);
+        completed += split.poll(uart, rx, 1 + ((rng = rng * 1103515245 + 12345) >> 16) % sizeof(rx));
+    }
+    const UbxParserStats& t = split.getStats();
+    check(completed == intact.size() && t.navPvtFrames == s.navPvtFrames && t.frames == s.frames &&
+          t.checksumErrors == s.checksumErrors && t.lengthErrors == s.lengthErrors && t.bytes == stream.size() &&
+          split.navPvt().iTOW == intact.back(), "UBX reads split at random points decode the same");
+}
+
+// Stage 4: read the log back through the format checks and the decoder
+static void verifyLog(HostStorageFile& storage, const std::vector<GPSPacket>& packets) {
+    static uint8_t scratch[LOG_MAX_BLOCK_SIZE];
+    LogRepairResult repair;
+    check(logRepair(storage, HOST_LOG_PATH, scratch, sizeof(scratch), repair) && !repair.repaired &&
+          repair.records == packets.size(), "log footer intact");
+
+    check(storage.open(HOST_LOG_PATH, STORAGE_READ), "log reopened");
+    LogFileHeader header;
+    storage.read((uint8_t*)&header, sizeof(header));
+    check(logCheckFileHeader(header) && header.encoding == LOG_ENCODING_DELTA, "file header valid");
+
+    size_t decoded = 0;
+    bool match = true;
+    for (uint32_t n = 0; n < repair.blocks; n++) {
+        storage.seek(logBlockOffset(header.blockSize, n));
+        if (storage.read(scratch, header.blockSize) != header.blockSize || !logCheckBlock(scratch, header.blockSize)) {
+            match = false;
+            break;
+        }
+        const LogBlockHeader* bh = (const LogBlockHeader*)scratch;
+        const uint8_t* payload = scratch + sizeof(LogBlockHeader);
+        size_t offset = 0;
+        DeltaDecoder decoder;
+        for (uint16_t r = 0; r < bh->recordCount; r++) {
+            GPSPacket packet;
+            size_t consumed = 0;
+            if (decoder.decode(payload + offset, bh->payloadLength - offset, packet, &consumed) != DeltaDecoder::DECODE_OK ||
+                decoded >= packets.size() || memcmp(&packet, &packets[decoded], sizeof(packet)) != 0) {
+                match = false;
+                break;
+            }
+            offset += consumed;
+            decoded++;
+        }
+    }
+    storage.close();
+    check(match && decoded == packets.size(), "log decodes to the exact packets");
+}
+
+// Stage 5: download the log over a lossy loopback link with the reference client
+static void transferLog(HostStorageFile& storage) {
+    check(storage.open(HOST_LOG_PATH, STORAGE_READ), "log opened for transfer");
+    uint32_t fileSize = storage.size();
+    std::vector<uint8_t> original(fileSize);
+    storage.read(original.data(), fileSize);
+    storage.seek(0);
+
+    LoopbackLink down(HOST_BLE_MTU - FT_ATT_OVERHEAD, HOST_LOSS_PERCENT, 7);
+    uint16_t payloadSize = ftPayloadSize(HOST_BLE_MTU);
+    FtSender sender;
+    FtReceiver receiver;
+    sender.begin(fileSize, payloadSize, 16, 0);
+    receiver.begin(fileSize, 4, 16);
+
+    std::vector<uint8_t> received(fileSize);
+    static uint8_t frame[sizeof(FtDataHeader) + FT_MAX_PAYLOAD];
+    bool complete = false, crcError = false;
+    uint32_t nowMs = 0;
+
+    Clock::time_point t0 = Clock::now();
+    while (!complete && !crcError && nowMs < 600000) {
+        nowMs += 10;    // One sink-task poll
+        sender.checkTimeout(nowMs, 1000);
+        if (ftSendFrames(sender, storage, down, 8, frame) < 0) break;
+        if (sender.done()) {
+            FtEndFrame end;
+            sender.buildEnd(end);
+            down.send((const uint8_t*)&end, sizeof(end));
+        }
+
+        std::vector<uint8_t> datagram;
+        while (down.receive(datagram)) {
+            const uint8_t* payload;
+            size_t length;
+            uint32_t offset;
+            FtReceiver::Result result = receiver.onFrame(datagram.data(), datagram.size(), &payload, &length, &offset);
+            if (result == FtReceiver::FT_RX_DATA) memcpy(received.data() + offset, payload, length);
+            if (result == FtReceiver::FT_RX_COMPLETE) complete = true;
+            if (result == FtReceiver::FT_RX_CRC_ERROR) crcError = true;
+
+            FtAckFrame ack;
+            if (receiver.takeAck(ack)) sender.onAck(ack, nowMs);   // Acks travel back losslessly
+        }
+    }
+    double us = elapsedUs(t0);
+    storage.close();
+
+    printf("transfer: %u bytes, %u frames, %u resent, %u lost, %u timeouts, %.1f ms simulated, %.0f us host\n",
+           fileSize, sender.getFramesSent(), sender.getRetransmits(), down.getLost(),
+           sender.getTimeouts(), (double)nowMs, us);
+    check(complete && received == original, "file transfer byte-exact over a lossy link");
+}
+
+// Replay a log or capture through the ingest path the way ingestSample() does
+// while a REPLAY: command is running: replay -> GPSData -> packet -> sinks
+static bool replayFile(HostStorageFile& storage, const char* path, uint16_t speed,
+                       std::vector<GPSPacket>& out, GPSData& gps) {
+    static uint8_t buffer[LOG_MAX_BLOCK_SIZE];
+    ReplaySource replay(hostClockUs);
+    if (!replay.open(&storage, path, speed, buffer, sizeof(buffer))) {
+        printf("replay: %s is not a v2 log or UBX capture\n", path);
+        return false;
+    }
+    ReplayFormat format = replay.getFormat();
+
+    IMUData imu;
+    PacketPower power = { 3950, 87, 0x04 };
+    LoopbackLink udp(1472);
+    LoopbackLink ble(HOST_BLE_MTU - FT_ATT_OVERHEAD);
+    DeltaEncoder encoder;
+    std::vector<uint8_t> datagram;
+    double buildUs = 0, sinkUs = 0;
+
+    ReplayRecord record;
+    for (;;) {
+        ReplayResult result = replay.poll(record);
+        if (result == REPLAY_END) break;
+        if (result == REPLAY_WAIT) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            continue;
+        }
+
+        Clock::time_point t0 = Clock::now();
+        if (record.format == REPLAY_FORMAT_UBX) {
+            gpsDataFromNavPvt(record.pvt, gps);
+        } else {
+            gpsDataFromPacket(record.packet, gps);
+        }
+        GPSPacket packet;
+        buildPacket(gps, &imu, power, packet);
+        buildUs += elapsedUs(t0);
+
+        t0 = Clock::now();
+        udp.send((const uint8_t*)&packet, sizeof(packet));
+        ble.send((const uint8_t*)&packet, sizeof(packet));
+        uint8_t encoded[DELTA_MAX_RECORD_SIZE];
+        encoder.encode(packet, encoded);
+        while (udp.receive(datagram)) {}
+        while (ble.receive(datagram)) {}
+        sinkUs += elapsedUs(t0);
+        out.push_back(packet);
+    }
+
+    const ReplayStats& rs = replay.getStats();
+    uint32_t samples = rs.samples ? rs.samples : 1;
+    printf("replay %s (%s, speed %u): %u samples in %.1f ms = %u samples/s, max lag %u us\n",
+           path, format == REPLAY_FORMAT_LOG ? "log" : "UBX", speed, rs.samples,
+           (rs.lastUs - rs.startUs) / 1000.0, replay.samplesPerSecond(), rs.maxLagUs);
+    printf("  read %.3f us/sample (max %u us, %u blocks), build %.3f us, sinks %.3f us, decode errors %u\n",
+           (double)rs.totalReadUs / samples, rs.maxReadUs, rs.blocks,
+           buildUs / samples, sinkUs / samples, rs.decodeErrors);
+    return true;
+}
+
+// The board's split: the sink task reads the card into a ring, bounded so it
+// never laps the reader, and ends with a REPLAY_FORMAT_NONE marker; the ingest
+// task paces what it takes off the ring. Interleaved here as alternating ticks.
+static bool replayQueued(HostStorageFile& storage, const char* path, uint16_t speed,
+                         std::vector<GPSPacket>& out, uint32_t& overruns) {
+    static uint8_t buffer[LOG_MAX_BLOCK_SIZE];
+    ReplaySource reader(hostClockUs);
+    ReplayPacer pacer(hostClockUs);
+    TelemetryRing<ReplayRecord> ring;
+    ring.begin(HOST_REPLAY_RING_CAPACITY);
+    int consumer = ring.addConsumer();
+    if (!reader.open(&storage, path, speed, buffer, sizeof(buffer))) return false;
+    pacer.start(speed);
+
+    GPSData gps;
+    IMUData imu;
+    PacketPower power = { 3950, 87, 0x04 };
+    ReplayRecord record, held;
+    bool endQueued = false, holding = false, ended = false;
+    while (!ended) {
+        // Sink task: top the ring up without lapping the ingest cursor
+        while (!endQueued && ring.available(consumer) < HOST_REPLAY_RING_CAPACITY - 1) {
+            if (!reader.read(record)) {
+                record.format = REPLAY_FORMAT_NONE;
+                endQueued = true;
+            }
+            ring.push(record);
+        }
+        // Ingest task: up to a burst of due samples
+        for (int n = 0; n < 32 && !ended; n++) {
+            if (!holding && !ring.read(consumer, held)) break;
+            holding = true;
+            if (held.format == REPLAY_FORMAT_NONE) {
+                ended = true;
+                break;
+            }
+            if (!pacer.release(held)) break;
+            holding = false;
+            if (held.format == REPLAY_FORMAT_UBX) {
+                gpsDataFromNavPvt(held.pvt, gps);
+            } else {
+                gpsDataFromPacket(held.packet, gps);
+            }
+            GPSPacket packet;
+            buildPacket(gps, &imu, power, packet);
+            out.push_back(packet);
+        }
+        if (!ended) std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    overruns = ring.getConsumerStats(consumer).overruns;
+    return true;
+}
+
+// GNSS fields of two packets (the IMU and power fields are the replaying device's own)
+static bool sameFix(const GPSPacket& a, const GPSPacket& b) {
+    return a.timestamp == b.timestamp && a.latitude == b.latitude && a.longitude == b.longitude &&
+           a.altitude == b.altitude && a.speed == b.speed && a.heading == b.heading &&
+           a.fixType == b.fixType && a.satellites == b.satellites;
+}
+
+static bool sameFixes(const std::vector<GPSPacket>& a, const std::vector<GPSPacket>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (!sameFix(a[i], b[i])) return false;
+    }
+    return true;
+}
+
+// Stage 6: replay both recordings as fast as possible, then one paced
+static void checkReplay(HostStorageFile& storage, const std::vector<GPSPacket>& packets) {
+    std::vector<GPSPacket> fromLog, fromCapture, paced;
+    GPSData logGps, captureGps, pacedGps;
+    fromLog.reserve(packets.size());
+    fromCapture.reserve(packets.size());
+
+    check(replayFile(storage, HOST_LOG_PATH, 0, fromLog, logGps) && sameFixes(fromLog, packets),
+          "log replay reproduces every fix");
+    check(replayFile(storage, HOST_CAPTURE_PATH, 0, fromCapture, captureGps) && sameFixes(fromCapture, packets),
+          "UBX replay reproduces every fix");
+    check(logGps.year == captureGps.year && logGps.month == captureGps.month && logGps.day == captureGps.day &&
+          logGps.hour == captureGps.hour && logGps.minute == captureGps.minute &&
+          logGps.second == captureGps.second, "log replay recovers the UTC date and time");
+
+    // Recorded span / speed is the floor; allow the host some scheduling slack on top
+    Clock::time_point t0 = Clock::now();
+    replayFile(storage, HOST_CAPTURE_PATH, HOST_REPLAY_SPEED, paced, pacedGps);
+    double ms = elapsedUs(t0) / 1000.0;
+    double expectedMs = (packets.size() - 1) * (1000.0 / HOST_NAV_RATE_HZ) / HOST_REPLAY_SPEED;
+    check(paced.size() == packets.size() && ms >= expectedMs * 0.99 && ms <= expectedMs + 100.0,
+          "paced replay follows the recorded time line");
+
+    std::vector<GPSPacket> queuedLog, queuedCapture;
+    uint32_t logOverruns = 0, captureOverruns = 0;
+    t0 = Clock::now();
+    bool queued = replayQueued(storage, HOST_LOG_PATH, 0, queuedLog, logOverruns) &&
+                  replayQueued(storage, HOST_CAPTURE_PATH, HOST_REPLAY_SPEED, queuedCapture, captureOverruns);
+    ms = elapsedUs(t0) / 1000.0;
+    check(queued && sameFixes(queuedLog, packets) && sameFixes(queuedCapture, packets) &&
+          logOverruns == 0 && captureOverruns == 0 && ms >= expectedMs * 0.99,
+          "replay read into a ring and paced on the other side reproduces every fix");
+}
+
+// Stage 6b: copy the log's blocks through a file that tears one block write.
+// With a working seek the torn block is skipped and the rest stay on the
+// stride; without one the writer stops and the file still closes cleanly.
+#define HOST_TORN_PATH          "/HOST_TORN.bin"
+#define HOST_TORN_BLOCK         2
+
+class TornWriteFile : public HostStorageFile {
+public:
+    TornWriteFile(const std::string& root, bool seekWorks) :
+        HostStorageFile(root), seekWorks(seekWorks), blockWrites(0), tearing(false) {}
+
+    size_t write(const uint8_t* data, size_t length) override {
+        tearing = length == HOST_BLOCK_SIZE && blockWrites++ == HOST_TORN_BLOCK;
+        return HostStorageFile::write(data, tearing ? length / 2 : length);
+    }
+    bool seek(uint32_t position) override {
+        return (seekWorks || !tearing) && HostStorageFile::seek(position);
+    }
+
+private:
+    bool seekWorks;
+    uint32_t blockWrites;
+    bool tearing;
+};
+
+static void checkTornLog(const std::string& root, HostStorageFile& storage, const std::vector<GPSPacket>& packets) {
+    static uint8_t block[HOST_BLOCK_SIZE];
+    for (int seekWorks = 1; seekWorks >= 0; seekWorks--) {
+        check(storage.open(HOST_LOG_PATH, STORAGE_READ), "log reopened for the torn copy");
+        LogFileHeader header;
+        storage.read((uint8_t*)&header, sizeof(header));
+        uint32_t blocks = (storage.size() - LOG_FILE_HEADER_SIZE) / HOST_BLOCK_SIZE;
+
+        // Which packets survive: every block but the torn one, or only those before it
+        TornWriteFile torn(root, seekWorks != 0);
+        LogWriter writer;
+        writer.open(&torn, HOST_TORN_PATH, header);
+        std::vector<GPSPacket> expected;
+        uint32_t refused = 0;
+        for (uint32_t n = 0; n < blocks; n++) {
+            storage.seek(logBlockOffset(HOST_BLOCK_SIZE, n));
+            if (storage.read(block, HOST_BLOCK_SIZE) != HOST_BLOCK_SIZE || !logCheckBlock(block, HOST_BLOCK_SIZE)) break;
+            const LogBlockHeader* bh = (const LogBlockHeader*)block;
+            if (writer.writeBlock(block, HOST_BLOCK_SIZE, bh->recordCount)) {
+                expected.insert(expected.end(), packets.begin() + bh->firstRecord,
+                                packets.begin() + bh->firstRecord + bh->recordCount);
+            } else {
+                refused++;
+            }
+        }
+        storage.close();
+        bool failed = writer.isFailed();
+        uint32_t written = writer.getBlocks();
+        writer.finish();
+
+        LogRepairResult repair;
+        bool footer = logRepair(storage, HOST_TORN_PATH, block, sizeof(block), repair) && !repair.repaired &&
+                      repair.records == expected.size();
+
+        static uint8_t buffer[LOG_MAX_BLOCK_SIZE];
+        ReplaySource replay(hostClockUs);
+        std::vector<GPSPacket> replayed;
+        ReplayRecord record;
+        if (replay.open(&storage, HOST_TORN_PATH, 0, buffer, sizeof(buffer))) {
+            while (replay.read(record)) replayed.push_back(record.packet);
+        }
+        bool same = sameFixes(replayed, expected);
+
+        if (seekWorks) {
+            check(footer && !failed && refused == 1 && written == blocks - 1 && same &&
+                  replay.getStats().tornBlocks == 1,
+                  "a torn block write keeps the stride - later blocks index and replay");
+
+            // Cut the footer off and let repair walk past the torn block
+            std::vector<uint8_t> bytes;
+            check(storage.open(HOST_TORN_PATH, STORAGE_READ), "torn log reopened");
+            bytes.resize(logBlockOffset(HOST_BLOCK_SIZE, blocks));
+            bool read = storage.read(bytes.data(), bytes.size()) == bytes.size();
+            storage.close();
+            check(read && storage.open(HOST_TORN_PATH, STORAGE_WRITE) &&
+                  storage.write(bytes.data(), bytes.size()) == bytes.size(), "torn log truncated");
+            storage.close();
+            check(logRepair(storage, HOST_TORN_PATH, block, sizeof(block), repair) && repair.repaired &&
+                  repair.blocks == blocks - 1 && repair.records == expected.size(),
+                  "repair skips the torn block and recovers the ones after it");
+        } else {
+            check(footer && failed && refused == blocks - HOST_TORN_BLOCK && written == HOST_TORN_BLOCK && same,
+                  "a torn block write the file cannot seek past stops the writer, the log still closes");
+        }
+    }
+}
+
+// Stage 7: command layer
+static void checkCommands() {
+    struct { CommandChannel channel; const char* text; CommandId id; const char* argument; } cases[] = {
+        { COMMAND_CHANNEL_CONFIG, "START_LOG", CMD_START_LOG, "" },
+        { COMMAND_CHANNEL_CONFIG, "DOWNLOAD:HOST_0001.bin", CMD_DOWNLOAD, "HOST_0001.bin" },
+        { COMMAND_CHANNEL_FILE, "GET:HOST_0001.bin", CMD_DOWNLOAD, "HOST_0001.bin" },
+        { COMMAND_CHANNEL_FILE, "STOP", CMD_CANCEL_TRANSFER, "" },
+        { COMMAND_CHANNEL_FILE, "STATUS", CMD_TRANSFER_STATUS, "" },
+        { COMMAND_CHANNEL_CONFIG, "REPLAY:HOST_0001.ubx:0", CMD_REPLAY, "HOST_0001.ubx:0" },
+        { COMMAND_CHANNEL_CONFIG, "STOP_REPLAY", CMD_STOP_REPLAY, "" },
+        { COMMAND_CHANNEL_CONFIG, "BENCH", CMD_BENCHMARK, "" },
+        { COMMAND_CHANNEL_CONFIG, "BENCH:crc16", CMD_BENCHMARK, "crc16" },
+        { COMMAND_CHANNEL_CONFIG, "BATCH:100", CMD_BLE_BATCH, "100" },
+        { COMMAND_CHANNEL_CONFIG, "UDP_BATCH:1472:50", CMD_UDP_BATCH, "1472:50" },
+        { COMMAND_CHANNEL_CONFIG, "REPORT", CMD_REPORT_POLICY, "" },
+        { COMMAND_CHANNEL_CONFIG, "REPORT:BLE:pos=50,hb=2000", CMD_REPORT_POLICY, "BLE:pos=50,hb=2000" },
+        { COMMAND_CHANNEL_CONFIG, "RATE:BLE:5:AVG", CMD_RATE, "BLE:5:AVG" },
+        { COMMAND_CHANNEL_CONFIG, "CFG", CMD_CONFIG, "" },
+        { COMMAND_CHANNEL_CONFIG, "CFG:nav_hz=10", CMD_CONFIG, "nav_hz=10" },
+        { COMMAND_CHANNEL_CONFIG, "HIST", CMD_HISTOGRAMS, "" },
+        { COMMAND_CHANNEL_CONFIG, "HIST:EXPORT", CMD_HISTOGRAMS, "EXPORT" },
+        { COMMAND_CHANNEL_CONFIG, "STOP", CMD_NONE, "" },
+        { COMMAND_CHANNEL_FILE, "GET:", CMD_NONE, "" },
+    };
+
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        ParsedCommand cmd;
+        bool parsed = parseCommand(cases[i].channel, cases[i].text, strlen(cases[i].text), cmd);
+        if (parsed != (cases[i].id != CMD_NONE) || cmd.id != cases[i].id ||
+            strcmp(cmd.argument, cases[i].argument) != 0) {
+            printf("  command '%s' parsed as %d '%s'\n", cases[i].text, cmd.id, cmd.argument);
+            ok = false;
+        }
+    }
+    check(ok, "command parser");
+
+    ReportPolicyConfig config;
+    bool parsed = reportPolicyParse("pos=50,hdg=0,hb=2000", config);
+    ok = parsed && config.enabled && config.deadband[REPORT_FIELD_POSITION] == 50 &&
+         config.deadband[REPORT_FIELD_HEADING] == 0 && config.heartbeatMs == 2000 &&
+         config.deadband[REPORT_FIELD_SPEED] == REPORT_DEFAULT_SPEED_MMS;
+    ok &= reportPolicyParse("OFF", config) && !config.enabled && config.heartbeatMs == 2000;
+    ok &= !reportPolicyParse("pos=50,bogus=1", config) && !config.enabled &&
+          config.deadband[REPORT_FIELD_POSITION] == 50;
+    ok &= !reportPolicyParse("pos=", config) && !reportPolicyParse("pos=5x", config);
+    check(ok, "report policy settings parser");
+}
+
+// Binary command frames: same commands as the text form, errors answered by
+// status, fields joined into the argument, responses round-trip
+static void checkCommandFrames() {
+    struct { const char* text; const char* fields[3]; int64_t number; } cases[] = {
+        { "START_LOG", { nullptr }, -1 },
+        { "DOWNLOAD:HOST_0001.bin", { "HOST_0001.bin" }, -1 },
+        { "REPLAY:HOST_0001.ubx:0", { "HOST_0001.ubx" }, 0 },
+        { "RATE", { nullptr }, -1 },
+        { "RATE:BLE:5:AVG", { "BLE:5:AVG" }, -1 },
+        { "UDP_BATCH:1472:50", { nullptr }, -1 },        // Two numbers, built below
+        { "CFG:nav_hz=10", { "nav_hz=10" }, -1 },
+        { "HIST:EXPORT", { "EXPORT" }, -1 },
+    };
+    bool same = true;
+    uint8_t requestId = 1;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        ParsedCommand text, binary;
+        parseCommand(COMMAND_CHANNEL_CONFIG, cases[i].text, strlen(cases[i].text), text);
+        CommandFrameBuilder builder;
+        builder.begin(requestId, commandOpcode(text.id));
+        for (int f = 0; f < 3 && cases[i].fields[f]; f++) builder.addText(cases[i].fields[f]);
+        if (cases[i].number >= 0) builder.addUint((uint32_t)cases[i].number);
+        if (text.id == CMD_UDP_BATCH) {
+            builder.addUint(1472);
+            builder.addUint(50);
+        }
+        CommandStatus status = parseCommandFrame(builder.data(), builder.finish(), binary);
+        if (status != CMD_STATUS_OK || binary.id != text.id || binary.requestId != requestId ||
+            strcmp(binary.argument, text.argument) != 0) {
+            printf("  frame for '%s' gave %s %d '%s'\n", cases[i].text, commandStatusName(status), binary.id,
+                   binary.argument);
+            same = false;
+        }
+        requestId++;
+    }
+    check(same, "binary frames decode to the same commands as the text form");
+
+    struct { uint8_t requestId; uint8_t opcode; const char* field; uint32_t number; bool flipCrc; CommandStatus status; }
+    errors[] = {
+        { 1, 0x7F, nullptr, 0, false, CMD_STATUS_UNKNOWN_OPCODE },
+        { 1, 0, nullptr, 0, false, CMD_STATUS_UNKNOWN_OPCODE },
+        { 1, CMD_OP_START_LOG, "now", 0, false, CMD_STATUS_BAD_ARGUMENT },
+        { 1, CMD_OP_DOWNLOAD, nullptr, 0, false, CMD_STATUS_BAD_ARGUMENT },
+        { 0, CMD_OP_START_LOG, nullptr, 0, false, CMD_STATUS_BAD_FRAME },
+        { 1, CMD_OP_START_LOG, nullptr, 0, true, CMD_STATUS_BAD_CRC },
+        { 9, CMD_OP_CONFIG, "0123456789012345678901234567890123456789012345678901234567890123", 0, false,
+          CMD_STATUS_BAD_ARGUMENT },        // 64 characters
+        { 1, CMD_OP_SHOW_SCREEN, nullptr, 4000000000UL, false, CMD_STATUS_OK },
+    };
+    bool statuses = true;
+    for (size_t i = 0; i < sizeof(errors) / sizeof(errors[0]); i++) {
+        CommandFrameBuilder builder;
+        builder.begin(errors[i].requestId, errors[i].opcode);
+        if (errors[i].field) builder.addText(errors[i].field);
+        if (errors[i].number) builder.addUint(errors[i].number);
+        size_t length = builder.finish();
+        uint8_t frame[CMD_FRAME_MAX_SIZE];
+        memcpy(frame, builder.data(), length);
+        if (errors[i].flipCrc) frame[length - 1] ^= 0x40;
+        ParsedCommand cmd;
+        CommandStatus status = parseCommandFrame(frame, length, cmd);
+        bool ok = status == errors[i].status && (status == CMD_STATUS_OK) == (cmd.id != CMD_NONE) &&
+                  cmd.requestId == errors[i].requestId;
+        if (status == CMD_STATUS_OK) ok &= strcmp(cmd.argument, "4000000000") == 0;
+        if (!ok) {
+            printf("  error case %u gave %s, expected %s\n", (unsigned)i, commandStatusName(status),
+                   commandStatusName(errors[i].status));
+            statuses = false;
+        }
+    }
+    uint8_t oddField[] = { CMD_FRAME_REQUEST, 1, CMD_OP_SHOW_SCREEN, 5, CMD_TLV_UINT, 3, 1, 2, 3, 0, 0 };
+    uint16_t crc = crc16(oddField, 9);
+    oddField[9] = (uint8_t)crc;
+    oddField[10] = (uint8_t)(crc >> 8);
+    ParsedCommand cmd;
+    statuses &= parseCommandFrame(oddField, sizeof(oddField), cmd) == CMD_STATUS_BAD_ARGUMENT;
+    check(statuses, "bad frames are answered with the matching status");
+
+    ParsedCommand rate = { CMD_RATE, "", 1 }, rateSet = { CMD_RATE, "BLE:5", 1 }, start = { CMD_START_LOG, "", 1 };
+    ParsedCommand config = { CMD_CONFIG, "nav_hz=10", 1 };
+    bool replies = commandHasReply(rate) && !commandHasReply(rateSet) && !commandHasReply(start) &&
+                   commandHasReply(config);
+
+    char text[300];
+    for (size_t i = 0; i < sizeof(text); i++) text[i] = (char)('a' + i % 26);
+    uint8_t response[CMD_RESPONSE_MAX_SIZE];
+    size_t length = encodeCommandResponse(42, CMD_OP_CONFIG, CMD_STATUS_FAILED, CMD_RESPONSE_FLAG_MORE,
+                                          (const uint8_t*)text, sizeof(text), response);
+    CommandResponseHeader header;
+    const uint8_t* payload = nullptr;
+    replies &= length == CMD_RESPONSE_MAX_SIZE && parseCommandResponse(response, length, header, payload) &&
+               header.requestId == 42 && header.opcode == CMD_OP_CONFIG && header.status == CMD_STATUS_FAILED &&
+               header.flags == CMD_RESPONSE_FLAG_MORE && header.length == CMD_RESPONSE_MAX_PAYLOAD &&
+               memcmp(payload, text, CMD_RESPONSE_MAX_PAYLOAD) == 0;
+    length = encodeCommandResponse(7, CMD_OP_START_LOG, CMD_STATUS_OK, 0, nullptr, 0, response);
+    replies &= parseCommandResponse(response, length, header, payload) && header.length == 0;
+    response[1] ^= 1;
+    replies &= !parseCommandResponse(response, length, header, payload) &&
+               !parseCommandResponse(response, length - 1, header, payload);
+    check(replies, "reply routing per command and response frames round-trip");
+}
+
+// Random bytes, random text and mutated valid frames through both parsers.
+// Returns the number of inputs that broke an invariant.
+static uint32_t fuzzCommandParsers(uint32_t iterations, uint32_t seed, uint32_t* accepted) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ_:=0123456789.abcxyz";
+    static const char* keywords[] = { "", "RATE", "RATE:", "CFG:", "STOP", "GET:", "DOWNLOAD:", "SCREEN:" };
+    uint32_t state = seed ? seed : 1;
+    uint32_t violations = 0;
+    accepted[0] = accepted[1] = 0;
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        state = state * 1664525UL + 1013904223UL;
+        uint8_t input[CMD_FRAME_MAX_SIZE + 8];
+        size_t length = (state >> 8) % sizeof(input);
+        int mode = (state >> 24) % 5;
+
+        if (mode == 0) {
+            // Raw bytes, half of them dressed as a request header
+            for (size_t b = 0; b < length; b++) {
+                state = state * 1664525UL + 1013904223UL;
+                input[b] = (uint8_t)(state >> 16);
+            }
+            if (length > 0 && (state & 1)) input[0] = CMD_FRAME_REQUEST;
+        } else if (mode == 1) {
+            // A keyword, or part of one, and a tail from the command alphabet
+            const char* keyword = keywords[(state >> 4) % (sizeof(keywords) / sizeof(keywords[0]))];
+            size_t keywordLength = strlen(keyword);
+            if (length < keywordLength) keywordLength = length;
+            memcpy(input, keyword, keywordLength);
+            if (state & 0x10000) length = keywordLength + (state >> 17) % 8;
+            for (size_t b = keywordLength; b < length; b++) {
+                state = state * 1664525UL + 1013904223UL;
+                input[b] = (uint8_t)alphabet[(state >> 16) % (sizeof(alphabet) - 1)];
+            }
+        } else {
+            // Valid frame, then one bit flipped (mode 2), cut short (mode 3) or as built
+            CommandFrameBuilder builder;
+            builder.begin((uint8_t)(1 + (state >> 4) % 255), (uint8_t)(1 + (state >> 12) % (CMD_OP_COUNT - 1)));
+            int fields = (state >> 20) % 4;
+            for (int f = 0; f < fields; f++) {
+                state = state * 1664525UL + 1013904223UL;
+                if (state & 1) {
+                    builder.addUint(state >> (state % 24));
+                } else {
+                    char text[24];
+                    size_t textLength = 1 + (state >> 8) % (sizeof(text) - 1);
+                    for (size_t b = 0; b < textLength; b++) text[b] = alphabet[(state >> b) % (sizeof(alphabet) - 1)];
+                    text[textLength] = '\0';
+                    builder.addText(text);
+                }
+            }
+            size_t frameLength = builder.finish();
+            memcpy(input, builder.data(), frameLength);
+            if (mode == 2) {
+                size_t bit = (state >> 3) % (frameLength * 8);
+                input[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+                length = frameLength;
+            } else if (mode == 3) {
+                length = frameLength > 0 ? (state >> 5) % frameLength : 0;
+            } else {
+                length = frameLength;
+            }
+        }
+
+        ParsedCommand cmd;
+        CommandStatus status = parseCommandFrame(input, length, cmd);
+        bool bounded = memchr(cmd.argument, '\0', sizeof(cmd.argument)) != nullptr;
+        bool broken = !bounded || (status == CMD_STATUS_OK) != (cmd.id != CMD_NONE) ||
+                      (status == CMD_STATUS_OK && (cmd.requestId == 0 || mode == 2 || mode == 3)) ||  // CRC catches every mutation
+                      (mode == 4 && status != CMD_STATUS_OK && status != CMD_STATUS_BAD_ARGUMENT);
+        if (status == CMD_STATUS_OK) accepted[0]++;
+
+        bool parsed = parseCommand(COMMAND_CHANNEL_CONFIG, (const char*)input, length, cmd) ||
+                      parseCommand(COMMAND_CHANNEL_FILE, (const char*)input, length, cmd);
+        bounded = memchr(cmd.argument, '\0', sizeof(cmd.argument)) != nullptr;
+        broken |= !bounded || parsed != (cmd.id != CMD_NONE) || (parsed && cmd.requestId != 0);
+        if (parsed) accepted[1]++;
+        if (broken) violations++;
+    }
+    return violations;
+}
+
+static int runFuzz(uint32_t iterations, uint32_t seed) {
+    uint32_t accepted[2];
+    Clock::time_point start = Clock::now();
+    uint32_t violations = fuzzCommandParsers(iterations, seed, accepted);
+    double us = elapsedUs(start);
+    printf("command fuzz: %lu inputs (seed %lu), %lu frames and %lu text commands accepted, %lu violations, "
+           "%.0f ns/input\n", (unsigned long)iterations, (unsigned long)seed, (unsigned long)accepted[0],
+           (unsigned long)accepted[1], (unsigned long)violations, iterations ? us * 1000.0 / iterations : 0.0);
+    return violations ? 1 : 0;
+}
+
+// Stage 8: latency histograms - bucket bounds, percentiles, windows, export
+static void checkHistograms() {
+    bool bucketsOk = true;
+    for (uint32_t v = 0; v <= LATENCY_MAX_US; v += 1 + v / 97) {
+        uint16_t index = LatencyHistogram::bucketIndex(v);
+        uint32_t low = LatencyHistogram::bucketLow(index);
+        uint32_t high = LatencyHistogram::bucketHigh(index);
+        if (index >= LATENCY_BUCKET_COUNT || v < low || v > high ||
+            (uint64_t)(high - low) * LATENCY_SUB_BUCKETS > low) {
+            printf("  value %lu -> bucket %u [%lu, %lu]\n", (unsigned long)v, index,
+                   (unsigned long)low, (unsigned long)high);
+            bucketsOk = false;
+            break;
+        }
+    }
+    check(bucketsOk, "histogram buckets cover the range within 1/128");
+
+    // 40 ms epochs with 1 ms of jitter and a few late ones
+    WindowedHistogram epochs;
+    for (uint32_t i = 0; i < 10000; i++) {
+        epochs.record(39500 + (i * 7919) % 1000);
+    }
+    epochs.rotate();
+    for (uint32_t i = 0; i < 1000; i++) {
+        epochs.record(i < 990 ? 40000 : 80000 + i);
+    }
+    epochs.rotate();
+    const LatencyHistogram& window = epochs.getWindow();
+    const LatencyHistogram& lifetime = epochs.getLifetime();
+    uint32_t p50 = lifetime.valueAtPercentile(50.0f);
+    check(window.getCount() == 1000 && lifetime.getCount() == 11000, "histogram windows fold into lifetime");
+    check(p50 >= 39500 && p50 <= 40500 + 40500 / LATENCY_SUB_BUCKETS, "histogram p50 within one bucket");
+    check(window.valueAtPercentile(99.9f) == window.getMax() && window.getMax() == 80999 &&
+          window.countAbove(EPOCH_BUDGET_HOST_US) == 10, "histogram tail and budget count");
+
+    char line[LATENCY_LINE_SIZE];
+    latencyFormat(lifetime, line, sizeof(line), false);
+    printf("  epoch interval: %s over 40ms:%lu\n", line, (unsigned long)lifetime.countAbove(EPOCH_BUDGET_HOST_US));
+
+    static uint8_t exported[LATENCY_EXPORT_MAX_SIZE];
+    size_t length = lifetime.exportTo("epoch_interval", exported, sizeof(exported));
+    LatencyHistogram imported;
+    char name[LATENCY_NAME_MAX + 1];
+    bool roundTrip = length > 0 && imported.importFrom(exported, length, name, sizeof(name)) == length &&
+                     strcmp(name, "epoch_interval") == 0 && imported.getCount() == lifetime.getCount() &&
+                     imported.getMax() == lifetime.getMax() && imported.getMin() == lifetime.getMin();
+    for (float p = 0.0f; roundTrip && p <= 100.0f; p += 0.5f) {
+        roundTrip = imported.valueAtPercentile(p) == lifetime.valueAtPercentile(p);
+    }
+    printf("  export: %lu bytes for %lu samples\n", (unsigned long)length, (unsigned long)lifetime.getCount());
+    check(roundTrip, "histogram binary export round trip");
+}
+
+// Telemetry bus: a producer lapping a slow consumer, consumers at different
+// speeds, readLatest and trim, then a reader racing the producer on another
+// thread. The reader sleeps halfway through every other copy, so the producer
+// overwrites slots underneath it and the stamp re-check has to catch them.
+#define RING_PROBE_WORDS    255
+#define RING_RACE_MS        200
+
+struct RingProbe {
+    uint32_t sequence;
+    uint32_t words[RING_PROBE_WORDS];
+    static thread_local bool pauseMidCopy;
+    static thread_local uint32_t copies;
+
+    RingProbe() : sequence(0) { memset(words, 0, sizeof(words)); }
+    RingProbe& operator=(const RingProbe& other) {
+        const int half = RING_PROBE_WORDS / 2;
+        sequence = other.sequence;
+        memcpy(words, other.words, half * sizeof(words[0]));
+        if (pauseMidCopy && (++copies & 1)) std::this_thread::sleep_for(std::chrono::microseconds(1));
+        memcpy(words + half, other.words + half, (RING_PROBE_WORDS - half) * sizeof(words[0]));
+        return *this;
+    }
+
+    void fill(uint32_t n) {
+        sequence = n;
+        for (int i = 0; i < RING_PROBE_WORDS; i++) words[i] = n * 2654435761u + i;
+    }
+    bool intact() const {
+        for (int i = 0; i < RING_PROBE_WORDS; i++) {
+            if (words[i] != sequence * 2654435761u + i) return false;
+        }
+        return true;
+    }
+};
+
+thread_local bool RingProbe::pauseMidCopy = false;
+thread_local uint32_t RingProbe::copies = 0;
+
+static void checkTelemetryRing() {
+    const uint32_t capacity = 16;
+    TelemetryRing<RingProbe> ring;
+    ring.begin(capacity);
+    static RingProbe probe;
+
+    // Lap: 40 pushes past a consumer that never read
+    int lagging = ring.addConsumer();
+    for (uint32_t n = 0; n < 40; n++) {
+        probe.fill(n);
+        ring.push(probe);
+    }
+    bool lapped = ring.available(lagging) == capacity && ring.read(lagging, probe) &&
+                  probe.sequence == 40 - capacity && ring.getConsumerStats(lagging).overruns == 40 - capacity;
+    uint32_t expected = probe.sequence + 1;
+    while (ring.read(lagging, probe)) lapped &= probe.intact() && probe.sequence == expected++;
+    lapped &= expected == 40 && ring.getConsumerStats(lagging).reads == capacity;
+    check(lapped, "ring counts a lapped consumer's losses and resumes at the oldest kept sample");
+
+    // Fast, medium and slow consumers on the same bus
+    int ids[3];
+    for (int c = 0; c < 3; c++) ids[c] = ring.addConsumer();
+    const uint32_t start = ring.getTotalPushed(), pushes = 1000;
+    uint32_t next[3] = { start, start, start };
+    bool ordered = true;
+    for (uint32_t n = start; n < start + pushes; n++) {
+        probe.fill(n);
+        ring.push(probe);
+        for (int c = 0; c < 3; c++) {
+            uint32_t budget = c == 0 ? capacity : c == 1 ? (n % 4 == 0 ? capacity : 0) : (n % 40 == 0 ? 3 : 0);
+            static RingProbe out;
+            for (uint32_t r = 0; r < budget && ring.read(ids[c], out); r++) {
+                ordered &= out.intact() && out.sequence >= next[c];
+                next[c] = out.sequence + 1;
+            }
+        }
+    }
+    bool accounted = true;
+    for (int c = 0; c < 3; c++) {
+        static RingProbe out;
+        while (ring.read(ids[c], out)) next[c] = out.sequence + 1;
+        const TelemetryRing<RingProbe>::ConsumerStats& s = ring.getConsumerStats(ids[c]);
+        accounted &= next[c] == start + pushes && s.reads + s.overruns == pushes;
+    }
+    check(ordered && accounted && ring.getConsumerStats(ids[0]).overruns == 0 &&
+          ring.getConsumerStats(ids[1]).overruns == 0 && ring.getConsumerStats(ids[2]).overruns > 0,
+          "ring consumers advance independently, only the slow one loses samples");
+
+    // readLatest skips without counting, trim drops oldest-first and counts
+    int latest = ring.addConsumer();
+    uint32_t base = ring.getTotalPushed();
+    for (uint32_t n = base; n < base + 10; n++) {
+        probe.fill(n);
+        ring.push(probe);
+    }
+    bool skipped = ring.readLatest(latest, probe) && probe.sequence == base + 9 &&
+                   ring.getConsumerStats(latest).overruns == 0 && !ring.readLatest(latest, probe) &&
+                   !ring.read(latest, probe);
+    check(skipped, "ring readLatest returns the newest sample without counting overruns");
+
+    int trimmed = ring.addConsumer();
+    base = ring.getTotalPushed();
+    for (uint32_t n = base; n < base + 10; n++) {
+        probe.fill(n);
+        ring.push(probe);
+    }
+    bool bounded = ring.trim(trimmed, 3) == 7 && ring.getConsumerStats(trimmed).overruns == 7 &&
+                   ring.trim(trimmed, 3) == 0 && ring.available(trimmed) == 3 &&
+                   ring.read(trimmed, probe) && probe.sequence == base + 7;
+    check(bounded, "ring trim keeps the newest samples and counts the dropped ones");
+
+    // Racing reader: the smallest ring and a producer that never waits
+    TelemetryRing<RingProbe> raced;
+    raced.begin(2);
+    int reader = raced.addConsumer();
+    std::atomic<bool> stop(false);
+    uint32_t racePushes = 0;
+    std::thread producer([&]() {
+        static RingProbe p;
+        for (; !stop.load(std::memory_order_relaxed); racePushes++) {
+            p.fill(racePushes);
+            raced.push(p);
+        }
+    });
+    uint32_t torn = 0, backwards = 0, last = 0;
+    bool first = true;
+    static RingProbe out;
+    RingProbe::pauseMidCopy = true;
+    Clock::time_point raceStart = Clock::now();
+    for (bool finished = false; !finished; ) {
+        finished = stop.load();
+        if (!finished && elapsedUs(raceStart) > RING_RACE_MS * 1000.0) {
+            stop.store(true);
+            producer.join();
+            finished = true;
+        }
+        while (raced.read(reader, out)) {
+            torn += !out.intact();
+            backwards += !first && out.sequence <= last;
+            last = out.sequence;
+            first = false;
+        }
+        std::this_thread::yield();
+    }
+    RingProbe::pauseMidCopy = false;
+    const TelemetryRing<RingProbe>::ConsumerStats& s = raced.getConsumerStats(reader);
+    printf("ring race: %u pushes, %u read, %u lost, %u of them overwritten mid-copy\n",
+           racePushes, s.reads, s.overruns, s.torn);
+    check(torn == 0 && backwards == 0 && last == racePushes - 1 && s.reads + s.overruns == racePushes &&
+          s.torn > 0,
+          "ring reader racing the producer never returns a torn or stale sample");
+}
+
+// Stage 9: batched telemetry notifications against per-sample ones, on a simulated
+// 5 ms sink-task tick with samples arriving at `rateHz`
+static void runBatching(const std::vector<GPSPacket>& packets, uint32_t rateHz, uint32_t lossPercent) {
+    LoopbackLink link(HOST_BLE_MTU - FT_ATT_OVERHEAD, lossPercent, 11);
+    TelemetryBatcher batcher;
+    TelemetryBatchReceiver receiver;
+    batcher.setMaxLatency(HOST_BATCH_LATENCY_US);
+
+    const uint32_t tickUs = 5000;
+    const uint32_t sampleUs = 1000000 / rateHz;
+    uint32_t nowUs = 0, nextSampleUs = 0;
+    bool intact = true;
+    uint32_t lastEnd = 0;   // One past the last sample received; a lost final frame is invisible
+    std::vector<uint8_t> datagram;
+    for (uint32_t i = 0; i < packets.size() || batcher.pending(); nowUs += tickUs) {
+        for (; i < packets.size() && nextSampleUs <= nowUs; i++, nextSampleUs += sampleUs) {
+            batcher.add(link, packets[i], i, nextSampleUs, nowUs);
+        }
+        batcher.poll(link, nowUs);
+        if (i == packets.size()) batcher.flush(link, nowUs);
+
+        while (link.receive(datagram)) {
+            TelemetryBatchHeader header;
+            const GPSPacket* received;
+            int count = receiver.onFrame(datagram.data(), datagram.size(), header, &received);
+            for (int n = 0; n < count; n++) {
+                intact &= header.firstSample + n < packets.size() &&
+                          memcmp(&received[n], &packets[header.firstSample + n], sizeof(GPSPacket)) == 0;
+            }
+            if (count > 0) lastEnd = header.firstSample + count;
+        }
+    }
+
+    const TelemetryBatchStats& s = batcher.getStats();
+    uint32_t total = (uint32_t)packets.size();
+    printf("batch %u Hz: %u samples in %u notifications instead of %u (%.1f/frame, %u full, %u deadline), "
+           "%.1f notifications/s, hold avg %.1f ms max %.1f ms, %u lost frames / %u samples\n",
+           rateHz, s.samples, s.frames, total, (double)s.samples / s.frames, s.fullFrames, s.deadlineFrames,
+           s.frames * 1e6 / nowUs, s.totalHoldUs / 1000.0 / s.frames, s.maxHoldUs / 1000.0,
+           receiver.getLostFrames(), receiver.getLostSamples());
+
+    char what[64];
+    snprintf(what, sizeof(what), "batched telemetry at %u Hz arrives intact", rateHz);
+    check(intact && receiver.getInvalid() == 0 && s.samples == total, what);
+    snprintf(what, sizeof(what), "batch gaps at %u Hz match the link losses", rateHz);
+    check((receiver.getLostFrames() == link.getLost() || (lastEnd < total && receiver.getLostFrames() < link.getLost())) &&
+          receiver.getSamples() + receiver.getLostSamples() == lastEnd &&
+          s.maxHoldUs <= HOST_BATCH_LATENCY_US + tickUs, what);
+}
+
+// Drain the UDP sink's bus cursor into the batcher, as the UDP task does
+static void drainUdpCursor(TelemetryRing<GPSPacket>& ring, int consumer, TelemetryBatcher& batcher,
+                           UdpSocketLink& link) {
+    uint32_t sequence = ring.getTotalPushed() - ring.available(consumer);
+    GPSPacket packet;
+    while (ring.read(consumer, packet)) {
+        batcher.add(link, packet, sequence++, 0, (uint32_t)hostClockUs());
+    }
+}
+
+static void collectUdp(UdpReceiver& receiver, TelemetryBatchReceiver& client,
+                       const std::vector<GPSPacket>& packets, bool& intact, uint32_t& firstSample) {
+    std::vector<uint8_t> datagram;
+    while (receiver.receive(datagram)) {
+        TelemetryBatchHeader header;
+        const GPSPacket* received;
+        int count = client.onFrame(datagram.data(), datagram.size(), header, &received);
+        if (client.getFrames() == 1) firstSample = header.firstSample;
+        for (int n = 0; n < count; n++) {
+            intact &= header.firstSample + n < packets.size() &&
+                      memcmp(&received[n], &packets[header.firstSample + n], sizeof(GPSPacket)) == 0;
+        }
+    }
+}
+
+// Stage 10: the UDP sink against a local receiver over real sockets - bus cursor,
+// batcher and datagram sizes as on the board, first flowing, then stalled
+static void runUdp(const std::vector<GPSPacket>& packets) {
+    const uint32_t total = (uint32_t)packets.size();
+    const uint16_t datagramSizes[] = { 512, 1472 };     // UDP_BATCH_DEFAULT_BYTES, UDP_MAX_DATAGRAM
+
+    for (size_t d = 0; d < sizeof(datagramSizes) / sizeof(datagramSizes[0]); d++) {
+        UdpReceiver receiver;
+        UdpSocketLink link;
+        if (!receiver.open(0) || !link.open("127.0.0.1", receiver.getPort())) {
+            check(false, "UDP sockets opened");
+            return;
+        }
+        TelemetryRing<GPSPacket> ring;
+        ring.begin(HOST_RING_CAPACITY);
+        int consumer = ring.addConsumer();
+        TelemetryBatcher batcher;
+        batcher.setMaxFrame(datagramSizes[d]);
+        batcher.setMaxLatency(100000);
+        TelemetryBatchReceiver client;
+        bool intact = true;
+        uint32_t firstSample = 0;
+
+        Clock::time_point t0 = Clock::now();
+        for (uint32_t i = 0; i < total; i++) {
+            ring.push(packets[i]);
+            drainUdpCursor(ring, consumer, batcher, link);
+            collectUdp(receiver, client, packets, intact, firstSample);
+        }
+        batcher.flush(link, (uint32_t)hostClockUs());
+        collectUdp(receiver, client, packets, intact, firstSample);
+        double seconds = elapsedUs(t0) / 1e6;
+
+        const TelemetryBatchStats& s = batcher.getStats();
+        uint32_t lost = total - client.getSamples();
+        printf("udp %u B: %u samples in %u datagrams (%.1f/datagram), %.0f datagrams/s, %.0f samples/s, "
+               "loss %u (%.2f%%), send failures %u\n",
+               datagramSizes[d], client.getSamples(), client.getFrames(), (double)s.samples / s.frames,
+               s.frames / seconds, client.getSamples() / seconds, lost, 100.0 * lost / total, s.sendFailures);
+        char what[64];
+        snprintf(what, sizeof(what), "UDP %u-byte datagrams arrive intact", datagramSizes[d]);
+        check(intact && client.getInvalid() == 0 && lost == client.getLostSamples() + s.samplesLost, what);
+    }
+
+    // Stalled link: the whole run lands on the bus before the UDP task gets to
+    // run again. The ring laps, the backlog bound drops the oldest, the newest go out.
+    UdpReceiver receiver;
+    UdpSocketLink link;
+    receiver.open(0);
+    link.open("127.0.0.1", receiver.getPort());
+    TelemetryRing<GPSPacket> ring;
+    ring.begin(HOST_RING_CAPACITY);
+    int consumer = ring.addConsumer();
+    for (uint32_t i = 0; i < total; i++) {
+        ring.push(packets[i]);
+    }
+    ring.trim(consumer, HOST_UDP_BACKLOG);
+    TelemetryBatcher batcher;
+    batcher.setMaxFrame(512);
+    batcher.setMaxLatency(100000);
+    drainUdpCursor(ring, consumer, batcher, link);
+    batcher.flush(link, (uint32_t)hostClockUs());
+    TelemetryBatchReceiver client;
+    bool intact = true;
+    uint32_t firstSample = 0;
+    collectUdp(receiver, client, packets, intact, firstSample);
+
+    uint32_t kept = total < HOST_UDP_BACKLOG ? total : HOST_UDP_BACKLOG;
+    printf("udp stalled: %u of %u samples sent from sample %u, %u dropped oldest-first\n",
+           client.getSamples(), total, firstSample, ring.getConsumerStats(consumer).overruns);
+    check(intact && client.getSamples() == kept && firstSample == total - kept &&
+          ring.getConsumerStats(consumer).overruns == total - kept, "UDP backlog drops the oldest samples");
+}
+
+static void printBenchResult(const BenchRunner& runner, const BenchResult& result) {
+    char line[BENCH_LINE_SIZE];
+    benchFormatResult(runner, result, line, sizeof(line));
+    printf("%s\n", line);
+}
+
+// Replayed drive plus a parked tail: GNSS jitter, IMU noise, a 5 s fix drop
+// and a battery step. The client holds the last sample it received; every
+// sample of the track is compared against what it would show.
+static void runPolicy(HostStorageFile& storage) {
+    std::vector<GPSPacket> track;
+    GPSData gps;
+    if (!replayFile(storage, HOST_CAPTURE_PATH, 0, track, gps) || track.empty()) {
+        check(false, "report policy replay");
+        return;
+    }
+    const uint32_t driveLength = (uint32_t)track.size();
+    const uint32_t parkedLength = HOST_PARKED_SECONDS * HOST_NAV_RATE_HZ;
+    uint32_t rng = 7;
+    GPSPacket parked = track.back();
+    parked.speed = 0;
+    for (uint32_t i = 0; i < parkedLength; i++) {
+        GPSPacket p = parked;
+        p.timestamp += i / HOST_NAV_RATE_HZ + 1;
+        p.latitude += (int32_t)((rng = rng * 1103515245 + 12345) >> 16) % 45 - 22;     // +-25 cm
+        p.longitude += (int32_t)((rng = rng * 1103515245 + 12345) >> 16) % 71 - 35;
+        p.altitude += (int32_t)((rng = rng * 1103515245 + 12345) >> 16) % 601 - 300;
+        p.heading = ((rng = rng * 1103515245 + 12345) >> 8) % 36000000;                 // Meaningless at rest
+        p.accel_x = (int16_t)(((rng = rng * 1103515245 + 12345) >> 16) % 61) - 30;
+        p.accel_z = 1000 + (int16_t)(((rng = rng * 1103515245 + 12345) >> 16) % 61) - 30;
+        p.gyro_x = (int16_t)(((rng = rng * 1103515245 + 12345) >> 16) % 601) - 300;
+        p.satellites = parked.satellites - 1 + ((rng = rng * 1103515245 + 12345) >> 16) % 3;
+        if (i >= parkedLength / 2 && i < parkedLength / 2 + 5 * HOST_NAV_RATE_HZ) p.fixType = 2;
+        if (i >= parkedLength * 3 / 4) p.battery_pct = parked.battery_pct - 1;
+        track.push_back(p);
+    }
+
+    ReportPolicy policy;
+    ReportPolicyConfig config;
+    config.enabled = true;
+    policy.configure(config);
+    LoopbackLink link(HOST_BLE_MTU - FT_ATT_OVERHEAD);
+    TelemetryBatcher batcher;
+    TelemetryBatchReceiver receiver;
+    batcher.setMaxLatency(HOST_BATCH_LATENCY_US);
+    batcher.setSparse(true);
+
+    std::vector<bool> received(track.size(), false);    // Indexed by bus sequence
+    uint32_t lastReceived = 0;
+    const uint32_t sampleUs = 1000000 / HOST_NAV_RATE_HZ;
+    bool intact = true;
+    std::vector<uint8_t> datagram;
+    for (uint32_t i = 0; i <= track.size(); i++) {
+        uint32_t nowUs = i * sampleUs;
+        if (i == track.size()) {
+            batcher.flush(link, nowUs);
+        } else if (policy.offer(track[i], nowUs / 1000)) {
+            batcher.add(link, track[i], i, nowUs, nowUs);
+        } else {
+            batcher.poll(link, nowUs);
+        }
+        while (link.receive(datagram)) {
+            TelemetryBatchHeader header;
+            const GPSPacket* packets;
+            int count = receiver.onFrame(datagram.data(), datagram.size(), header, &packets);
+            for (int n = 0; n < count; n++) {
+                uint32_t sequence = receiver.getSequence(n);
+                intact &= sequence < track.size() && memcmp(&packets[n], &track[sequence], sizeof(GPSPacket)) == 0;
+                if (sequence < track.size()) received[sequence] = true;
+                lastReceived = sequence;
+            }
+        }
+    }
+
+    // Zero-order hold on the client against the true track
+    uint32_t maxError[REPORT_FIELD_COUNT] = { 0 };
+    uint32_t driveSent = 0, parkedSent = 0, maxHoldMs = 0;
+    bool bounded = received[0], stateHeld = true;
+    uint32_t shown = 0;
+    for (uint32_t i = 0; i < track.size(); i++) {
+        if (received[i]) {
+            shown = i;
+            (i < driveLength ? driveSent : parkedSent)++;
+        }
+        const GPSPacket& held = track[shown];
+        const GPSPacket& truth = track[i];
+        for (int f = 0; f < REPORT_FIELD_COUNT; f++) {
+            if (f == REPORT_FIELD_HEADING && truth.speed < REPORT_HEADING_MIN_SPEED_MMS) continue;
+            uint32_t error = ReportPolicy::deviation((ReportField)f, held, truth);
+            if (error > maxError[f]) maxError[f] = error;
+            bounded &= error < config.deadband[f];
+        }
+        stateHeld &= held.fixType == truth.fixType && held.pmu_status == truth.pmu_status &&
+                     held.battery_pct == truth.battery_pct;
+        uint32_t holdMs = (i - shown) * sampleUs / 1000;
+        if (holdMs > maxHoldMs) maxHoldMs = holdMs;
+    }
+
+    const ReportPolicyStats& s = policy.getStats();
+    const TelemetryBatchStats& b = batcher.getStats();
+    char line[REPORT_STATS_LINE_SIZE];
+    reportPolicyFormat(policy, line, sizeof(line), false);
+    printf("report policy: %s\n", line);
+    printf("  drive %u/%u samples (%.1fx), parked %u/%u (%.1fx), %u notifications instead of %u, "
+           "client error pos %u cm spd %u mm/s hdg %u cdeg acc %u mg, held max %u ms\n",
+           driveSent, driveLength, (double)driveLength / (driveSent ? driveSent : 1),
+           parkedSent, parkedLength, (double)parkedLength / (parkedSent ? parkedSent : 1),
+           b.frames, (uint32_t)track.size(), maxError[REPORT_FIELD_POSITION], maxError[REPORT_FIELD_SPEED],
+           maxError[REPORT_FIELD_HEADING], maxError[REPORT_FIELD_ACCEL], maxHoldMs);
+
+    check(intact && receiver.getInvalid() == 0 && receiver.getLostFrames() == 0 &&
+          receiver.getSamples() == s.sent && driveSent + parkedSent == s.sent &&
+          receiver.getSamples() + receiver.getSkippedSamples() == lastReceived + 1,
+          "dead-band telemetry arrives intact as sparse frames");
+    check(bounded && stateHeld && maxHoldMs < config.heartbeatMs,
+          "client error stays inside the dead-bands, state changes and heartbeats always sent");
+    bool statsMatch = true;
+    for (int f = 0; f < REPORT_FIELD_COUNT; f++) statsMatch &= s.maxError[f] == maxError[f];
+    check(statsMatch && s.stateChanges >= 3 && parkedSent * 10 <= parkedLength,
+          "report policy stats match the replay and a parked logger drops to the heartbeat");
+
+    // REPORT:... from another task while the sink takes configs between samples:
+    // every field of the k-th published config is k, so a torn copy shows
+    StagedReportPolicy staged;
+    ReportPolicyConfig taken;
+    bool handOff = !staged.take(taken);
+    ReportPolicyConfig edited = staged.staged();
+    edited.enabled = true;
+    staged.publish(edited);
+    handOff &= staged.take(taken) && taken.enabled && !staged.take(taken) && staged.generation() == 1;
+
+    std::atomic<bool> stop(false);
+    uint32_t published = 0;
+    std::thread writer([&]() {
+        ReportPolicyConfig c;
+        while (!stop.load(std::memory_order_relaxed)) {
+            published++;
+            c.enabled = (published & 1) != 0;
+            for (int f = 0; f < REPORT_FIELD_COUNT; f++) c.deadband[f] = published;
+            c.heartbeatMs = published;
+            staged.publish(c);
+        }
+    });
+    uint32_t takes = 0, mixed = 0, backwards = 0, lastTaken = 0;
+    Clock::time_point raceStart = Clock::now();
+    for (bool finished = false; !finished; ) {
+        if (elapsedUs(raceStart) > RING_RACE_MS * 1000.0) {
+            stop.store(true);
+            writer.join();
+            finished = true;
+        }
+        if (!staged.take(taken)) continue;
+        takes++;
+        bool consistent = taken.enabled == ((taken.heartbeatMs & 1) != 0);
+        for (int f = 0; f < REPORT_FIELD_COUNT; f++) consistent &= taken.deadband[f] == taken.heartbeatMs;
+        mixed += !consistent;
+        backwards += taken.heartbeatMs <= lastTaken;
+        lastTaken = taken.heartbeatMs;
+    }
+    printf("staged report policy: %u published, %u taken between samples\n", published, takes);
+    check(handOff && mixed == 0 && backwards == 0 && takes > 0 && lastTaken == published,
+          "sinks take staged report policies whole, newest last");
+}
+
+// The fan-out at the default rates (SD 25, BLE 10, UDP 5, UI 15 Hz) on a
+// jittered 25 Hz bus: output rates, every output the mean of its window,
+// a rate change mid-run, the circular heading mean and a gap resync.
+static void runRateControl(const std::vector<GPSPacket>& packets) {
+    struct Consumer { const char* name; uint16_t hz; RateFilter filter; RateDecimator decimator; uint32_t out; };
+    Consumer consumers[] = {
+        { "sd", 25, RATE_FILTER_AVERAGE, RateDecimator(), 0 },
+        { "ble", 10, RATE_FILTER_AVERAGE, RateDecimator(), 0 },
+        { "udp", 5, RATE_FILTER_AVERAGE, RateDecimator(), 0 },
+        { "ui", 15, RATE_FILTER_LATEST, RateDecimator(), 0 },
+    };
+    const int count = sizeof(consumers) / sizeof(consumers[0]);
+    for (int c = 0; c < count; c++) {
+        consumers[c].decimator.configure(consumers[c].hz, consumers[c].filter, HOST_NAV_RATE_HZ);
+    }
+
+    const uint32_t half = (uint32_t)packets.size() / 2;
+    const uint32_t sampleUs = 1000000 / HOST_NAV_RATE_HZ;
+    uint32_t rng = 3, windowStart[4] = { 0 };
+    uint32_t secondHalfOut = 0;
+    bool means = true, crcs = true, raw = true;
+    double filterNs = 0;
+    for (uint32_t i = 0; i < packets.size(); i++) {
+        if (i == half) consumers[1].decimator.configure(5, RATE_FILTER_AVERAGE, HOST_NAV_RATE_HZ);   // RATE:BLE:5 mid-run
+        rng = rng * 1103515245 + 12345;
+        int64_t timeUs = (int64_t)i * sampleUs + (int32_t)((rng >> 16) % (2 * HOST_INGEST_JITTER_US + 1)) -
+                         HOST_INGEST_JITTER_US;
+        for (int c = 0; c < count; c++) {
+            Consumer& consumer = consumers[c];
+            GPSPacket out;
+            Clock::time_point t0 = Clock::now();
+            bool due = consumer.decimator.push(packets[i], timeUs, out);
+            filterNs += elapsedUs(t0) * 1000.0;
+            if (i == half && c == 1) windowStart[c] = i;     // Reconfigure drops the pending window
+            if (!due) continue;
+            consumer.out++;
+            if (c == 1 && i >= half) secondHalfOut++;
+
+            crcs &= out.crc == crc16((const uint8_t*)&out, sizeof(GPSPacket) - 2);
+            if (consumer.filter == RATE_FILTER_LATEST || consumer.hz >= HOST_NAV_RATE_HZ) {
+                raw &= memcmp(&out, &packets[i], sizeof(GPSPacket)) == 0;
+            } else {
+                double speed = 0, latitude = 0;
+                for (uint32_t k = windowStart[c]; k <= i; k++) {
+                    speed += packets[k].speed;
+                    latitude += packets[k].latitude;
+                }
+                uint32_t n = i - windowStart[c] + 1;
+                means &= fabs(out.speed - speed / n) <= 0.5 && fabs(out.latitude - latitude / n) <= 0.5 &&
+                         out.fixType == packets[i].fixType && out.timestamp == packets[i].timestamp;
+            }
+            windowStart[c] = i + 1;
+        }
+    }
+
+    double seconds = (double)packets.size() / HOST_NAV_RATE_HZ;
+    printf("rate control: %u samples over %.0f s -> sd %u, ble %u (10 then 5 Hz), udp %u, ui %u (LAST), "
+           "%.1f ns/sample/consumer\n", (uint32_t)packets.size(), seconds, consumers[0].out, consumers[1].out,
+           consumers[2].out, consumers[3].out, filterNs / packets.size() / count);
+    bool rates = consumers[0].out == packets.size() &&
+                 abs((int)consumers[2].out - (int)(seconds * 5)) <= 1 &&
+                 abs((int)consumers[3].out - (int)(seconds * 15)) <= 1 &&
+                 abs((int)(consumers[1].out - secondHalfOut) - (int)(half / 2.5)) <= 1 &&
+                 abs((int)secondHalfOut - (int)((packets.size() - half) / 5)) <= 1;
+    check(rates, "each consumer runs at its own rate, changeable mid-run");
+    check(means && crcs && raw, "averaged outputs are the window means with a fresh CRC");
+
+    // At or above the input rate nothing is held or averaged, whatever the jitter
+    RateDecimator fast;
+    fast.configure(HOST_NAV_RATE_HZ * 2, RATE_FILTER_AVERAGE, HOST_NAV_RATE_HZ);
+    bool passed = true;
+    for (uint32_t i = 0; i < 100 && i < packets.size(); i++) {
+        GPSPacket out;
+        int64_t timeUs = (int64_t)i * sampleUs + (i % 3 == 0 ? HOST_INGEST_JITTER_US : -HOST_INGEST_JITTER_US);
+        passed &= fast.push(packets[i], timeUs, out) && memcmp(&out, &packets[i], sizeof(GPSPacket)) == 0;
+    }
+    check(passed && fast.getStats().out == fast.getStats().in && fast.getStats().maxWindow == 0,
+          "a rate at or above the input rate passes every sample through");
+
+    // 359.9 and 0.1 degrees average to 0, not 180; a gap emits the window it
+    // interrupted and restarts with the sample after it
+    RateDecimator decimator;
+    decimator.configure(1, RATE_FILTER_AVERAGE, HOST_NAV_RATE_HZ);
+    GPSPacket a = packets[0], b = packets[0], c = packets[0], d = packets[0], out;
+    a.heading = 35990000;
+    b.heading = 10000;
+    c.heading = 20000;
+    d.heading = 40000;
+    decimator.push(a, 0, out);
+    decimator.push(a, 400000, out);
+    bool emitted = decimator.push(b, 1000000, out);
+    bool wraps = emitted && (out.heading < 5000 || out.heading > 35995000);
+    emitted = decimator.push(b, 3000000, out) && out.heading == b.heading;     // Nothing pending: due now
+    bool held = !decimator.push(c, 3400000, out);
+    bool late = decimator.push(d, 6000000, out) && memcmp(&out, &c, sizeof(GPSPacket)) == 0;
+    bool restarted = decimator.push(c, 7000000, out) && out.heading == (d.heading + c.heading) / 2;
+    const RateControlStats& gaps = decimator.getStats();
+    check(wraps && emitted && held && late && restarted && gaps.resyncs == 2 && gaps.late == 1 &&
+          gaps.out == gaps.in - 2, "heading averages on the circle and a gap emits the window it interrupted");
+}
+
+// GNSS/IMU fusion on a simulated drive: 200 Hz IMU with a constant gyro
+// bias and noise, 25 Hz GNSS with noise and a 10 s outage. Fully
+// deterministic, so the error bounds are hard limits, not statistics.
+#define FUSION_HOST_IMU_HZ          200
+#define FUSION_HOST_SECONDS         180
+#define FUSION_HOST_GYRO_BIAS       0.02f       // rad/s, ~1.1 deg/s
+#define FUSION_HOST_OUTAGE_START    100         // s
+#define FUSION_HOST_OUTAGE_SECONDS  10
+#define FUSION_HOST_MEAN_ERROR_M    0.5         // Mean error before each fix, outside the outage
+#define FUSION_HOST_OUTAGE_ERROR_M  5.0         // Worst error during the outage
+#define FUSION_HOST_UPDATE_NS       5000        // Mean cost of one predict or correct
+#define FUSION_HOST_OUTPUT_HZ       100         // FUSION_OUTPUT_HZ
+#define FUSION_HOST_RING_CAPACITY   128         // FUSION_RING_CAPACITY
+
+// Roughly normal, unit variance: sum of four uniforms
+static float fusionNoise(uint32_t& rng) {
+    float sum = 0.0f;
+    for (int i = 0; i < 4; i++) {
+        rng = rng * 1103515245 + 12345;
+        sum += (float)((rng >> 8) & 0xFFFF) / 65535.0f - 0.5f;
+    }
+    return sum * 1.732f;
+}
+
+static void runFusion() {
+    const double metersPerLat = 0.0111319491;           // Per 1e-7 deg, as in fusion_engine.cpp
+    const int32_t originLat = 522297000, originLon = 210122000;
+    const double metersPerLon = metersPerLat * cos(52.2297 * M_PI / 180.0);
+    const uint32_t steps = FUSION_HOST_SECONDS * FUSION_HOST_IMU_HZ;
+    const uint32_t fixEvery = FUSION_HOST_IMU_HZ / HOST_NAV_RATE_HZ;
+    const double dt = 1.0 / FUSION_HOST_IMU_HZ;
+    uint32_t rng = 99;
+
+    FusionEngine fusion;
+    double east = 0, north = 0, speed = 12.0, heading = 0.8;
+    double errorSum = 0, outageMax = 0, fixedMax = 0;
+    uint32_t errorCount = 0, predicts = 0, corrects = 0;
+    double predictNs = 0, correctNs = 0;
+    FusionState state;
+
+    // The board's fused state stream: published at FUSION_HOST_OUTPUT_HZ, sent
+    // by the UDP task as TB_FRAME_FUSION datagrams at each (25 Hz) wake-up
+    TelemetryRing<FusionState> fusionBus;
+    fusionBus.begin(FUSION_HOST_RING_CAPACITY);
+    int udpConsumer = fusionBus.addConsumer();
+    static FusionRecord records[TB_MAX_FUSION_RECORDS];
+    static uint8_t frame[TB_MAX_FRAME];
+    uint32_t published = 0, streamed = 0, frames = 0;
+    bool streamIntact = true;
+
+    for (uint32_t i = 0; i <= steps; i++) {
+        double t = i * dt;
+        int64_t nowUs = (int64_t)i * (1000000 / FUSION_HOST_IMU_HZ);
+
+        // Truth: speed swings 9-15 m/s, alternating curves
+        double accel = 0.6 * cos(t * 0.2);
+        double yawRate = 0.08 * sin(t * 0.15);
+        if (i > 0) {
+            Clock::time_point t0 = Clock::now();
+            fusion.predict(nowUs, (float)accel + 0.05f * fusionNoise(rng),
+                           (float)yawRate + FUSION_HOST_GYRO_BIAS + 0.005f * fusionNoise(rng));
+            predictNs += elapsedUs(t0) * 1000.0;
+            predicts++;
+            speed += accel * dt;
+            heading += yawRate * dt;
+            east += speed * sin(heading) * dt;
+            north += speed * cos(heading) * dt;
+        }
+        if (fusion.isInitialized() && i % (FUSION_HOST_IMU_HZ / FUSION_HOST_OUTPUT_HZ) == 0) {
+            fusion.getState(state);
+            fusionBus.push(state);
+            published++;
+        }
+        if (i % fixEvery != 0) continue;
+
+        uint8_t count = 0;
+        FusionState sent[TB_MAX_FUSION_RECORDS];
+        while (count < TB_MAX_FUSION_RECORDS && fusionBus.read(udpConsumer, sent[count])) {
+            fusionRecordFrom(sent[count], records[count]);
+            count++;
+        }
+        if (count > 0) {
+            size_t length = encodeFusionFrame(records, count, (uint16_t)frames, streamed, frame);
+            TelemetryBatchHeader header;
+            const FusionRecord* received;
+            int n = parseFusionFrame(frame, length, header, &received);
+            streamIntact &= n == count && header.sequence == (uint16_t)frames && header.firstSample == streamed;
+            for (int k = 0; k < n && k < count; k++) {
+                streamIntact &= received[k].timeUs == (uint32_t)sent[k].timestampUs &&
+                                received[k].latitude == sent[k].latitude &&
+                                fabs(received[k].speed * 0.01 - sent[k].speed) <= 0.006 &&
+                                fabs(fmod(received[k].heading * 0.01 - sent[k].heading + 540.0, 360.0) - 180.0) <= 0.006;     // Half a unit, plus float rounding
+            }
+            streamed += count;
+            frames++;
+        }
+
+        // Prediction error: the dead-reckoned state just before the fix lands
+        bool outage = t >= FUSION_HOST_OUTAGE_START && t < FUSION_HOST_OUTAGE_START + FUSION_HOST_OUTAGE_SECONDS;
+        if (fusion.isInitialized()) {
+            fusion.getState(state);
+            double errorN = (state.latitude - originLat) * metersPerLat - north;
+            double errorE = (state.longitude - originLon) * metersPerLon - east;
+            double error = sqrt(errorN * errorN + errorE * errorE);
+            if (outage) {
+                if (error > outageMax) outageMax = error;
+            } else if (t >= 10.0) {     // Past the bias convergence
+                errorSum += error;
+                errorCount++;
+                if (error > fixedMax) fixedMax = error;
+            }
+        }
+        if (outage) continue;
+
+        FusionGnssFix fix;
+        fix.timestampUs = nowUs;
+        fix.latitude = originLat + (int32_t)lrint((north + 1.0 * fusionNoise(rng)) / metersPerLat);
+        fix.longitude = originLon + (int32_t)lrint((east + 1.0 * fusionNoise(rng)) / metersPerLon);
+        fix.speed = (float)speed + 0.1f * fusionNoise(rng);
+        fix.heading = (float)fmod(heading * 180.0 / M_PI + 0.5 * fusionNoise(rng) + 720.0, 360.0);
+        fix.horizontalAccuracy = 1.5f;
+        fix.speedAccuracy = 0.2f;
+        fix.headingAccuracy = 1.0f;
+        Clock::time_point t0 = Clock::now();
+        fusion.correct(fix);
+        correctNs += elapsedUs(t0) * 1000.0;
+        corrects++;
+    }
+
+    const FusionStats& s = fusion.getStats();
+    double meanError = errorCount ? errorSum / errorCount : 0.0;
+    printf("fusion: %u predictions, %u corrections (%u rejected, %u resets), error before fix mean %.2f m "
+           "max %.2f m, %d s outage max %.2f m, predict %.0f ns, correct %.0f ns\n",
+           s.predictions, s.corrections, s.rejectedFixes, s.resets, meanError, fixedMax,
+           FUSION_HOST_OUTAGE_SECONDS, outageMax, predictNs / predicts, correctNs / corrects);
+    check(s.resets == 0 && s.rejectedFixes == 0 && meanError < FUSION_HOST_MEAN_ERROR_M,
+          "fusion tracks the drive with a biased gyro");
+    check(outageMax > 0.0 && outageMax < FUSION_HOST_OUTAGE_ERROR_M, "fusion dead-reckons through a GNSS outage");
+    check(predictNs / predicts < FUSION_HOST_UPDATE_NS && correctNs / corrects < FUSION_HOST_UPDATE_NS,
+          "fusion predict and correct stay within their cost bound");
+    printf("fusion stream: %u states published, %u streamed in %u frames\n", published, streamed, frames);
+    TelemetryBatchHeader empty;
+    const FusionRecord* none;
+    check(streamIntact && streamed == published && fusionBus.getConsumerStats(udpConsumer).overruns == 0 &&
+          parseFusionFrame(frame, sizeof(TelemetryBatchHeader), empty, &none) < 0,
+          "fused states reach the UDP sink as TB_FRAME_FUSION frames, every one in order");
+}
+
+// Config registry: staged writes, persistence across a rebuilt registry (a
+// reboot), boot-scope entries, range checks on stored and typed values, reset
+static int configNotified[4];
+
+static void countConfigChange(int id) {
+    configNotified[id]++;
+}
+
+static void checkConfig() {
+    enum { NAV_HZ, DEBUG, UDP_HOST, RATE_BLE };
+    static const ConfigEntry entries[] = {      // Excerpt of the firmware table (globals.cpp)
+        { "nav_hz",   CONFIG_TYPE_UINT, 1, 25, HOST_NAV_RATE_HZ, nullptr, CONFIG_SCOPE_BOOT },
+        { "debug",    CONFIG_TYPE_BOOL, 0, 1, 1, nullptr, 0x0002 },
+        { "udp_host", CONFIG_TYPE_TEXT, 0, 15, 0, "172.16.2.158", 0x0004 },
+        { "rate_ble", CONFIG_TYPE_UINT, 0, RATE_MAX_HZ, 10, nullptr, 0x0010 },
+    };
+    const int count = sizeof(entries) / sizeof(entries[0]);
+    MemoryConfigStore store;
+    char line[CONFIG_LINE_SIZE];
+
+    ConfigRegistry config(entries, count);
+    config.load(store);
+    config.subscribe(0x0002 | 0x0004 | 0x0010, countConfigChange);
+    bool defaults = config.get(NAV_HZ) == HOST_NAV_RATE_HZ && config.getBool(DEBUG) &&
+                    strcmp(config.getText(UDP_HOST), "172.16.2.158") == 0 && config.get(RATE_BLE) == 10 &&
+                    config.getStats().loaded == 0 && store.size() == 0;
+    check(defaults, "config registry starts from the build defaults");
+
+    bool staged = config.set(config.find("rate_ble"), "5") == CONFIG_OK &&
+                  config.set(config.find("nav_hz"), "10") == CONFIG_OK &&
+                  config.set(config.find("debug"), "false") == CONFIG_OK &&
+                  config.set(config.find("udp_host"), "10.0.0.7") == CONFIG_OK &&
+                  config.get(RATE_BLE) == 10;       // Nothing live before service()
+    int changed = config.service(store);
+    config.format(NAV_HZ, line, sizeof(line));
+    bool applied = changed == 3 && config.get(RATE_BLE) == 5 && !config.getBool(DEBUG) &&
+                   strcmp(config.getText(UDP_HOST), "10.0.0.7") == 0 && config.get(NAV_HZ) == HOST_NAV_RATE_HZ &&
+                   strcmp(line, "nav_hz=25->10") == 0 && store.size() == 4 &&
+                   configNotified[RATE_BLE] == 1 && configNotified[DEBUG] == 1 &&
+                   configNotified[UDP_HOST] == 1 && configNotified[NAV_HZ] == 0;
+    config.set(RATE_BLE, "5");                      // Same value: stored again, nobody told
+    applied &= config.service(store) == 0 && configNotified[RATE_BLE] == 1 && config.service(store) == 0;
+    check(staged && applied, "config changes persist, go live on service() and notify once");
+
+    ConfigRegistry rebooted(entries, count);
+    rebooted.load(store);
+    rebooted.format(NAV_HZ, line, sizeof(line));
+    bool reloaded = rebooted.get(NAV_HZ) == 10 && rebooted.get(RATE_BLE) == 5 && !rebooted.getBool(DEBUG) &&
+                    strcmp(rebooted.getText(UDP_HOST), "10.0.0.7") == 0 && strcmp(line, "nav_hz=10") == 0 &&
+                    rebooted.getStats().loaded == 4 && rebooted.getStats().rejected == 0;
+    check(reloaded, "config survives a reboot, boot entries apply then");
+
+    bool rejected = rebooted.set(NAV_HZ, "26") == CONFIG_OUT_OF_RANGE && rebooted.set(NAV_HZ, "0") == CONFIG_OUT_OF_RANGE &&
+                    rebooted.set(NAV_HZ, "abc") == CONFIG_BAD_VALUE && rebooted.set(NAV_HZ, "-1") == CONFIG_BAD_VALUE &&
+                    rebooted.set(NAV_HZ, "") == CONFIG_BAD_VALUE && rebooted.set(DEBUG, "maybe") == CONFIG_BAD_VALUE &&
+                    rebooted.set(UDP_HOST, "255.255.255.2550") == CONFIG_BAD_VALUE &&
+                    rebooted.set(rebooted.find("nope"), "1") == CONFIG_UNKNOWN_KEY &&
+                    rebooted.service(store) == 0 && rebooted.get(NAV_HZ) == 10;
+    uint32_t outOfRange = 40;                       // Written by a build with a wider range
+    store.write("nav_hz", (const uint8_t*)&outOfRange, sizeof(outOfRange));
+    store.write("debug", (const uint8_t*)"1", 1);
+    ConfigRegistry downgraded(entries, count);
+    downgraded.load(store);
+    rejected &= downgraded.get(NAV_HZ) == HOST_NAV_RATE_HZ && downgraded.getBool(DEBUG) &&
+                downgraded.getStats().rejected == 2 && downgraded.getStats().loaded == 2;
+    check(rejected, "bad typed and stored values are refused");
+
+    downgraded.resetAll();
+    changed = downgraded.service(store);
+    ConfigRegistry fresh(entries, count);
+    fresh.load(store);
+    bool reset = changed == 2 && store.size() == 0 && downgraded.get(RATE_BLE) == 10 &&
+                 strcmp(downgraded.getText(UDP_HOST), "172.16.2.158") == 0 && fresh.getStats().loaded == 0;
+    check(reset, "CFG:RESET erases every stored value");
+
+    // A command task keeps re-staging udp_host while the sink services; every
+    // value stored or made live has to be one of the two written whole
+    static const char* hosts[2] = { "11111111", "222222222222222" };
+    std::atomic<bool> stop(false);
+    uint32_t sets = 0;
+    std::thread setter([&]() {
+        while (!stop.load(std::memory_order_relaxed)) {
+            fresh.set(UDP_HOST, hosts[++sets & 1]);
+        }
+    });
+    uint32_t services = 0, torn = 0;
+    Clock::time_point raceStart = Clock::now();
+    for (bool finished = false; !finished; ) {
+        if (elapsedUs(raceStart) > RING_RACE_MS * 1000.0) {
+            stop.store(true);
+            setter.join();
+            finished = true;
+        }
+        fresh.service(store);
+        services++;
+        uint8_t stored[CONFIG_TEXT_MAX + 1] = { 0 };
+        store.read("udp_host", stored, CONFIG_TEXT_MAX);
+        const char* live = fresh.getText(UDP_HOST);
+        bool whole = (strcmp(live, hosts[0]) == 0 || strcmp(live, hosts[1]) == 0) &&
+                     (strcmp((const char*)stored, hosts[0]) == 0 || strcmp((const char*)stored, hosts[1]) == 0);
+        torn += !whole && store.contains("udp_host");
+    }
+    fresh.service(store);
+    printf("staged config text: %u sets, %u services\n", sets, services);
+    check(torn == 0 && strcmp(fresh.getText(UDP_HOST), hosts[sets & 1]) == 0,
+          "config text set from another task is stored and applied whole, newest last");
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        HostStorageFile storage(argc > 3 ? argv[3] : ".");
+        BenchRunner runner(hostClockNs, 1000, "host");
+        char line[BENCH_LINE_SIZE];
+        benchFormatHeader(line, sizeof(line));
+        printf("%s\n", line);
+        return benchRunSuite(runner, &storage, argc > 2 ? argv[2] : nullptr, printBenchResult) > 0 ? 0 : 1;
+    }
+    if (argc > 1 && strcmp(argv[1], "fuzz") == 0) {
+        uint32_t iterations = argc > 2 ? (uint32_t)strtoul(argv[2], nullptr, 10) : 1000000;
+        uint32_t seed = argc > 3 ? (uint32_t)strtoul(argv[3], nullptr, 10) : 1;
+        return runFuzz(iterations, seed);
+    }
+    if (argc > 2 && strcmp(argv[1], "replay") == 0) {
+        HostStorageFile storage("");
+        std::vector<GPSPacket> packets;
+        GPSData gps;
+        uint16_t speed = argc > 3 ? (uint16_t)atoi(argv[3]) : 0;
+        return replayFile(storage, argv[2], speed, packets, gps) ? 0 : 1;
+    }
+
+    uint32_t epochs = argc > 1 ? (uint32_t)atoi(argv[1]) : HOST_NAV_RATE_HZ * 600;
+    const char* root = argc > 2 ? argv[2] : ".";
+
+    check(crc16SelfTest(), "crc16 implementations agree");
+
+    HostStorageFile storage(root);
+    std::vector<GPSPacket> packets;
+    packets.reserve(epochs);
+
+    runPipeline(epochs, storage, packets);
+    checkUbxCorruption();
+    verifyLog(storage, packets);
+    transferLog(storage);
+    checkReplay(storage, packets);
+    checkTornLog(root, storage, packets);
+    checkCommands();
+    checkCommandFrames();
+    uint32_t accepted[2];
+    check(fuzzCommandParsers(200000, 1, accepted) == 0 && accepted[0] > 0 && accepted[1] > 0,
+          "command parsers survive 200k fuzzed inputs");
+    checkHistograms();
+    checkTelemetryRing();
+    runBatching(packets, HOST_NAV_RATE_HZ, HOST_LOSS_PERCENT);
+    runBatching(packets, 200, 0);
+    runUdp(packets);
+    runPolicy(storage);
+    runRateControl(packets);
+    runFusion();
+    checkConfig();
+
+    printf("%s (%d failure%s)\n", failures ? "FAILED" : "OK", failures, failures == 1 ? "" : "s");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,70 @@
+#include "imu_calibration.h"
+#include <math.h>
+#include <string.h>
+
+ImuCalibrator::ImuCalibrator() : state(IMU_CAL_IDLE), startMs(0), restarts(0) {
+    resetAxes();
+    memset(&result, 0, sizeof(result));
+}
+
+void ImuCalibrator::resetAxes() {
+    for (int i = 0; i < 6; i++) {
+        axes[i].reset();
+    }
+}
+
+void ImuCalibrator::start(uint32_t nowMs) {
+    resetAxes();
+    state = IMU_CAL_COLLECTING;
+    startMs = nowMs;
+    restarts = 0;
+}
+
+bool ImuCalibrator::isStill(float* accelStd, float* gyroStd) const {
+    float worstAccel = 0.0f;
+    float worstGyro = 0.0f;
+    for (int i = 0; i < 3; i++) {
+        float a = sqrtf(axes[i].variance());
+        float g = sqrtf(axes[i + 3].variance());
+        if (a > worstAccel) worstAccel = a;
+        if (g > worstGyro) worstGyro = g;
+    }
+    *accelStd = worstAccel;
+    *gyroStd = worstGyro;
+    return worstAccel <= IMU_CAL_MAX_ACCEL_STD && worstGyro <= IMU_CAL_MAX_GYRO_STD;
+}
+
+bool ImuCalibrator::addSample(const float accel[3], const float gyro[3], uint32_t nowMs) {
+    if (state != IMU_CAL_COLLECTING) return false;
+
+    if (nowMs - startMs > IMU_CAL_TIMEOUT_MS) {
+        state = IMU_CAL_FAILED;
+        return true;
+    }
+
+    for (int i = 0; i < 3; i++) {
+        axes[i].add(accel[i]);
+        axes[i + 3].add(gyro[i]);
+    }
+
+    uint32_t n = axes[0].count;
+    if (n % IMU_CAL_CHECK_INTERVAL != 0 && n < IMU_CAL_SAMPLES) return false;
+
+    float accelStd, gyroStd;
+    if (!isStill(&accelStd, &gyroStd)) {
+        resetAxes();            // Moved - start the window over
+        restarts++;
+        return false;
+    }
+    if (n < IMU_CAL_SAMPLES) return false;
+
+    for (int i = 0; i < 3; i++) {
+        result.accelOffset[i] = axes[i].mean;
+        result.gyroOffset[i] = axes[i + 3].mean;
+    }
+    result.accelOffset[2] -= 1.0f;     // Remove gravity (Z up)
+    result.accelStd = accelStd;
+    result.gyroStd = gyroStd;
+    state = IMU_CAL_DONE;
+    return true;
+}
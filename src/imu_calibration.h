@@ -0,0 +1,78 @@
+#ifndef IMU_CALIBRATION_H
+#define IMU_CALIBRATION_H
+
+#include <stdint.h>
+
+// ==============================================
+// INCREMENTAL IMU CALIBRATION
+// ==============================================
+// Fed one sample at a time from the sampling path, so nothing ever blocks.
+// Per-axis mean and variance are tracked with Welford's algorithm; every
+// IMU_CAL_CHECK_INTERVAL samples the variance is checked and collection
+// restarts if the device is moving. The device is assumed to lie flat with
+// Z up (gravity is removed from the Z accel offset).
+
+#define IMU_CAL_SAMPLES         400     // Still samples needed (2 s at 200 Hz)
+#define IMU_CAL_CHECK_INTERVAL  50      // Variance check cadence
+#define IMU_CAL_MAX_ACCEL_STD   0.02f   // g - anything noisier is treated as motion
+#define IMU_CAL_MAX_GYRO_STD    0.5f    // deg/s
+#define IMU_CAL_TIMEOUT_MS      30000   // Give up if the device never stays still this long
+
+// Running mean/variance (Welford)
+struct WelfordStats {
+    uint32_t count;
+    float mean;
+    float m2;
+
+    void reset() { count = 0; mean = 0.0f; m2 = 0.0f; }
+    void add(float x) {
+        count++;
+        float delta = x - mean;
+        mean += delta / count;
+        m2 += delta * (x - mean);
+    }
+    float variance() const { return count > 1 ? m2 / (count - 1) : 0.0f; }
+};
+
+enum ImuCalibrationState {
+    IMU_CAL_IDLE,
+    IMU_CAL_COLLECTING,
+    IMU_CAL_DONE,
+    IMU_CAL_FAILED          // Timed out while moving - previous offsets stay in use
+};
+
+struct ImuCalibrationResult {
+    float accelOffset[3];   // g
+    float gyroOffset[3];    // deg/s
+    float accelStd;         // Worst axis over the accepted window
+    float gyroStd;
+};
+
+class ImuCalibrator {
+public:
+    ImuCalibrator();
+
+    void start(uint32_t nowMs);
+    void cancel() { state = IMU_CAL_IDLE; }
+
+    // Feed one uncalibrated sample. Returns true when calibration finished (DONE or FAILED).
+    bool addSample(const float accel[3], const float gyro[3], uint32_t nowMs);
+
+    ImuCalibrationState getState() const { return state; }
+    bool isCollecting() const { return state == IMU_CAL_COLLECTING; }
+    uint32_t getSamples() const { return axes[0].count; }
+    uint32_t getRestarts() const { return restarts; }
+    const ImuCalibrationResult& getResult() const { return result; }
+
+private:
+    WelfordStats axes[6];   // accel XYZ, gyro XYZ
+    ImuCalibrationState state;
+    uint32_t startMs;
+    uint32_t restarts;
+    ImuCalibrationResult result;
+
+    void resetAxes();
+    bool isStill(float* accelStd, float* gyroStd) const;
+};
+
+#endif // IMU_CALIBRATION_H
@@ -0,0 +1,217 @@
+#include "imu_sampler.h"
+#include <esp_timer.h>
+#include "stage_probe.h"
+
+#define MPU_RECORD_SIZE         MPU6xxx_BURST_LENGTH
+#define MPU_GYRO_OUTPUT_HZ      1000    // Gyro output rate with the DLPF enabled
+#define MPU_DLPF_CFG            1       // 184 Hz accel / 188 Hz gyro bandwidth
+#define MPU_FIFO_EN_ALL         0xF8    // TEMP | XG | YG | ZG | ACCEL - same order as the burst read
+#define MPU_USER_CTRL_FIFO_EN   0x40
+#define MPU_USER_CTRL_FIFO_RST  0x04
+#define MPU_INT_DATA_RDY        0x01
+#define MPU_INT_FIFO_OFLOW      0x10
+
+// Wire's transfer buffer is 128 bytes, so FIFO reads are split into whole records
+#define MPU_FIFO_READ_RECORDS   (128 / MPU_RECORD_SIZE)
+
+void decodeMPUBurst(const uint8_t* raw, MpuReading& out) {
+    int16_t words[MPU6xxx_BURST_LENGTH / 2];
+    for (int i = 0; i < MPU6xxx_BURST_LENGTH / 2; i++) {
+        words[i] = (int16_t)((raw[2 * i] << 8) | raw[2 * i + 1]);
+    }
+
+    const float accelScale = 1.0f / MPU6xxx_ACCEL_LSB_PER_G;
+    const float gyroScale = 1.0f / MPU6xxx_GYRO_LSB_PER_DPS;
+    out.accelX = words[0] * accelScale;
+    out.accelY = words[1] * accelScale;
+    out.accelZ = words[2] * accelScale;
+    out.rawTemp = words[3];
+    out.gyroX = words[4] * gyroScale;
+    out.gyroY = words[5] * gyroScale;
+    out.gyroZ = words[6] * gyroScale;
+}
+
+ImuSampler::ImuSampler() :
+    wire(nullptr),
+    taskHandle(nullptr),
+    rateHz(0),
+    periodUs(0),
+    fifoSize(0),
+    interruptDriven(false),
+    running(false),
+    lastTimestampUs(0),
+    isrMux(portMUX_INITIALIZER_UNLOCKED),
+    lastInterruptUs(0),
+    pendingSamples(0)
+{
+}
+
+bool ImuSampler::begin(TwoWire* imuWire, uint8_t chipType, uint16_t rate, int interruptPin) {
+    wire = imuWire;
+    rateHz = constrain(rate, 4, MPU_GYRO_OUTPUT_HZ);
+    uint8_t divider = MPU_GYRO_OUTPUT_HZ / rateHz - 1;
+    rateHz = MPU_GYRO_OUTPUT_HZ / (divider + 1);
+    periodUs = 1000000UL / rateHz;
+    fifoSize = chipType == 0x68 ? 1024 : 512;     // MPU6050 vs MPU6500/9250
+    interruptDriven = interruptPin >= 0;
+
+    if (!bus.begin(IMU_RING_CAPACITY)) {
+        Serial.println("❌ IMU sampler: ring allocation failed");
+        return false;
+    }
+
+    bool ok = true;
+    ok &= writeRegister(MPU6xxx_CONFIG, MPU_DLPF_CFG);
+    ok &= writeRegister(MPU6xxx_SMPLRT_DIV, divider);
+    ok &= writeRegister(MPU6xxx_INT_PIN_CFG, 0x00);        // Active high, push-pull, 50 us pulse
+    ok &= writeRegister(MPU6xxx_INT_ENABLE, interruptDriven ? MPU_INT_DATA_RDY : 0x00);
+    ok &= writeRegister(MPU6xxx_FIFO_EN, MPU_FIFO_EN_ALL);
+    if (!ok) {
+        Serial.println("❌ IMU sampler: MPU configuration failed");
+        return false;
+    }
+    resetFifo();
+
+    if (xTaskCreatePinnedToCore(samplerTask, "imu", IMU_TASK_STACK, this,
+                                IMU_TASK_PRIORITY, &taskHandle, IMU_TASK_CORE) != pdPASS) {
+        Serial.println("❌ IMU sampler: task creation failed");
+        return false;
+    }
+
+    if (interruptDriven) {
+        pinMode(interruptPin, INPUT);
+        attachInterruptArg(digitalPinToInterrupt(interruptPin), dataReadyIsr, this, RISING);
+    }
+
+    running = true;
+    Serial.printf("✅ IMU sampler: %u Hz, FIFO %u bytes, batch %d, %s\n", rateHz, fifoSize,
+                  IMU_FIFO_BATCH, interruptDriven ? "data-ready IRQ" : "timer");
+    return true;
+}
+
+bool ImuSampler::writeRegister(uint8_t reg, uint8_t value) {
+    wire->beginTransmission(MPU6xxx_ADDRESS);
+    wire->write(reg);
+    wire->write(value);
+    return wire->endTransmission() == 0;
+}
+
+bool ImuSampler::readRegisters(uint8_t reg, uint8_t* buffer, size_t length) {
+    wire->beginTransmission(MPU6xxx_ADDRESS);
+    wire->write(reg);
+    if (wire->endTransmission(false) != 0) return false;
+    if (wire->requestFrom((uint8_t)MPU6xxx_ADDRESS, (uint8_t)length, (uint8_t)1) != length) return false;
+    return wire->readBytes(buffer, length) == length;
+}
+
+void ImuSampler::resetFifo() {
+    writeRegister(MPU6xxx_USER_CTRL, MPU_USER_CTRL_FIFO_RST);
+    writeRegister(MPU6xxx_USER_CTRL, MPU_USER_CTRL_FIFO_EN);
+
+    portENTER_CRITICAL(&isrMux);
+    pendingSamples = 0;
+    portEXIT_CRITICAL(&isrMux);
+}
+
+void ImuSampler::drainFifo() {
+    PROBE_SCOPE(PROBE_IMU_READ);
+    int64_t start = esp_timer_get_time();
+    uint8_t buffer[MPU_FIFO_READ_RECORDS * MPU_RECORD_SIZE];
+
+    // Reading INT_STATUS also clears the overflow flag
+    uint8_t status;
+    if (!readRegisters(MPU6xxx_INT_STATUS, &status, 1) || !readRegisters(MPU6xxx_FIFO_COUNTH, buffer, 2)) {
+        stats.readErrors++;
+        return;
+    }
+    if (status & MPU_INT_FIFO_OFLOW) {
+        stats.fifoOverflows++;
+        resetFifo();
+        return;
+    }
+
+    uint16_t count = (buffer[0] << 8) | buffer[1];
+    if (count % MPU_RECORD_SIZE != 0 || count > fifoSize) {
+        stats.resyncs++;            // Partial record - realign on a fresh FIFO
+        resetFifo();
+        return;
+    }
+
+    uint16_t records = count / MPU_RECORD_SIZE;
+    if (records == 0) return;
+
+    // The newest record was taken at the last data-ready edge; older ones are one period apart
+    int64_t newestUs;
+    if (interruptDriven) {
+        portENTER_CRITICAL(&isrMux);
+        newestUs = lastInterruptUs;
+        portEXIT_CRITICAL(&isrMux);
+    } else {
+        newestUs = start;
+    }
+    int64_t timestampUs = newestUs - (int64_t)(records - 1) * periodUs;
+
+    uint16_t remaining = records;
+    while (remaining > 0) {
+        uint16_t chunk = remaining < MPU_FIFO_READ_RECORDS ? remaining : MPU_FIFO_READ_RECORDS;
+        if (!readRegisters(MPU6xxx_FIFO_R_W, buffer, chunk * MPU_RECORD_SIZE)) {
+            stats.readErrors++;
+            resetFifo();
+            return;
+        }
+
+        for (uint16_t i = 0; i < chunk; i++) {
+            ImuSample sample;
+            decodeMPUBurst(buffer + i * MPU_RECORD_SIZE, sample.reading);
+            if (timestampUs <= lastTimestampUs) timestampUs = lastTimestampUs + 1;
+            sample.timestampUs = timestampUs;
+            lastTimestampUs = timestampUs;
+            timestampUs += periodUs;
+            bus.push(sample);
+        }
+        remaining -= chunk;
+    }
+
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+    stats.samples += records;
+    stats.batches++;
+    if (records > stats.maxBatch) stats.maxBatch = records;
+    stats.lastDrainUs = elapsed;
+    if (elapsed > stats.maxDrainUs) stats.maxDrainUs = elapsed;
+}
+
+void IRAM_ATTR ImuSampler::dataReadyIsr(void* arg) {
+    ImuSampler* self = static_cast<ImuSampler*>(arg);
+    bool wake = false;
+
+    portENTER_CRITICAL_ISR(&self->isrMux);
+    self->lastInterruptUs = esp_timer_get_time();
+    self->stats.interrupts++;
+    if (++self->pendingSamples >= IMU_FIFO_BATCH) {
+        self->pendingSamples = 0;
+        wake = true;
+    }
+    portEXIT_CRITICAL_ISR(&self->isrMux);
+
+    if (wake) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(self->taskHandle, &woken);
+        if (woken) portYIELD_FROM_ISR();
+    }
+}
+
+void ImuSampler::samplerTask(void* param) {
+    ImuSampler* self = static_cast<ImuSampler*>(param);
+    uint32_t batchMs = (self->periodUs * IMU_FIFO_BATCH) / 1000;
+    if (batchMs == 0) batchMs = 1;
+
+    for (;;) {
+        if (self->interruptDriven) {
+            // The timeout keeps the FIFO drained if an edge is ever missed
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(batchMs * 4));
+        } else {
+            vTaskDelay(pdMS_TO_TICKS(batchMs));
+        }
+        self->drainFifo();
+    }
+}
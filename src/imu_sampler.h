@@ -0,0 +1,82 @@
+#ifndef IMU_SAMPLER_H
+#define IMU_SAMPLER_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "data_structures.h"
+#include "telemetry_ring.h"
+#include "boardconfig.h"
+
+// ==============================================
+// MPU6xxx FIFO SAMPLER
+// ==============================================
+// The MPU runs at a fixed output data rate (SMPLRT_DIV) and queues accel,
+// temperature and gyro in its hardware FIFO. A pinned task drains the FIFO
+// in batches: the data-ready interrupt only wakes it every IMU_FIFO_BATCH
+// samples (the MPU6050 has no FIFO watermark interrupt), or a timer does
+// when no interrupt line is wired. Each sample is timestamped against
+// esp_timer and published on its own TelemetryRing.
+//
+// After begin() the sampler task is the only user of the IMU I2C bus.
+
+// Scaled accel (g), gyro (deg/s) and raw temperature of one MPU sample
+struct MpuReading {
+    float accelX, accelY, accelZ;
+    float gyroX, gyroY, gyroZ;
+    int16_t rawTemp;
+};
+
+// Decode a 14-byte ACCEL_XOUT_H..GYRO_ZOUT_L block (burst read or FIFO record)
+void decodeMPUBurst(const uint8_t* raw, MpuReading& out);
+
+struct ImuSample {
+    int64_t timestampUs;        // esp_timer time the MPU took the sample
+    MpuReading reading;
+};
+
+typedef TelemetryRing<ImuSample> ImuBus;
+
+class ImuSampler {
+public:
+    ImuSampler();
+
+    // Configure rate/FIFO/interrupt and start the task. interruptPin < 0 polls on a timer.
+    bool begin(TwoWire* wire, uint8_t chipType, uint16_t rateHz, int interruptPin);
+    bool isRunning() const { return running; }
+
+    // Add consumers after begin()
+    ImuBus& getBus() { return bus; }
+
+    uint16_t getRateHz() const { return rateHz; }
+    const ImuSamplerStats& getStats() const { return stats; }
+
+private:
+    TwoWire* wire;
+    ImuBus bus;
+    TaskHandle_t taskHandle;
+    uint16_t rateHz;
+    uint32_t periodUs;
+    uint16_t fifoSize;
+    bool interruptDriven;
+    bool running;
+    int64_t lastTimestampUs;
+
+    // Written by the ISR
+    portMUX_TYPE isrMux;
+    volatile int64_t lastInterruptUs;
+    volatile uint32_t pendingSamples;
+
+    ImuSamplerStats stats;
+
+    bool writeRegister(uint8_t reg, uint8_t value);
+    bool readRegisters(uint8_t reg, uint8_t* buffer, size_t length);
+    void resetFifo();
+    void drainFifo();
+
+    static void IRAM_ATTR dataReadyIsr(void* arg);
+    static void samplerTask(void* param);
+};
+
+#endif // IMU_SAMPLER_H
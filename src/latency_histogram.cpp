@@ -0,0 +1,188 @@
+#include "latency_histogram.h"
+#include "delta_codec.h"
+#include <stdio.h>
+#include <string.h>
+
+void LatencyHistogram::reset() {
+    memset(counts, 0, sizeof(counts));
+    count = 0;
+    minUs = UINT32_MAX;
+    maxUs = 0;
+    sumUs = 0;
+}
+
+uint16_t LatencyHistogram::bucketIndex(uint32_t valueUs) {
+    if (valueUs > LATENCY_MAX_US) valueUs = LATENCY_MAX_US;
+    if (valueUs < 2 * LATENCY_SUB_BUCKETS) return (uint16_t)valueUs;
+    uint32_t msb = 31 - __builtin_clz(valueUs);
+    uint32_t shift = msb - LATENCY_SUB_BUCKET_BITS;
+    return (uint16_t)(LATENCY_SUB_BUCKETS * (shift + 1) + (valueUs >> shift) - LATENCY_SUB_BUCKETS);
+}
+
+uint32_t LatencyHistogram::bucketLow(uint16_t index) {
+    if (index < 2 * LATENCY_SUB_BUCKETS) return index;
+    uint32_t shift = index / LATENCY_SUB_BUCKETS - 1;
+    return (uint32_t)(LATENCY_SUB_BUCKETS + index % LATENCY_SUB_BUCKETS) << shift;
+}
+
+uint32_t LatencyHistogram::bucketHigh(uint16_t index) {
+    if (index < 2 * LATENCY_SUB_BUCKETS) return index;
+    uint32_t shift = index / LATENCY_SUB_BUCKETS - 1;
+    return bucketLow(index) + (1UL << shift) - 1;
+}
+
+void LatencyHistogram::record(uint32_t valueUs) {
+    counts[bucketIndex(valueUs)]++;
+    count++;
+    sumUs += valueUs;
+    if (valueUs < minUs) minUs = valueUs;
+    if (valueUs > maxUs) maxUs = valueUs;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    if (other.count == 0) return;
+    for (int i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+        counts[i] += other.counts[i];
+    }
+    count += other.count;
+    sumUs += other.sumUs;
+    if (other.minUs < minUs) minUs = other.minUs;
+    if (other.maxUs > maxUs) maxUs = other.maxUs;
+}
+
+uint32_t LatencyHistogram::valueAtPercentile(float percent) const {
+    if (count == 0) return 0;
+    // Rank of the sample at `percent`, 1-based
+    double exact = (double)percent / 100.0 * count;
+    uint32_t rank = (uint32_t)exact;
+    if (rank < exact) rank++;
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+
+    uint32_t seen = 0;
+    for (uint16_t i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            uint32_t high = bucketHigh(i);
+            return high < maxUs ? high : maxUs;
+        }
+    }
+    return maxUs;
+}
+
+uint32_t LatencyHistogram::countAbove(uint32_t valueUs) const {
+    if (valueUs >= LATENCY_MAX_US) return 0;
+    uint32_t above = 0;
+    for (uint16_t i = bucketIndex(valueUs) + 1; i < LATENCY_BUCKET_COUNT; i++) {
+        above += counts[i];
+    }
+    return above;
+}
+
+static bool putVarint(uint8_t* out, size_t size, size_t& length, uint32_t value) {
+    if (length + DELTA_FIELD_MAX_BYTES > size) return false;
+    length += varintEncode(value, out + length);
+    return true;
+}
+
+size_t LatencyHistogram::exportTo(const char* name, uint8_t* out, size_t size) const {
+    size_t nameLength = strlen(name);
+    if (nameLength > LATENCY_NAME_MAX) nameLength = LATENCY_NAME_MAX;
+    if (size < 4 + 1 + nameLength) return 0;
+
+    size_t length = 0;
+    out[length++] = 'L';
+    out[length++] = 'H';
+    out[length++] = LATENCY_EXPORT_VERSION;
+    out[length++] = LATENCY_SUB_BUCKET_BITS;
+    out[length++] = (uint8_t)nameLength;
+    memcpy(out + length, name, nameLength);
+    length += nameLength;
+
+    uint32_t nonzero = 0;
+    for (int i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+        if (counts[i]) nonzero++;
+    }
+    if (!putVarint(out, size, length, count) || !putVarint(out, size, length, getMin()) ||
+        !putVarint(out, size, length, maxUs) || !putVarint(out, size, length, getMean()) ||
+        !putVarint(out, size, length, nonzero)) {
+        return 0;
+    }
+
+    int next = 0;
+    for (int i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+        if (!counts[i]) continue;
+        if (!putVarint(out, size, length, (uint32_t)(i - next)) ||
+            !putVarint(out, size, length, counts[i])) {
+            return 0;
+        }
+        next = i + 1;
+    }
+    return length;
+}
+
+size_t LatencyHistogram::importFrom(const uint8_t* data, size_t length, char* name, size_t nameSize) {
+    if (length < 5 || data[0] != 'L' || data[1] != 'H' || data[2] != LATENCY_EXPORT_VERSION ||
+        data[3] != LATENCY_SUB_BUCKET_BITS) {
+        return 0;
+    }
+    size_t nameLength = data[4];
+    size_t pos = 5 + nameLength;
+    if (nameLength > LATENCY_NAME_MAX || pos > length) return 0;
+    if (nameSize > 0) {
+        size_t copy = nameLength < nameSize - 1 ? nameLength : nameSize - 1;
+        memcpy(name, data + 5, copy);
+        name[copy] = '\0';
+    }
+
+    uint32_t header[5];     // count, min, max, mean, nonzero buckets
+    for (int i = 0; i < 5; i++) {
+        size_t n = varintDecode(data + pos, length - pos, &header[i]);
+        if (n == 0) return 0;
+        pos += n;
+    }
+
+    reset();
+    uint32_t next = 0;
+    uint32_t total = 0;
+    for (uint32_t b = 0; b < header[4]; b++) {
+        uint32_t gap, bucketCount;
+        size_t n = varintDecode(data + pos, length - pos, &gap);
+        if (n == 0) return 0;
+        pos += n;
+        n = varintDecode(data + pos, length - pos, &bucketCount);
+        if (n == 0) return 0;
+        pos += n;
+        uint32_t index = next + gap;
+        if (index >= LATENCY_BUCKET_COUNT) return 0;
+        counts[index] = bucketCount;
+        total += bucketCount;
+        next = index + 1;
+    }
+    if (total != header[0]) return 0;
+
+    count = header[0];
+    minUs = count ? header[1] : UINT32_MAX;
+    maxUs = header[2];
+    sumUs = (uint64_t)header[3] * count;
+    return pos;
+}
+
+void WindowedHistogram::rotate() {
+    uint8_t next = active ^ 1;
+    windows[next].reset();
+    active = next;
+    lifetime.merge(windows[next ^ 1]);
+}
+
+size_t latencyFormat(const LatencyHistogram& h, char* out, size_t size, bool compact) {
+    if (size == 0) return 0;
+    int n = snprintf(out, size,
+                     compact ? "%lu/%lu/%lu/%lu/%lu/%lu"
+                             : "n:%-7lu p50:%-6lu p90:%-6lu p99:%-6lu p99.9:%-6lu max:%luus",
+                     (unsigned long)h.getCount(), (unsigned long)h.valueAtPercentile(50.0f),
+                     (unsigned long)h.valueAtPercentile(90.0f), (unsigned long)h.valueAtPercentile(99.0f),
+                     (unsigned long)h.valueAtPercentile(99.9f), (unsigned long)h.getMax());
+    if (n < 0) return 0;
+    return (size_t)n < size ? (size_t)n : size - 1;
+}
@@ -0,0 +1,97 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ==============================================
+// LOG-LINEAR LATENCY HISTOGRAMS
+// ==============================================
+// HDR-style fixed-memory histograms of microsecond values. Below
+// 2 * LATENCY_SUB_BUCKETS every microsecond has its own bucket; above that
+// each power of two is split into LATENCY_SUB_BUCKETS linear steps, so a
+// bucket is never wider than 1/128 of its value (256 us at a 40 ms epoch). Recording is an index
+// computation and an increment - no allocation, no floating point.
+//
+// WindowedHistogram double-buffers a histogram so one task can record while
+// another rotates it: the finished window is folded into the lifetime totals
+// and stays queryable until the next rotation. Nothing is ever hard-reset.
+
+#define LATENCY_SUB_BUCKET_BITS 7       // 128 steps per power of two (<= 0.8% bucket width)
+#define LATENCY_SUB_BUCKETS     (1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_RANGE_BITS      22      // Values clamp at 2^22 - 1 us (~4.2 s)
+#define LATENCY_MAX_US          ((1UL << LATENCY_RANGE_BITS) - 1)
+#define LATENCY_BUCKET_COUNT    ((LATENCY_RANGE_BITS - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_SUB_BUCKETS)
+
+// Compact export (little-endian varints, delta_codec.h):
+//   'L' 'H' version subBucketBits | varint nameLength, name | varint count, min, max, mean
+//   | varint nonzero buckets | { varint index gap from the previous bucket + 1, varint count } ...
+#define LATENCY_EXPORT_VERSION  1
+#define LATENCY_NAME_MAX        23
+#define LATENCY_EXPORT_MAX_SIZE (5 + LATENCY_NAME_MAX + 5 * 5 + LATENCY_BUCKET_COUNT * 7 + 5)   // ~14 KB worst case
+#define LATENCY_LINE_SIZE       96      // One latencyFormat() line
+
+class LatencyHistogram {
+public:
+    LatencyHistogram() { reset(); }
+
+    void reset();
+    void record(uint32_t valueUs);
+    void merge(const LatencyHistogram& other);
+
+    uint32_t getCount() const { return count; }
+    uint32_t getMin() const { return count ? minUs : 0; }
+    uint32_t getMax() const { return maxUs; }
+    uint32_t getMean() const { return count ? (uint32_t)(sumUs / count) : 0; }
+
+    // Highest value equivalent to the sample at `percent` (0-100, e.g. 99.9),
+    // never above the recorded maximum. 0 when empty.
+    uint32_t valueAtPercentile(float percent) const;
+
+    // Samples in buckets that lie entirely above valueUs (a lower bound that
+    // is exact when valueUs is a bucket edge)
+    uint32_t countAbove(uint32_t valueUs) const;
+
+    static uint16_t bucketIndex(uint32_t valueUs);
+    static uint32_t bucketLow(uint16_t index);
+    static uint32_t bucketHigh(uint16_t index);
+
+    // Returns bytes written, 0 when out is too small
+    size_t exportTo(const char* name, uint8_t* out, size_t size) const;
+    // Parses one exported histogram; returns bytes consumed, 0 on malformed input
+    size_t importFrom(const uint8_t* data, size_t length, char* name, size_t nameSize);
+
+private:
+    uint32_t counts[LATENCY_BUCKET_COUNT];
+    uint32_t count;
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint64_t sumUs;
+};
+
+class WindowedHistogram {
+public:
+    WindowedHistogram() : active(0) {}
+
+    // Writer side: a single task per histogram
+    void record(uint32_t valueUs) { windows[active].record(valueUs); }
+
+    // Reader side: start a new window and fold the finished one into the
+    // lifetime totals. A record racing the switch lands in the finished window.
+    void rotate();
+
+    const LatencyHistogram& getCurrent() const { return windows[active]; }
+    const LatencyHistogram& getWindow() const { return windows[active ^ 1]; }    // Last finished window
+    const LatencyHistogram& getLifetime() const { return lifetime; }
+
+private:
+    LatencyHistogram windows[2];
+    LatencyHistogram lifetime;
+    volatile uint8_t active;
+};
+
+// "n:.. p50:.. p90:.. p99:.. p99.9:.. max:..us" (or the compact
+// "n/p50/p90/p99/p99.9/max" form used in BLE replies)
+size_t latencyFormat(const LatencyHistogram& histogram, char* out, size_t size, bool compact);
+
+#endif // LATENCY_HISTOGRAM_H
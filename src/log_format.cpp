@@ -0,0 +1,91 @@
+#include "log_format.h"
+#include "crc16.h"
+#include <string.h>
+
+static_assert(sizeof(LogFileHeader) <= LOG_FILE_HEADER_SIZE, "LogFileHeader must fit its sector");
+static_assert(sizeof(LogBlockHeader) == 32, "LogBlockHeader layout changed");
+static_assert(sizeof(LogIndexEntry) == 12, "LogIndexEntry layout changed");
+static_assert(sizeof(LogFooter) == 20, "LogFooter layout changed");
+
+void logInitFileHeader(LogFileHeader& header, uint32_t blockSize, uint16_t recordSize,
+                       uint8_t encoding, uint32_t createdUnix) {
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, LOG_FILE_MAGIC, sizeof(header.magic));
+    header.version = LOG_FORMAT_VERSION;
+    header.headerSize = LOG_FILE_HEADER_SIZE;
+    header.blockSize = blockSize;
+    header.recordSize = recordSize;
+    header.encoding = encoding;
+    header.createdUnix = createdUnix;
+    header.crc = crc16((const uint8_t*)&header, offsetof(LogFileHeader, crc));
+}
+
+bool logCheckFileHeader(const LogFileHeader& header) {
+    return memcmp(header.magic, LOG_FILE_MAGIC, sizeof(header.magic)) == 0 &&
+           header.version == LOG_FORMAT_VERSION &&
+           header.headerSize == LOG_FILE_HEADER_SIZE &&
+           header.blockSize > sizeof(LogBlockHeader) &&
+           header.crc == crc16((const uint8_t*)&header, offsetof(LogFileHeader, crc));
+}
+
+void logSealBlock(uint8_t* block, uint32_t blockSize, const LogBlockHeader& header) {
+    LogBlockHeader sealed = header;
+    uint8_t* payload = block + sizeof(LogBlockHeader);
+    uint32_t capacity = logBlockPayloadCapacity(blockSize);
+
+    if (sealed.payloadLength < capacity) {
+        memset(payload + sealed.payloadLength, 0, capacity - sealed.payloadLength);
+    }
+    sealed.magic = LOG_BLOCK_MAGIC;
+    sealed.payloadCrc = crc16(payload, sealed.payloadLength);
+    sealed.headerCrc = crc16((const uint8_t*)&sealed, offsetof(LogBlockHeader, headerCrc));
+    memcpy(block, &sealed, sizeof(sealed));
+}
+
+bool logCheckBlockHeader(const LogBlockHeader& header, uint32_t blockSize) {
+    return header.magic == LOG_BLOCK_MAGIC &&
+           header.payloadLength <= logBlockPayloadCapacity(blockSize) &&
+           header.headerCrc == crc16((const uint8_t*)&header, offsetof(LogBlockHeader, headerCrc));
+}
+
+bool logCheckBlock(const uint8_t* block, uint32_t blockSize) {
+    LogBlockHeader header;
+    memcpy(&header, block, sizeof(header));
+    if (!logCheckBlockHeader(header, blockSize)) return false;
+    return header.payloadCrc == crc16(block + sizeof(LogBlockHeader), header.payloadLength);
+}
+
+void logInitFooter(LogFooter& footer, const LogIndexEntry* index, uint32_t entryCount,
+                   uint32_t indexOffset, uint32_t totalRecords) {
+    footer.magic = LOG_INDEX_MAGIC;
+    footer.entryCount = entryCount;
+    footer.indexOffset = indexOffset;
+    footer.totalRecords = totalRecords;
+    footer.indexCrc = crc16((const uint8_t*)index, entryCount * sizeof(LogIndexEntry));
+    footer.crc = crc16((const uint8_t*)&footer, offsetof(LogFooter, crc));
+}
+
+bool logCheckFooter(const LogFooter& footer) {
+    return footer.magic == LOG_INDEX_MAGIC &&
+           footer.crc == crc16((const uint8_t*)&footer, offsetof(LogFooter, crc));
+}
+
+bool logCheckIndex(const LogFooter& footer, const LogIndexEntry* index) {
+    return footer.indexCrc == crc16((const uint8_t*)index, footer.entryCount * sizeof(LogIndexEntry));
+}
+
+int32_t logFindBlock(const LogIndexEntry* index, uint32_t entryCount, uint32_t timestamp) {
+    if (entryCount == 0) return -1;
+
+    uint32_t lo = 0;
+    uint32_t hi = entryCount;
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (index[mid].firstTimestamp <= timestamp) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return (int32_t)lo;
+}
@@ -0,0 +1,100 @@
+#ifndef LOG_FORMAT_H
+#define LOG_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ==============================================
+// LOG FILE FORMAT V2
+// ==============================================
+//   [LogFileHeader, padded to 512 bytes]
+//   [block 0][block 1]...[block n-1]      fixed size, sector aligned
+//   [LogIndexEntry x n][LogFooter]        written at close, or rebuilt after power loss
+//
+// Every block starts with a LogBlockHeader (first/last timestamp, record
+// count, CRCs) and can be validated on its own, so partial downloads can be
+// checked block by block. The footer sits at the very end of the file; the
+// index lets readers binary-search a time range without scanning the file.
+// Pure functions on memory buffers - no Arduino dependencies.
+
+#define LOG_FILE_MAGIC          "GPSLOG2"       // 8 bytes including the terminator
+#define LOG_FORMAT_VERSION      2
+#define LOG_FILE_HEADER_SIZE    512
+#define LOG_BLOCK_MAGIC         0x4B4C4247UL    // "GBLK"
+#define LOG_INDEX_MAGIC         0x58444947UL    // "GIDX"
+
+// Payload encodings
+#define LOG_ENCODING_RAW        0               // Back-to-back fixed-size records
+#define LOG_ENCODING_DELTA      1               // delta_codec.h records, keyframe first in every block
+
+struct __attribute__((packed)) LogFileHeader {
+    char magic[8];
+    uint16_t version;
+    uint16_t headerSize;        // Offset of block 0
+    uint32_t blockSize;
+    uint16_t recordSize;        // Fixed record size for RAW, 0 for variable-length encodings
+    uint8_t encoding;
+    uint8_t reserved0;
+    uint32_t createdUnix;
+    uint16_t crc;               // CRC16 of all preceding header bytes
+};
+
+struct __attribute__((packed)) LogBlockHeader {
+    uint32_t magic;
+    uint32_t sequence;          // Block number within the file
+    uint32_t firstTimestamp;    // Unix seconds of the first record
+    uint32_t lastTimestamp;     // Unix seconds of the last record
+    uint32_t firstRecord;       // File-wide index of the first record
+    uint16_t recordCount;
+    uint16_t payloadLength;     // Bytes after the header, rest of the block is zero padding
+    uint8_t encoding;
+    uint8_t flags;
+    uint16_t payloadCrc;
+    uint16_t reserved0;
+    uint16_t headerCrc;         // CRC16 of all preceding header bytes
+};
+
+struct __attribute__((packed)) LogIndexEntry {
+    uint32_t offset;            // File offset of the block
+    uint32_t firstTimestamp;
+    uint32_t lastTimestamp;
+};
+
+struct __attribute__((packed)) LogFooter {
+    uint32_t magic;
+    uint32_t entryCount;
+    uint32_t indexOffset;       // File offset of the first LogIndexEntry
+    uint32_t totalRecords;
+    uint16_t indexCrc;
+    uint16_t crc;               // CRC16 of all preceding footer bytes
+};
+
+// File header
+void logInitFileHeader(LogFileHeader& header, uint32_t blockSize, uint16_t recordSize,
+                       uint8_t encoding, uint32_t createdUnix);
+bool logCheckFileHeader(const LogFileHeader& header);
+
+// Blocks. logSealBlock fills the header CRCs and zero-pads the unused payload tail.
+inline uint32_t logBlockPayloadCapacity(uint32_t blockSize) {
+    return blockSize - sizeof(LogBlockHeader);
+}
+void logSealBlock(uint8_t* block, uint32_t blockSize, const LogBlockHeader& header);
+bool logCheckBlock(const uint8_t* block, uint32_t blockSize);
+bool logCheckBlockHeader(const LogBlockHeader& header, uint32_t blockSize);
+
+// Index and footer
+void logInitFooter(LogFooter& footer, const LogIndexEntry* index, uint32_t entryCount,
+                   uint32_t indexOffset, uint32_t totalRecords);
+bool logCheckFooter(const LogFooter& footer);
+bool logCheckIndex(const LogFooter& footer, const LogIndexEntry* index);
+
+// Offset of block n for a file with the given block size
+inline uint32_t logBlockOffset(uint32_t blockSize, uint32_t n) {
+    return LOG_FILE_HEADER_SIZE + n * blockSize;
+}
+
+// Binary search: index of the block that holds `timestamp` (the last block whose first
+// timestamp is <= timestamp), 0 when it precedes the log, -1 for an empty index.
+int32_t logFindBlock(const LogIndexEntry* index, uint32_t entryCount, uint32_t timestamp);
+
+#endif // LOG_FORMAT_H
@@ -0,0 +1,157 @@
+#include "log_writer.h"
+#include <string.h>
+
+LogBlockBuilder::LogBlockBuilder() : block(nullptr), blockSize(0) {
+    memset(&header, 0, sizeof(header));
+}
+
+void LogBlockBuilder::begin(uint8_t* buffer, uint32_t size, uint8_t encoding) {
+    block = buffer;
+    blockSize = size;
+    memset(&header, 0, sizeof(header));
+    header.encoding = encoding;
+}
+
+uint32_t LogBlockBuilder::space() const {
+    return block ? logBlockPayloadCapacity(blockSize) - header.payloadLength : 0;
+}
+
+bool LogBlockBuilder::add(const void* data, size_t length, uint32_t timestamp) {
+    if (!block || length > space()) return false;
+
+    memcpy(block + sizeof(LogBlockHeader) + header.payloadLength, data, length);
+    header.payloadLength += length;
+    if (header.recordCount == 0) header.firstTimestamp = timestamp;
+    header.lastTimestamp = timestamp;
+    header.recordCount++;
+    return true;
+}
+
+uint16_t LogBlockBuilder::seal(uint32_t sequence, uint32_t firstRecord) {
+    header.sequence = sequence;
+    header.firstRecord = firstRecord;
+    logSealBlock(block, blockSize, header);
+
+    uint16_t count = header.recordCount;
+    block = nullptr;
+    return count;
+}
+
+LogWriter::LogWriter() : file(nullptr), offset(0), records(0), failed(false) {}
+
+bool LogWriter::open(StorageFile* storage, const char* path, const LogFileHeader& header) {
+    if (file) finish();
+    if (!storage->open(path, STORAGE_WRITE)) return false;
+
+    uint8_t sector[LOG_FILE_HEADER_SIZE];
+    memset(sector, 0, sizeof(sector));
+    memcpy(sector, &header, sizeof(header));
+
+    if (storage->write(sector, sizeof(sector)) != sizeof(sector)) {
+        storage->close();
+        return false;
+    }
+
+    file = storage;
+    offset = sizeof(sector);
+    records = 0;
+    failed = false;
+    index.clear();
+    return true;
+}
+
+bool LogWriter::writeBlock(const uint8_t* block, uint32_t length, uint16_t count) {
+    if (!file || failed) return false;
+
+    size_t written = file->write(block, length);
+    if (written != length) {
+        // Keep the stride: the torn block fails validation and is skipped by readers
+        if (file->seek(offset + length)) {
+            offset += length;
+        } else {
+            offset += written;
+            failed = true;
+        }
+        return false;
+    }
+    const LogBlockHeader* header = (const LogBlockHeader*)block;
+    LogIndexEntry entry = { offset, header->firstTimestamp, header->lastTimestamp };
+    index.push_back(entry);
+    records += count;
+    offset += length;
+    return true;
+}
+
+void LogWriter::flush() {
+    if (file) file->flush();
+}
+
+void LogWriter::finish() {
+    if (!file) return;
+
+    LogFooter footer;
+    uint32_t count = index.size();
+    logInitFooter(footer, index.data(), count, offset, records);
+    if (count > 0) {
+        file->write((const uint8_t*)index.data(), count * sizeof(LogIndexEntry));
+    }
+    file->write((const uint8_t*)&footer, sizeof(footer));
+    file->flush();
+    file->close();
+    file = nullptr;
+    index.clear();
+}
+
+bool logRepair(StorageFile& f, const char* path, uint8_t* scratch, uint32_t scratchSize,
+               LogRepairResult& result) {
+    memset(&result, 0, sizeof(result));
+    if (!f.open(path, STORAGE_READ)) return false;
+
+    LogFileHeader header;
+    uint32_t size = f.size();
+    if (size < LOG_FILE_HEADER_SIZE ||
+        f.read((uint8_t*)&header, sizeof(header)) != sizeof(header) ||
+        !logCheckFileHeader(header) || header.blockSize > scratchSize) {
+        f.close();
+        return false;  // Not a v2 log (v1 files are left alone)
+    }
+
+    // Intact footer that ends exactly at EOF - nothing to do
+    LogFooter footer;
+    if (size >= LOG_FILE_HEADER_SIZE + sizeof(footer)) {
+        f.seek(size - sizeof(footer));
+        if (f.read((uint8_t*)&footer, sizeof(footer)) == sizeof(footer) && logCheckFooter(footer) &&
+            footer.indexOffset + footer.entryCount * sizeof(LogIndexEntry) + sizeof(footer) == size) {
+            f.close();
+            result.blocks = footer.entryCount;
+            result.records = footer.totalRecords;
+            return true;
+        }
+    }
+
+    // Walk the fixed-stride blocks, skipping torn ones
+    std::vector<LogIndexEntry> entries;
+    uint32_t offset = LOG_FILE_HEADER_SIZE;
+    for (; offset + header.blockSize <= size; offset += header.blockSize) {
+        if (!f.seek(offset) || f.read(scratch, header.blockSize) != header.blockSize) break;
+        if (!logCheckBlock(scratch, header.blockSize)) continue;
+        const LogBlockHeader* bh = (const LogBlockHeader*)scratch;
+        LogIndexEntry entry = { offset, bh->firstTimestamp, bh->lastTimestamp };
+        entries.push_back(entry);
+        result.records += bh->recordCount;
+    }
+    f.close();
+
+    // The index goes after whatever is at the end of the file; readers locate it via the footer
+    if (!f.open(path, STORAGE_APPEND)) return false;
+    logInitFooter(footer, entries.data(), entries.size(), size, result.records);
+    if (!entries.empty()) {
+        f.write((const uint8_t*)entries.data(), entries.size() * sizeof(LogIndexEntry));
+    }
+    f.write((const uint8_t*)&footer, sizeof(footer));
+    f.close();
+
+    result.repaired = true;
+    result.blocks = entries.size();
+    return true;
+}
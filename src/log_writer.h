@@ -0,0 +1,90 @@
+#ifndef LOG_WRITER_H
+#define LOG_WRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "log_format.h"
+#include "platform_io.h"
+
+// ==============================================
+// LOG FILE WRITER (FORMAT V2)
+// ==============================================
+// The storage-facing half of the logger, split out of SdLogger so it can run
+// against any StorageFile. LogBlockBuilder fills one block in memory,
+// LogWriter lays sealed blocks out in a file and appends the index and footer
+// on finish(), and logRepair() rebuilds the index of a file cut off by a
+// power loss. SdLogger adds the block pool and the writer task on top.
+
+#define LOG_MAX_BLOCK_SIZE      16384   // Largest block logRepair() can scan
+
+// Appends records to a caller-owned block buffer
+class LogBlockBuilder {
+public:
+    LogBlockBuilder();
+
+    // Start filling `block` (blockSize bytes). Any previous block is abandoned.
+    void begin(uint8_t* block, uint32_t blockSize, uint8_t encoding);
+    bool isActive() const { return block != nullptr; }
+
+    // Copy a record in. Returns false when it does not fit in the remaining space.
+    bool add(const void* data, size_t length, uint32_t timestamp);
+
+    uint32_t space() const;
+    bool isFull() const { return isActive() && space() == 0; }
+    uint16_t records() const { return header.recordCount; }
+
+    // Fill the header, CRCs and padding and detach from the buffer. Returns the record count.
+    uint16_t seal(uint32_t sequence, uint32_t firstRecord);
+
+private:
+    uint8_t* block;
+    uint32_t blockSize;
+    LogBlockHeader header;
+};
+
+class LogWriter {
+public:
+    LogWriter();
+
+    // Create `path` and write the file header sector
+    bool open(StorageFile* storage, const char* path, const LogFileHeader& header);
+    bool isOpen() const { return file != nullptr; }
+
+    // Append one sealed block. On a short write the records are lost and false
+    // is returned; the file skips to the next block boundary so later blocks
+    // stay on the fixed stride, and when even that fails the writer stops
+    // appending (isFailed()) until finish().
+    bool writeBlock(const uint8_t* block, uint32_t length, uint16_t records);
+    bool isFailed() const { return failed; }
+
+    void flush();
+
+    // Write the index and footer, then close the file
+    void finish();
+
+    uint32_t getOffset() const { return offset; }
+    uint32_t getRecords() const { return records; }
+    uint32_t getBlocks() const { return index.size(); }
+
+private:
+    StorageFile* file;
+    uint32_t offset;
+    uint32_t records;
+    bool failed;
+    std::vector<LogIndexEntry> index;
+};
+
+struct LogRepairResult {
+    bool repaired;          // False when the footer was already intact
+    uint32_t blocks;
+    uint32_t records;
+};
+
+// Rebuild the index/footer of a v2 log that lacks one. `scratch` must hold one
+// block. Blocks that fail validation (a torn write) are skipped, not indexed.
+// Returns false for files that are not v2 logs or could not be rewritten.
+bool logRepair(StorageFile& file, const char* path, uint8_t* scratch, uint32_t scratchSize,
+               LogRepairResult& result);
+
+#endif // LOG_WRITER_H
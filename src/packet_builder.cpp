@@ -0,0 +1,132 @@
+#include "packet_builder.h"
+#include <string.h>
+#include "crc16.h"
+
+void gpsDataFromNavPvt(const UbxNavPvt& pvt, GPSData& gps) {
+    uint32_t timestamp = ubxUnixEpoch(pvt);
+    if (timestamp > 0 && timestamp < 4000000000UL) {  // Reasonable timestamp range
+        gps.timestamp = timestamp;
+    }
+    
+    // Native units straight through - no float round trip on the hot path
+    if (pvt.lat >= -900000000 && pvt.lat <= 900000000) {
+        gps.latitude = pvt.lat;
+    }
+    
+    if (pvt.lon >= -1800000000 && pvt.lon <= 1800000000) {
+        gps.longitude = pvt.lon;
+    }
+    
+    if (pvt.height >= -1000000 && pvt.height <= 10000000) {   // -1 km to 10 km
+        gps.altitude = pvt.height;
+    }
+    
+    if (pvt.gSpeed >= 0 && pvt.gSpeed <= 138889) {            // 500 km/h
+        gps.speed = pvt.gSpeed;
+    }
+    
+    if (pvt.headMot >= 0 && pvt.headMot <= 36000000) {
+        gps.heading = pvt.headMot;
+    }
+    
+    if (pvt.fixType <= 5) {
+        gps.fixType = pvt.fixType;
+    }
+    
+    if (pvt.numSV <= 50) {
+        gps.satellites = pvt.numSV;
+    }
+    
+    if (pvt.year >= 2000 && pvt.year <= 2100) {
+        gps.year = pvt.year;
+    }
+    
+    if (pvt.month >= 1 && pvt.month <= 12) {
+        gps.month = pvt.month;
+    }
+    
+    if (pvt.day >= 1 && pvt.day <= 31) {
+        gps.day = pvt.day;
+    }
+    
+    if (pvt.hour <= 23) {
+        gps.hour = pvt.hour;
+    }
+    
+    if (pvt.min <= 59) {
+        gps.minute = pvt.min;
+    }
+    
+    if (pvt.sec <= 59) {
+        gps.second = pvt.sec;
+    }
+}
+
+void gpsDataFromPacket(const GPSPacket& packet, GPSData& gps) {
+    gps.timestamp = packet.timestamp;
+    gps.latitude = packet.latitude;
+    gps.longitude = packet.longitude;
+    gps.altitude = packet.altitude;
+    gps.speed = packet.speed;
+    gps.heading = (int32_t)packet.heading;
+    gps.fixType = packet.fixType;
+    gps.satellites = packet.satellites;
+    
+    // Civil date from days since 1970-01-01 (proleptic Gregorian, era-based)
+    uint32_t secondOfDay = packet.timestamp % 86400;
+    int32_t days = (int32_t)(packet.timestamp / 86400) + 719468;
+    int32_t era = days / 146097;
+    uint32_t dayOfEra = (uint32_t)(days - era * 146097);
+    uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    uint32_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    uint32_t mp = (5 * dayOfYear + 2) / 153;
+    uint32_t month = mp < 10 ? mp + 3 : mp - 9;
+    
+    gps.year = (uint16_t)(yearOfEra + era * 400 + (month <= 2 ? 1 : 0));
+    gps.month = (uint8_t)month;
+    gps.day = (uint8_t)(dayOfYear - (153 * mp + 2) / 5 + 1);
+    gps.hour = secondOfDay / 3600;
+    gps.minute = (secondOfDay / 60) % 60;
+    gps.second = secondOfDay % 60;
+}
+
+void buildPacket(const GPSData& gps, const IMUData* imu, const PacketPower& power, GPSPacket& packet) {
+    memset(&packet, 0, sizeof(packet));  // Initialize all fields to zero
+    
+    packet.timestamp = gps.timestamp;
+    
+    // gps is range-checked at ingest and already in packet units
+    packet.latitude = gps.latitude;
+    packet.longitude = gps.longitude;
+    packet.altitude = gps.altitude;
+    packet.speed = gps.speed > 65535 ? 65535 : (uint16_t)gps.speed;  // Field saturates at ~236 km/h
+    packet.heading = (uint32_t)gps.heading;
+    
+    packet.fixType = gps.fixType;
+    packet.satellites = gps.satellites;
+    
+    packet.battery_mv = power.batteryMv;
+    packet.battery_pct = power.batteryPct;
+    packet.pmu_status = power.pmuStatus;
+    
+    // Safe IMU data with bounds checking
+    if (imu) {
+        if (imu->accelX >= -50 && imu->accelX <= 50) {
+            packet.accel_x = (int16_t)(imu->accelX * 1000);
+        }
+        if (imu->accelY >= -50 && imu->accelY <= 50) {
+            packet.accel_y = (int16_t)(imu->accelY * 1000);
+        }
+        if (imu->accelZ >= -50 && imu->accelZ <= 50) {
+            packet.accel_z = (int16_t)(imu->accelZ * 1000);
+        }
+        if (imu->gyroX >= -2000 && imu->gyroX <= 2000) {
+            packet.gyro_x = (int16_t)(imu->gyroX * 100);
+        }
+        if (imu->gyroY >= -2000 && imu->gyroY <= 2000) {
+            packet.gyro_y = (int16_t)(imu->gyroY * 100);
+        }
+    }
+    
+    packet.crc = crc16((uint8_t*)&packet, sizeof(GPSPacket) - 2);
+}
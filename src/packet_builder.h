@@ -0,0 +1,33 @@
+#ifndef PACKET_BUILDER_H
+#define PACKET_BUILDER_H
+
+#include <stdint.h>
+#include "gps_packet.h"
+#include "sensor_data.h"
+#include "ubx_parser.h"
+
+// ==============================================
+// PACKET LAYER
+// ==============================================
+// NAV-PVT -> GPSData -> GPSPacket, the same on the board and on the host.
+// Values are validated once on the way in; packet building is a copy plus
+// the IMU scaling and the CRC.
+
+// Battery/PMU fields of the packet, already range-checked by the caller
+struct PacketPower {
+    uint16_t batteryMv;
+    uint8_t batteryPct;
+    uint8_t pmuStatus;          // bit0 charging, bit1 USB, bit2 battery connected
+};
+
+// Copy a NAV-PVT into gps. Fields outside their valid range keep the previous value.
+void gpsDataFromNavPvt(const UbxNavPvt& pvt, GPSData& gps);
+
+// Inverse of buildPacket() for the GNSS fields, used when a log is replayed.
+// The calendar fields are derived from the packet's UTC timestamp.
+void gpsDataFromPacket(const GPSPacket& packet, GPSData& gps);
+
+// Fill every packet field and the CRC. imu may be null (IMU fields stay zero).
+void buildPacket(const GPSData& gps, const IMUData* imu, const PacketPower& power, GPSPacket& packet);
+
+#endif // PACKET_BUILDER_H
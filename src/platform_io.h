@@ -0,0 +1,69 @@
+#ifndef PLATFORM_IO_H
+#define PLATFORM_IO_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ==============================================
+// PLATFORM I/O INTERFACES
+// ==============================================
+// The thin seams between the data path and the hardware. The packet, log,
+// file-transfer and command layers only talk to these, so the same code runs
+// against SD/UART/BLE/UDP/NVS on the board (sd_storage.h and the adapters in
+// gpscode.cpp) and against file-backed and loopback stand-ins on the host
+// (host/host_io.h). Implementations own no heap and never throw.
+
+enum StorageMode : uint8_t {
+    STORAGE_READ,
+    STORAGE_WRITE,      // Create or truncate
+    STORAGE_APPEND
+};
+
+// One open file on the log storage (SD card on the board)
+class StorageFile {
+public:
+    virtual ~StorageFile() {}
+
+    virtual bool open(const char* path, StorageMode mode) = 0;
+    virtual bool isOpen() const = 0;
+    virtual void close() = 0;
+
+    virtual size_t read(uint8_t* buffer, size_t length) = 0;
+    virtual size_t write(const uint8_t* data, size_t length) = 0;
+    virtual bool seek(uint32_t position) = 0;
+    virtual uint32_t position() = 0;
+    virtual uint32_t size() = 0;
+    virtual void flush() = 0;
+};
+
+// Byte stream (GNSS UART on the board)
+class ByteStream {
+public:
+    virtual ~ByteStream() {}
+
+    virtual size_t available() = 0;
+    virtual size_t read(uint8_t* buffer, size_t length) = 0;
+    virtual size_t write(const uint8_t* data, size_t length) = 0;
+};
+
+// Datagram link (BLE notifications, UDP). Payloads larger than maxPayload() are refused.
+class PacketLink {
+public:
+    virtual ~PacketLink() {}
+
+    virtual bool isReady() = 0;
+    virtual size_t maxPayload() = 0;
+    virtual bool send(const uint8_t* data, size_t length) = 0;
+};
+
+// Small persistent key/value store (NVS on the board)
+class ConfigStore {
+public:
+    virtual ~ConfigStore() {}
+    // Bytes stored under key, 0 when missing or larger than size
+    virtual size_t read(const char* key, uint8_t* buffer, size_t size) = 0;
+    virtual bool write(const char* key, const uint8_t* data, size_t length) = 0;
+    virtual bool erase(const char* key) = 0;
+};
+
+#endif // PLATFORM_IO_H
@@ -0,0 +1,146 @@
+#include "rate_control.h"
+#include "crc16.h"
+#include <string.h>
+
+#define HEADING_FULL_TURN   36000000L       // deg * 1e5
+
+// Rounded to nearest, halves away from zero
+static int64_t roundedMean(int64_t sum, uint32_t count) {
+    return sum >= 0 ? (sum + count / 2) / count : -((-sum + count / 2) / count);
+}
+
+RateDecimator::RateDecimator() :
+    rateHz(0),
+    filter(RATE_FILTER_AVERAGE),
+    periodUs(0),
+    passThrough(true),
+    nextDueUs(0),
+    lastUs(0),
+    started(false),
+    count(0)
+{
+    memset(&base, 0, sizeof(base));
+    memset(&newest, 0, sizeof(newest));
+}
+
+void RateDecimator::configure(uint16_t hz, RateFilter newFilter, uint16_t inputHz) {
+    rateHz = hz > RATE_MAX_HZ ? RATE_MAX_HZ : hz;
+    filter = newFilter;
+    periodUs = rateHz ? 1000000UL / rateHz : 0;
+    passThrough = rateHz == 0 || (inputHz > 0 && rateHz >= inputHz);
+    started = false;
+    count = 0;
+}
+
+void RateDecimator::accumulate(const GPSPacket& p) {
+    if (count == 0) {
+        base = p;
+        sumLatitude = sumLongitude = sumAltitude = sumHeading = 0;
+        sumSpeed = sumBatteryMv = 0;
+        memset(sumAccel, 0, sizeof(sumAccel));
+        memset(sumGyro, 0, sizeof(sumGyro));
+    }
+    sumLatitude += (int64_t)p.latitude - base.latitude;
+    sumLongitude += (int64_t)p.longitude - base.longitude;
+    sumAltitude += (int64_t)p.altitude - base.altitude;
+    int32_t turn = (int32_t)(p.heading % HEADING_FULL_TURN) - (int32_t)(base.heading % HEADING_FULL_TURN);
+    if (turn >= HEADING_FULL_TURN / 2) turn -= HEADING_FULL_TURN;
+    if (turn < -HEADING_FULL_TURN / 2) turn += HEADING_FULL_TURN;
+    sumHeading += turn;
+    sumSpeed += p.speed;
+    sumBatteryMv += p.battery_mv;
+    sumAccel[0] += p.accel_x;
+    sumAccel[1] += p.accel_y;
+    sumAccel[2] += p.accel_z;
+    sumGyro[0] += p.gyro_x;
+    sumGyro[1] += p.gyro_y;
+    count++;
+}
+
+void RateDecimator::average(GPSPacket& out) const {
+    out = newest;
+    out.latitude = (int32_t)(base.latitude + roundedMean(sumLatitude, count));
+    out.longitude = (int32_t)(base.longitude + roundedMean(sumLongitude, count));
+    out.altitude = (int32_t)(base.altitude + roundedMean(sumAltitude, count));
+    int64_t heading = (int64_t)(base.heading % HEADING_FULL_TURN) + roundedMean(sumHeading, count);
+    out.heading = (uint32_t)((heading + HEADING_FULL_TURN) % HEADING_FULL_TURN);
+    out.speed = (uint16_t)roundedMean(sumSpeed, count);
+    out.battery_mv = (uint16_t)roundedMean(sumBatteryMv, count);
+    out.accel_x = (int16_t)roundedMean(sumAccel[0], count);
+    out.accel_y = (int16_t)roundedMean(sumAccel[1], count);
+    out.accel_z = (int16_t)roundedMean(sumAccel[2], count);
+    out.gyro_x = (int16_t)roundedMean(sumGyro[0], count);
+    out.gyro_y = (int16_t)roundedMean(sumGyro[1], count);
+    out.crc = crc16((const uint8_t*)&out, sizeof(GPSPacket) - 2);
+}
+
+// Close the window: its filtered output, or its newest sample as is
+void RateDecimator::emit(GPSPacket& out) {
+    if (filter == RATE_FILTER_AVERAGE && count > 1) {
+        average(out);
+    } else {
+        out = newest;
+    }
+    if (count > stats.maxWindow) stats.maxWindow = count;
+    stats.out++;
+    count = 0;
+}
+
+bool RateDecimator::push(const GPSPacket& packet, int64_t timeUs, GPSPacket& out) {
+    stats.in++;
+    if (passThrough) {
+        out = packet;
+        stats.out++;
+        return true;
+    }
+
+    int64_t interval = started ? timeUs - lastUs : 0;
+    lastUs = timeUs;
+    bool late = false;
+    if (started && interval > (int64_t)periodUs) {
+        // The slot passed with nobody to emit it; don't smear the gap into one
+        // average. A pending window goes out now, this sample opens the next.
+        stats.resyncs++;
+        late = count > 0;
+        if (late) {
+            emit(out);
+            stats.late++;
+        }
+        nextDueUs = late ? timeUs + periodUs : timeUs;
+    }
+    if (filter == RATE_FILTER_AVERAGE) {
+        accumulate(packet);
+    } else {
+        count++;
+    }
+    newest = packet;
+    if (late) return true;
+
+    if (!started) {
+        started = true;
+        nextDueUs = timeUs;
+    }
+    // The sample nearest the slot boundary closes the window, so ingest jitter
+    // never slips a slot
+    int64_t slack = interval < (int64_t)periodUs ? interval / 2 : periodUs / 2;
+    if (timeUs + slack <= nextDueUs && timeUs < nextDueUs) return false;
+    nextDueUs += periodUs;
+    if (nextDueUs <= timeUs) nextDueUs = timeUs + periodUs;
+    emit(out);
+    return true;
+}
+
+bool rateFilterParse(const char* text, RateFilter& filter) {
+    if (strcmp(text, "AVG") == 0) {
+        filter = RATE_FILTER_AVERAGE;
+    } else if (strcmp(text, "LAST") == 0) {
+        filter = RATE_FILTER_LATEST;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* rateFilterName(RateFilter filter) {
+    return filter == RATE_FILTER_LATEST ? "LAST" : "AVG";
+}
@@ -0,0 +1,87 @@
+#ifndef RATE_CONTROL_H
+#define RATE_CONTROL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "gps_packet.h"
+
+// ==============================================
+// PER-CONSUMER RATE CONTROL
+// ==============================================
+// Brings the bus sample rate down to what one consumer asked for. Every
+// input sample is used: RATE_FILTER_AVERAGE emits the boxcar mean of the
+// samples since the previous output (position, altitude, speed, heading on
+// the circle, IMU, battery voltage), which is the anti-alias filter the
+// decimation needs. State fields (fixType, satellites, battery_pct,
+// pmu_status, timestamp) come from the newest sample. RATE_FILTER_LATEST emits
+// the newest sample unchanged, for consumers that want real fixes.
+//
+// Output slots follow the ingest clock, so at 25 Hz in and 10 Hz out the
+// windows alternate 3 and 2 samples and average exactly 10 Hz. Rate 0 or a
+// rate at or above the nominal input rate passes every sample through
+// unchanged. After an input gap longer than a period, the window the gap
+// interrupted is emitted as it stands and the next one starts with the
+// sample after the gap, so the gap is never smeared into one average.
+
+#define RATE_MAX_HZ             1000
+
+enum RateFilter : uint8_t {
+    RATE_FILTER_AVERAGE = 0,
+    RATE_FILTER_LATEST
+};
+
+struct RateControlStats {
+    uint32_t in = 0;
+    uint32_t out = 0;
+    uint32_t maxWindow = 0;         // Most samples folded into one output
+    uint32_t resyncs = 0;           // Input gaps longer than a period restarted the window
+    uint32_t late = 0;              // Windows a gap interrupted, emitted when it ended
+};
+
+class RateDecimator {
+public:
+    RateDecimator();
+
+    // Takes effect with the next sample; a pending window is discarded.
+    // inputHz is the nominal bus rate (0 = unknown: only rate 0 passes through).
+    void configure(uint16_t rateHz, RateFilter filter, uint16_t inputHz);
+    uint16_t getRate() const { return rateHz; }
+    RateFilter getFilter() const { return filter; }
+
+    // Feed one bus sample (timeUs on any monotonic clock). Returns true when
+    // an output is due: `out` then holds the filtered packet, with its CRC
+    // recomputed when it was averaged. The output belongs to this input's time
+    // and sequence (after a gap: it is the window the gap interrupted).
+    bool push(const GPSPacket& packet, int64_t timeUs, GPSPacket& out);
+
+    const RateControlStats& getStats() const { return stats; }
+    void resetStats() { stats = RateControlStats(); }
+
+private:
+    uint16_t rateHz;
+    RateFilter filter;
+    uint32_t periodUs;
+    bool passThrough;
+    int64_t nextDueUs;
+    int64_t lastUs;
+    bool started;
+
+    // Boxcar window, relative to its first sample so nothing overflows
+    uint32_t count;
+    GPSPacket base;
+    GPSPacket newest;
+    int64_t sumLatitude, sumLongitude, sumAltitude, sumHeading;
+    int64_t sumSpeed, sumBatteryMv;
+    int64_t sumAccel[3], sumGyro[2];
+    RateControlStats stats;
+
+    void accumulate(const GPSPacket& packet);
+    void average(GPSPacket& out) const;
+    void emit(GPSPacket& out);
+};
+
+// "AVG"/"LAST"; returns false on anything else
+bool rateFilterParse(const char* text, RateFilter& filter);
+const char* rateFilterName(RateFilter filter);
+
+#endif // RATE_CONTROL_H
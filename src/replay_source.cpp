@@ -0,0 +1,244 @@
+#include "replay_source.h"
+#include <string.h>
+
+ReplaySource::ReplaySource(ReplayClock clock) :
+    clock(clock),
+    file(nullptr),
+    format(REPLAY_FORMAT_NONE),
+    speed(1),
+    buffer(nullptr),
+    bufferSize(0),
+    blockIndex(0),
+    blockEnd(0),
+    recordsLeft(0),
+    payloadOffset(0),
+    payloadLength(0),
+    lastTimestamp(0),
+    sameSecond(0),
+    chunkLength(0),
+    chunkOffset(0),
+    lastItow(0),
+    weekOffsetUs(0),
+    pacer(clock),
+    pending(false)
+{
+    memset(&header, 0, sizeof(header));
+    memset(&next, 0, sizeof(next));
+}
+
+bool ReplaySource::open(StorageFile* storage, const char* path, uint16_t replaySpeed,
+                        uint8_t* work, uint32_t workSize) {
+    close();
+    if (!storage->open(path, STORAGE_READ)) return false;
+
+    uint8_t probe[sizeof(LogFileHeader)];
+    size_t n = storage->read(probe, sizeof(probe));
+    if (n == sizeof(LogFileHeader) && logCheckFileHeader(*(const LogFileHeader*)probe)) {
+        memcpy(&header, probe, sizeof(header));
+        bool knownRecords = header.encoding == LOG_ENCODING_DELTA ||
+                            (header.encoding == LOG_ENCODING_RAW && header.recordSize == sizeof(GPSPacket));
+        if (!knownRecords || header.blockSize > workSize) {
+            storage->close();
+            return false;
+        }
+        format = REPLAY_FORMAT_LOG;
+        blockEnd = storage->size();
+        LogFooter footer;
+        if (blockEnd >= LOG_FILE_HEADER_SIZE + sizeof(footer) && storage->seek(blockEnd - sizeof(footer)) &&
+            storage->read((uint8_t*)&footer, sizeof(footer)) == sizeof(footer) &&
+            logCheckFooter(footer) && footer.indexOffset <= blockEnd) {
+            blockEnd = footer.indexOffset;
+        }
+    } else if (n >= 2 && probe[0] == UBX_SYNC_CHAR_1 && probe[1] == UBX_SYNC_CHAR_2) {
+        if (workSize < REPLAY_UBX_CHUNK) {
+            storage->close();
+            return false;
+        }
+        format = REPLAY_FORMAT_UBX;
+        storage->seek(0);
+    } else {
+        storage->close();
+        return false;
+    }
+
+    file = storage;
+    speed = replaySpeed;
+    buffer = work;
+    bufferSize = workSize;
+    blockIndex = 0;
+    recordsLeft = 0;
+    lastTimestamp = 0;
+    sameSecond = 0;
+    parser.reset();
+    chunkLength = 0;
+    chunkOffset = 0;
+    lastItow = 0;
+    weekOffsetUs = 0;
+    pending = false;
+    pacer.start(replaySpeed);
+    stats = ReplayStats();
+    return true;
+}
+
+void ReplaySource::close() {
+    if (file) file->close();
+    file = nullptr;
+    format = REPLAY_FORMAT_NONE;
+}
+
+bool ReplaySource::loadBlock() {
+    // Blocks are fixed stride up to the index; a torn one is skipped, the next still lines up
+    for (;;) {
+        uint32_t offset = logBlockOffset(header.blockSize, blockIndex);
+        if (offset + header.blockSize > blockEnd) return false;
+        if (!file->seek(offset) || file->read(buffer, header.blockSize) != header.blockSize) return false;
+        blockIndex++;
+        if (logCheckBlock(buffer, header.blockSize)) break;
+        stats.tornBlocks++;
+    }
+    const LogBlockHeader* bh = (const LogBlockHeader*)buffer;
+    recordsLeft = bh->recordCount;
+    payloadOffset = sizeof(LogBlockHeader);
+    payloadLength = sizeof(LogBlockHeader) + bh->payloadLength;
+    decoder.reset();    // Every block opens with a keyframe
+    stats.blocks++;
+    stats.bytesRead += header.blockSize;
+    return true;
+}
+
+bool ReplaySource::nextLogRecord(ReplayRecord& out) {
+    for (;;) {
+        while (recordsLeft == 0) {
+            if (!loadBlock()) return false;
+        }
+
+        const uint8_t* data = buffer + payloadOffset;
+        size_t available = payloadLength - payloadOffset;
+        size_t consumed = 0;
+        if (header.encoding == LOG_ENCODING_RAW) {
+            if (available < sizeof(GPSPacket)) {
+                recordsLeft = 0;
+                stats.decodeErrors++;
+                continue;
+            }
+            memcpy(&out.packet, data, sizeof(GPSPacket));
+            consumed = sizeof(GPSPacket);
+        } else {
+            DeltaDecoder::Result result = decoder.decode(data, available, out.packet, &consumed);
+            if (result == DeltaDecoder::DECODE_ERROR) {
+                recordsLeft = 0;    // Resync at the next block's keyframe
+                stats.decodeErrors++;
+                continue;
+            }
+            if (result == DeltaDecoder::DECODE_SKIPPED) {
+                payloadOffset += consumed;
+                recordsLeft--;
+                continue;
+            }
+        }
+        payloadOffset += consumed;
+        recordsLeft--;
+
+        if (out.packet.timestamp == lastTimestamp) {
+            sameSecond++;
+        } else {
+            lastTimestamp = out.packet.timestamp;
+            sameSecond = 0;
+        }
+        out.format = REPLAY_FORMAT_LOG;
+        out.mediaUs = (int64_t)out.packet.timestamp * 1000000 + (int64_t)sameSecond * (1000000 / REPLAY_LOG_RATE_HZ);
+        return true;
+    }
+}
+
+bool ReplaySource::nextUbxRecord(ReplayRecord& out) {
+    for (;;) {
+        while (chunkOffset < chunkLength) {
+            if (parser.feed(buffer[chunkOffset++])) {
+                out.format = REPLAY_FORMAT_UBX;
+                out.pvt = parser.navPvt();
+                if (out.pvt.iTOW < lastItow) weekOffsetUs += 604800000000LL;
+                lastItow = out.pvt.iTOW;
+                out.mediaUs = weekOffsetUs + (int64_t)out.pvt.iTOW * 1000;
+                return true;
+            }
+        }
+        chunkLength = file->read(buffer, REPLAY_UBX_CHUNK);
+        chunkOffset = 0;
+        if (chunkLength == 0) return false;
+        stats.blocks++;
+        stats.bytesRead += chunkLength;
+    }
+}
+
+bool ReplaySource::read(ReplayRecord& out) {
+    if (!file) return false;
+
+    int64_t readStart = clock();
+    bool ok = format == REPLAY_FORMAT_LOG ? nextLogRecord(out) : nextUbxRecord(out);
+    uint32_t readUs = (uint32_t)(clock() - readStart);
+    stats.totalReadUs += readUs;
+    if (readUs > stats.maxReadUs) stats.maxReadUs = readUs;
+    if (!ok) close();
+    return ok;
+}
+
+ReplayResult ReplaySource::poll(ReplayRecord& out) {
+    if (!pending) {
+        if (!file) return REPLAY_IDLE;
+        if (!read(next)) return REPLAY_END;
+        pending = true;
+    }
+    if (!pacer.release(next)) return REPLAY_WAIT;
+
+    const ReplayStats& paced = pacer.getStats();
+    stats.samples = paced.samples;
+    stats.maxLagUs = paced.maxLagUs;
+    stats.startUs = paced.startUs;
+    stats.lastUs = paced.lastUs;
+    out = next;
+    pending = false;
+    return REPLAY_SAMPLE;
+}
+
+uint32_t ReplaySource::samplesPerSecond() const {
+    return pacer.samplesPerSecond();
+}
+
+ReplayPacer::ReplayPacer(ReplayClock clock) :
+    clock(clock),
+    speed(1),
+    started(false),
+    mediaStartUs(0)
+{
+}
+
+void ReplayPacer::start(uint16_t replaySpeed) {
+    speed = replaySpeed;
+    started = false;
+    mediaStartUs = 0;
+    stats = ReplayStats();
+}
+
+bool ReplayPacer::release(const ReplayRecord& record) {
+    int64_t now = clock();
+    if (!started) {
+        started = true;
+        stats.startUs = now;
+        mediaStartUs = record.mediaUs;
+    }
+    if (speed > 0) {
+        int64_t due = stats.startUs + (record.mediaUs - mediaStartUs) / speed;
+        if (now < due) return false;
+        uint32_t lag = (uint32_t)(now - due);
+        if (lag > stats.maxLagUs) stats.maxLagUs = lag;
+    }
+    stats.samples++;
+    stats.lastUs = now;
+    return true;
+}
+
+uint32_t ReplayPacer::samplesPerSecond() const {
+    int64_t elapsed = stats.lastUs - stats.startUs;
+    return elapsed > 0 ? (uint32_t)((uint64_t)stats.samples * 1000000 / elapsed) : 0;
+}
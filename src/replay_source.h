@@ -0,0 +1,158 @@
+#ifndef REPLAY_SOURCE_H
+#define REPLAY_SOURCE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "platform_io.h"
+#include "gps_packet.h"
+#include "log_format.h"
+#include "delta_codec.h"
+#include "ubx_parser.h"
+
+// ==============================================
+// LOG / UBX CAPTURE REPLAY
+// ==============================================
+// Feeds a recorded v2 log (.bin, RAW or DELTA encoded) or a raw UBX capture
+// back into the ingest path in place of the GNSS receiver. Samples are paced
+// on their recorded time line: speed 1 is real time, N is N times faster and
+// 0 releases every sample as soon as it is asked for, which is how the
+// pipeline's saturation point is found.
+//
+// Log records only carry whole seconds, so records sharing a second are
+// spread REPLAY_LOG_RATE_HZ apart. UBX captures are paced on NAV-PVT iTOW.
+// Storage is read one block (log) or one chunk (UBX) at a time into a caller
+// supplied buffer, so the per-sample cost is a decode, not a card access.
+//
+// Reading and pacing are separate: read() decodes the next record and
+// ReplayPacer decides when it is due, so the card can be read by the task
+// that owns it while another task releases the records on time. poll() does
+// both in one place.
+
+#define REPLAY_LOG_RATE_HZ      25      // Nominal record rate assumed for logs
+#define REPLAY_UBX_CHUNK        512     // Capture bytes read per refill
+
+enum ReplayFormat : uint8_t {
+    REPLAY_FORMAT_NONE,         // Also marks the end of a replay when records are queued
+    REPLAY_FORMAT_LOG,          // v2 log: GPSPacket records
+    REPLAY_FORMAT_UBX           // Raw receiver output: NAV-PVT frames
+};
+
+enum ReplayResult : uint8_t {
+    REPLAY_IDLE,                // Nothing open
+    REPLAY_WAIT,                // Next sample is not due yet
+    REPLAY_SAMPLE,              // `out` holds the next sample
+    REPLAY_END                  // File exhausted (or unreadable) - replay closed
+};
+
+struct ReplayRecord {
+    ReplayFormat format;
+    int64_t mediaUs;            // Position on the recording's time line
+    GPSPacket packet;           // REPLAY_FORMAT_LOG
+    UbxNavPvt pvt;              // REPLAY_FORMAT_UBX
+};
+
+struct ReplayStats {
+    uint32_t samples = 0;
+    uint32_t blocks = 0;        // Log blocks (or UBX chunks) read
+    uint32_t decodeErrors = 0;  // Malformed records - rest of the block skipped
+    uint32_t tornBlocks = 0;    // Log blocks that failed validation - skipped
+    uint64_t bytesRead = 0;
+    uint32_t maxReadUs = 0;     // Slowest storage read + decode of one sample
+    uint64_t totalReadUs = 0;
+    uint32_t maxLagUs = 0;      // Latest a sample was taken after it was due
+    int64_t startUs = 0;        // First sample released
+    int64_t lastUs = 0;         // Most recent sample released
+};
+
+// Monotonic microsecond clock (esp_timer_get_time on the board)
+typedef int64_t (*ReplayClock)();
+
+// Releases records on their recorded time line. Fills the pacing fields of
+// ReplayStats (samples, maxLagUs, startUs, lastUs).
+class ReplayPacer {
+public:
+    explicit ReplayPacer(ReplayClock clock);
+
+    void start(uint16_t replaySpeed);
+
+    // True when `record` is due; it then counts as released
+    bool release(const ReplayRecord& record);
+
+    uint16_t getSpeed() const { return speed; }
+    const ReplayStats& getStats() const { return stats; }
+
+    // Samples released per second of wall time since the first one
+    uint32_t samplesPerSecond() const;
+
+private:
+    ReplayClock clock;
+    uint16_t speed;
+    bool started;
+    int64_t mediaStartUs;
+    ReplayStats stats;
+};
+
+class ReplaySource {
+public:
+    explicit ReplaySource(ReplayClock clock);
+
+    // Detect the format of `path` and start replaying it. `buffer` must hold one
+    // log block (LOG_MAX_BLOCK_SIZE covers every log this firmware writes).
+    bool open(StorageFile* storage, const char* path, uint16_t speed, uint8_t* buffer, uint32_t bufferSize);
+    void close();
+    bool isActive() const { return file != nullptr; }
+
+    // Decode the next record, due or not. False at the end of the file (or
+    // on a read error), which also closes the replay.
+    bool read(ReplayRecord& out);
+
+    // Release the next sample once it is due (read() plus pacing)
+    ReplayResult poll(ReplayRecord& out);
+
+    ReplayFormat getFormat() const { return format; }
+    uint16_t getSpeed() const { return speed; }
+    const ReplayStats& getStats() const { return stats; }
+    const UbxParserStats& getParserStats() const { return parser.getStats(); }
+
+    // Samples released per second of wall time since the first one
+    uint32_t samplesPerSecond() const;
+
+private:
+    ReplayClock clock;
+    StorageFile* file;
+    ReplayFormat format;
+    uint16_t speed;
+    uint8_t* buffer;
+    uint32_t bufferSize;
+
+    // Log state
+    LogFileHeader header;
+    uint32_t blockIndex;        // Next block to load
+    uint32_t blockEnd;          // Blocks end here: the index, or the end of a log without one
+    uint16_t recordsLeft;       // Records still to decode in the loaded block
+    uint32_t payloadOffset;
+    uint32_t payloadLength;
+    DeltaDecoder decoder;
+    uint32_t lastTimestamp;
+    uint32_t sameSecond;        // Records already seen with lastTimestamp
+
+    // UBX state
+    UbxParser parser;
+    uint32_t chunkLength;
+    uint32_t chunkOffset;
+    uint32_t lastItow;
+    int64_t weekOffsetUs;       // Added when iTOW wraps at the end of a GPS week
+
+    // Pacing
+    ReplayPacer pacer;
+    bool pending;
+    ReplayRecord next;
+
+    ReplayStats stats;
+
+    bool loadBlock();
+    bool nextLogRecord(ReplayRecord& out);
+    bool nextUbxRecord(ReplayRecord& out);
+};
+
+#endif // REPLAY_SOURCE_H
@@ -0,0 +1,209 @@
+#include "report_policy.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CM_PER_E7_DEGREE    1.1131949f      // 1e-7 degree of latitude (WGS84 mean)
+#define HEADING_FULL_TURN   36000000UL      // deg * 1e5
+
+static const char* fieldNames[REPORT_FIELD_COUNT] = {
+    "pos", "alt", "spd", "hdg", "acc", "gyr", "sat"
+};
+
+const char* reportFieldName(ReportField field) {
+    return field < REPORT_FIELD_COUNT ? fieldNames[field] : "?";
+}
+
+static uint32_t absDiff(int32_t a, int32_t b) {
+    return a > b ? (uint32_t)((int64_t)a - b) : (uint32_t)((int64_t)b - a);
+}
+
+ReportPolicy::ReportPolicy() :
+    referenceMs(0),
+    haveReference(false)
+{
+    memset(&reference, 0, sizeof(reference));
+}
+
+void ReportPolicy::configure(const ReportPolicyConfig& newConfig) {
+    config = newConfig;
+    haveReference = false;
+}
+
+uint32_t ReportPolicy::deviation(ReportField field, const GPSPacket& ref, const GPSPacket& p) {
+    switch (field) {
+        case REPORT_FIELD_POSITION: {
+            // Equirectangular: exact enough over a dead-band's worth of metres
+            float north = (float)((int64_t)p.latitude - ref.latitude) * CM_PER_E7_DEGREE;
+            float east = (float)((int64_t)p.longitude - ref.longitude) * CM_PER_E7_DEGREE *
+                         cosf(ref.latitude * (float)(M_PI / 180.0 / 1e7));
+            return (uint32_t)sqrtf(north * north + east * east);
+        }
+        case REPORT_FIELD_ALTITUDE:
+            return absDiff(p.altitude, ref.altitude) / 10;
+        case REPORT_FIELD_SPEED:
+            return absDiff(p.speed, ref.speed);
+        case REPORT_FIELD_HEADING: {
+            uint32_t diff = absDiff((int32_t)(p.heading % HEADING_FULL_TURN), (int32_t)(ref.heading % HEADING_FULL_TURN));
+            if (diff > HEADING_FULL_TURN / 2) diff = HEADING_FULL_TURN - diff;
+            return diff / 1000;
+        }
+        case REPORT_FIELD_ACCEL: {
+            uint32_t x = absDiff(p.accel_x, ref.accel_x);
+            uint32_t y = absDiff(p.accel_y, ref.accel_y);
+            uint32_t z = absDiff(p.accel_z, ref.accel_z);
+            return x > y ? (x > z ? x : z) : (y > z ? y : z);
+        }
+        case REPORT_FIELD_GYRO: {
+            uint32_t x = absDiff(p.gyro_x, ref.gyro_x);
+            uint32_t y = absDiff(p.gyro_y, ref.gyro_y);
+            return x > y ? x : y;
+        }
+        case REPORT_FIELD_SATELLITES:
+            return absDiff(p.satellites, ref.satellites);
+        default:
+            return 0;
+    }
+}
+
+bool ReportPolicy::offer(const GPSPacket& packet, uint32_t nowMs) {
+    stats.offered++;
+    if (!config.enabled) {
+        stats.sent++;
+        return true;
+    }
+
+    bool send = false;
+    uint32_t errors[REPORT_FIELD_COUNT] = { 0 };
+    if (!haveReference) {
+        stats.restarts++;
+        send = true;
+    } else {
+        if (packet.fixType != reference.fixType || packet.pmu_status != reference.pmu_status ||
+            packet.battery_pct != reference.battery_pct) {
+            stats.stateChanges++;
+            send = true;
+        }
+        if (config.heartbeatMs > 0 && nowMs - referenceMs >= config.heartbeatMs) {
+            stats.heartbeats++;
+            send = true;
+        }
+        for (int f = 0; f < REPORT_FIELD_COUNT; f++) {
+            if (config.deadband[f] == 0) continue;
+            if (f == REPORT_FIELD_HEADING && packet.speed < REPORT_HEADING_MIN_SPEED_MMS) continue;
+            errors[f] = deviation((ReportField)f, reference, packet);
+            if (errors[f] >= config.deadband[f]) {
+                stats.triggers[f]++;
+                send = true;
+            }
+        }
+    }
+
+    if (!send) {
+        // Held back: the client keeps showing the reference
+        for (int f = 0; f < REPORT_FIELD_COUNT; f++) {
+            if (errors[f] > stats.maxError[f]) stats.maxError[f] = errors[f];
+        }
+        return false;
+    }
+
+    reference = packet;
+    referenceMs = nowMs;
+    haveReference = true;
+    stats.sent++;
+    return true;
+}
+
+float ReportPolicy::reductionRatio() const {
+    return stats.sent ? (float)stats.offered / stats.sent : 1.0f;
+}
+
+StagedReportPolicy::StagedReportPolicy() :
+    begun(0),
+    done(0),
+    taken(0)
+{
+}
+
+void StagedReportPolicy::publish(const ReportPolicyConfig& newConfig) {
+    __atomic_fetch_add(&begun, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    config = newConfig;
+    __atomic_fetch_add(&done, 1, __ATOMIC_RELEASE);
+}
+
+bool StagedReportPolicy::take(ReportPolicyConfig& out) {
+    uint32_t current = __atomic_load_n(&done, __ATOMIC_ACQUIRE);
+    if (current == taken || __atomic_load_n(&begun, __ATOMIC_RELAXED) != current) return false;
+    out = config;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&begun, __ATOMIC_RELAXED) != current) return false;     // Written while copying
+    taken = current;
+    return true;
+}
+
+bool reportPolicyParse(const char* text, ReportPolicyConfig& config) {
+    if (strcmp(text, "OFF") == 0) {
+        config.enabled = false;
+        return true;
+    }
+    if (strcmp(text, "ON") == 0) {
+        config.enabled = true;
+        return true;
+    }
+
+    ReportPolicyConfig parsed = config;
+    const char* p = text;
+    while (*p) {
+        const char* equals = strchr(p, '=');
+        if (!equals) return false;
+        size_t keyLength = equals - p;
+
+        char* end;
+        unsigned long value = strtoul(equals + 1, &end, 10);
+        if (end == equals + 1 || (*end != ',' && *end != '\0')) return false;
+
+        if (keyLength == 2 && memcmp(p, "hb", 2) == 0) {
+            parsed.heartbeatMs = (uint32_t)value;
+        } else {
+            int field = 0;
+            while (field < REPORT_FIELD_COUNT &&
+                   !(strlen(fieldNames[field]) == keyLength && memcmp(p, fieldNames[field], keyLength) == 0)) {
+                field++;
+            }
+            if (field == REPORT_FIELD_COUNT) return false;
+            parsed.deadband[field] = (uint32_t)value;
+        }
+        p = *end == ',' ? end + 1 : end;
+    }
+    parsed.enabled = true;
+    config = parsed;
+    return true;
+}
+
+size_t reportPolicyFormat(const ReportPolicy& policy, char* out, size_t size, bool compact) {
+    if (size == 0) return 0;
+    const ReportPolicyConfig& c = policy.getConfig();
+    const ReportPolicyStats& s = policy.getStats();
+    if (!c.enabled) {
+        return snprintf(out, size, compact ? "OFF" : "off (every sample sent)");
+    }
+
+    int n = compact
+        ? snprintf(out, size, "%lu/%lu/%.1f/%lu/%lu;", (unsigned long)s.sent, (unsigned long)s.offered,
+                   policy.reductionRatio(), (unsigned long)s.stateChanges, (unsigned long)s.heartbeats)
+        : snprintf(out, size, "sent %lu/%lu (%.1fx) state:%lu hb:%lu/%lums err/band", (unsigned long)s.sent,
+                   (unsigned long)s.offered, policy.reductionRatio(), (unsigned long)s.stateChanges,
+                   (unsigned long)s.heartbeats, (unsigned long)c.heartbeatMs);
+    if (n < 0) return 0;
+    size_t length = (size_t)n < size ? (size_t)n : size - 1;
+    for (int f = 0; f < REPORT_FIELD_COUNT && length < size - 1; f++) {
+        if (c.deadband[f] == 0) continue;
+        n = snprintf(out + length, size - length, compact ? "%s=%lu/%lu;" : " %s:%lu/%lu", fieldNames[f],
+                     (unsigned long)s.maxError[f], (unsigned long)c.deadband[f]);
+        if (n < 0) break;
+        length += n;
+    }
+    return length < size ? length : size - 1;
+}
@@ -0,0 +1,136 @@
+#ifndef REPORT_POLICY_H
+#define REPORT_POLICY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "gps_packet.h"
+
+// ==============================================
+// DEAD-BAND / SEND-ON-CHANGE REPORTING
+// ==============================================
+// Per-sink filter in front of a radio link. Each sample is compared with the
+// last one the sink actually sent; it goes out only when a watched field moved
+// past its dead-band, a state field changed (fixType, pmu_status,
+// battery_pct), or the heartbeat is due. A parked logger drops to the
+// heartbeat rate while a moving one keeps its full rate.
+//
+// The client holds the last value it received, so every sample held back is
+// within its dead-bands of what the client shows: the reconstruction error of
+// each watched field is below its dead-band by construction. The stats record
+// the largest deviation actually held back per field so that bound can be
+// checked in the field. Heading is only watched above
+// REPORT_HEADING_MIN_SPEED_MMS, where it means something.
+
+#define REPORT_DEFAULT_POSITION_CM   100    // Horizontal distance
+#define REPORT_DEFAULT_ALTITUDE_CM   200
+#define REPORT_DEFAULT_SPEED_MMS     300    // ~1 km/h
+#define REPORT_DEFAULT_HEADING_CDEG  500    // 5 degrees
+#define REPORT_DEFAULT_ACCEL_MG      100    // Any axis
+#define REPORT_DEFAULT_GYRO_CDPS     1000   // 10 deg/s, any axis
+#define REPORT_DEFAULT_SATELLITES    3
+#define REPORT_DEFAULT_HEARTBEAT_MS  1000   // At least one sample per second
+#define REPORT_HEADING_MIN_SPEED_MMS 500    // Course over ground is noise below this
+#define REPORT_STATS_LINE_SIZE       160    // One reportPolicyFormat() line
+
+enum ReportField : uint8_t {
+    REPORT_FIELD_POSITION = 0,      // cm
+    REPORT_FIELD_ALTITUDE,          // cm
+    REPORT_FIELD_SPEED,             // mm/s
+    REPORT_FIELD_HEADING,           // centidegrees
+    REPORT_FIELD_ACCEL,             // mg
+    REPORT_FIELD_GYRO,              // deg/s * 100
+    REPORT_FIELD_SATELLITES,        // count
+    REPORT_FIELD_COUNT
+};
+
+struct ReportPolicyConfig {
+    bool enabled = false;           // Off = every sample is sent
+    uint32_t deadband[REPORT_FIELD_COUNT] = {
+        REPORT_DEFAULT_POSITION_CM, REPORT_DEFAULT_ALTITUDE_CM, REPORT_DEFAULT_SPEED_MMS,
+        REPORT_DEFAULT_HEADING_CDEG, REPORT_DEFAULT_ACCEL_MG, REPORT_DEFAULT_GYRO_CDPS,
+        REPORT_DEFAULT_SATELLITES
+    };                              // 0 = field not watched
+    uint32_t heartbeatMs = REPORT_DEFAULT_HEARTBEAT_MS;    // 0 = no heartbeat
+};
+
+struct ReportPolicyStats {
+    uint32_t offered = 0;
+    uint32_t sent = 0;
+    uint32_t restarts = 0;          // Sent because there was no reference (first sample, reconfigured)
+    uint32_t stateChanges = 0;
+    uint32_t heartbeats = 0;
+    uint32_t triggers[REPORT_FIELD_COUNT] = { 0 };     // Dead-band exceeded (one sample may trip several)
+    uint32_t maxError[REPORT_FIELD_COUNT] = { 0 };     // Largest deviation held back, field units
+};
+
+class ReportPolicy {
+public:
+    ReportPolicy();
+
+    // Takes effect immediately; the next sample is always sent
+    void configure(const ReportPolicyConfig& config);
+    const ReportPolicyConfig& getConfig() const { return config; }
+    bool isEnabled() const { return config.enabled; }
+
+    // True when the sample must be sent; it then becomes the reference.
+    // nowMs is any wrapping millisecond clock (the sample time).
+    bool offer(const GPSPacket& packet, uint32_t nowMs);
+
+    // Forget the reference, e.g. after a reconnect: the client has nothing to hold
+    void restart() { haveReference = false; }
+
+    const ReportPolicyStats& getStats() const { return stats; }
+    void resetStats() { stats = ReportPolicyStats(); }
+    // Samples offered per sample sent (1.0 = nothing saved)
+    float reductionRatio() const;
+
+    // Deviation of `packet` from `reference` in field units (the dead-band test
+    // and the reconstruction error use the same measure)
+    static uint32_t deviation(ReportField field, const GPSPacket& reference, const GPSPacket& packet);
+
+private:
+    ReportPolicyConfig config;
+    ReportPolicyStats stats;
+    GPSPacket reference;            // Last sample sent
+    uint32_t referenceMs;
+    bool haveReference;
+};
+
+// Hand-off of a ReportPolicyConfig from the command handlers (any task) to the
+// sink task that owns the policy. Like ConfigRegistry's staged values, a
+// writer fills in a whole copy and then bumps the generation; the sink takes
+// it between samples, and only when no write was in progress before or during
+// its copy, so it never configures from a half-written struct. Writers never
+// wait: two racing each other may mix their fields, but the result is still
+// only taken once both are done.
+class StagedReportPolicy {
+public:
+    StagedReportPolicy();
+
+    void publish(const ReportPolicyConfig& newConfig);
+    // The latest published copy, to edit and publish again
+    ReportPolicyConfig staged() const { return config; }
+    uint32_t generation() const { return __atomic_load_n(&done, __ATOMIC_ACQUIRE); }
+
+    // Owning sink: true when a newer complete config was copied into out
+    bool take(ReportPolicyConfig& out);
+
+private:
+    ReportPolicyConfig config;
+    uint32_t begun;                 // Writes started
+    uint32_t done;                  // Writes finished (the generation)
+    uint32_t taken;                 // Generation the sink last took
+};
+
+// Applies "OFF", "ON" or "key=value[,key=value...]" (keys: pos alt spd hdg acc
+// gyr sat hb; a setting also turns the policy on) to config. Returns false,
+// leaving config untouched, on an unknown key or a malformed number.
+bool reportPolicyParse(const char* text, ReportPolicyConfig& config);
+
+// "sent/offered ratio reasons max-error/dead-band per field" (or the compact
+// form used in BLE replies)
+size_t reportPolicyFormat(const ReportPolicy& policy, char* out, size_t size, bool compact);
+
+const char* reportFieldName(ReportField field);
+
+#endif // REPORT_POLICY_H
@@ -0,0 +1,325 @@
+#include "sd_logger.h"
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include "stage_probe.h"
+
+static_assert(SD_LOG_BLOCK_SIZE % 512 == 0, "SD_LOG_BLOCK_SIZE must be a multiple of the sector size");
+static_assert(SD_LOG_BLOCK_SIZE <= LOG_MAX_BLOCK_SIZE, "SD_LOG_BLOCK_SIZE exceeds LOG_MAX_BLOCK_SIZE");
+static_assert(SD_LOG_BLOCK_COUNT >= 2 && SD_LOG_BLOCK_COUNT <= 255, "SD_LOG_BLOCK_COUNT out of range");
+
+#define BLOCK_PAYLOAD_CAPACITY logBlockPayloadCapacity(SD_LOG_BLOCK_SIZE)
+
+SdLogger::SdLogger() :
+    pool(nullptr),
+    freeBlocks(nullptr),
+    commands(nullptr),
+    writerHandle(nullptr),
+    perfStats(nullptr),
+    currentBlock(-1),
+    currentEncoding(LOG_ENCODING_RAW),
+    currentStarted(0),
+    nextSequence(0),
+    nextRecord(0),
+    fileOpen(false),
+    openRequested(0),
+    openReported(0),
+    openFailed(false),
+    lastRateTime(0),
+    lastRateBytes(0),
+    openResult(false),
+    openCompleted(0),
+    bytesSinceFlush(0),
+    lastFlush(0)
+{
+    pendingPath[0] = '\0';
+    memset(&pendingHeader, 0, sizeof(pendingHeader));
+}
+
+bool SdLogger::begin(PerformanceStats* perf) {
+    perfStats = perf;
+
+    size_t bytes = (size_t)SD_LOG_BLOCK_SIZE * SD_LOG_BLOCK_COUNT;
+    pool = (uint8_t*)heap_caps_aligned_alloc(32, bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!pool) {
+        pool = (uint8_t*)heap_caps_aligned_alloc(32, bytes, MALLOC_CAP_8BIT);
+    }
+
+    freeBlocks = xQueueCreate(SD_LOG_BLOCK_COUNT, sizeof(uint8_t));
+    // Room for every data block plus an open and a close in flight
+    commands = xQueueCreate(SD_LOG_BLOCK_COUNT + 2, sizeof(Command));
+    if (!pool || !freeBlocks || !commands) {
+        Serial.println("❌ SD logger: allocation failed");
+        return false;
+    }
+
+    for (uint8_t i = 0; i < SD_LOG_BLOCK_COUNT; i++) {
+        xQueueSend(freeBlocks, &i, 0);
+    }
+
+    if (xTaskCreatePinnedToCore(writerTask, "sdwriter", SD_WRITER_TASK_STACK, this,
+                                SD_WRITER_TASK_PRIORITY, &writerHandle,
+                                SD_WRITER_TASK_CORE) != pdPASS) {
+        Serial.println("❌ SD logger: writer task creation failed");
+        return false;
+    }
+
+    lastRateTime = millis();
+    Serial.printf("✅ SD logger: %d x %d byte blocks\n", SD_LOG_BLOCK_COUNT, SD_LOG_BLOCK_SIZE);
+    return true;
+}
+
+bool SdLogger::open(const char* path, uint32_t createdUnix, uint16_t recordSize, uint8_t encoding) {
+    if (!writerHandle) return false;
+    if (fileOpen) close();
+
+    // The writer reads the pending path and header when it dequeues the open,
+    // so they must not change until it has answered the previous one
+    if (__atomic_load_n(&openCompleted, __ATOMIC_ACQUIRE) != openRequested) return false;
+
+    strncpy(pendingPath, path, sizeof(pendingPath) - 1);
+    pendingPath[sizeof(pendingPath) - 1] = '\0';
+    logInitFileHeader(pendingHeader, SD_LOG_BLOCK_SIZE, recordSize, encoding, createdUnix);
+    currentEncoding = encoding;
+
+    Command cmd = { LOG_CMD_OPEN, 0, 0, 0, openRequested + 1 };
+    if (xQueueSend(commands, &cmd, 0) != pdTRUE) return false;
+    openRequested++;
+
+    nextSequence = 0;
+    nextRecord = 0;
+    openFailed = false;
+    fileOpen = true;
+    return true;
+}
+
+bool SdLogger::takeOpenResult(bool& ok) {
+    if (openReported == openRequested ||
+        __atomic_load_n(&openCompleted, __ATOMIC_ACQUIRE) != openRequested) {
+        return false;
+    }
+    openReported = openRequested;
+    ok = openResult;
+    return true;
+}
+
+void SdLogger::close() {
+    if (!fileOpen) return;
+
+    if (currentBlock >= 0 && builder.records() > 0) {
+        submitBlock();
+    }
+    Command cmd = { LOG_CMD_CLOSE, 0, 0, 0, 0 };
+    xQueueSend(commands, &cmd, pdMS_TO_TICKS(1000));
+    fileOpen = false;
+}
+
+uint32_t SdLogger::blockSpace() const {
+    return currentBlock >= 0 ? builder.space() : 0;
+}
+
+void SdLogger::seal() {
+    if (fileOpen && currentBlock >= 0 && builder.records() > 0) {
+        submitBlock();
+    }
+}
+
+bool SdLogger::append(const void* data, size_t length, uint32_t timestamp) {
+    if (!fileOpen || length == 0 || length > BLOCK_PAYLOAD_CAPACITY) {
+        return false;
+    }
+
+    if (currentBlock >= 0 && length > builder.space()) {
+        submitBlock();
+    }
+    if (currentBlock < 0 && !acquireBlock()) {
+        countDrops(1);
+        return false;
+    }
+
+    builder.add(data, length, timestamp);
+    if (builder.isFull()) {
+        submitBlock();
+    }
+    return true;
+}
+
+void SdLogger::poll() {
+    unsigned long now = millis();
+
+    // A failed open stops further appends; blocks already queued are dropped by the writer
+    if (fileOpen && !openFailed && __atomic_load_n(&openCompleted, __ATOMIC_ACQUIRE) == openRequested &&
+        !openResult) {
+        openFailed = true;
+        if (currentBlock >= 0) {
+            countDrops(builder.records());
+            uint8_t index = (uint8_t)currentBlock;
+            xQueueSend(freeBlocks, &index, 0);
+            currentBlock = -1;
+        }
+        fileOpen = false;
+    }
+
+    if (fileOpen && currentBlock >= 0 && builder.records() > 0 &&
+        now - currentStarted >= SD_LOG_MAX_BLOCK_AGE_MS) {
+        submitBlock();
+    }
+
+    if (now - lastRateTime >= 1000) {
+        uint32_t written = stats.bytesWritten;
+        stats.bytesPerSecond = (uint32_t)((uint64_t)(written - lastRateBytes) * 1000 / (now - lastRateTime));
+        lastRateBytes = written;
+        lastRateTime = now;
+    }
+}
+
+bool SdLogger::acquireBlock() {
+    uint8_t index;
+    if (xQueueReceive(freeBlocks, &index, 0) != pdTRUE) {
+        return false;
+    }
+    currentBlock = index;
+    builder.begin(pool + (size_t)index * SD_LOG_BLOCK_SIZE, SD_LOG_BLOCK_SIZE, currentEncoding);
+    currentStarted = millis();
+    return true;
+}
+
+void SdLogger::submitBlock() {
+    // Blocks are always written whole, so every block stays sector aligned in the file
+    uint16_t records = builder.seal(nextSequence++, nextRecord);
+    nextRecord += records;
+
+    Command cmd = { LOG_CMD_DATA, (uint8_t)currentBlock, records, SD_LOG_BLOCK_SIZE, 0 };
+    if (xQueueSend(commands, &cmd, 0) != pdTRUE) {
+        // Cannot happen while the command queue outsizes the pool, but never leak a block
+        countDrops(records);
+        uint8_t index = (uint8_t)currentBlock;
+        xQueueSend(freeBlocks, &index, 0);
+    } else {
+        uint32_t waiting = uxQueueMessagesWaiting(commands);
+        if (waiting > stats.queueHighWater) stats.queueHighWater = waiting;
+    }
+    currentBlock = -1;
+}
+
+// Called from the sink task and from the writer task on the other core
+void SdLogger::countDrops(uint32_t records) {
+    __atomic_fetch_add(&stats.recordsDropped, records, __ATOMIC_RELAXED);
+    if (!perfStats) return;
+    unsigned long dropped = __atomic_load_n(&perfStats->droppedPackets, __ATOMIC_RELAXED);
+    while (dropped < ULONG_MAX - records &&
+           !__atomic_compare_exchange_n(&perfStats->droppedPackets, &dropped, dropped + records,
+                                        true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+void SdLogger::writeBlock(const Command& cmd) {
+    const uint8_t* block = pool + (size_t)cmd.block * SD_LOG_BLOCK_SIZE;
+
+    if (writer.isOpen()) {
+        PROBE_SCOPE(PROBE_SD_WRITE);
+        int64_t start = esp_timer_get_time();
+        bool ok = writer.writeBlock(block, cmd.length, cmd.records);
+        uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+
+        stats.lastWriteUs = elapsed;
+        stats.totalWriteUs += elapsed;
+        if (elapsed > stats.maxWriteUs) stats.maxWriteUs = elapsed;
+
+        if (ok) {
+            stats.bytesWritten += cmd.length;
+            stats.blocksWritten++;
+            bytesSinceFlush += cmd.length;
+        } else {
+            stats.writeErrors++;
+            countDrops(cmd.records);
+        }
+
+        // Size/time flush policy - each flush costs a FAT + directory update
+        unsigned long now = millis();
+        if (bytesSinceFlush >= SD_LOG_FLUSH_BYTES || now - lastFlush >= SD_LOG_FLUSH_INTERVAL_MS) {
+            writer.flush();
+            stats.flushes++;
+            bytesSinceFlush = 0;
+            lastFlush = now;
+        }
+    } else {
+        countDrops(cmd.records);
+    }
+
+    uint8_t blockIndex = cmd.block;
+    xQueueSend(freeBlocks, &blockIndex, portMAX_DELAY);
+}
+
+void SdLogger::writerTask(void* param) {
+    SdLogger* self = static_cast<SdLogger*>(param);
+    Command cmd;
+
+    for (;;) {
+        if (xQueueReceive(self->commands, &cmd, portMAX_DELAY) != pdTRUE) continue;
+
+        switch (cmd.type) {
+            case LOG_CMD_OPEN:
+                self->writer.finish();     // No-op unless a file was left open
+                self->openResult = self->writer.open(&self->file, self->pendingPath, self->pendingHeader);
+                self->bytesSinceFlush = 0;
+                self->lastFlush = millis();
+                __atomic_store_n(&self->openCompleted, cmd.request, __ATOMIC_RELEASE);
+                break;
+
+            case LOG_CMD_DATA:
+                self->writeBlock(cmd);
+                break;
+
+            case LOG_CMD_CLOSE:
+                if (self->writer.isOpen()) {
+                    self->writer.finish();
+                    self->stats.flushes++;
+                }
+                break;
+        }
+    }
+}
+
+// ==============================================
+// POWER-LOSS RECOVERY
+// ==============================================
+bool SdLogger::repairLog(const char* path) {
+    uint8_t* scratch = (uint8_t*)heap_caps_malloc(LOG_MAX_BLOCK_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!scratch) scratch = (uint8_t*)malloc(LOG_MAX_BLOCK_SIZE);
+    if (!scratch) return false;
+
+    SdStorageFile f;
+    LogRepairResult result;
+    bool ok = logRepair(f, path, scratch, LOG_MAX_BLOCK_SIZE, result);
+    free(scratch);
+
+    if (ok && result.repaired) {
+        Serial.printf("🩹 Repaired %s: %lu blocks, %lu records\n", path,
+                      (unsigned long)result.blocks, (unsigned long)result.records);
+    }
+    return ok;
+}
+
+void SdLogger::repairLogs() {
+    File root = SD.open("/");
+    if (!root) return;
+
+    // Collect names first - the directory handle must not stay open while files are rewritten
+    std::vector<String> candidates;
+    File entry = root.openNextFile();
+    while (entry) {
+        if (!entry.isDirectory()) {
+            String name = entry.name();
+            if (name.endsWith(".bin")) {
+                candidates.push_back(name.startsWith("/") ? name : "/" + name);
+            }
+        }
+        entry.close();
+        entry = root.openNextFile();
+    }
+    root.close();
+
+    for (size_t i = 0; i < candidates.size(); i++) {
+        repairLog(candidates[i].c_str());
+    }
+}
@@ -0,0 +1,125 @@
+#ifndef SD_LOGGER_H
+#define SD_LOGGER_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <SD.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <vector>
+#include "data_structures.h"
+#include "log_format.h"
+#include "log_writer.h"
+#include "sd_storage.h"
+#include "boardconfig.h"
+
+// ==============================================
+// BATCHED SD LOGGER
+// ==============================================
+// Records are appended into sector-aligned blocks held in PSRAM. Full (or
+// aged) blocks are sealed in log format v2 (see log_format.h) and handed to a
+// background writer task, so the caller never waits for the card. The file
+// layout itself lives in LogBlockBuilder/LogWriter (log_writer.h). When every
+// block is in flight the record is dropped and counted in
+// PerformanceStats::droppedPackets. The writer appends the block index and
+// footer on close; repairLogs() rebuilds them for files cut off by power loss.
+//
+// Producer API (open/append/poll/close) must be called from a single task.
+// Opening never waits for the card: the request is queued ahead of the
+// file's first blocks and poll() picks up the writer's result.
+
+class SdLogger {
+public:
+    SdLogger();
+
+    // Allocate the block pool and start the writer task
+    bool begin(PerformanceStats* perf);
+
+    // Open a new log file (closes the current one first). Queues the request and
+    // returns at once; false when the queue is full or an earlier open is still
+    // in flight. Records can be appended straight away - if the open fails they
+    // are dropped and counted. takeOpenResult() reports the outcome.
+    bool open(const char* path, uint32_t createdUnix, uint16_t recordSize, uint8_t encoding);
+    void close();
+    bool isOpen() const { return fileOpen; }
+
+    // True once per open() when the writer has answered it; `ok` is the result
+    bool takeOpenResult(bool& ok);
+
+    // Copy a record into the current block. Returns false if it had to be dropped.
+    bool append(const void* data, size_t length, uint32_t timestamp);
+
+    // Bytes still free in the current block (0 when no block is being filled)
+    uint32_t blockSpace() const;
+
+    // Hand the current block to the writer now; the next append starts a fresh block
+    void seal();
+
+    // Rebuild the index/footer of every v2 log in the root directory that lacks one.
+    // Call before begin() - runs synchronously.
+    static void repairLogs();
+    static bool repairLog(const char* path);
+
+    // Time-based policy: submit an aged partial block, update throughput
+    void poll();
+
+    const SdLoggerStats& getStats() const { return stats; }
+
+private:
+    enum CommandType : uint8_t {
+        LOG_CMD_OPEN,
+        LOG_CMD_DATA,
+        LOG_CMD_CLOSE
+    };
+
+    struct Command {
+        CommandType type;
+        uint8_t block;
+        uint16_t records;
+        uint32_t length;
+        uint32_t request;           // LOG_CMD_OPEN: open() sequence number
+    };
+
+    uint8_t* pool;
+    QueueHandle_t freeBlocks;       // Indices of empty blocks
+    QueueHandle_t commands;         // Writer work queue (FIFO keeps open/data/close ordered)
+    TaskHandle_t writerHandle;
+    PerformanceStats* perfStats;
+
+    // Producer state
+    int currentBlock;
+    LogBlockBuilder builder;        // Fills the pool block at currentBlock
+    uint8_t currentEncoding;
+    unsigned long currentStarted;
+    uint32_t nextSequence;
+    uint32_t nextRecord;
+    bool fileOpen;                  // Accepting records: open requested and not failed
+    uint32_t openRequested;         // Sequence number of the latest open()
+    uint32_t openReported;          // Latest open whose result takeOpenResult() returned
+    bool openFailed;
+    unsigned long lastRateTime;
+    uint32_t lastRateBytes;
+
+    // Writer state
+    SdStorageFile file;
+    LogWriter writer;
+    char pendingPath[64];
+    LogFileHeader pendingHeader;
+    volatile bool openResult;
+    uint32_t openCompleted;         // Written with release after openResult
+    uint32_t bytesSinceFlush;
+    unsigned long lastFlush;
+
+    SdLoggerStats stats;
+
+    bool acquireBlock();
+    void submitBlock();
+    void countDrops(uint32_t records);
+    void writeBlock(const Command& cmd);
+
+    static void writerTask(void* param);
+};
+
+#endif // SD_LOGGER_H
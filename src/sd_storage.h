@@ -0,0 +1,33 @@
+#ifndef SD_STORAGE_H
+#define SD_STORAGE_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <SD.h>
+#include "platform_io.h"
+
+// StorageFile on the SD card (fs::File). The host build uses HostStorageFile instead.
+class SdStorageFile : public StorageFile {
+public:
+    bool open(const char* path, StorageMode mode) override {
+        if (file) file.close();
+        const char* sdMode = mode == STORAGE_READ ? FILE_READ :
+                             mode == STORAGE_APPEND ? FILE_APPEND : FILE_WRITE;
+        file = SD.open(path, sdMode);
+        return (bool)file;
+    }
+    bool isOpen() const override { return (bool)file; }
+    void close() override { if (file) file.close(); }
+
+    size_t read(uint8_t* buffer, size_t length) override { return file.read(buffer, length); }
+    size_t write(const uint8_t* data, size_t length) override { return file.write(data, length); }
+    bool seek(uint32_t position) override { return file.seek(position); }
+    uint32_t position() override { return file.position(); }
+    uint32_t size() override { return file.size(); }
+    void flush() override { file.flush(); }
+
+private:
+    File file;
+};
+
+#endif // SD_STORAGE_H
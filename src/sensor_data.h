@@ -0,0 +1,56 @@
+#ifndef SENSOR_DATA_H
+#define SENSOR_DATA_H
+
+#include <stdint.h>
+
+// Latest GNSS fix and IMU reading as the ingest stage sees them. Kept free of
+// Arduino headers so the packet layer (packet_builder.h) builds on the host.
+
+// GPS data structure - kept in the receiver's native NAV-PVT units from
+// parse through log and packet; convert with the helpers only for display
+struct GPSData {
+    uint32_t timestamp = 0;
+    int32_t latitude = 0;   // deg * 1e7
+    int32_t longitude = 0;  // deg * 1e7
+    int32_t altitude = 0;   // mm above ellipsoid
+    int32_t speed = 0;      // mm/s ground speed
+    int32_t heading = 0;    // deg * 1e5, heading of motion
+    uint8_t fixType = 0;
+    uint8_t satellites = 0;
+    uint16_t year = 0;
+    uint8_t month = 0;
+    uint8_t day = 0;
+    uint8_t hour = 0;
+    uint8_t minute = 0;
+    uint8_t second = 0;
+    
+    double latitudeDeg() const { return latitude * 1e-7; }
+    double longitudeDeg() const { return longitude * 1e-7; }
+    float altitudeM() const { return altitude * 0.001f; }
+    float speedKmh() const { return speed * 0.0036f; }
+    float headingDeg() const { return heading * 1e-5f; }
+};
+
+// IMU data structure
+struct IMUData {
+    float accelX = 0.0, accelY = 0.0, accelZ = 0.0;
+    float gyroX = 0.0, gyroY = 0.0, gyroZ = 0.0;
+    float temperature = 0.0;
+    float magnitude = 0.0;
+    bool motionDetected = false;
+    unsigned long lastMotionTime = 0;
+    
+    // Calibration data
+    float accelOffsetX = 0.0;
+    float accelOffsetY = 0.0;
+    float accelOffsetZ = 0.0;
+    float gyroOffsetX = 0.0;
+    float gyroOffsetY = 0.0;
+    float gyroOffsetZ = 0.0;
+    bool isCalibrated = false;
+    unsigned long calibrationStartTime = 0;
+    int calibrationSamples = 0;
+    bool calibrationInProgress = false;
+};
+
+#endif // SENSOR_DATA_H
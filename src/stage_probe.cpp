@@ -0,0 +1,53 @@
+#include "stage_probe.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+ProbeStats probeStats[PROBE_STAGE_COUNT];
+
+static const char* stageNames[PROBE_STAGE_COUNT] = {
+    "gnss", "imu", "packet", "udp", "ble", "sd", "lvgl"
+};
+
+const char* probeStageName(ProbeStage stage) {
+    return stage < PROBE_STAGE_COUNT ? stageNames[stage] : "?";
+}
+
+uint32_t probeCyclesPerUs() {
+#ifdef ARDUINO
+    return ESP.getCpuFreqMHz();
+#else
+    return 1000;
+#endif
+}
+
+void probeReset() {
+    memset(probeStats, 0, sizeof(probeStats));
+}
+
+size_t probeFormat(char* out, size_t size, bool compact) {
+    if (size == 0) return 0;
+    out[0] = '\0';
+    if (!STAGE_PROBES_ENABLED) {
+        return snprintf(out, size, compact ? "PROBES:DISABLED" : "Probes compiled out");
+    }
+
+    const float perUs = (float)probeCyclesPerUs();
+    size_t length = compact ? snprintf(out, size, "PROBES:") : 0;
+    for (int i = 0; i < PROBE_STAGE_COUNT && length < size; i++) {
+        const ProbeStats& s = probeStats[i];
+        float avgUs = s.count ? (float)s.totalCycles / s.count / perUs : 0.0f;
+        float maxUs = s.maxCycles / perUs;
+        int n = compact
+            ? snprintf(out + length, size - length, "%s=%lu/%.2f/%.1f;", stageNames[i],
+                       (unsigned long)s.count, avgUs, maxUs)
+            : snprintf(out + length, size - length, "%-6s n:%-8lu avg:%8.2fus max:%8.1fus\n", stageNames[i],
+                       (unsigned long)s.count, avgUs, maxUs);
+        if (n < 0) break;
+        length += n;
+    }
+    return length < size ? length : size - 1;
+}
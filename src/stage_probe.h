@@ -0,0 +1,96 @@
+#ifndef STAGE_PROBE_H
+#define STAGE_PROBE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef ARDUINO
+#include <esp_cpu.h>
+#else
+#include <time.h>
+#endif
+
+// ==============================================
+// HOT-PATH STAGE PROBES
+// ==============================================
+// PROBE_SCOPE(stage) times the rest of the enclosing block with the CPU cycle
+// counter and folds it into that stage's counters: two register reads and a
+// handful of adds per pass. Each stage is recorded by a single pinned task,
+// so the counters need no locking and the per-core cycle counter is valid.
+//
+// Build with -D STAGE_PROBES_ENABLED=0 to compile every probe out; the
+// counters then stay at zero and the report says so.
+// Off the board the cycle counter is replaced by a nanosecond monotonic clock.
+
+#ifndef STAGE_PROBES_ENABLED
+#define STAGE_PROBES_ENABLED    1
+#endif
+
+#define PROBE_REPORT_SIZE       512     // Enough for the full table
+
+enum ProbeStage : uint8_t {
+    PROBE_GNSS_PARSE = 0,       // UART drain + UBX parse (ingest task)
+    PROBE_IMU_READ,             // I2C burst or FIFO drain (ingest / IMU task)
+    PROBE_PACKET_BUILD,         // GPSData -> GPSPacket + CRC (ingest task)
+    PROBE_UDP_SEND,             // One datagram (UDP sink task)
+    PROBE_BLE_NOTIFY,           // One notification (sink task)
+    PROBE_SD_WRITE,             // One log block (SD writer task)
+    PROBE_LVGL,                 // lv_timer_handler() (UI task)
+    PROBE_STAGE_COUNT
+};
+
+struct ProbeStats {
+    uint32_t count;
+    uint32_t lastCycles;
+    uint32_t maxCycles;
+    uint64_t totalCycles;
+};
+
+extern ProbeStats probeStats[PROBE_STAGE_COUNT];
+
+// Free-running counter; only differences are used
+inline uint32_t probeCycles() {
+#ifdef ARDUINO
+    return esp_cpu_get_ccount();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+#endif
+}
+
+inline void probeRecord(ProbeStage stage, uint32_t cycles) {
+    ProbeStats& s = probeStats[stage];
+    s.count++;
+    s.lastCycles = cycles;
+    s.totalCycles += cycles;
+    if (cycles > s.maxCycles) s.maxCycles = cycles;
+}
+
+const char* probeStageName(ProbeStage stage);
+uint32_t probeCyclesPerUs();
+void probeReset();
+
+// One line per stage (count, avg/max us), or a single
+// "PROBES:name=count/avgUs/maxUs;..." line for a BLE reply
+size_t probeFormat(char* out, size_t size, bool compact);
+
+#if STAGE_PROBES_ENABLED
+class ProbeScope {
+public:
+    explicit ProbeScope(ProbeStage stage) : stage(stage), start(probeCycles()) {}
+    ~ProbeScope() { probeRecord(stage, probeCycles() - start); }
+
+private:
+    ProbeStage stage;
+    uint32_t start;
+};
+
+#define PROBE_CONCAT_(a, b)     a##b
+#define PROBE_CONCAT(a, b)      PROBE_CONCAT_(a, b)
+#define PROBE_SCOPE(stage)      ProbeScope PROBE_CONCAT(probeScope, __LINE__)(stage)
+#else
+#define PROBE_SCOPE(stage)      do {} while (0)
+#endif
+
+#endif // STAGE_PROBE_H
@@ -0,0 +1,398 @@
+#include "task_pipeline.h"
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <new>
+
+static const char* taskNames[PIPELINE_TASK_COUNT] = { "ingest", "sinks", "ui" };
+
+TaskPipeline::TaskPipeline() :
+    sinkCount(0),
+    uiConsumerId(-1),
+    nextSequence(0),
+    ingestBurst(1),
+    epochPeriodUs(1000000UL / GNSS_NAV_RATE_HZ),
+    histograms(nullptr),
+    running(false)
+{
+    memset(&callbacks, 0, sizeof(callbacks));
+    uiRate.stagedHz = 0;
+    uiRate.stagedFilter = RATE_FILTER_AVERAGE;
+    uiRate.staged = false;
+    memset(histogramNames, 0, sizeof(histogramNames));
+    strcpy(histogramNames[PIPELINE_HIST_EPOCH], "epoch_interval");
+    for (int i = 0; i < PIPELINE_TASK_COUNT; i++) {
+        taskHandles[i] = nullptr;
+        snprintf(histogramNames[PIPELINE_HIST_ITERATION + i], LATENCY_NAME_MAX + 1, "iter_%s", taskNames[i]);
+    }
+}
+
+bool TaskPipeline::addSink(const char* name, SinkCallback callback) {
+    if (running || !callback || sinkCount >= PIPELINE_MAX_SINKS) return false;
+    sinks[sinkCount].name = name;
+    sinks[sinkCount].callback = callback;
+    sinks[sinkCount].consumerId = -1;
+    sinks[sinkCount].timing = SinkTimingStats();
+    sinks[sinkCount].rate.stagedHz = 0;
+    sinks[sinkCount].rate.stagedFilter = RATE_FILTER_AVERAGE;
+    sinks[sinkCount].rate.staged = false;
+    sinks[sinkCount].ownTask = false;
+    sinks[sinkCount].task = nullptr;
+    sinks[sinkCount].owner = this;
+    snprintf(histogramNames[PIPELINE_HIST_SINK + sinkCount], LATENCY_NAME_MAX + 1, "lat_%s", name);
+    sinkCount++;
+    return true;
+}
+
+bool TaskPipeline::addTaskSink(const char* name, SinkCallback callback, const SinkTaskConfig& config) {
+    if (!addSink(name, callback)) return false;
+    PipelineSink& sink = sinks[sinkCount - 1];
+    sink.ownTask = true;
+    sink.taskConfig = config;
+    return true;
+}
+
+bool TaskPipeline::begin(const PipelineCallbacks& cb) {
+    if (!cb.ingest || !cb.housekeeping || !cb.uiService) {
+        Serial.println("❌ Pipeline: missing callbacks");
+        return false;
+    }
+    callbacks = cb;
+
+    // ~24 KB per histogram: PSRAM only, the pipeline runs without them otherwise
+    void* mem = heap_caps_malloc(sizeof(WindowedHistogram) * PIPELINE_HIST_COUNT,
+                                 MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (mem) {
+        histograms = static_cast<WindowedHistogram*>(mem);
+        for (int i = 0; i < PIPELINE_HIST_COUNT; i++) {
+            new (&histograms[i]) WindowedHistogram();
+        }
+    } else {
+        Serial.println("⚠️ Pipeline: no PSRAM for latency histograms");
+    }
+
+    if (!bus.begin(TELEMETRY_RING_CAPACITY)) {
+        Serial.println("❌ Pipeline: telemetry bus allocation failed");
+        teardown();
+        return false;
+    }
+    for (int i = 0; i < sinkCount; i++) {
+        sinks[i].consumerId = bus.addConsumer();
+    }
+    uiConsumerId = bus.addConsumer();
+    if (uiConsumerId < 0) {
+        Serial.println("❌ Pipeline: too many bus consumers");
+        teardown();
+        return false;
+    }
+    Serial.printf("✅ Telemetry bus: %lu samples x %u bytes in %s\n",
+                  (unsigned long)bus.getCapacity(), (unsigned)sizeof(TelemetrySample),
+                  bus.isInPsram() ? "PSRAM" : "internal RAM");
+
+    // Every task waits for the start signal, so a partial failure can delete
+    // the ones already created before any of them has touched a callback
+    bool ok = true;
+    ok &= xTaskCreatePinnedToCore(sinkTask, "sinks", SINK_TASK_STACK, this,
+                                  SINK_TASK_PRIORITY, &taskHandles[PIPELINE_TASK_SINK],
+                                  SINK_TASK_CORE) == pdPASS;
+    ok &= xTaskCreatePinnedToCore(uiTask, "ui", UI_TASK_STACK, this,
+                                  UI_TASK_PRIORITY, &taskHandles[PIPELINE_TASK_UI],
+                                  UI_TASK_CORE) == pdPASS;
+    for (int i = 0; i < sinkCount; i++) {
+        PipelineSink& sink = sinks[i];
+        if (!sink.ownTask) continue;
+        ok &= xTaskCreatePinnedToCore(sinkOwnTask, sink.name, sink.taskConfig.stackSize, &sink,
+                                      sink.taskConfig.priority, &sink.task, sink.taskConfig.core) == pdPASS;
+    }
+    ok &= xTaskCreatePinnedToCore(ingestTask, "ingest", INGEST_TASK_STACK, this,
+                                  INGEST_TASK_PRIORITY, &taskHandles[PIPELINE_TASK_INGEST],
+                                  INGEST_TASK_CORE) == pdPASS;
+    if (!ok) {
+        Serial.println("❌ Pipeline: task creation failed");
+        teardown();
+        return false;
+    }
+
+    running = true;
+    // Sinks and UI first so they are waiting before the first sample is produced
+    xTaskNotifyGive(taskHandles[PIPELINE_TASK_SINK]);
+    xTaskNotifyGive(taskHandles[PIPELINE_TASK_UI]);
+    for (int i = 0; i < sinkCount; i++) {
+        if (sinks[i].task) xTaskNotifyGive(sinks[i].task);
+    }
+    xTaskNotifyGive(taskHandles[PIPELINE_TASK_INGEST]);
+    Serial.printf("✅ Pipeline running: ingest@core%d/%dms, sinks@core%d, ui@core%d/%dms\n",
+                  INGEST_TASK_CORE, INGEST_PERIOD_MS, SINK_TASK_CORE, UI_TASK_CORE, UI_PERIOD_MS);
+    return true;
+}
+
+// Undo a failed begin(): the tasks created so far are still parked in
+// waitForStart(), so deleting them cannot interrupt any work
+void TaskPipeline::teardown() {
+    for (int i = 0; i < PIPELINE_TASK_COUNT; i++) {
+        if (taskHandles[i]) vTaskDelete(taskHandles[i]);
+        taskHandles[i] = nullptr;
+    }
+    for (int i = 0; i < sinkCount; i++) {
+        if (sinks[i].task) vTaskDelete(sinks[i].task);
+        sinks[i].task = nullptr;
+        sinks[i].consumerId = -1;
+    }
+    uiConsumerId = -1;
+    bus.release();
+    if (histograms) {
+        for (int i = 0; i < PIPELINE_HIST_COUNT; i++) {
+            histograms[i].~WindowedHistogram();
+        }
+        heap_caps_free(histograms);
+        histograms = nullptr;
+    }
+}
+
+void TaskPipeline::waitForStart() {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
+
+int TaskPipeline::findSink(const char* name) const {
+    for (int i = 0; i < sinkCount; i++) {
+        if (strcmp(sinks[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+const PipelineRate* TaskPipeline::getRate(const char* consumer) const {
+    if (strcmp(consumer, "ui") == 0) return &uiRate;
+    int index = findSink(consumer);
+    return index >= 0 ? &sinks[index].rate : nullptr;
+}
+
+bool TaskPipeline::setRate(const char* consumer, uint16_t hz, RateFilter filter) {
+    PipelineRate* rate = const_cast<PipelineRate*>(getRate(consumer));
+    if (!rate) return false;
+    rate->stagedHz = hz > RATE_MAX_HZ ? RATE_MAX_HZ : hz;
+    rate->stagedFilter = filter;
+    rate->staged = true;
+    return true;
+}
+
+// inputHz: the epoch rate; consumers at or above it see every sample unchanged
+void TaskPipeline::applyRate(PipelineRate& rate, uint16_t inputHz) {
+    if (!rate.staged) return;
+    rate.staged = false;
+    rate.decimator.configure(rate.stagedHz, (RateFilter)rate.stagedFilter, inputHz);
+}
+
+void TaskPipeline::markEpoch(int64_t nowUs) {
+    const uint32_t nominalUs = epochPeriodUs;
+
+    if (epochStats.lastEpochUs > 0) {
+        uint32_t gap = (uint32_t)(nowUs - epochStats.lastEpochUs);
+        if (gap > epochStats.maxGapUs) epochStats.maxGapUs = gap;
+        if (histograms) histograms[PIPELINE_HIST_EPOCH].record(gap);
+        if (gap > nominalUs + nominalUs / 2) {
+            // Count every epoch that fell inside the gap, not just one
+            epochStats.missedEpochs += (gap + nominalUs / 2) / nominalUs - 1;
+        }
+    }
+    epochStats.lastEpochUs = nowUs;
+    epochStats.epochs++;
+}
+
+void TaskPipeline::resetSinkStats() {
+    for (int i = 0; i < sinkCount; i++) {
+        sinks[i].timing = SinkTimingStats();
+    }
+}
+
+void TaskPipeline::rotateHistograms() {
+    if (!histograms) return;
+    for (int i = 0; i < getHistogramCount(); i++) {
+        histograms[i].rotate();
+    }
+}
+
+uint32_t TaskPipeline::currentPercentile(int index, float percent) const {
+    return histograms ? histograms[index].getCurrent().valueAtPercentile(percent) : 0;
+}
+
+void TaskPipeline::drainSink(int index) {
+    PipelineSink& sink = sinks[index];
+    applyRate(sink.rate, epochRateHz());
+    TelemetrySample sample, output;
+    while (bus.read(sink.consumerId, sample)) {
+        // Every sample goes through the filter; the callback only sees its outputs
+        if (!sink.rate.decimator.push(sample.packet, sample.timestampUs, output.packet)) continue;
+        output.timestampUs = sample.timestampUs;
+        output.sequence = sample.sequence;
+
+        int64_t callStart = esp_timer_get_time();
+        sink.callback(output);
+        uint32_t latency = (uint32_t)(callStart - sample.timestampUs);
+        uint32_t exec = (uint32_t)(esp_timer_get_time() - callStart);
+        SinkTimingStats& t = sink.timing;
+        t.samples++;
+        if (histograms) histograms[PIPELINE_HIST_SINK + index].record(latency);
+        t.totalExecUs += exec;
+        if (exec > t.maxExecUs) t.maxExecUs = exec;
+    }
+}
+
+void TaskPipeline::recordIteration(PipelineTask task, uint32_t execUs, uint32_t periodUs) {
+    TaskTimingStats& s = stats[task];
+    s.iterations++;
+    s.lastExecUs = execUs;
+    s.totalExecUs += execUs;
+    if (execUs > s.maxExecUs) s.maxExecUs = execUs;
+    if (periodUs > 0 && execUs > periodUs) s.overruns++;
+    if (histograms) histograms[PIPELINE_HIST_ITERATION + task].record(execUs);
+}
+
+void TaskPipeline::printStats() {
+    for (int i = 0; i < PIPELINE_TASK_COUNT; i++) {
+        TaskTimingStats& s = stats[i];
+        if (taskHandles[i]) {
+            s.stackHighWater = uxTaskGetStackHighWaterMark(taskHandles[i]);
+        }
+        uint32_t avg = s.iterations ? (uint32_t)(s.totalExecUs / s.iterations) : 0;
+        uint32_t p99 = currentPercentile(PIPELINE_HIST_ITERATION + i, 99.0f);
+        Serial.printf("⏱️ %-6s it:%lu avg:%luus p99:%luus max:%luus over:%lu drop:%lu hw:%lu stack:%lu\n",
+                      taskNames[i], (unsigned long)s.iterations, (unsigned long)avg, (unsigned long)p99,
+                      (unsigned long)s.maxExecUs, (unsigned long)s.overruns,
+                      (unsigned long)s.queueDrops, (unsigned long)s.queueHighWater,
+                      (unsigned long)s.stackHighWater);
+    }
+    for (int i = 0; i < sinkCount; i++) {
+        if (sinks[i].consumerId < 0) continue;
+        const TelemetryBus::ConsumerStats& cs = bus.getConsumerStats(sinks[i].consumerId);
+        const SinkTimingStats& t = sinks[i].timing;
+        const RateDecimator& rate = sinks[i].rate.decimator;
+        uint32_t avgExec = t.samples ? (uint32_t)(t.totalExecUs / t.samples) : 0;
+        Serial.printf("📦 sink %-6s rate:%u%s read:%lu out:%lu overrun:%lu backlog:%lu lat p50:%luus p99:%luus max:%luus exec avg:%luus max:%luus\n",
+                      sinks[i].name, rate.getRate(), rate.getRate() ? rateFilterName(rate.getFilter()) : "",
+                      (unsigned long)cs.reads, (unsigned long)t.samples, (unsigned long)cs.overruns,
+                      (unsigned long)bus.available(sinks[i].consumerId),
+                      (unsigned long)currentPercentile(PIPELINE_HIST_SINK + i, 50.0f),
+                      (unsigned long)currentPercentile(PIPELINE_HIST_SINK + i, 99.0f),
+                      (unsigned long)currentPercentile(PIPELINE_HIST_SINK + i, 100.0f),
+                      (unsigned long)avgExec, (unsigned long)t.maxExecUs);
+    }
+    const RateControlStats& ui = uiRate.decimator.getStats();
+    Serial.printf("🖥️ ui rate:%u%s in:%lu out:%lu\n", uiRate.decimator.getRate(),
+                  uiRate.decimator.getRate() ? rateFilterName(uiRate.decimator.getFilter()) : "",
+                  (unsigned long)ui.in, (unsigned long)ui.out);
+    Serial.printf("🛰️ Epochs:%lu missed:%lu maxGap:%luus interval p50:%luus p99:%luus p99.9:%luus\n",
+                  (unsigned long)epochStats.epochs, (unsigned long)epochStats.missedEpochs,
+                  (unsigned long)epochStats.maxGapUs,
+                  (unsigned long)currentPercentile(PIPELINE_HIST_EPOCH, 50.0f),
+                  (unsigned long)currentPercentile(PIPELINE_HIST_EPOCH, 99.0f),
+                  (unsigned long)currentPercentile(PIPELINE_HIST_EPOCH, 99.9f));
+}
+
+// Ingest: fixed-rate, highest priority. Publishing to the bus is wait-free.
+// Normally one sample per period; in burst mode ingest is called again while it keeps producing.
+void TaskPipeline::ingestTask(void* param) {
+    TaskPipeline* self = static_cast<TaskPipeline*>(param);
+    const TickType_t period = pdMS_TO_TICKS(INGEST_PERIOD_MS);
+    TelemetrySample sample;
+
+    waitForStart();
+    TickType_t lastWake = xTaskGetTickCount();
+    for (;;) {
+        int64_t start = esp_timer_get_time();
+
+        uint16_t burst = self->ingestBurst;
+        int64_t produced = start;
+        for (uint16_t n = 0; n < burst && self->callbacks.ingest(sample.packet); n++) {
+            sample.timestampUs = produced;
+            sample.sequence = self->nextSequence++;
+            self->bus.push(sample);
+            xTaskNotifyGive(self->taskHandles[PIPELINE_TASK_SINK]);
+            for (int i = 0; i < self->sinkCount; i++) {
+                if (self->sinks[i].task) xTaskNotifyGive(self->sinks[i].task);
+            }
+            produced = esp_timer_get_time();
+        }
+
+        self->recordIteration(PIPELINE_TASK_INGEST, (uint32_t)(esp_timer_get_time() - start),
+                              INGEST_PERIOD_MS * 1000UL);
+        vTaskDelayUntil(&lastWake, period);
+    }
+}
+
+// Sinks: woken by ingest, each sink drains its own cursor, then housekeeping runs.
+void TaskPipeline::sinkTask(void* param) {
+    TaskPipeline* self = static_cast<TaskPipeline*>(param);
+    TaskTimingStats& s = self->stats[PIPELINE_TASK_SINK];
+
+    waitForStart();
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(INGEST_PERIOD_MS * 4));
+        int64_t start = esp_timer_get_time();
+
+        uint32_t overruns = 0;
+        for (int i = 0; i < self->sinkCount; i++) {
+            PipelineSink& sink = self->sinks[i];
+            if (sink.ownTask) continue;
+            uint32_t backlog = self->bus.available(sink.consumerId);
+            if (backlog > s.queueHighWater) s.queueHighWater = backlog;
+
+            self->drainSink(i);
+            overruns += self->bus.getConsumerStats(sink.consumerId).overruns;
+        }
+        s.queueDrops = overruns;
+        self->callbacks.housekeeping();
+
+        self->recordIteration(PIPELINE_TASK_SINK, (uint32_t)(esp_timer_get_time() - start), 0);
+    }
+}
+
+// Sinks with their own task: same drain, plus a backlog bound and an idle hook
+// that runs even when no samples arrive (batch deadlines, reconnects).
+void TaskPipeline::sinkOwnTask(void* param) {
+    PipelineSink* sink = static_cast<PipelineSink*>(param);
+    TaskPipeline* self = sink->owner;
+    const int index = sink - self->sinks;
+    const SinkTaskConfig& config = sink->taskConfig;
+
+    waitForStart();
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(config.idleMs));
+        if (config.maxBacklog > 0) {
+            self->bus.trim(sink->consumerId, config.maxBacklog);
+        }
+        self->drainSink(index);
+        if (config.idle) config.idle();
+    }
+}
+
+// UI: sole owner of LVGL. Without a rate it jumps straight to the newest sample;
+// with one, every sample goes through the filter and the UI sees its outputs.
+void TaskPipeline::uiTask(void* param) {
+    TaskPipeline* self = static_cast<TaskPipeline*>(param);
+    const TickType_t period = pdMS_TO_TICKS(UI_PERIOD_MS);
+    TelemetrySample sample, input;
+    RateDecimator& rate = self->uiRate.decimator;
+
+    waitForStart();
+    TickType_t lastWake = xTaskGetTickCount();
+    for (;;) {
+        int64_t start = esp_timer_get_time();
+
+        applyRate(self->uiRate, self->epochRateHz());
+        bool fresh = false;
+        if (rate.getRate() == 0) {
+            fresh = self->bus.readLatest(self->uiConsumerId, sample);
+        } else {
+            while (self->bus.read(self->uiConsumerId, input)) {
+                if (!rate.push(input.packet, input.timestampUs, sample.packet)) continue;
+                sample.timestampUs = input.timestampUs;
+                sample.sequence = input.sequence;
+                fresh = true;
+            }
+        }
+        self->callbacks.uiService(fresh ? &sample : nullptr);
+
+        self->recordIteration(PIPELINE_TASK_UI, (uint32_t)(esp_timer_get_time() - start),
+                              UI_PERIOD_MS * 1000UL);
+        vTaskDelayUntil(&lastWake, period);
+    }
+}
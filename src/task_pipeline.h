@@ -0,0 +1,156 @@
+#ifndef TASK_PIPELINE_H
+#define TASK_PIPELINE_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "data_structures.h"
+#include "telemetry_ring.h"
+#include "latency_histogram.h"
+#include "rate_control.h"
+#include "boardconfig.h"
+
+// Pipeline stages. Ingest produces samples, sinks fan them out, UI owns LVGL.
+enum PipelineTask {
+    PIPELINE_TASK_INGEST = 0,
+    PIPELINE_TASK_SINK = 1,
+    PIPELINE_TASK_UI = 2,
+    PIPELINE_TASK_COUNT = 3
+};
+
+// Latency histograms kept by the pipeline: GNSS epoch interval, iteration
+// time of each task, and bus -> callback latency of each sink
+enum PipelineHistogram {
+    PIPELINE_HIST_EPOCH = 0,
+    PIPELINE_HIST_ITERATION = 1,                                    // + PipelineTask
+    PIPELINE_HIST_SINK = PIPELINE_HIST_ITERATION + PIPELINE_TASK_COUNT,   // + sink index
+    PIPELINE_HIST_COUNT = PIPELINE_HIST_SINK + PIPELINE_MAX_SINKS
+};
+
+typedef TelemetryRing<TelemetrySample> TelemetryBus;
+typedef void (*SinkCallback)(const TelemetrySample& sample);
+
+// Work callbacks supplied by the application. Each one runs on its own task.
+struct PipelineCallbacks {
+    bool (*ingest)(GPSPacket& packet);                  // Returns true when a new packet was produced
+    void (*housekeeping)();                             // Deferred ops, file transfer, battery, WiFi
+    void (*uiService)(const TelemetrySample* latest);   // LVGL + UI refresh (latest may be null)
+};
+
+// How a sink with its own task runs (addTaskSink)
+struct SinkTaskConfig {
+    BaseType_t core;
+    UBaseType_t priority;
+    uint32_t stackSize;
+    uint32_t idleMs;            // Longest wait for samples before idle() runs anyway
+    uint32_t maxBacklog;        // Unread samples kept; older ones are dropped first (0 = ring capacity)
+    void (*idle)();             // Runs after every wake-up: deadlines, reconnects (may be null)
+};
+
+class TaskPipeline;
+
+// Output rate of one bus consumer. setRate() stages it from any task; the
+// consumer's own task applies it before its next sample.
+struct PipelineRate {
+    RateDecimator decimator;
+    volatile uint16_t stagedHz;
+    volatile uint8_t stagedFilter;
+    volatile bool staged;
+};
+
+// A consumer of the telemetry bus, drained by the shared sink task or by its own task
+struct PipelineSink {
+    const char* name;
+    SinkCallback callback;
+    int consumerId;
+    SinkTimingStats timing;
+    PipelineRate rate;
+    bool ownTask;
+    SinkTaskConfig taskConfig;
+    TaskHandle_t task;
+    TaskPipeline* owner;
+};
+
+class TaskPipeline {
+public:
+    TaskPipeline();
+
+    // Register a bus consumer. Must be called before begin().
+    bool addSink(const char* name, SinkCallback callback);
+    // Same, drained by a task of its own so a slow sink (network I/O) only
+    // ever backs up its own cursor. Its callback and idle() run on that task.
+    bool addTaskSink(const char* name, SinkCallback callback, const SinkTaskConfig& config);
+
+    // Allocate the bus and start the pinned tasks
+    bool begin(const PipelineCallbacks& callbacks);
+    bool isRunning() const { return running; }
+
+    TelemetryBus& getBus() { return bus; }
+
+    // Target rate of a sink ("sd", "ble", ...) or of the UI ("ui") in Hz, 0 = every
+    // sample (rate_control.h). Callable from any task, before or after begin().
+    bool setRate(const char* consumer, uint16_t hz, RateFilter filter);
+    const PipelineRate* getRate(const char* consumer) const;
+    int findSink(const char* name) const;
+    uint16_t getSinkRate(int sink) const { return sinks[sink].rate.stagedHz; }
+
+    // Samples the ingest task may produce per period (1 = one per INGEST_PERIOD_MS).
+    // Raised while a replay is running so it can push past the live sample rate.
+    void setIngestBurst(uint16_t samples) { ingestBurst = samples > 0 ? samples : 1; }
+
+    // Timing statistics (safe to read from any task, values are word-sized)
+    const TaskTimingStats& getStats(PipelineTask task) const { return stats[task]; }
+    const EpochStats& getEpochStats() const { return epochStats; }
+    int getSinkCount() const { return sinkCount; }
+    const SinkTimingStats& getSinkStats(int sink) const { return sinks[sink].timing; }
+    void resetSinkStats();
+
+    // Histograms (allocated in PSRAM by begin(), null before or without PSRAM).
+    // Index is a PipelineHistogram.
+    int getHistogramCount() const { return PIPELINE_HIST_SINK + sinkCount; }
+    const WindowedHistogram* getHistogram(int index) const { return histograms ? &histograms[index] : nullptr; }
+    const char* getHistogramName(int index) const { return histogramNames[index]; }
+    // Start a new window on every histogram; the finished one stays queryable
+    void rotateHistograms();
+
+    // Record a GNSS epoch arrival so missed epochs can be detected
+    void markEpoch(int64_t nowUs);
+    // Navigation rate the receiver was configured for (default GNSS_NAV_RATE_HZ)
+    void setEpochRate(uint16_t hz) { epochPeriodUs = 1000000UL / (hz > 0 ? hz : 1); }
+
+    // Percentiles cover the current histogram window
+    void printStats();
+
+private:
+    PipelineCallbacks callbacks;
+    TelemetryBus bus;
+    PipelineSink sinks[PIPELINE_MAX_SINKS];
+    int sinkCount;
+    int uiConsumerId;
+    PipelineRate uiRate;
+    uint32_t nextSequence;
+    volatile uint16_t ingestBurst;
+    TaskHandle_t taskHandles[PIPELINE_TASK_COUNT];
+    TaskTimingStats stats[PIPELINE_TASK_COUNT];
+    EpochStats epochStats;
+    uint32_t epochPeriodUs;
+    WindowedHistogram* histograms;
+    char histogramNames[PIPELINE_HIST_COUNT][LATENCY_NAME_MAX + 1];
+    bool running;
+
+    void teardown();
+    static void waitForStart();
+    void recordIteration(PipelineTask task, uint32_t execUs, uint32_t periodUs);
+    void drainSink(int index);
+    static void applyRate(PipelineRate& rate, uint16_t inputHz);
+    uint16_t epochRateHz() const { return (uint16_t)(1000000UL / epochPeriodUs); }
+    uint32_t currentPercentile(int index, float percent) const;     // 0 without histograms
+
+    // FreeRTOS task entry points
+    static void ingestTask(void* param);
+    static void sinkTask(void* param);
+    static void uiTask(void* param);
+    static void sinkOwnTask(void* param);
+};
+
+#endif // TASK_PIPELINE_H
@@ -0,0 +1,215 @@
+#include "telemetry_batch.h"
+#include <math.h>
+#include <string.h>
+
+// ==============================================
+// SENDER
+// ==============================================
+
+TelemetryBatcher::TelemetryBatcher() :
+    length(0),
+    count(0),
+    nextSample(0),
+    queuedUs(0),
+    maxLatencyUs(0),
+    maxFrame(0),
+    sparse(false)
+{
+    memset(&header, 0, sizeof(header));
+    header.type = TB_FRAME_BATCH;
+}
+
+bool TelemetryBatcher::add(PacketLink& link, const GPSPacket& packet, uint32_t sampleSequence,
+                           uint32_t sampleTimeUs, uint32_t nowUs) {
+    size_t limit = link.maxPayload();
+    if (limit > TB_MAX_FRAME) limit = TB_MAX_FRAME;
+    if (maxFrame > 0 && limit > maxFrame) limit = maxFrame;
+    const size_t entry = sizeof(GPSPacket) + (sparse ? 1 : 0);
+    if (sizeof(TelemetryBatchHeader) + entry > limit) {
+        stats.samplesLost++;        // MTU not negotiated yet
+        return false;
+    }
+
+    bool ok = true;
+    if (count > 0) {
+        bool joins = sparse ? (uint32_t)(sampleSequence - nextSample) < 255 : sampleSequence == nextSample;
+        if (nowUs - queuedUs >= maxLatencyUs) {
+            ok = send(link, nowUs, &stats.deadlineFrames);
+        } else if (length + entry > limit) {
+            ok = send(link, nowUs, &stats.fullFrames);      // MTU shrank under the frame
+        } else if (!joins || sparse != (header.type == TB_FRAME_SPARSE)) {
+            ok = send(link, nowUs, nullptr);                // Gap too long for the frame, or mode switched
+        }
+    }
+
+    if (count == 0) {
+        length = sizeof(TelemetryBatchHeader);
+        header.type = sparse ? TB_FRAME_SPARSE : TB_FRAME_BATCH;
+        header.firstSample = sampleSequence;
+        header.baseTimeUs = sampleTimeUs;
+        queuedUs = nowUs;
+    }
+    // Packets stay contiguous; sparse steps are appended when the frame is sent
+    memcpy(frame + sizeof(TelemetryBatchHeader) + count * sizeof(GPSPacket), &packet, sizeof(GPSPacket));
+    steps[count] = count ? (uint8_t)(sampleSequence - nextSample + 1) : 0;
+    length += entry;
+    count++;
+    nextSample = sampleSequence + 1;
+
+    if (length + entry > limit || count >= TB_MAX_SAMPLES) {
+        ok &= send(link, nowUs, &stats.fullFrames);
+    }
+    return ok;
+}
+
+bool TelemetryBatcher::poll(PacketLink& link, uint32_t nowUs) {
+    if (count == 0 || nowUs - queuedUs < maxLatencyUs) return true;
+    return send(link, nowUs, &stats.deadlineFrames);
+}
+
+bool TelemetryBatcher::flush(PacketLink& link, uint32_t nowUs) {
+    if (count == 0) return true;
+    return send(link, nowUs, nullptr);
+}
+
+void TelemetryBatcher::discard() {
+    stats.samplesLost += count;
+    count = 0;
+    length = 0;
+}
+
+bool TelemetryBatcher::send(PacketLink& link, uint32_t nowUs, uint32_t* reason) {
+    header.count = count;
+    memcpy(frame, &header, sizeof(header));
+    if (header.type == TB_FRAME_SPARSE) {
+        memcpy(frame + sizeof(header) + count * sizeof(GPSPacket), steps, count);
+    }
+
+    bool ok = link.send(frame, length);
+    if (ok) {
+        uint32_t hold = nowUs - queuedUs;
+        stats.frames++;
+        stats.samples += count;
+        stats.bytes += length;
+        stats.totalHoldUs += hold;
+        if (hold > stats.maxHoldUs) stats.maxHoldUs = hold;
+        if (reason) (*reason)++;
+    } else {
+        stats.sendFailures++;
+        stats.samplesLost += count;
+    }
+
+    // The number is used up either way, so the client sees the lost frame
+    header.sequence++;
+    count = 0;
+    length = 0;
+    return ok;
+}
+
+// ==============================================
+// REFERENCE CLIENT
+// ==============================================
+
+TelemetryBatchReceiver::TelemetryBatchReceiver() :
+    started(false),
+    expectedFrame(0),
+    expectedSample(0),
+    frames(0),
+    samples(0),
+    lostFrames(0),
+    lostSamples(0),
+    skippedSamples(0),
+    invalid(0)
+{
+}
+
+int TelemetryBatchReceiver::onFrame(const uint8_t* data, size_t length, TelemetryBatchHeader& header,
+                                    const GPSPacket** packets) {
+    if (length < sizeof(TelemetryBatchHeader) || (data[0] != TB_FRAME_BATCH && data[0] != TB_FRAME_SPARSE)) {
+        invalid++;
+        return -1;
+    }
+    memcpy(&header, data, sizeof(header));
+    const bool isSparse = header.type == TB_FRAME_SPARSE;
+    size_t entry = sizeof(GPSPacket) + (isSparse ? 1 : 0);
+    if (header.count == 0 || header.count > TB_MAX_SAMPLES || length != sizeof(header) + header.count * entry) {
+        invalid++;
+        return -1;
+    }
+
+    const uint8_t* step = data + sizeof(header) + header.count * sizeof(GPSPacket);
+    sequences[0] = header.firstSample;
+    for (int n = 1; n < header.count; n++) {
+        uint8_t s = isSparse ? step[n] : 1;
+        if (s == 0) {
+            invalid++;
+            return -1;
+        }
+        sequences[n] = sequences[n - 1] + s;
+    }
+
+    if (started) {
+        lostFrames += (uint16_t)(header.sequence - expectedFrame);
+        int32_t gap = (int32_t)(header.firstSample - expectedSample);
+        if (gap > 0 && isSparse) {
+            skippedSamples += gap;
+        } else if (gap > 0) {
+            lostSamples += gap;
+        }
+    }
+    if (isSparse) skippedSamples += sequences[header.count - 1] - header.firstSample + 1 - header.count;
+    started = true;
+    expectedFrame = header.sequence + 1;
+    expectedSample = sequences[header.count - 1] + 1;
+    frames++;
+    samples += header.count;
+
+    *packets = reinterpret_cast<const GPSPacket*>(data + sizeof(header));
+    return header.count;
+}
+
+// ==============================================
+// FUSED STATE FRAMES
+// ==============================================
+
+static uint16_t saturated(float value) {
+    return value <= 0.0f ? 0 : value >= 65535.0f ? 65535 : (uint16_t)lroundf(value);
+}
+
+static int16_t clamped(float value) {
+    return value <= -32768.0f ? -32768 : value >= 32767.0f ? 32767 : (int16_t)lroundf(value);
+}
+
+void fusionRecordFrom(const FusionState& state, FusionRecord& out) {
+    out.timeUs = (uint32_t)state.timestampUs;
+    out.latitude = state.latitude;
+    out.longitude = state.longitude;
+    out.speed = saturated(state.speed * 100.0f);
+    out.heading = (uint16_t)(lroundf(state.heading * 100.0f) % 36000);
+    out.velocityNorth = clamped(state.velocityNorth * 100.0f);
+    out.velocityEast = clamped(state.velocityEast * 100.0f);
+    out.positionStd = saturated(state.positionStd * 100.0f);
+    out.sinceFixMs = state.sinceFixMs > 65535 ? 65535 : (uint16_t)state.sinceFixMs;
+}
+
+size_t encodeFusionFrame(const FusionRecord* records, uint8_t count, uint16_t frameSequence,
+                         uint32_t firstState, uint8_t* out) {
+    if (count > TB_MAX_FUSION_RECORDS) count = TB_MAX_FUSION_RECORDS;
+    TelemetryBatchHeader header = { TB_FRAME_FUSION, count, frameSequence, firstState,
+                                    count ? records[0].timeUs : 0 };
+    memcpy(out, &header, sizeof(header));
+    memcpy(out + sizeof(header), records, count * sizeof(FusionRecord));
+    return sizeof(header) + count * sizeof(FusionRecord);
+}
+
+int parseFusionFrame(const uint8_t* data, size_t length, TelemetryBatchHeader& header,
+                     const FusionRecord** records) {
+    if (length < sizeof(header) || data[0] != TB_FRAME_FUSION) return -1;
+    memcpy(&header, data, sizeof(header));
+    if (header.count == 0 || header.count > TB_MAX_FUSION_RECORDS ||
+        length != sizeof(header) + header.count * sizeof(FusionRecord)) {
+        return -1;
+    }
+    *records = reinterpret_cast<const FusionRecord*>(data + sizeof(header));
+    return header.count;
+}
@@ -0,0 +1,181 @@
+#ifndef TELEMETRY_BATCH_H
+#define TELEMETRY_BATCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "gps_packet.h"
+#include "platform_io.h"
+#include "fusion_engine.h"
+
+// ==============================================
+// BATCHED TELEMETRY FRAMES (BLE telemetryChar, UDP)
+// ==============================================
+// Without batching every sample is one GPSPacket-sized notification. In
+// batch mode (BATCH:<ms> on the config characteristic, 0 turns it off) as
+// many consecutive samples as fit the negotiated MTU share one notification.
+// The UDP sink always sends these frames, sized by UDP_BATCH:<bytes>:<ms>.
+//
+//   TelemetryBatchHeader + count * GPSPacket
+//
+// A frame is sent when the next sample would not fit, or when its oldest
+// sample has waited maxLatencyUs. A batch frame is never sizeof(GPSPacket)
+// long, so a client tells the two forms apart by length. `sequence` counts frames and
+// `firstSample` is the bus sequence of the first packet; packets within a
+// frame are always consecutive, so the client sees both lost notifications
+// and samples dropped before they reached the radio.
+//
+// Behind a report policy (report_policy.h) most samples are held back on
+// purpose, so the sink switches to sparse frames:
+//
+//   TelemetryBatchHeader (TB_FRAME_SPARSE) + count * GPSPacket + count * uint8 step
+//
+// step[n] is packet n's bus sequence minus packet n-1's (step[0] = 0), so the
+// client still places every sample in time. Sequence gaps there are held-back
+// samples; only frame sequence gaps mean something was lost on the link.
+//
+// The UDP sink also streams the fused state (fusion_engine.h) at its own,
+// higher rate:
+//
+//   TelemetryBatchHeader (TB_FRAME_FUSION) + count * FusionRecord
+//
+// with its own frame sequence; firstSample counts fused states, so a gap
+// there is states the device dropped before they reached the link.
+// No Arduino dependencies - TelemetryBatchReceiver doubles as the reference client.
+
+#define TB_FRAME_BATCH          0xB1
+#define TB_FRAME_SPARSE         0xB2
+#define TB_FRAME_FUSION         0xB3
+#define TB_MAX_FRAME            1472    // Largest unfragmented UDP payload; BLE frames are held to the MTU
+#define TB_MAX_SAMPLES          ((TB_MAX_FRAME - sizeof(TelemetryBatchHeader)) / sizeof(GPSPacket))
+
+struct __attribute__((packed)) TelemetryBatchHeader {
+    uint8_t type;               // TB_FRAME_BATCH or TB_FRAME_SPARSE
+    uint8_t count;              // GPSPackets that follow
+    uint16_t sequence;          // Frame number, +1 per frame sent
+    uint32_t firstSample;       // Bus sequence of the first packet
+    uint32_t baseTimeUs;        // Device time the first packet was produced (wraps)
+};
+
+struct __attribute__((packed)) FusionRecord {
+    uint32_t timeUs;            // Device time of the state (wraps)
+    int32_t latitude;           // deg * 1e7
+    int32_t longitude;          // deg * 1e7
+    uint16_t speed;             // cm/s
+    uint16_t heading;           // Centidegrees, 0-35999
+    int16_t velocityNorth;      // cm/s
+    int16_t velocityEast;       // cm/s
+    uint16_t positionStd;       // cm, saturates at 65535
+    uint16_t sinceFixMs;        // Dead-reckoned time, saturates at 65535
+};
+
+#define TB_MAX_FUSION_RECORDS   ((TB_MAX_FRAME - sizeof(TelemetryBatchHeader)) / sizeof(FusionRecord))
+
+struct TelemetryBatchStats {
+    uint32_t frames = 0;
+    uint32_t samples = 0;           // Samples sent in frames
+    uint32_t bytes = 0;             // Frame bytes handed to the link
+    uint32_t fullFrames = 0;        // Sent because the next sample would not fit
+    uint32_t deadlineFrames = 0;    // Sent because the oldest sample hit the deadline
+    uint32_t sendFailures = 0;
+    uint32_t samplesLost = 0;       // In failed or discarded frames, or larger than the MTU allows
+    uint32_t maxHoldUs = 0;         // Oldest sample: queued -> frame sent
+    uint64_t totalHoldUs = 0;       // Summed per frame
+};
+
+class TelemetryBatcher {
+public:
+    TelemetryBatcher();
+
+    void setMaxLatency(uint32_t us) { maxLatencyUs = us; }
+    uint32_t getMaxLatency() const { return maxLatencyUs; }
+    // Frame size cap below the link's own limit (0 = link limit)
+    void setMaxFrame(size_t bytes) { maxFrame = bytes; }
+    // Sparse frames accept sequence gaps; a pending frame of the other kind
+    // is sent with the next sample
+    void setSparse(bool enable) { sparse = enable; }
+    bool isSparse() const { return sparse; }
+
+    // Queue one sample (times in microseconds, any wrapping clock). Sends the
+    // pending frame first when the sample would not fit, is not consecutive
+    // (sparse: more than 255 samples on) or the deadline passed. Returns false
+    // when a send failed.
+    bool add(PacketLink& link, const GPSPacket& packet, uint32_t sampleSequence,
+             uint32_t sampleTimeUs, uint32_t nowUs);
+
+    // Send the pending frame once its oldest sample has waited maxLatencyUs
+    bool poll(PacketLink& link, uint32_t nowUs);
+
+    // Send the pending frame now (no-op when empty)
+    bool flush(PacketLink& link, uint32_t nowUs);
+
+    // Drop the pending frame, e.g. after a disconnect
+    void discard();
+
+    uint8_t pending() const { return count; }
+    const TelemetryBatchStats& getStats() const { return stats; }
+    void resetStats() { stats = TelemetryBatchStats(); }
+
+private:
+    uint8_t frame[TB_MAX_FRAME];
+    uint8_t steps[TB_MAX_SAMPLES];  // Sparse frames: appended behind the packets on send
+    size_t length;
+    uint8_t count;
+    TelemetryBatchHeader header;    // Copied to the front of the frame when it is sent
+    uint32_t nextSample;            // Sequence the next packet must have to join a dense frame
+    uint32_t queuedUs;              // When the first packet of the frame was queued
+    uint32_t maxLatencyUs;
+    size_t maxFrame;
+    bool sparse;
+    TelemetryBatchStats stats;
+
+    // reason: the stats counter to bump on success, or null
+    bool send(PacketLink& link, uint32_t nowUs, uint32_t* reason);
+};
+
+// Wire form of one fused state
+void fusionRecordFrom(const FusionState& state, FusionRecord& out);
+
+// One TB_FRAME_FUSION frame of `count` records (1..TB_MAX_FUSION_RECORDS) into
+// out (>= TB_MAX_FRAME bytes); firstState is the state number of records[0].
+// Returns the frame length.
+size_t encodeFusionFrame(const FusionRecord* records, uint8_t count, uint16_t frameSequence,
+                         uint32_t firstState, uint8_t* out);
+
+// Client side: the records of a TB_FRAME_FUSION frame (*records points into
+// data), or -1 when this is not a well-formed one
+int parseFusionFrame(const uint8_t* data, size_t length, TelemetryBatchHeader& header,
+                     const FusionRecord** records);
+
+// Reference client: validates frames and counts what went missing.
+class TelemetryBatchReceiver {
+public:
+    TelemetryBatchReceiver();
+
+    // Returns the packets in a batch or sparse frame (*packets points into
+    // data), or -1 when this is not a well-formed frame.
+    int onFrame(const uint8_t* data, size_t length, TelemetryBatchHeader& header,
+                const GPSPacket** packets);
+    // Bus sequence of packet n of the last frame
+    uint32_t getSequence(int n) const { return sequences[n]; }
+
+    uint32_t getFrames() const { return frames; }
+    uint32_t getSamples() const { return samples; }
+    uint32_t getLostFrames() const { return lostFrames; }
+    uint32_t getLostSamples() const { return lostSamples; }
+    uint32_t getSkippedSamples() const { return skippedSamples; }
+    uint32_t getInvalid() const { return invalid; }
+
+private:
+    bool started;
+    uint16_t expectedFrame;
+    uint32_t expectedSample;
+    uint32_t frames;
+    uint32_t samples;
+    uint32_t lostFrames;        // Frame sequence gaps
+    uint32_t lostSamples;       // Sample sequence gaps (lost frames or upstream drops)
+    uint32_t skippedSamples;    // Sparse frames: sequence gaps (held back, lost or dropped upstream)
+    uint32_t invalid;
+    uint32_t sequences[TB_MAX_SAMPLES];
+};
+
+#endif // TELEMETRY_BATCH_H
@@ -0,0 +1,196 @@
+#ifndef TELEMETRY_RING_H
+#define TELEMETRY_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <new>
+#include <atomic>
+
+#ifdef ARDUINO
+#include <esp_heap_caps.h>
+#endif
+
+// ==============================================
+// SINGLE-PRODUCER / MULTI-CONSUMER TELEMETRY RING
+// ==============================================
+// The producer never blocks and never waits for consumers: when a consumer
+// falls more than `capacity` samples behind, the oldest samples are
+// overwritten and the consumer's overrun counter is increased instead.
+//
+// Each slot carries a stamp (ring position + 1, 0 while being written), so a
+// consumer can detect a slot that was overwritten while it was copying it.
+// Header-only and free of Arduino dependencies so it also builds on the host.
+
+#define TELEMETRY_CACHE_LINE    64
+#define TELEMETRY_MAX_CONSUMERS 8
+
+template <typename T>
+class TelemetryRing {
+public:
+    struct ConsumerStats {
+        uint32_t reads;
+        uint32_t overruns;      // Samples lost because this consumer fell behind
+        uint32_t torn;          // Of those, slots overwritten while being copied
+    };
+
+    TelemetryRing() : slots(nullptr), capacity(0), mask(0), consumerCount(0), inPsram(false) {
+        head.store(0, std::memory_order_relaxed);
+    }
+
+    ~TelemetryRing() { release(); }
+
+    // Allocate storage (PSRAM when available). capacityPow2 must be a power of two.
+    bool begin(uint32_t capacityPow2) {
+        if (slots || capacityPow2 < 2 || (capacityPow2 & (capacityPow2 - 1)) != 0) return false;
+
+        size_t bytes = sizeof(Slot) * capacityPow2;
+        void* mem = nullptr;
+#ifdef ARDUINO
+        mem = heap_caps_aligned_alloc(TELEMETRY_CACHE_LINE, bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        inPsram = mem != nullptr;
+        if (!mem) mem = heap_caps_aligned_alloc(TELEMETRY_CACHE_LINE, bytes, MALLOC_CAP_8BIT);
+#else
+        mem = aligned_alloc(TELEMETRY_CACHE_LINE, bytes);
+#endif
+        if (!mem) return false;
+
+        slots = static_cast<Slot*>(mem);
+        for (uint32_t i = 0; i < capacityPow2; i++) {
+            new (&slots[i]) Slot();
+        }
+        capacity = capacityPow2;
+        mask = capacityPow2 - 1;
+        head.store(0, std::memory_order_release);
+        return true;
+    }
+
+    // Free the storage; consumers must register again after the next begin()
+    void release() {
+        if (!slots) return;
+        for (uint32_t i = 0; i < capacity; i++) {
+            slots[i].~Slot();
+        }
+#ifdef ARDUINO
+        heap_caps_free(slots);
+#else
+        free(slots);
+#endif
+        slots = nullptr;
+        capacity = 0;
+        mask = 0;
+        consumerCount = 0;
+    }
+
+    // Register a consumer. Returns its id, or -1 when the table is full.
+    // New consumers start at the current head and only see future samples.
+    int addConsumer() {
+        if (consumerCount >= TELEMETRY_MAX_CONSUMERS) return -1;
+        int id = consumerCount++;
+        consumers[id].cursor = head.load(std::memory_order_acquire);
+        consumers[id].stats.reads = 0;
+        consumers[id].stats.overruns = 0;
+        consumers[id].stats.torn = 0;
+        return id;
+    }
+
+    // Producer side. Wait-free; overwrites the oldest slot.
+    void push(const T& value) {
+        uint32_t pos = head.load(std::memory_order_relaxed);
+        Slot& slot = slots[pos & mask];
+        slot.stamp.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.value = value;
+        slot.stamp.store(pos + 1, std::memory_order_release);
+        head.store(pos + 1, std::memory_order_release);
+    }
+
+    // Consumer side. Copies the next unread sample; false when caught up.
+    bool read(int id, T& out) {
+        Consumer& c = consumers[id];
+        for (;;) {
+            uint32_t h = head.load(std::memory_order_acquire);
+            uint32_t cur = c.cursor;
+            if (cur == h) return false;
+
+            if (h - cur > capacity) {
+                c.stats.overruns += h - cur - capacity;
+                cur = h - capacity;
+            }
+
+            Slot& slot = slots[cur & mask];
+            if (slot.stamp.load(std::memory_order_acquire) == cur + 1) {
+                out = slot.value;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.stamp.load(std::memory_order_relaxed) == cur + 1) {
+                    c.cursor = cur + 1;
+                    c.stats.reads++;
+                    return true;
+                }
+                c.stats.torn++;
+            }
+
+            // Overwritten underneath us - the producer lapped this slot
+            c.stats.overruns++;
+            c.cursor = cur + 1;
+        }
+    }
+
+    // Skip to the newest sample (for consumers that only care about "now", e.g. the UI).
+    // Skipped samples are not counted as overruns.
+    bool readLatest(int id, T& out) {
+        Consumer& c = consumers[id];
+        uint32_t h = head.load(std::memory_order_acquire);
+        if (c.cursor == h) return false;
+        c.cursor = h - 1;
+        return read(id, out);
+    }
+
+    // Bound a consumer's backlog: drop all but the newest `keep` unread
+    // samples, oldest first. Dropped samples count as overruns.
+    uint32_t trim(int id, uint32_t keep) {
+        Consumer& c = consumers[id];
+        uint32_t backlog = head.load(std::memory_order_acquire) - c.cursor;
+        if (backlog <= keep) return 0;
+        uint32_t dropped = backlog - keep;
+        c.cursor += dropped;
+        c.stats.overruns += dropped;
+        return dropped;
+    }
+
+    uint32_t available(int id) const {
+        uint32_t backlog = head.load(std::memory_order_acquire) - consumers[id].cursor;
+        return backlog > capacity ? capacity : backlog;
+    }
+
+    const ConsumerStats& getConsumerStats(int id) const { return consumers[id].stats; }
+    uint32_t getCapacity() const { return capacity; }
+    uint32_t getTotalPushed() const { return head.load(std::memory_order_relaxed); }
+    bool isInPsram() const { return inPsram; }
+
+private:
+    struct alignas(TELEMETRY_CACHE_LINE) Slot {
+        std::atomic<uint32_t> stamp;
+        T value;
+        Slot() : value() { stamp.store(0, std::memory_order_relaxed); }
+    };
+
+    // Each consumer's cursor lives on its own cache line so consumers never false-share
+    struct alignas(TELEMETRY_CACHE_LINE) Consumer {
+        uint32_t cursor;
+        ConsumerStats stats;
+    };
+
+    Slot* slots;
+    uint32_t capacity;
+    uint32_t mask;
+    alignas(TELEMETRY_CACHE_LINE) std::atomic<uint32_t> head;
+    Consumer consumers[TELEMETRY_MAX_CONSUMERS];
+    int consumerCount;
+    bool inPsram;
+
+    TelemetryRing(const TelemetryRing&) = delete;
+    TelemetryRing& operator=(const TelemetryRing&) = delete;
+};
+
+#endif // TELEMETRY_RING_H
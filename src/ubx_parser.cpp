@@ -0,0 +1,190 @@
+#include "ubx_parser.h"
+#include <string.h>
+
+static_assert(sizeof(UbxNavPvt) == UBX_NAV_PVT_LEN, "UbxNavPvt must match the 92-byte wire layout");
+
+UbxParser::UbxParser() {
+    memset(&pvt, 0, sizeof(pvt));
+    reset();
+}
+
+void UbxParser::reset() {
+    state = WAIT_SYNC_1;
+    msgClass = 0;
+    msgId = 0;
+    length = 0;
+    offset = 0;
+    ckA = 0;
+    ckB = 0;
+    capture = false;
+    failed = false;
+    frameLength = 0;
+}
+
+bool UbxParser::feed(uint8_t byte) {
+    stats.bytes++;
+    uint32_t completed = step(byte);
+    if (failed) completed += rescan();
+    return completed > 0;
+}
+
+// Runs the bytes after a failed frame's sync back through the state machine.
+// New frames are stored at the front of frame[] while the unread bytes are
+// taken from further back, so the rescan works in place; a frame that fails
+// again during the rescan is spliced in front of the remaining bytes.
+uint32_t UbxParser::rescan() {
+    uint32_t completed = 0;
+    uint16_t pending = 0, next = 0;
+    while (failed) {
+        stats.rescans++;
+        uint16_t retry = frameLength - 1;
+        memmove(frame, frame + 1, retry);
+        memmove(frame + retry, frame + next, pending - next);
+        pending = retry + (pending - next);
+        next = 0;
+        reset();
+        while (next < pending && !failed) {
+            completed += step(frame[next++]);
+        }
+    }
+    return completed;
+}
+
+// One byte through the state machine. Returns 1 when it completed a valid
+// NAV-PVT frame; sets `failed` when the frame in progress turned out bad.
+uint32_t UbxParser::step(uint8_t byte) {
+    switch (state) {
+        case WAIT_SYNC_1:
+            if (byte == UBX_SYNC_CHAR_1) {
+                frame[0] = byte;
+                frameLength = 1;
+                state = WAIT_SYNC_2;
+            }
+            return 0;
+
+        case WAIT_SYNC_2:
+            if (byte == UBX_SYNC_CHAR_2) {
+                frame[frameLength++] = byte;
+                state = READ_CLASS;
+                ckA = 0;
+                ckB = 0;
+            } else if (byte != UBX_SYNC_CHAR_1) {
+                state = WAIT_SYNC_1;
+            }
+            return 0;
+
+        case READ_CLASS:
+            frame[frameLength++] = byte;
+            msgClass = byte;
+            checksum(byte);
+            state = READ_ID;
+            return 0;
+
+        case READ_ID:
+            frame[frameLength++] = byte;
+            msgId = byte;
+            checksum(byte);
+            state = READ_LENGTH_1;
+            return 0;
+
+        case READ_LENGTH_1:
+            frame[frameLength++] = byte;
+            length = byte;
+            checksum(byte);
+            state = READ_LENGTH_2;
+            return 0;
+
+        case READ_LENGTH_2:
+            frame[frameLength++] = byte;
+            length |= (uint16_t)byte << 8;
+            checksum(byte);
+            if (length > UBX_MAX_FRAME_PAYLOAD) {
+                stats.lengthErrors++;
+                failed = true;
+                return 0;
+            }
+            capture = msgClass == UBX_CLASS_NAV && msgId == UBX_ID_NAV_PVT;
+            if (capture && length != UBX_NAV_PVT_LEN) {
+                stats.lengthErrors++;
+                capture = false;
+            }
+            offset = 0;
+            state = length > 0 ? READ_PAYLOAD : READ_CK_A;
+            return 0;
+
+        case READ_PAYLOAD:
+            frame[frameLength++] = byte;
+            checksum(byte);
+            if (++offset >= length) state = READ_CK_A;
+            return 0;
+
+        case READ_CK_A:
+            frame[frameLength++] = byte;
+            if (byte != ckA) {
+                stats.checksumErrors++;
+                failed = true;
+                return 0;
+            }
+            state = READ_CK_B;
+            return 0;
+
+        case READ_CK_B: {
+            frame[frameLength++] = byte;
+            if (byte != ckB) {
+                stats.checksumErrors++;
+                failed = true;
+                return 0;
+            }
+            stats.frames++;
+            uint32_t completed = 0;
+            if (capture) {
+                memcpy(&pvt, frame + 6, sizeof(pvt));
+                stats.navPvtFrames++;
+                completed = 1;
+            }
+            reset();
+            return completed;
+        }
+    }
+
+    reset();
+    return 0;
+}
+
+uint32_t UbxParser::feed(const uint8_t* data, size_t length) {
+    uint32_t completed = 0;
+    stats.bytes += length;
+    for (size_t i = 0; i < length; i++) {
+        completed += step(data[i]);
+        if (failed) completed += rescan();
+    }
+    return completed;
+}
+
+uint32_t UbxParser::poll(ByteStream& stream, uint8_t* buffer, size_t bufferSize) {
+    uint32_t completed = 0;
+    size_t available = stream.available();
+    while (available > 0) {
+        size_t n = stream.read(buffer, available < bufferSize ? available : bufferSize);
+        if (n == 0) break;
+        completed += feed(buffer, n);
+        available = stream.available();
+    }
+    return completed;
+}
+
+// Days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant's days_from_civil)
+static int32_t daysFromCivil(int32_t y, uint32_t m, uint32_t d) {
+    y -= m <= 2;
+    const int32_t era = (y >= 0 ? y : y - 399) / 400;
+    const uint32_t yoe = (uint32_t)(y - era * 400);
+    const uint32_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int32_t)doe - 719468;
+}
+
+uint32_t ubxUnixEpoch(const UbxNavPvt& p) {
+    if (p.year < 1970 || p.month < 1 || p.month > 12 || p.day < 1 || p.day > 31) return 0;
+    int32_t days = daysFromCivil(p.year, p.month, p.day);
+    return (uint32_t)days * 86400UL + p.hour * 3600UL + p.min * 60UL + p.sec;
+}
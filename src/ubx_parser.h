@@ -0,0 +1,134 @@
+#ifndef UBX_PARSER_H
+#define UBX_PARSER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "platform_io.h"
+
+// ==============================================
+// STREAMING UBX PARSER
+// ==============================================
+// Incremental, allocation-free u-blox UBX frame parser. Bytes are fed straight
+// from the UART RX buffer; NAV-PVT payloads are validated with the Fletcher
+// checksum and land in a packed struct that mirrors the wire layout (the
+// ESP32-S3 is little-endian, so no per-field decoding is needed).
+//
+// The bytes of the frame in progress are kept, so a frame that fails its
+// length or checksum check is rescanned from the byte after its sync: a sync
+// lost to corruption or a truncated frame costs only the bad frame, never the
+// valid ones that were swallowed as its payload.
+
+#define UBX_SYNC_CHAR_1         0xB5
+#define UBX_SYNC_CHAR_2         0x62
+#define UBX_CLASS_NAV           0x01
+#define UBX_ID_NAV_PVT          0x07
+#define UBX_NAV_PVT_LEN         92
+#define UBX_MAX_FRAME_PAYLOAD   1024    // Anything longer is treated as a lost sync
+#define UBX_FRAME_OVERHEAD      8       // Sync, class, id, length, checksum
+
+// UBX-NAV-PVT payload (92 bytes), field names follow the u-blox interface description
+struct __attribute__((packed)) UbxNavPvt {
+    uint32_t iTOW;          // GPS time of week (ms)
+    uint16_t year;
+    uint8_t month;
+    uint8_t day;
+    uint8_t hour;
+    uint8_t min;
+    uint8_t sec;
+    uint8_t valid;          // bit0 validDate, bit1 validTime, bit2 fullyResolved
+    uint32_t tAcc;          // ns
+    int32_t nano;           // ns
+    uint8_t fixType;        // 0 none, 2 2D, 3 3D, ...
+    uint8_t flags;          // bit0 gnssFixOK
+    uint8_t flags2;
+    uint8_t numSV;
+    int32_t lon;            // deg * 1e7
+    int32_t lat;            // deg * 1e7
+    int32_t height;         // mm above ellipsoid
+    int32_t hMSL;           // mm above mean sea level
+    uint32_t hAcc;          // mm
+    uint32_t vAcc;          // mm
+    int32_t velN;           // mm/s
+    int32_t velE;           // mm/s
+    int32_t velD;           // mm/s
+    int32_t gSpeed;         // mm/s
+    int32_t headMot;        // deg * 1e5
+    uint32_t sAcc;          // mm/s
+    uint32_t headAcc;       // deg * 1e5
+    uint16_t pDOP;          // * 0.01
+    uint16_t flags3;
+    uint8_t reserved0[4];
+    int32_t headVeh;        // deg * 1e5
+    int16_t magDec;         // deg * 1e2
+    uint16_t magAcc;        // deg * 1e2
+};
+
+// Parser counters
+struct UbxParserStats {
+    uint32_t bytes = 0;
+    uint32_t frames = 0;            // Frames with a valid checksum (any class/id)
+    uint32_t navPvtFrames = 0;
+    uint32_t checksumErrors = 0;
+    uint32_t lengthErrors = 0;      // Oversized frames or NAV-PVT with the wrong length
+    uint32_t rescans = 0;           // Bad frames whose bytes were searched again for a sync
+};
+
+class UbxParser {
+public:
+    UbxParser();
+
+    void reset();
+
+    // Feed one byte. Returns true when a complete, valid NAV-PVT frame was just decoded.
+    bool feed(uint8_t byte);
+
+    // Feed a buffer. Returns the number of NAV-PVT frames completed; navPvt() holds the latest.
+    uint32_t feed(const uint8_t* data, size_t length);
+
+    // Read everything the stream has buffered, bufferSize bytes at a time, and feed it.
+    // Returns the number of NAV-PVT frames completed.
+    uint32_t poll(ByteStream& stream, uint8_t* buffer, size_t bufferSize);
+
+    const UbxNavPvt& navPvt() const { return pvt; }
+    const UbxParserStats& getStats() const { return stats; }
+
+private:
+    enum State : uint8_t {
+        WAIT_SYNC_1,
+        WAIT_SYNC_2,
+        READ_CLASS,
+        READ_ID,
+        READ_LENGTH_1,
+        READ_LENGTH_2,
+        READ_PAYLOAD,
+        READ_CK_A,
+        READ_CK_B
+    };
+
+    State state;
+    uint8_t msgClass;
+    uint8_t msgId;
+    uint16_t length;
+    uint16_t offset;
+    uint8_t ckA;
+    uint8_t ckB;
+    bool capture;                           // Current frame is NAV-PVT, committed to pvt on valid checksum
+    bool failed;                            // Current frame failed a check, frame[] needs a rescan
+    uint16_t frameLength;
+    uint8_t frame[UBX_MAX_FRAME_PAYLOAD + UBX_FRAME_OVERHEAD];     // Bytes since the sync, sync included
+    UbxNavPvt pvt;
+    UbxParserStats stats;
+
+    uint32_t step(uint8_t byte);
+    uint32_t rescan();
+
+    inline void checksum(uint8_t byte) {
+        ckA += byte;
+        ckB += ckA;
+    }
+};
+
+// Seconds since 1970-01-01 UTC from the NAV-PVT date/time fields
+uint32_t ubxUnixEpoch(const UbxNavPvt& pvt);
+
+#endif // UBX_PARSER_H
@@ -1,6 +1,7 @@
 #include "ui_manager.h"
 #include <Arduino_GFX_Library.h>
 #include <WiFi.h>
+#include "stage_probe.h"
 
 // Global display objects for JC3248W535EN
 Arduino_DataBus *bus = nullptr;
@@ -14,7 +15,12 @@ UIManager::UIManager() :
     perfStats(nullptr),
     fileTransferPtr(nullptr),
     mainScreen(nullptr),
+    performanceScreen(nullptr),
+    probeLabel(nullptr),
+    fusionLabel(nullptr),
+    fusionFresh(false),
     currentScreen(SCREEN_SPEEDOMETER),
+    requestedScreen(SCREEN_SPEEDOMETER),
     updateRequested(true),
     lastUpdate(0),
     lastHeaderUpdate(0),
@@ -239,6 +245,13 @@ void UIManager::createWorkingTestScreen() {
     lv_obj_set_style_text_font(info, UI_FONT_SMALL, 0);
     lv_obj_set_pos(info, 10, 250);
     
+    // Fused state (fusion_engine.h), refreshed by update()
+    fusionLabel = lv_label_create(scr);
+    lv_label_set_text(fusionLabel, "Fusion: waiting for a fix");
+    lv_obj_set_style_text_color(fusionLabel, lv_color_hex(0xFFFF00), 0);
+    lv_obj_set_style_text_font(fusionLabel, UI_FONT_SMALL, 0);
+    lv_obj_set_pos(fusionLabel, 10, 310);
+    
     // Load the screen
     lv_scr_load(scr);
     mainScreen = scr;
@@ -246,9 +259,71 @@ void UIManager::createWorkingTestScreen() {
     Serial.println("✅ Working test screen created with colors and buttons");
 }
 
+// Stage probe table (stage_probe.h), refreshed once a second while shown
+void UIManager::createPerformanceScreen() {
+    lv_obj_t* scr = lv_obj_create(NULL);
+    lv_obj_set_style_bg_color(scr, lv_color_hex(0x001122), 0);
+    
+    lv_obj_t* title = lv_label_create(scr);
+    lv_label_set_text(title, "Hot-path timing");
+    lv_obj_set_style_text_color(title, lv_color_hex(0xFFFFFF), 0);
+    lv_obj_set_style_text_font(title, UI_FONT_MEDIUM, 0);
+    lv_obj_set_pos(title, 10, 10);
+    
+    probeLabel = lv_label_create(scr);
+    lv_label_set_text(probeLabel, "");
+    lv_obj_set_style_text_color(probeLabel, lv_color_hex(0x00FF00), 0);
+    lv_obj_set_style_text_font(probeLabel, UI_FONT_SMALL, 0);
+    lv_obj_set_pos(probeLabel, 10, 50);
+    
+    performanceScreen = scr;
+}
+
+void UIManager::updatePerformanceScreen() {
+    if (!probeLabel) return;
+    char text[PROBE_REPORT_SIZE];
+    probeFormat(text, sizeof(text), false);
+    lv_label_set_text(probeLabel, text);
+}
+
+void UIManager::setFusionState(const FusionState& state) {
+    fusionState = state;
+    fusionFresh = true;
+}
+
+void UIManager::updateFusionLabel() {
+    if (!fusionLabel || !fusionFresh) return;
+    fusionFresh = false;
+    char text[96];
+    snprintf(text, sizeof(text), "Fusion: %.1f km/h %.0f deg +-%.1f m%s",
+             fusionState.speed * 3.6f, fusionState.heading, fusionState.positionStd,
+             fusionState.sinceFixMs > 1000 ? " (dead reckoning)" : "");
+    lv_label_set_text(fusionLabel, text);
+}
+
+// Runs on the UI task, the only one allowed to touch LVGL
 void UIManager::update() {
-    // For now, just handle LVGL timer
-    // We can add data updates later once the display is confirmed working
+    ScreenType requested = requestedScreen;
+    if (requested != currentScreen) {
+        if (requested == SCREEN_PERFORMANCE) {
+            if (!performanceScreen) createPerformanceScreen();
+            updatePerformanceScreen();
+            lv_scr_load(performanceScreen);
+        } else if (mainScreen) {
+            lv_scr_load(mainScreen);
+        }
+        currentScreen = requested;
+        lastStatusUpdate = millis();
+    }
+    
+    if (currentScreen != SCREEN_PERFORMANCE && millis() - lastUpdate >= UPDATE_INTERVAL) {
+        updateFusionLabel();
+        lastUpdate = millis();
+    }
+    if (currentScreen == SCREEN_PERFORMANCE && millis() - lastStatusUpdate >= HEADER_UPDATE_INTERVAL) {
+        updatePerformanceScreen();
+        lastStatusUpdate = millis();
+    }
 }
 
 void UIManager::requestUpdate() {
@@ -258,14 +333,17 @@ void UIManager::requestUpdate() {
 // Screen management (simplified for now)
 void UIManager::showScreen(ScreenType screen) {
     Serial.printf("Switching to screen %d\n", screen);
+    requestedScreen = screen;
 }
 
 void UIManager::nextScreen() {
     Serial.println("Next screen requested");
+    requestedScreen = (ScreenType)((requestedScreen + 1) % (SCREEN_PERFORMANCE + 1));
 }
 
 void UIManager::previousScreen() {
     Serial.println("Previous screen requested");
+    requestedScreen = (ScreenType)((requestedScreen + SCREEN_PERFORMANCE) % (SCREEN_PERFORMANCE + 1));
 }
 
 ScreenType UIManager::getCurrentScreen() const {
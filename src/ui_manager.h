@@ -5,6 +5,7 @@
 #include <Arduino_GFX_Library.h>
 #include "data_structures.h"
 #include "boardconfig.h"
+#include "fusion_engine.h"
 
 // Forward declarations for Arduino_GFX objects
 extern Arduino_DataBus *bus;
@@ -41,6 +42,9 @@ public:
     void setMenuCallback(void (*callback)());
     void setSystemCallback(void (*callback)());
     
+    // Newest fused state (UI task), shown on the main screen
+    void setFusionState(const FusionState& state);
+    
     // File transfer support
     void setFileTransferData(FileTransferState* ft) { fileTransferPtr = ft; }
     void updateFileTransferUI();
@@ -61,9 +65,15 @@ private:
     lv_obj_t* mainScreen;
     lv_obj_t* progressBar;
     lv_obj_t* transferLabel;
+    lv_obj_t* performanceScreen;
+    lv_obj_t* probeLabel;
+    lv_obj_t* fusionLabel;
+    FusionState fusionState;
+    bool fusionFresh;
     
     // State variables
     ScreenType currentScreen;
+    volatile ScreenType requestedScreen;    // Set from any task, applied by update() on the UI task
     bool updateRequested;
     unsigned long lastUpdate;
     unsigned long lastHeaderUpdate;
@@ -79,6 +89,9 @@ private:
     
     // Private methods
     void createWorkingTestScreen();
+    void createPerformanceScreen();
+    void updatePerformanceScreen();
+    void updateFusionLabel();
     
     // Utility functions
     lv_color_t getSpeedColor(float speed);